@@ -58,6 +58,7 @@ COMPILER_SRC_FILES :=  \
     src/google/protobuf/extension_set_heavy.cc \
     src/google/protobuf/generated_message_reflection.cc \
     src/google/protobuf/generated_message_util.cc \
+    src/google/protobuf/incremental_parser.cc \
     src/google/protobuf/message.cc \
     src/google/protobuf/message_lite.cc \
     src/google/protobuf/reflection_ops.cc \
@@ -120,13 +121,17 @@ COMPILER_SRC_FILES :=  \
     src/google/protobuf/compiler/javanano/javanano_primitive_field.cc \
     src/google/protobuf/compiler/python/python_generator.cc \
     src/google/protobuf/io/coded_stream.cc \
+    src/google/protobuf/io/delimited_reader.cc \
     src/google/protobuf/io/gzip_stream.cc \
+    src/google/protobuf/io/lz_stream.cc \
     src/google/protobuf/io/printer.cc \
+    src/google/protobuf/io/record_io.cc \
     src/google/protobuf/io/tokenizer.cc \
     src/google/protobuf/io/zero_copy_stream.cc \
     src/google/protobuf/io/zero_copy_stream_impl.cc \
     src/google/protobuf/io/zero_copy_stream_impl_lite.cc \
     src/google/protobuf/stubs/common.cc \
+    src/google/protobuf/stubs/crc32c.cc \
     src/google/protobuf/stubs/hash.cc \
     src/google/protobuf/stubs/once.cc \
     src/google/protobuf/stubs/structurally_valid.cc \
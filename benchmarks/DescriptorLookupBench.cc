@@ -0,0 +1,106 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures DescriptorPool::FindMessageTypeByName() and FindFieldByName() on
+// the generated pool for names it has already built, called from several
+// threads at once, as code that resolves types by name at run time does.
+// The generated pool is backed by a DescriptorDatabase, so before it had a
+// lock-free path every lookup took its mutex.  To compare with that, build
+// it against a library from before the change (see readme.txt).
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/stubs/common.h>
+
+#include "ThreadBench.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::DescriptorProto;
+using google::protobuf::FileDescriptor;
+using std::string;
+using std::vector;
+using thread_bench::Benchmark;
+using thread_bench::kCallsPerThread;
+
+namespace {
+
+// The names looked up: every message type in descriptor.proto, and the
+// fields of each.
+vector<string> type_names;
+vector<string> field_names;
+
+const DescriptorPool* pool;
+
+void* FindMessageTypes(void* arg) {
+  long sum = 0;
+  for (int i = 0; i < kCallsPerThread; i++) {
+    sum += reinterpret_cast<long>(
+        pool->FindMessageTypeByName(type_names[i % type_names.size()]));
+  }
+  return reinterpret_cast<void*>(sum);
+}
+
+void* FindFields(void* arg) {
+  long sum = 0;
+  for (int i = 0; i < kCallsPerThread; i++) {
+    sum += reinterpret_cast<long>(
+        pool->FindFieldByName(field_names[i % field_names.size()]));
+  }
+  return reinterpret_cast<void*>(sum);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  int max_threads = thread_bench::ParseMaxThreads(argc, argv);
+  if (max_threads == 0) return 1;
+
+  pool = DescriptorPool::generated_pool();
+  const FileDescriptor* file = DescriptorProto::descriptor()->file();
+  for (int i = 0; i < file->message_type_count(); i++) {
+    const Descriptor* type = file->message_type(i);
+    type_names.push_back(type->full_name());
+    for (int j = 0; j < type->field_count(); j++) {
+      field_names.push_back(type->field(j)->full_name());
+    }
+  }
+
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    Benchmark("FindMessageTypeByName()", &FindMessageTypes, threads);
+    Benchmark("FindFieldByName()", &FindFields, threads);
+  }
+  return 0;
+}
@@ -0,0 +1,175 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures what generated code pays at startup to register its descriptors
+// with the generated pool, and what the first reflective use pays later.
+// The schemas are synthesized in memory and shaped like
+// unittest_enormous_descriptor.proto: each file holds one message with many
+// string fields that have long names and long default values, and each file
+// imports the one before it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/descriptor_database.h>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/strutil.h>
+
+using google::protobuf::DescriptorPool;
+using google::protobuf::DescriptorProto;
+using google::protobuf::EncodedDescriptorDatabase;
+using google::protobuf::FieldDescriptorProto;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::SimpleItoa;
+using std::string;
+using std::vector;
+
+namespace {
+
+const int kRounds = 5;
+
+string FileName(int index) {
+  return "enormous_" + SimpleItoa(index) + ".proto";
+}
+
+string MessageName(int index) {
+  return "TestEnormousDescriptor" + SimpleItoa(index);
+}
+
+// Builds the encoded FileDescriptorProtos, as embedded in generated .pb.cc
+// files.
+void MakeFiles(int num_files, int num_fields, vector<string>* files) {
+  for (int i = 0; i < num_files; i++) {
+    FileDescriptorProto file;
+    file.set_name(FileName(i));
+    file.set_package("benchmarks");
+    if (i > 0) file.add_dependency(FileName(i - 1));
+    DescriptorProto* message = file.add_message_type();
+    message->set_name(MessageName(i));
+    for (int j = 1; j <= num_fields; j++) {
+      FieldDescriptorProto* field = message->add_field();
+      field->set_name("long_field_name_is_looooooooooooooooooooooooooooooooo"
+                      "ooooooooooooooooooooooooooooooooooooooooong_" +
+                      SimpleItoa(j));
+      field->set_number(j);
+      field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+      field->set_type(FieldDescriptorProto::TYPE_STRING);
+      field->set_default_value("long default value is also looooooooooooooo"
+                               "ooooooooooooooooooooooooooooooooooooooooooooo"
+                               "ooooooooooooooooooooooong");
+    }
+    files->push_back(file.SerializeAsString());
+  }
+}
+
+double Seconds(clock_t start) {
+  return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void Report(const char* name, double total_seconds) {
+  printf("%-42s %10.3fms\n", name, total_seconds * 1000 / kRounds);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  int num_files = argc > 1 ? atoi(argv[1]) : 1000;
+  int num_fields = argc > 2 ? atoi(argv[2]) : 100;
+  if (argc > 3 || num_files < 1 || num_fields < 1) {
+    fprintf(stderr,
+            "Usage: %s [number of files] [number of fields per file]\n",
+            argv[0]);
+    return 1;
+  }
+
+  vector<string> files;
+  MakeFiles(num_files, num_fields, &files);
+  printf("%d files with %d fields each, averaged over %d rounds\n",
+         num_files, num_fields, kRounds);
+
+  double eager_add = 0;
+  double lazy_add = 0;
+  double first_file = 0;
+  double last_file = 0;
+  double first_symbol = 0;
+  for (int round = 0; round < kRounds; round++) {
+    {
+      // What InternalAddGeneratedFile() used to do for every linked-in file.
+      EncodedDescriptorDatabase database;
+      clock_t start = clock();
+      for (int i = 0; i < files.size(); i++) {
+        database.Add(files[i].data(), files[i].size());
+      }
+      eager_add += Seconds(start);
+    }
+
+    EncodedDescriptorDatabase database;
+    clock_t start = clock();
+    for (int i = 0; i < files.size(); i++) {
+      database.AddUnindexed(files[i].data(), files[i].size());
+    }
+    lazy_add += Seconds(start);
+
+    // descriptor() on a type from a file without dependencies.
+    DescriptorPool pool(&database);
+    start = clock();
+    GOOGLE_CHECK(pool.FindFileByName(FileName(0)) != NULL);
+    first_file += Seconds(start);
+
+    // descriptor() on a type from the file that imports all the others.
+    start = clock();
+    GOOGLE_CHECK(pool.FindFileByName(FileName(num_files - 1)) != NULL);
+    last_file += Seconds(start);
+
+    // A by-name lookup, which needs every file indexed.
+    EncodedDescriptorDatabase other_database;
+    for (int i = 0; i < files.size(); i++) {
+      other_database.AddUnindexed(files[i].data(), files[i].size());
+    }
+    DescriptorPool other_pool(&other_database);
+    start = clock();
+    GOOGLE_CHECK(other_pool.FindMessageTypeByName(
+        "benchmarks." + MessageName(0)) != NULL);
+    first_symbol += Seconds(start);
+  }
+
+  Report("Register all files (Add)", eager_add);
+  Report("Register all files (AddUnindexed)", lazy_add);
+  Report("First use of a file with no imports", first_file);
+  Report("First use of a file importing all others", last_file);
+  Report("First lookup of a type by name", first_symbol);
+  return 0;
+}
@@ -0,0 +1,273 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures the memory a DescriptorPool uses for a large synthetic schema,
+// and the speed of the lookups its hash tables serve: by full name in the
+// pool, and by name or number within a message or enum.  The schema has
+// many files, each defining messages with many fields and a nested enum.
+//
+// Memory is counted by replacing the global operator new, so it covers
+// everything the pool allocates but not malloc's own overhead for each
+// block.  The number of blocks is reported too, since that overhead is
+// usually 8 to 16 bytes per block.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/strutil.h>
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::DescriptorProto;
+using google::protobuf::EnumDescriptor;
+using google::protobuf::EnumDescriptorProto;
+using google::protobuf::EnumValueDescriptorProto;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FieldDescriptorProto;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::SimpleItoa;
+using std::string;
+using std::vector;
+
+namespace {
+
+size_t live_bytes = 0;
+size_t live_blocks = 0;
+
+// Enough to keep the blocks handed out suitably aligned.
+const size_t kHeaderSize = 16;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  char* block = static_cast<char*>(malloc(size + kHeaderSize));
+  if (block == NULL) throw std::bad_alloc();
+  *reinterpret_cast<size_t*>(block) = size;
+  live_bytes += size;
+  ++live_blocks;
+  return block + kHeaderSize;
+}
+
+void operator delete(void* ptr) throw() {
+  if (ptr == NULL) return;
+  char* block = static_cast<char*>(ptr) - kHeaderSize;
+  live_bytes -= *reinterpret_cast<size_t*>(block);
+  --live_blocks;
+  free(block);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* ptr) throw() { operator delete(ptr); }
+
+namespace {
+
+const int kRounds = 5;
+
+double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void MakeFiles(int num_files, int num_messages, int num_fields,
+               vector<FileDescriptorProto>* files) {
+  files->resize(num_files);
+  for (int i = 0; i < num_files; i++) {
+    FileDescriptorProto* file = &(*files)[i];
+    file->set_name("synthetic_" + SimpleItoa(i) + ".proto");
+    file->set_package("benchmarks.synthetic" + SimpleItoa(i));
+    for (int j = 0; j < num_messages; j++) {
+      DescriptorProto* message = file->add_message_type();
+      message->set_name("Message" + SimpleItoa(j));
+      EnumDescriptorProto* enum_type = message->add_enum_type();
+      enum_type->set_name("Kind");
+      for (int k = 0; k < 10; k++) {
+        EnumValueDescriptorProto* value = enum_type->add_value();
+        value->set_name("KIND_" + SimpleItoa(j) + "_" + SimpleItoa(k));
+        value->set_number(k);
+      }
+      for (int k = 1; k <= num_fields; k++) {
+        FieldDescriptorProto* field = message->add_field();
+        field->set_name("field_" + SimpleItoa(k));
+        field->set_number(k);
+        field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+        field->set_type(k % 2 == 0 ? FieldDescriptorProto::TYPE_INT32
+                                   : FieldDescriptorProto::TYPE_STRING);
+      }
+    }
+  }
+}
+
+void Report(const char* name, double seconds, long calls) {
+  printf("%-38s %8.2fns per lookup\n", name, seconds * 1e9 / calls);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  int num_files = argc > 1 ? atoi(argv[1]) : 500;
+  int num_messages = argc > 2 ? atoi(argv[2]) : 20;
+  int num_fields = argc > 3 ? atoi(argv[3]) : 40;
+  if (argc > 4 || num_files < 1 || num_messages < 1 || num_fields < 1) {
+    fprintf(stderr,
+            "Usage: %s [number of files] [messages per file] "
+            "[fields per message]\n", argv[0]);
+    return 1;
+  }
+
+  vector<FileDescriptorProto> files;
+  MakeFiles(num_files, num_messages, num_fields, &files);
+
+  size_t bytes_before = live_bytes;
+  size_t blocks_before = live_blocks;
+  double start = Now();
+  DescriptorPool* pool = new DescriptorPool;
+  for (int i = 0; i < files.size(); i++) {
+    GOOGLE_CHECK(pool->BuildFile(files[i]) != NULL);
+  }
+  double build_seconds = Now() - start;
+  size_t pool_bytes = live_bytes - bytes_before;
+  size_t pool_blocks = live_blocks - blocks_before;
+
+  vector<const Descriptor*> messages;
+  vector<string> message_names;
+  vector<string> field_names;
+  vector<string> missing_names;
+  for (int i = 0; i < num_files; i++) {
+    for (int j = 0; j < num_messages; j++) {
+      const Descriptor* message = pool->FindMessageTypeByName(
+          files[i].package() + "." + files[i].message_type(j).name());
+      GOOGLE_CHECK(message != NULL);
+      messages.push_back(message);
+      message_names.push_back(message->full_name());
+      missing_names.push_back(message->full_name() + "Missing");
+      for (int k = 0; k < message->field_count(); k++) {
+        field_names.push_back(message->field(k)->full_name());
+      }
+    }
+  }
+  int num_symbols = message_names.size() * (2 + num_fields + 10);
+  printf("%d files, %d messages, %d fields, ~%d symbols\n", num_files,
+         static_cast<int>(message_names.size()),
+         static_cast<int>(field_names.size()), num_symbols);
+  printf("%-38s %8.2fms\n", "BuildFile() for every file",
+         build_seconds * 1000);
+  printf("%-38s %8.2fMB in %d blocks, %.1f bytes per symbol\n", "Pool memory",
+         pool_bytes / 1e6, static_cast<int>(pool_blocks),
+         static_cast<double>(pool_bytes) / num_symbols);
+
+  long sum = 0;
+  double pool_messages = 0;
+  double pool_fields = 0;
+  double pool_misses = 0;
+  double fields_by_name = 0;
+  double fields_by_number = 0;
+  double values_by_number = 0;
+  long nested_calls = 0;
+  for (int round = 0; round < kRounds; round++) {
+    start = Now();
+    for (int i = 0; i < message_names.size(); i++) {
+      sum += reinterpret_cast<long>(
+          pool->FindMessageTypeByName(message_names[i]));
+    }
+    pool_messages += Now() - start;
+
+    start = Now();
+    for (int i = 0; i < field_names.size(); i++) {
+      sum += reinterpret_cast<long>(pool->FindFieldByName(field_names[i]));
+    }
+    pool_fields += Now() - start;
+
+    start = Now();
+    for (int i = 0; i < missing_names.size(); i++) {
+      sum += reinterpret_cast<long>(
+          pool->FindMessageTypeByName(missing_names[i]));
+    }
+    pool_misses += Now() - start;
+
+    // The names and numbers asked for are in a different order from the
+    // fields, so that consecutive lookups touch unrelated entries.
+    vector<string> local_names;
+    for (int k = 1; k <= num_fields; k++) {
+      local_names.push_back("field_" + SimpleItoa(k));
+    }
+    start = Now();
+    for (int i = 0; i < messages.size(); i++) {
+      const Descriptor* message = messages[(i * 7919) % messages.size()];
+      for (int k = 0; k < num_fields; k++) {
+        sum += reinterpret_cast<long>(
+            message->FindFieldByName(local_names[(k * 7) % num_fields]));
+      }
+    }
+    fields_by_name += Now() - start;
+
+    start = Now();
+    for (int i = 0; i < messages.size(); i++) {
+      const Descriptor* message = messages[(i * 7919) % messages.size()];
+      for (int k = 0; k < num_fields; k++) {
+        sum += reinterpret_cast<long>(
+            message->FindFieldByNumber((k * 7) % num_fields + 1));
+      }
+    }
+    fields_by_number += Now() - start;
+
+    start = Now();
+    for (int i = 0; i < messages.size(); i++) {
+      const EnumDescriptor* kind =
+          messages[(i * 7919) % messages.size()]->enum_type(0);
+      for (int k = 0; k < num_fields; k++) {
+        sum += reinterpret_cast<long>(kind->FindValueByNumber(k % 10));
+      }
+    }
+    values_by_number += Now() - start;
+    nested_calls += messages.size() * num_fields;
+  }
+
+  Report("DescriptorPool::FindMessageTypeByName", pool_messages,
+         kRounds * message_names.size());
+  Report("DescriptorPool::FindFieldByName", pool_fields,
+         kRounds * field_names.size());
+  Report("  ... for names which are not found", pool_misses,
+         kRounds * missing_names.size());
+  Report("Descriptor::FindFieldByName", fields_by_name, nested_calls);
+  Report("Descriptor::FindFieldByNumber", fields_by_number, nested_calls);
+  Report("EnumDescriptor::FindValueByNumber", values_by_number, nested_calls);
+  GOOGLE_CHECK_NE(sum, 0);
+  delete pool;
+  return 0;
+}
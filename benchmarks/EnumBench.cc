@@ -0,0 +1,97 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures the generated <Enum>_IsValid() functions, which are called for
+// every enum value parsed, on the enums in enum_bench.proto.  Half of the
+// inputs are valid values and half are numbers near or between them.
+
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+#include <google/protobuf/stubs/common.h>
+
+#include "enum_bench.pb.h"
+
+using std::vector;
+
+namespace {
+
+const int kNumInputs = 4096;
+const long kCalls = 200000000;
+
+typedef bool IsValidFunction(int value);
+
+// Builds the inputs from the enum's values without going through
+// descriptors, so that the same binary works whatever the optimize_for mode.
+void MakeInputs(IsValidFunction* is_valid, int min, int max,
+                vector<int>* inputs) {
+  vector<int> valid;
+  for (int value = min; value <= max; value++) {
+    if (is_valid(value)) valid.push_back(value);
+    if (value == max) break;  // Avoid overflow when max is kint32max.
+  }
+
+  // A simple linear congruential generator keeps runs reproducible.
+  unsigned int seed = 12345;
+  for (int i = 0; i < kNumInputs; i++) {
+    seed = seed * 1103515245 + 12345;
+    int value = valid[(seed >> 8) % valid.size()];
+    inputs->push_back(i % 2 == 0 ? value : value + 1 + (seed >> 28));
+  }
+}
+
+void Benchmark(const char* name, IsValidFunction* is_valid, int min,
+               int max) {
+  vector<int> inputs;
+  MakeInputs(is_valid, min, max, &inputs);
+
+  long valid_count = 0;
+  clock_t start = clock();
+  for (long i = 0; i < kCalls; i++) {
+    valid_count += is_valid(inputs[i % kNumInputs]);
+  }
+  double elapsed = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  printf("%-16s %6.2fns per call (%ld valid)\n", name,
+         elapsed * 1e9 / kCalls, valid_count);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  Benchmark("Contiguous", &benchmarks::ContiguousEnum_IsValid,
+            benchmarks::ContiguousEnum_MIN, benchmarks::ContiguousEnum_MAX);
+  Benchmark("Gappy", &benchmarks::GappyEnum_IsValid,
+            benchmarks::GappyEnum_MIN, benchmarks::GappyEnum_MAX);
+  Benchmark("Sparse", &benchmarks::SparseEnum_IsValid,
+            benchmarks::SparseEnum_MIN, benchmarks::SparseEnum_MAX);
+  return 0;
+}
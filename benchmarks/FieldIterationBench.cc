@@ -0,0 +1,159 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures walking every set field of a message tree through reflection, as
+// generic serializers and printers do: once with Reflection::ListFields()
+// at every nesting level, and once with Reflection::VisitFields().  The
+// message is descriptor.proto's own FileDescriptorProto, both as a generated
+// message and as a DynamicMessage.
+
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/stubs/common.h>
+
+using google::protobuf::DynamicMessageFactory;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+using std::vector;
+
+namespace {
+
+const int kRounds = 20000;
+
+// Returns the number of set fields (counting each element of a repeated
+// field) in message and everything under it.
+int CountWithListFields(const Message& message) {
+  const Reflection* reflection = message.GetReflection();
+  vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  int count = 0;
+  for (int i = 0; i < fields.size(); i++) {
+    const FieldDescriptor* field = fields[i];
+    if (field->is_repeated()) {
+      int size = reflection->FieldSize(message, field);
+      count += size;
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        for (int j = 0; j < size; j++) {
+          count += CountWithListFields(
+              reflection->GetRepeatedMessage(message, field, j));
+        }
+      }
+    } else {
+      count++;
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        count += CountWithListFields(reflection->GetMessage(message, field));
+      }
+    }
+  }
+  return count;
+}
+
+class FieldCounter : public Reflection::FieldVisitor {
+ public:
+  FieldCounter(const Message& message, int* count)
+      : message_(message), reflection_(message.GetReflection()),
+        count_(count) {}
+
+  void Visit(const FieldDescriptor* field) {
+    if (field->is_repeated()) {
+      int size = reflection_->FieldSize(message_, field);
+      *count_ += size;
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        for (int j = 0; j < size; j++) {
+          Count(reflection_->GetRepeatedMessage(message_, field, j));
+        }
+      }
+    } else {
+      ++*count_;
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        Count(reflection_->GetMessage(message_, field));
+      }
+    }
+  }
+
+  void Count(const Message& message) {
+    FieldCounter counter(message, count_);
+    message.GetReflection()->VisitFields(message, &counter);
+  }
+
+ private:
+  const Message& message_;
+  const Reflection* reflection_;
+  int* count_;
+};
+
+int CountWithVisitFields(const Message& message) {
+  int count = 0;
+  FieldCounter counter(message, &count);
+  counter.Count(message);
+  return count;
+}
+
+void Benchmark(const char* name, int (*count_function)(const Message&),
+               const Message& message) {
+  long checksum = 0;
+  clock_t start = clock();
+  for (int round = 0; round < kRounds; round++) {
+    checksum += count_function(message);
+  }
+  double elapsed = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  printf("%-28s %8.2fus per walk (%ld fields per walk)\n", name,
+         elapsed * 1e6 / kRounds, checksum / kRounds);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  FileDescriptorProto generated;
+  FileDescriptorProto::descriptor()->file()->CopyTo(&generated);
+
+  DynamicMessageFactory factory;
+  Message* dynamic =
+      factory.GetPrototype(FileDescriptorProto::descriptor())->New();
+  dynamic->ParseFromString(generated.SerializeAsString());
+
+  Benchmark("Generated, ListFields()", &CountWithListFields, generated);
+  Benchmark("Generated, VisitFields()", &CountWithVisitFields, generated);
+  Benchmark("Dynamic, ListFields()", &CountWithListFields, *dynamic);
+  Benchmark("Dynamic, VisitFields()", &CountWithVisitFields, *dynamic);
+
+  delete dynamic;
+  return 0;
+}
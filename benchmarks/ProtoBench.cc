@@ -0,0 +1,210 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// C++ counterpart of ProtoBench.java.  Since C++ message types are compiled
+// in, the same source is built once per code generator configuration being
+// compared; see readme.txt.
+
+#include <stdio.h>
+#include <time.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/stubs/common.h>
+
+#include "google_size.pb.h"
+#include "google_speed.pb.h"
+
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::Message;
+using google::protobuf::MessageFactory;
+using google::protobuf::uint8;
+using std::string;
+
+namespace {
+
+const double kMinSampleTimeSeconds = 2;
+const double kTargetTimeSeconds = 30;
+
+// A benchmarked operation.
+class Action {
+ public:
+  virtual ~Action() {}
+  virtual void Execute() = 0;
+};
+
+double TimeAction(Action* action, long iterations) {
+  clock_t start = clock();
+  for (long i = 0; i < iterations; i++) {
+    action->Execute();
+  }
+  return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void Benchmark(const string& name, size_t data_size, Action* action) {
+  for (int i = 0; i < 100; i++) {
+    action->Execute();
+  }
+
+  long iterations = 1;
+  double elapsed = TimeAction(action, iterations);
+  while (elapsed < kMinSampleTimeSeconds) {
+    iterations *= 2;
+    elapsed = TimeAction(action, iterations);
+  }
+
+  iterations = static_cast<long>(kTargetTimeSeconds / elapsed * iterations);
+  elapsed = TimeAction(action, iterations);
+  printf("%s: %ld iterations in %.3fs; %.3fMB/s\n", name.c_str(), iterations,
+         elapsed, iterations * data_size / (elapsed * 1024 * 1024));
+}
+
+class SerializeToString : public Action {
+ public:
+  explicit SerializeToString(const Message* message) : message_(message) {}
+  virtual void Execute() { message_->SerializeToString(&output_); }
+
+ private:
+  const Message* message_;
+  string output_;
+};
+
+class SerializeToArray : public Action {
+ public:
+  explicit SerializeToArray(const Message* message)
+      : message_(message), output_(message->ByteSize(), '\0') {}
+  virtual void Execute() {
+    message_->SerializeWithCachedSizesToArray(
+        reinterpret_cast<uint8*>(&output_[0]));
+  }
+
+ private:
+  const Message* message_;
+  string output_;
+};
+
+class ParseFromString : public Action {
+ public:
+  ParseFromString(const Message* prototype, const string& data)
+      : prototype_(prototype), data_(data) {}
+  virtual void Execute() {
+    Message* message = prototype_->New();
+    message->ParseFromString(data_);
+    delete message;
+  }
+
+ private:
+  const Message* prototype_;
+  const string& data_;
+};
+
+class ParseReusingMessage : public Action {
+ public:
+  ParseReusingMessage(const Message* prototype, const string& data)
+      : message_(prototype->New()), data_(data) {}
+  ~ParseReusingMessage() { delete message_; }
+  virtual void Execute() {
+    // ParseFromArray() clears the message first, but keeps the memory
+    // allocated by previous parses.
+    message_->ParseFromArray(data_.data(), data_.size());
+  }
+
+ private:
+  Message* message_;
+  const string& data_;
+};
+
+// Runs all benchmarks for one message type and input file.  Errors are
+// reported to stderr, and the return value indicates success.
+bool RunTest(const string& type, const string& file) {
+  printf("Benchmarking %s with file %s\n", type.c_str(), file.c_str());
+  const Descriptor* descriptor =
+      DescriptorPool::generated_pool()->FindMessageTypeByName(type);
+  if (descriptor == NULL) {
+    fprintf(stderr, "Unknown message type: %s\n", type.c_str());
+    return false;
+  }
+  const Message* prototype =
+      MessageFactory::generated_factory()->GetPrototype(descriptor);
+
+  std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+  if (!in) {
+    fprintf(stderr, "Unable to read %s\n", file.c_str());
+    return false;
+  }
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  const string data = contents.str();
+
+  Message* sample = prototype->New();
+  if (!sample->ParseFromString(data)) {
+    fprintf(stderr, "Unable to parse %s as %s\n", file.c_str(), type.c_str());
+    delete sample;
+    return false;
+  }
+
+  SerializeToString serialize_to_string(sample);
+  Benchmark("Serialize to string", data.size(), &serialize_to_string);
+  SerializeToArray serialize_to_array(sample);
+  Benchmark("Serialize to array", data.size(), &serialize_to_array);
+  ParseFromString parse_from_string(prototype, data);
+  Benchmark("Deserialize from string", data.size(), &parse_from_string);
+  ParseReusingMessage parse_reusing_message(prototype, data);
+  Benchmark("Deserialize reusing message", data.size(),
+            &parse_reusing_message);
+  printf("\n");
+
+  delete sample;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  if (argc < 3 || (argc - 1) % 2 != 0) {
+    fprintf(stderr,
+            "Usage: %s <message type name> <input data>\n"
+            "The message type name is the fully-qualified message name,\n"
+            "e.g. benchmarks.SpeedMessage1\n"
+            "(You can specify multiple pairs of message type name and input "
+            "data.)\n", argv[0]);
+    return 1;
+  }
+  bool success = true;
+  for (int i = 1; i < argc; i += 2) {
+    success &= RunTest(argv[i], argv[i + 1]);
+  }
+  return success ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures reading singular fields of many messages through reflection, as a
+// generic exporter that writes each field out as a column does: once with
+// the Reflection::Get*() methods, and once with a FieldAccessor obtained per
+// field before the loop.  The messages are FieldDescriptorProtos, both as
+// generated messages and as DynamicMessages.
+
+#include <stdio.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/reflection.h>
+#include <google/protobuf/stubs/common.h>
+
+using google::protobuf::Descriptor;
+using google::protobuf::DynamicMessageFactory;
+using google::protobuf::FieldAccessor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FieldDescriptorProto;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+using google::protobuf::int32;
+using std::string;
+using std::vector;
+
+namespace {
+
+const int kNumMessages = 10000;
+const int kRounds = 200;
+
+// The columns: one int32, one enum and one string field.
+struct Columns {
+  vector<int32> number;
+  vector<int32> label;
+  vector<string::size_type> name_size;
+};
+
+void ExportWithReflection(const vector<Message*>& messages,
+                          const FieldDescriptor* number,
+                          const FieldDescriptor* label,
+                          const FieldDescriptor* name, Columns* columns) {
+  string scratch;
+  for (int i = 0; i < messages.size(); i++) {
+    const Message& message = *messages[i];
+    const Reflection* reflection = message.GetReflection();
+    columns->number.push_back(
+        reflection->HasField(message, number) ?
+        reflection->GetInt32(message, number) : -1);
+    columns->label.push_back(reflection->GetEnumValue(message, label));
+    columns->name_size.push_back(
+        reflection->GetStringReference(message, name, &scratch).size());
+  }
+}
+
+void ExportWithAccessors(const vector<Message*>& messages,
+                         const FieldDescriptor* number,
+                         const FieldDescriptor* label,
+                         const FieldDescriptor* name, Columns* columns) {
+  const Reflection* reflection = messages[0]->GetReflection();
+  FieldAccessor<int32> number_accessor =
+      reflection->GetAccessor<int32>(number);
+  FieldAccessor<int32> label_accessor = reflection->GetAccessor<int32>(label);
+  FieldAccessor<string> name_accessor = reflection->GetAccessor<string>(name);
+  string scratch;
+  for (int i = 0; i < messages.size(); i++) {
+    const Message& message = *messages[i];
+    columns->number.push_back(
+        number_accessor.Has(message) ? number_accessor.Get(message) : -1);
+    columns->label.push_back(label_accessor.Get(message));
+    columns->name_size.push_back(
+        name_accessor.GetReference(message, &scratch).size());
+  }
+}
+
+typedef void ExportFunction(const vector<Message*>& messages,
+                            const FieldDescriptor* number,
+                            const FieldDescriptor* label,
+                            const FieldDescriptor* name, Columns* columns);
+
+void Benchmark(const char* name, ExportFunction* export_function,
+               const vector<Message*>& messages) {
+  const Descriptor* descriptor = messages[0]->GetDescriptor();
+  const FieldDescriptor* number = descriptor->FindFieldByName("number");
+  const FieldDescriptor* label = descriptor->FindFieldByName("label");
+  const FieldDescriptor* field_name = descriptor->FindFieldByName("name");
+
+  long checksum = 0;
+  clock_t start = clock();
+  for (int round = 0; round < kRounds; round++) {
+    Columns columns;
+    columns.number.reserve(messages.size());
+    columns.label.reserve(messages.size());
+    columns.name_size.reserve(messages.size());
+    export_function(messages, number, label, field_name, &columns);
+    checksum += columns.number.back() + columns.label.back() +
+        columns.name_size.back();
+  }
+  double elapsed = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  printf("%-32s %6.2fns per message (checksum %ld)\n", name,
+         elapsed * 1e9 / (static_cast<double>(kRounds) * messages.size()),
+         checksum);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  vector<Message*> generated;
+  for (int i = 0; i < kNumMessages; i++) {
+    FieldDescriptorProto* field = new FieldDescriptorProto;
+    field->set_name("field_" + string(i % 20, 'x'));
+    if (i % 3 != 0) field->set_number(i);
+    field->set_label(i % 2 == 0 ? FieldDescriptorProto::LABEL_OPTIONAL
+                                : FieldDescriptorProto::LABEL_REPEATED);
+    generated.push_back(field);
+  }
+
+  DynamicMessageFactory factory;
+  const Message* prototype =
+      factory.GetPrototype(FieldDescriptorProto::descriptor());
+  vector<Message*> dynamic;
+  for (int i = 0; i < generated.size(); i++) {
+    Message* message = prototype->New();
+    message->ParseFromString(generated[i]->SerializeAsString());
+    dynamic.push_back(message);
+  }
+
+  Benchmark("Generated, Reflection::Get*()", &ExportWithReflection,
+            generated);
+  Benchmark("Generated, FieldAccessor", &ExportWithAccessors, generated);
+  Benchmark("Dynamic, Reflection::Get*()", &ExportWithReflection, dynamic);
+  Benchmark("Dynamic, FieldAccessor", &ExportWithAccessors, dynamic);
+
+  for (int i = 0; i < generated.size(); i++) {
+    delete generated[i];
+    delete dynamic[i];
+  }
+  return 0;
+}
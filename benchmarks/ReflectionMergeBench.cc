@@ -0,0 +1,199 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures CopyFrom() between a generated message and a DynamicMessage of
+// the same type, which goes through ReflectionOps, next to a copy of the
+// ListFields()-based Clear() and Merge() that ReflectionOps used before it
+// cached merge plans.  The messages are FieldDescriptorProtos (mostly
+// scalars) and descriptor.proto's own FileDescriptorProto (mostly strings
+// and sub-messages).
+
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/unknown_field_set.h>
+#include <google/protobuf/stubs/common.h>
+
+using google::protobuf::Descriptor;
+using google::protobuf::DynamicMessageFactory;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FieldDescriptorProto;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+using std::vector;
+
+namespace {
+
+const int kRounds = 20000;
+
+void MergeWithListFields(const Message& from, Message* to);
+
+// DynamicMessage::Clear() used to clear each field ListFields() returned.
+void CopyToDynamicWithListFields(const Message& from, Message* to) {
+  const Reflection* reflection = to->GetReflection();
+  vector<const FieldDescriptor*> fields;
+  reflection->ListFields(*to, &fields);
+  for (int i = 0; i < fields.size(); i++) {
+    reflection->ClearField(to, fields[i]);
+  }
+  reflection->MutableUnknownFields(to)->Clear();
+  MergeWithListFields(from, to);
+}
+
+void CopyToGeneratedWithListFields(const Message& from, Message* to) {
+  to->Clear();
+  MergeWithListFields(from, to);
+}
+
+void MergeWithListFields(const Message& from, Message* to) {
+  const Reflection* from_reflection = from.GetReflection();
+  const Reflection* to_reflection = to->GetReflection();
+  vector<const FieldDescriptor*> fields;
+  from_reflection->ListFields(from, &fields);
+  for (int i = 0; i < fields.size(); i++) {
+    const FieldDescriptor* field = fields[i];
+    if (field->is_repeated()) {
+      int count = from_reflection->FieldSize(from, field);
+      for (int j = 0; j < count; j++) {
+        switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                                     \
+          case FieldDescriptor::CPPTYPE_##CPPTYPE:                       \
+            to_reflection->Add##METHOD(to, field,                        \
+              from_reflection->GetRepeated##METHOD(from, field, j));     \
+            break;
+
+          HANDLE_TYPE(INT32 , Int32 );
+          HANDLE_TYPE(INT64 , Int64 );
+          HANDLE_TYPE(UINT32, UInt32);
+          HANDLE_TYPE(UINT64, UInt64);
+          HANDLE_TYPE(FLOAT , Float );
+          HANDLE_TYPE(DOUBLE, Double);
+          HANDLE_TYPE(BOOL  , Bool  );
+          HANDLE_TYPE(STRING, String);
+          HANDLE_TYPE(ENUM  , Enum  );
+#undef HANDLE_TYPE
+
+          case FieldDescriptor::CPPTYPE_MESSAGE:
+            MergeWithListFields(
+                from_reflection->GetRepeatedMessage(from, field, j),
+                to_reflection->AddMessage(to, field));
+            break;
+        }
+      }
+    } else {
+      switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                                     \
+        case FieldDescriptor::CPPTYPE_##CPPTYPE:                         \
+          to_reflection->Set##METHOD(to, field,                          \
+            from_reflection->Get##METHOD(from, field));                  \
+          break;
+
+        HANDLE_TYPE(INT32 , Int32 );
+        HANDLE_TYPE(INT64 , Int64 );
+        HANDLE_TYPE(UINT32, UInt32);
+        HANDLE_TYPE(UINT64, UInt64);
+        HANDLE_TYPE(FLOAT , Float );
+        HANDLE_TYPE(DOUBLE, Double);
+        HANDLE_TYPE(BOOL  , Bool  );
+        HANDLE_TYPE(STRING, String);
+        HANDLE_TYPE(ENUM  , Enum  );
+#undef HANDLE_TYPE
+
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+          MergeWithListFields(from_reflection->GetMessage(from, field),
+                              to_reflection->MutableMessage(to, field));
+          break;
+      }
+    }
+  }
+}
+
+void CopyWithCopyFrom(const Message& from, Message* to) {
+  to->CopyFrom(from);
+}
+
+void Benchmark(const char* name,
+               void (*copy_function)(const Message&, Message*),
+               const Message& from, Message* to) {
+  clock_t start = clock();
+  for (int round = 0; round < kRounds; round++) {
+    copy_function(from, to);
+  }
+  double elapsed = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+  GOOGLE_CHECK_EQ(from.SerializeAsString(), to->SerializeAsString());
+  printf("%-44s %8.3fus per copy\n", name, elapsed * 1e6 / kRounds);
+}
+
+void BenchmarkType(const char* type_name, const Message& generated) {
+  DynamicMessageFactory factory;
+  const Descriptor* descriptor = generated.GetDescriptor();
+  Message* dynamic = factory.GetPrototype(descriptor)->New();
+  dynamic->CopyFrom(generated);
+  Message* generated_copy = generated.New();
+
+  printf("%s\n", type_name);
+  Benchmark("  Generated to dynamic, ListFields() merge",
+            &CopyToDynamicWithListFields, generated, dynamic);
+  Benchmark("  Generated to dynamic, CopyFrom()",
+            &CopyWithCopyFrom, generated, dynamic);
+  Benchmark("  Dynamic to generated, ListFields() merge",
+            &CopyToGeneratedWithListFields, *dynamic, generated_copy);
+  Benchmark("  Dynamic to generated, CopyFrom()",
+            &CopyWithCopyFrom, *dynamic, generated_copy);
+
+  delete generated_copy;
+  delete dynamic;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  FieldDescriptorProto field;
+  field.set_name("field_name");
+  field.set_number(17);
+  field.set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+  field.set_type(FieldDescriptorProto::TYPE_INT64);
+  field.set_default_value("42");
+  field.set_oneof_index(0);
+  BenchmarkType("FieldDescriptorProto", field);
+
+  FileDescriptorProto file;
+  FileDescriptorProto::descriptor()->file()->CopyTo(&file);
+  BenchmarkType("FileDescriptorProto of descriptor.proto", file);
+  return 0;
+}
@@ -0,0 +1,90 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The thread harness shared by the benchmarks which call a function from
+// several threads at once.
+
+#ifndef PROTOBUF_BENCHMARKS_THREAD_BENCH_H__
+#define PROTOBUF_BENCHMARKS_THREAD_BENCH_H__
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace thread_bench {
+
+// How many times each thread calls the function under test.
+const int kCallsPerThread = 2000000;
+
+inline double Now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Runs |function| in |num_threads| threads at once and prints the time per
+// call and the number of calls per second over all threads.  |function|
+// should make kCallsPerThread calls.
+inline void Benchmark(const char* name, void* (*function)(void*),
+                      int num_threads) {
+  std::vector<pthread_t> threads(num_threads);
+  double start = Now();
+  for (int i = 0; i < num_threads; i++) {
+    pthread_create(&threads[i], NULL, function, NULL);
+  }
+  for (int i = 0; i < num_threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  double elapsed = Now() - start;
+  printf("%-28s %2d threads: %7.2fns per call, %6.1fM calls/s\n", name,
+         num_threads, elapsed * 1e9 / kCallsPerThread,
+         num_threads * kCallsPerThread / elapsed / 1e6);
+}
+
+// Returns the maximum number of threads given on the command line, which
+// defaults to 8, or 0 after printing the usage if the arguments are bad.
+// Also prints how many CPUs are online, since the results only show
+// contention if the threads really run in parallel.
+inline int ParseMaxThreads(int argc, char* argv[]) {
+  int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+  if (argc > 2 || max_threads < 1) {
+    fprintf(stderr, "Usage: %s [maximum number of threads]\n", argv[0]);
+    return 0;
+  }
+  printf("%ld CPUs online\n", sysconf(_SC_NPROCESSORS_ONLN));
+  return max_threads;
+}
+
+}  // namespace thread_bench
+
+#endif  // PROTOBUF_BENCHMARKS_THREAD_BENCH_H__
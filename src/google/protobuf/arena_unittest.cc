@@ -38,6 +38,7 @@
 #endif
 #include <string>
 #include <vector>
+#include <utility>
 
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/test_util.h>
@@ -324,6 +325,37 @@ TEST(ArenaTest, SwapBetweenArenaAndNonArenaWithAllFieldsSet) {
   }
 }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+TEST(ArenaTest, MoveBetweenArenas) {
+  Arena arena1;
+  TestAllTypes* arena1_message = Arena::CreateMessage<TestAllTypes>(&arena1);
+  {
+    Arena arena2;
+    TestAllTypes* arena2_message = Arena::CreateMessage<TestAllTypes>(&arena2);
+    TestUtil::SetAllFields(arena2_message);
+    *arena1_message = std::move(*arena2_message);
+  }
+  // The fields were copied, since arena2 owned them.
+  TestUtil::ExpectAllFieldsSet(*arena1_message);
+
+  TestAllTypes non_arena_message(std::move(*arena1_message));
+  TestUtil::ExpectAllFieldsSet(non_arena_message);
+  TestUtil::ExpectAllFieldsSet(*arena1_message);
+}
+
+TEST(ArenaTest, MoveRepeatedFieldOnArena) {
+  Arena arena;
+  RepeatedPtrField<string>* field =
+      Arena::CreateMessage<RepeatedPtrField<string> >(&arena);
+  field->Add()->assign("1");
+
+  RepeatedPtrField<string> non_arena_field(std::move(*field));
+  ASSERT_EQ(1, non_arena_field.size());
+  EXPECT_EQ("1", non_arena_field.Get(0));
+  EXPECT_EQ(1, field->size());
+}
+#endif  // GOOGLE_PROTOBUF_CXX11
+
 TEST(ArenaTest, UnsafeArenaSwap) {
   Arena shared_arena;
   TestAllTypes* message1 = Arena::CreateMessage<TestAllTypes>(&shared_arena);
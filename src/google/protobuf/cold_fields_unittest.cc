@@ -0,0 +1,235 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// Tests for messages generated with the field_usage_profile option, which
+// moves the fields the profile never saw used into a lazily allocated struct
+// of cold fields.  The messages in unittest_cold_fields.proto are
+// wire-compatible with those in unittest.proto, so most tests check that the
+// cold fields behave exactly like ordinary ones.
+
+#include <string>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/text_format.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/unittest_cold_fields.pb.h>
+#include <google/protobuf/stubs/common.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using protobuf_unittest_cold_fields::TestAllTypes;
+using protobuf_unittest_cold_fields::TestRequiredForeign;
+
+string AllFieldsData() {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  return message.SerializeAsString();
+}
+
+// Copies |from| into |to|, which has a different type with the same field
+// names, without using either type's parser.
+void CopyThroughTextFormat(const Message& from, Message* to) {
+  string text;
+  ASSERT_TRUE(TextFormat::PrintToString(from, &text));
+  ASSERT_TRUE(TextFormat::ParseFromString(text, to));
+}
+
+TEST(ColdFieldsTest, SmallerThanAllHot) {
+  // All but a few singular fields of TestAllTypes are cold, so only a pointer
+  // is left in their place.
+  EXPECT_LT(sizeof(TestAllTypes), sizeof(unittest::TestAllTypes));
+}
+
+TEST(ColdFieldsTest, DefaultValues) {
+  TestAllTypes message;
+  EXPECT_FALSE(message.has_default_int32());
+  EXPECT_EQ(41, message.default_int32());
+  EXPECT_EQ("hello", message.default_string());
+  EXPECT_EQ("world", message.default_bytes());
+  EXPECT_EQ(TestAllTypes::BAR, message.default_nested_enum());
+  EXPECT_FALSE(message.has_optional_foreign_message());
+  EXPECT_EQ(&unittest::ForeignMessage::default_instance(),
+            &message.optional_foreign_message());
+  EXPECT_EQ("", message.SerializeAsString());
+}
+
+TEST(ColdFieldsTest, Accessors) {
+  TestAllTypes message;
+  message.set_optional_int64(101);
+  message.set_default_string("abc");
+  message.set_optional_nested_enum(TestAllTypes::BAZ);
+  message.mutable_optional_foreign_message()->set_c(5);
+  EXPECT_TRUE(message.has_optional_int64());
+  EXPECT_EQ(101, message.optional_int64());
+  EXPECT_EQ("abc", message.default_string());
+  EXPECT_EQ(TestAllTypes::BAZ, message.optional_nested_enum());
+  EXPECT_EQ(5, message.optional_foreign_message().c());
+
+  message.clear_default_string();
+  EXPECT_FALSE(message.has_default_string());
+  EXPECT_EQ("hello", message.default_string());
+  EXPECT_EQ("hello", TestAllTypes::default_instance().default_string());
+
+  unittest::ForeignMessage* foreign =
+      message.release_optional_foreign_message();
+  ASSERT_TRUE(foreign != NULL);
+  EXPECT_EQ(5, foreign->c());
+  EXPECT_FALSE(message.has_optional_foreign_message());
+  message.set_allocated_optional_foreign_message(foreign);
+  EXPECT_TRUE(message.has_optional_foreign_message());
+  EXPECT_EQ(foreign, &message.optional_foreign_message());
+
+  // Releasing from a message whose cold fields were never allocated.
+  TestAllTypes empty;
+  EXPECT_TRUE(empty.release_optional_foreign_message() == NULL);
+  EXPECT_TRUE(empty.release_optional_bytes() == NULL);
+}
+
+TEST(ColdFieldsTest, Serialization) {
+  string data = AllFieldsData();
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(data.size(), message.ByteSize());
+  EXPECT_EQ(data, message.SerializeAsString());
+
+  unittest::TestAllTypes reference;
+  ASSERT_TRUE(reference.ParseFromString(message.SerializeAsString()));
+  TestUtil::ExpectAllFieldsSet(reference);
+
+  // Only hot fields set.
+  TestAllTypes hot;
+  hot.set_optional_int32(1);
+  hot.set_optional_string("x");
+  reference.Clear();
+  ASSERT_TRUE(reference.ParseFromString(hot.SerializeAsString()));
+  EXPECT_EQ(1, reference.optional_int32());
+  EXPECT_EQ("x", reference.optional_string());
+  EXPECT_FALSE(reference.has_optional_int64());
+}
+
+TEST(ColdFieldsTest, Clear) {
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(AllFieldsData()));
+  message.Clear();
+  EXPECT_EQ(0, message.ByteSize());
+  EXPECT_FALSE(message.has_optional_int64());
+  EXPECT_EQ(0, message.optional_int64());
+  EXPECT_FALSE(message.has_default_string());
+  EXPECT_EQ("hello", message.default_string());
+  EXPECT_FALSE(message.has_optional_foreign_message());
+  EXPECT_FALSE(message.optional_foreign_message().has_c());
+
+  // The cleared message can be filled in again.
+  ASSERT_TRUE(message.ParseFromString(AllFieldsData()));
+  EXPECT_EQ(AllFieldsData(), message.SerializeAsString());
+}
+
+TEST(ColdFieldsTest, Swap) {
+  string data = AllFieldsData();
+  TestAllTypes message1;
+  TestAllTypes message2;
+  ASSERT_TRUE(message1.ParseFromString(data));
+  message2.set_optional_int32(7);
+
+  message1.Swap(&message2);
+  EXPECT_EQ(data, message2.SerializeAsString());
+  EXPECT_EQ(7, message1.optional_int32());
+  EXPECT_FALSE(message1.has_optional_int64());
+  EXPECT_EQ("hello", message1.default_string());
+
+  message1.Swap(&message2);
+  EXPECT_EQ(data, message1.SerializeAsString());
+  EXPECT_EQ(7, message2.optional_int32());
+}
+
+TEST(ColdFieldsTest, CopyAndMerge) {
+  string data = AllFieldsData();
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+
+  TestAllTypes copy(message);
+  EXPECT_EQ(data, copy.SerializeAsString());
+
+  unittest::TestAllTypes reference;
+  ASSERT_TRUE(reference.ParseFromString(data));
+  unittest::TestAllTypes other(reference);
+  reference.MergeFrom(other);
+  copy.MergeFrom(message);
+  EXPECT_EQ(reference.SerializeAsString(), copy.SerializeAsString());
+}
+
+TEST(ColdFieldsTest, Reflection) {
+  unittest::TestAllTypes reference;
+  TestUtil::SetAllFields(&reference);
+  TestAllTypes message;
+  CopyThroughTextFormat(reference, &message);
+  EXPECT_EQ(reference.SerializeAsString(), message.SerializeAsString());
+
+  // Reflection reads the defaults of a message whose cold fields were never
+  // allocated from the default instance.
+  TestAllTypes empty;
+  string text;
+  ASSERT_TRUE(TextFormat::PrintToString(empty, &text));
+  EXPECT_EQ("", text);
+  EXPECT_EQ(sizeof(TestAllTypes), empty.SpaceUsed());
+  const Reflection* reflection = empty.GetReflection();
+  const FieldDescriptor* default_string =
+      empty.GetDescriptor()->FindFieldByName("default_string");
+  EXPECT_EQ("hello", reflection->GetString(empty, default_string));
+
+  reflection->SetString(&empty, default_string, "abc");
+  EXPECT_EQ("abc", empty.default_string());
+  reflection->ClearField(&empty, default_string);
+  EXPECT_EQ("hello", empty.default_string());
+
+  TestAllTypes swapped;
+  ASSERT_TRUE(swapped.ParseFromString(reference.SerializeAsString()));
+  reflection->Swap(&empty, &swapped);
+  EXPECT_EQ(reference.SerializeAsString(), empty.SerializeAsString());
+  EXPECT_EQ("", swapped.SerializeAsString());
+}
+
+TEST(ColdFieldsTest, IsInitialized) {
+  TestRequiredForeign message;
+  message.set_dummy(1);
+  EXPECT_TRUE(message.IsInitialized());
+  message.mutable_optional_message()->set_a(1);
+  EXPECT_FALSE(message.IsInitialized());
+  message.mutable_optional_message()->set_b(2);
+  EXPECT_TRUE(message.IsInitialized());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
@@ -34,6 +34,7 @@
 
 #include <set>
 #include <map>
+#include <vector>
 
 #include <google/protobuf/compiler/cpp/cpp_enum.h>
 #include <google/protobuf/compiler/cpp/cpp_helpers.h>
@@ -58,6 +59,29 @@ bool ShouldGenerateArraySize(const EnumDescriptor* descriptor) {
   }
   return max_value != kint32max;
 }
+
+// Prints the items of an array initializer, as many to a line as fit.
+void PrintInitializerList(const vector<string>& items, io::Printer* printer) {
+  // Leaves room for the indentation of a function body plus one level.
+  static const int kMaxLineLength = 76;
+  printer->Indent();
+  int line_length = 0;
+  for (int i = 0; i < items.size(); i++) {
+    int item_length = items[i].size() + 1;  // Plus the comma.
+    if (line_length > 0 && line_length + 1 + item_length > kMaxLineLength) {
+      printer->Print("\n");
+      line_length = 0;
+    }
+    if (line_length > 0) {
+      printer->Print(" ");
+      line_length++;
+    }
+    printer->Print("$item$,", "item", items[i]);
+    line_length += item_length;
+  }
+  printer->Print("\n");
+  printer->Outdent();
+}
 }  // namespace
 
 EnumGenerator::EnumGenerator(const EnumDescriptor* descriptor,
@@ -236,32 +260,84 @@ void EnumGenerator::GenerateMethods(io::Printer* printer) {
       "}\n");
   }
 
-  printer->Print(vars,
-    "bool $classname$_IsValid(int value) {\n"
-    "  switch(value) {\n");
-
   // Multiple values may have the same number.  Make sure we only cover
   // each number once by first constructing a set containing all valid
-  // numbers, then printing a case statement for each element.
-
+  // numbers.
   set<int> numbers;
   for (int j = 0; j < descriptor_->value_count(); j++) {
     const EnumValueDescriptor* value = descriptor_->value(j);
     numbers.insert(value->number());
   }
+  int min_number = *numbers.begin();
+  int max_number = *numbers.rbegin();
+  // The number of integers from min_number to max_number; may not fit in an
+  // int32.
+  uint64 range =
+      static_cast<uint64>(static_cast<int64>(max_number) - min_number) + 1;
 
-  for (set<int>::iterator iter = numbers.begin();
-       iter != numbers.end(); ++iter) {
+  printer->Print(vars,
+    "bool $classname$_IsValid(int value) {\n");
+  printer->Indent();
+
+  // IsValid() is called for every enum value parsed, so avoid a multi-way
+  // branch.  Contiguous values only need a range check.  Otherwise, use a
+  // bitmap over the range if it is no bigger than a sorted array of the
+  // values would be, and binary search that array if not.
+  if (range == numbers.size()) {
+    printer->Print(
+      "return $min$ <= value && value <= $max$;\n",
+      "min", Int32ToString(min_number),
+      "max", Int32ToString(max_number));
+  } else if ((range + 31) / 32 <= numbers.size()) {
+    vector<uint32> words((range + 31) / 32, 0);
+    for (set<int>::iterator iter = numbers.begin();
+         iter != numbers.end(); ++iter) {
+      uint32 offset = static_cast<uint32>(*iter) -
+                      static_cast<uint32>(min_number);
+      words[offset / 32] |= 1u << (offset % 32);
+    }
+    vector<string> items;
+    for (int i = 0; i < words.size(); i++) {
+      char buffer[kFastToBufferSize];
+      items.push_back(string("0x") + FastHex32ToBuffer(words[i], buffer) + "u");
+    }
+    printer->Print(
+      "static const ::google::protobuf::uint32 kValidBits[] = {\n");
+    PrintInitializerList(items, printer);
+    printer->Print("};\n");
+
+    if (min_number == 0) {
+      printer->Print(
+        "::google::protobuf::uint32 offset =\n"
+        "    static_cast< ::google::protobuf::uint32>(value);\n");
+    } else {
+      printer->Print(
+        "::google::protobuf::uint32 offset =\n"
+        "    static_cast< ::google::protobuf::uint32>(value) -\n"
+        "    static_cast< ::google::protobuf::uint32>($min$);\n",
+        "min", Int32ToString(min_number));
+    }
     printer->Print(
-      "    case $number$:\n",
-      "number", Int32ToString(*iter));
+      "return offset < $range$u &&\n"
+      "       (kValidBits[offset / 32] & (1u << (offset % 32))) != 0;\n",
+      "range", SimpleItoa(range));
+  } else {
+    vector<string> items;
+    for (set<int>::iterator iter = numbers.begin();
+         iter != numbers.end(); ++iter) {
+      items.push_back(Int32ToString(*iter));
+    }
+    printer->Print("static const int kValidValues[] = {\n");
+    PrintInitializerList(items, printer);
+    printer->Print(
+      "};\n"
+      "return ::google::protobuf::internal::SortedArrayContains(\n"
+      "    kValidValues, $count$, value);\n",
+      "count", SimpleItoa(numbers.size()));
   }
 
-  printer->Print(vars,
-    "      return true;\n"
-    "    default:\n"
-    "      return false;\n"
-    "  }\n"
+  printer->Outdent();
+  printer->Print(
     "}\n"
     "\n");
 
@@ -223,6 +223,45 @@ GenerateConstructorCode(io::Printer* printer) const {
 
 // ===================================================================
 
+EnumColdFieldGenerator::
+EnumColdFieldGenerator(const FieldDescriptor* descriptor,
+                       const Options& options)
+  : EnumFieldGenerator(descriptor, options) {
+}
+
+EnumColdFieldGenerator::~EnumColdFieldGenerator() {}
+
+void EnumColdFieldGenerator::
+GenerateInlineAccessorDefinitions(io::Printer* printer) const {
+  printer->Print(variables_,
+    "inline $type$ $classname$::$name$() const {\n"
+    "  // @@protoc_insertion_point(field_get:$full_name$)\n"
+    "  return static_cast< $type$ >(cold().$name$_);\n"
+    "}\n"
+    "inline void $classname$::set_$name$($type$ value) {\n");
+  if (!HasPreservingUnknownEnumSemantics(descriptor_->file())) {
+    printer->Print(variables_,
+    "  assert($type$_IsValid(value));\n");
+  }
+  printer->Print(variables_,
+    "  $set_hasbit$\n"
+    "  mutable_cold()->$name$_ = value;\n"
+    "  // @@protoc_insertion_point(field_set:$full_name$)\n"
+    "}\n");
+}
+
+void EnumColdFieldGenerator::
+GenerateClearingCode(io::Printer* printer) const {
+  printer->Print(variables_, "_cold_->$name$_ = $default$;\n");
+}
+
+void EnumColdFieldGenerator::
+GenerateSwappingCode(io::Printer* printer) const {
+  // Don't print any swapping code. Swapping _cold_ will swap this field.
+}
+
+// ===================================================================
+
 RepeatedEnumFieldGenerator::
 RepeatedEnumFieldGenerator(const FieldDescriptor* descriptor,
                            const Options& options)
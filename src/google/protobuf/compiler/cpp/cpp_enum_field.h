@@ -87,6 +87,22 @@ class EnumOneofFieldGenerator : public EnumFieldGenerator {
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(EnumOneofFieldGenerator);
 };
 
+// See PrimitiveColdFieldGenerator.
+class EnumColdFieldGenerator : public EnumFieldGenerator {
+ public:
+  explicit EnumColdFieldGenerator(const FieldDescriptor* descriptor,
+                                  const Options& options);
+  ~EnumColdFieldGenerator();
+
+  // implements FieldGenerator ---------------------------------------
+  void GenerateInlineAccessorDefinitions(io::Printer* printer) const;
+  void GenerateClearingCode(io::Printer* printer) const;
+  void GenerateSwappingCode(io::Printer* printer) const;
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(EnumColdFieldGenerator);
+};
+
 class RepeatedEnumFieldGenerator : public FieldGenerator {
  public:
   explicit RepeatedEnumFieldGenerator(const FieldDescriptor* descriptor,
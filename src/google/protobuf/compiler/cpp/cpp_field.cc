@@ -164,6 +164,21 @@ FieldGenerator* FieldGeneratorMap::MakeGenerator(const FieldDescriptor* field,
       default:
         return new PrimitiveOneofFieldGenerator(field, options);
     }
+  } else if (IsColdField(field, options)) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        return new MessageColdFieldGenerator(field, options);
+      case FieldDescriptor::CPPTYPE_STRING:
+        switch (field->options().ctype()) {
+          default:  // StringColdFieldGenerator handles unknown ctypes.
+          case FieldOptions::STRING:
+            return new StringColdFieldGenerator(field, options);
+        }
+      case FieldDescriptor::CPPTYPE_ENUM:
+        return new EnumColdFieldGenerator(field, options);
+      default:
+        return new PrimitiveColdFieldGenerator(field, options);
+    }
   } else {
     switch (field->cpp_type()) {
       case FieldDescriptor::CPPTYPE_MESSAGE:
@@ -445,14 +445,25 @@ void FileGenerator::GenerateSource(io::Printer* printer) {
     "// @@protoc_insertion_point(global_scope)\n");
 }
 
+void FileGenerator::GenerateLayoutReport(io::Printer* printer) {
+  printer->Print(
+    "# Estimated padding in the classes generated for $filename$, assuming\n"
+    "# 64-bit pointers.\n",
+    "filename", file_->name());
+  for (int i = 0; i < file_->message_type_count(); i++) {
+    message_generators_[i]->GenerateLayoutReport(printer);
+  }
+}
+
 void FileGenerator::GenerateBuildDescriptors(io::Printer* printer) {
   // AddDescriptors() is a file-level procedure which adds the encoded
   // FileDescriptorProto for this .proto file to the global DescriptorPool for
   // generated files (DescriptorPool::generated_pool()). It either runs at
-  // static initialization time (by default) or when default_instance() is
-  // called for the first time (in LITE_RUNTIME mode with
-  // GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER flag enabled). This procedure also
-  // constructs default instances and registers extensions.
+  // static initialization time (by default) or when default_instance() or
+  // descriptor() is called for the first time (with the
+  // GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER flag enabled and no extensions
+  // defined in the file). This procedure also constructs default instances
+  // and registers extensions.
   //
   // Its sibling, AssignDescriptors(), actually pulls the compiled
   // FileDescriptor from the DescriptorPool and uses it to populate all of
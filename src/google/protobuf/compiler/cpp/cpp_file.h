@@ -71,6 +71,8 @@ class FileGenerator {
 
   void GenerateHeader(io::Printer* printer);
   void GenerateSource(io::Printer* printer);
+  // Generates the report requested by Options::layout_report.
+  void GenerateLayoutReport(io::Printer* printer);
 
  private:
   // Generate the BuildDescriptors() procedure, which builds all descriptors
@@ -34,6 +34,10 @@
 
 #include <google/protobuf/compiler/cpp/cpp_generator.h>
 
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 #include <vector>
 #include <memory>
 #ifndef _SHARED_PTR_H
@@ -46,12 +50,72 @@
 #include <google/protobuf/io/printer.h>
 #include <google/protobuf/io/zero_copy_stream.h>
 #include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/stubs/strutil.h>
 
 namespace google {
 namespace protobuf {
 namespace compiler {
 namespace cpp {
 
+namespace {
+
+// Reads a field usage profile.  Each line holds the full name of a field and
+// the number of times it was used, separated by whitespace.  Blank lines and
+// lines starting with '#' are ignored.
+bool ReadFieldUsageProfile(const string& filename,
+                           map<string, int64>* use_counts, string* error) {
+  ifstream in(filename.c_str());
+  if (!in) {
+    *error = filename + ": Could not open field usage profile.";
+    return false;
+  }
+  string line;
+  for (int line_number = 1; getline(in, line); line_number++) {
+    istringstream fields(line);
+    string name;
+    int64 count;
+    if (!(fields >> name) || name[0] == '#') continue;
+    if (!(fields >> count) || count < 0) {
+      *error = filename + ":" + SimpleItoa(line_number) +
+               ": Expected a field name followed by a use count.";
+      return false;
+    }
+    (*use_counts)[name] += count;
+  }
+  return true;
+}
+
+// Adds to |cold_fields| the fields of |descriptor| and its nested types which
+// the profile never saw used, if it saw any other field of their message used.
+// Messages which do not appear in the profile at all are left alone.
+void CollectColdFields(const Descriptor* descriptor,
+                       const map<string, int64>& use_counts,
+                       set<string>* cold_fields) {
+  bool profiled = false;
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    if (use_counts.count(descriptor->field(i)->full_name()) > 0) {
+      profiled = true;
+      break;
+    }
+  }
+  if (profiled) {
+    for (int i = 0; i < descriptor->field_count(); i++) {
+      const FieldDescriptor* field = descriptor->field(i);
+      map<string, int64>::const_iterator it =
+          use_counts.find(field->full_name());
+      if ((it == use_counts.end() || it->second == 0) &&
+          CanBeColdField(field)) {
+        cold_fields->insert(field->full_name());
+      }
+    }
+  }
+  for (int i = 0; i < descriptor->nested_type_count(); i++) {
+    CollectColdFields(descriptor->nested_type(i), use_counts, cold_fields);
+  }
+}
+
+}  // namespace
+
 CppGenerator::CppGenerator() {}
 CppGenerator::~CppGenerator() {}
 
@@ -82,6 +146,31 @@ bool CppGenerator::Generate(const FileDescriptor* file,
   //   }
   // FOO_EXPORT is a macro which should expand to __declspec(dllexport) or
   // __declspec(dllimport) depending on what is being compiled.
+  //
+  // If the table_driven_parsing option is passed, generated messages describe
+  // their fields with tables which are interpreted by a parse loop shared by
+  // all messages (see generated_message_util.h), instead of each containing
+  // its own parsing code.  This makes the generated code much smaller.  The
+  // table_driven_serialization option does the same for serialization and
+  // ByteSize(), using the same tables.
+  //
+  // If the tag_dispatch_table option is passed, generated parsers look up
+  // each tag in a table to find the case which handles it, instead of
+  // switching on the field number and then checking the wire type.  This
+  // makes the generated code slightly larger.
+  //
+  // If the field_usage_profile option names a file listing how often fields
+  // were used (see ReadFieldUsageProfile()), the optional fields which were
+  // never used are moved out of their message into a struct which is only
+  // allocated when one of them is set.  Only messages which appear in the
+  // profile are changed.  This makes messages with many rarely used fields
+  // smaller and cheaper to construct and clear.
+  //
+  // Data members of generated classes are ordered to minimize padding.  If
+  // the layout_report option is passed, foo.pb.layout is also written, with
+  // the estimated padding in each class and how many bytes per instance the
+  // member order saves compared to the order earlier versions of the
+  // generator used.
   Options file_options;
 
   for (int i = 0; i < options.size(); i++) {
@@ -89,6 +178,23 @@ bool CppGenerator::Generate(const FileDescriptor* file,
       file_options.dllexport_decl = options[i].second;
     } else if (options[i].first == "safe_boundary_check") {
       file_options.safe_boundary_check = true;
+    } else if (options[i].first == "table_driven_parsing") {
+      file_options.table_driven_parsing = true;
+    } else if (options[i].first == "table_driven_serialization") {
+      file_options.table_driven_serialization = true;
+    } else if (options[i].first == "tag_dispatch_table") {
+      file_options.tag_dispatch_table = true;
+    } else if (options[i].first == "layout_report") {
+      file_options.layout_report = true;
+    } else if (options[i].first == "field_usage_profile") {
+      map<string, int64> use_counts;
+      if (!ReadFieldUsageProfile(options[i].second, &use_counts, error)) {
+        return false;
+      }
+      for (int j = 0; j < file->message_type_count(); j++) {
+        CollectColdFields(file->message_type(j), use_counts,
+                          &file_options.cold_fields);
+      }
     } else {
       *error = "Unknown generator option: " + options[i].first;
       return false;
@@ -119,6 +225,13 @@ bool CppGenerator::Generate(const FileDescriptor* file,
     file_generator.GenerateSource(&printer);
   }
 
+  if (file_options.layout_report) {
+    google::protobuf::scoped_ptr<io::ZeroCopyOutputStream> output(
+        generator_context->Open(basename + ".layout"));
+    io::Printer printer(output.get(), '$');
+    file_generator.GenerateLayoutReport(&printer);
+  }
+
   return true;
 }
 
@@ -409,7 +409,11 @@ string SafeFunctionName(const Descriptor* descriptor,
 }
 
 bool StaticInitializersForced(const FileDescriptor* file) {
-  if (HasDescriptorMethods(file) || file->extension_count() > 0) {
+  // Extensions must be registered before anything is parsed, so files that
+  // define them always run AddDescriptors() at static initialization time.
+  // Everything else, including descriptors and default instances, can be
+  // built the first time it is needed.
+  if (file->extension_count() > 0) {
     return true;
   }
   for (int i = 0; i < file->message_type_count(); ++i) {
@@ -508,6 +512,13 @@ bool IsStringOrMessage(const FieldDescriptor* field) {
   return false;
 }
 
+bool CanBeColdField(const FieldDescriptor* field) {
+  return field->is_optional() && !field->is_extension() &&
+         field->containing_oneof() == NULL && !field->options().weak() &&
+         HasFieldPresence(field->file()) && !SupportsArenas(field) &&
+         !IsMapEntryMessage(field->containing_type());
+}
+
 }  // namespace cpp
 }  // namespace compiler
 }  // namespace protobuf
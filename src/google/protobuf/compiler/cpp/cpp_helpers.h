@@ -37,6 +37,7 @@
 
 #include <map>
 #include <string>
+#include <google/protobuf/compiler/cpp/cpp_options.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
 
@@ -235,6 +236,18 @@ inline bool SupportsArenas(const FieldDescriptor* field) {
   return SupportsArenas(field->file());
 }
 
+// Can the field be moved into its message's struct of cold fields?  Only
+// singular, optional fields of messages with has-bits qualify, since a set
+// has-bit is what guarantees that the struct has been allocated.  Files which
+// support arenas are not supported.
+bool CanBeColdField(const FieldDescriptor* field);
+
+// Is the field kept in its message's struct of cold fields, which is only
+// allocated once one of them is set, rather than in the message itself?
+inline bool IsColdField(const FieldDescriptor* field, const Options& options) {
+  return options.cold_fields.count(field->full_name()) > 0;
+}
+
 }  // namespace cpp
 }  // namespace compiler
 }  // namespace protobuf
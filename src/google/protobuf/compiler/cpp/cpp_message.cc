@@ -280,6 +280,91 @@ void OptimizePadding(vector<const FieldDescriptor*>* fields) {
   }
 }
 
+// Like EstimateAlignmentSize(), for the union which holds a oneof's fields.
+int EstimateAlignmentSize(const OneofDescriptor* oneof) {
+  int alignment = 1;
+  for (int i = 0; i < oneof->field_count(); i++) {
+    alignment = max(alignment, EstimateAlignmentSize(oneof->field(i)));
+  }
+  return alignment;
+}
+
+// Size of _has_bits_ in bytes.
+size_t SizeOfHasBits(const Descriptor* descriptor) {
+  // TODO(jieluo) - Optimize _has_bits_ for repeated and oneof fields.
+  size_t sizeof_has_bits = (descriptor->field_count() + 31) / 32 * 4;
+  if (descriptor->field_count() == 0) {
+    // Zero-size arrays aren't technically allowed, and MSVC in particular
+    // doesn't like them.  We still need to declare these arrays to make
+    // other code compile.  Since this is an uncommon case, we'll just declare
+    // them with size 1 and waste some space.  Oh well.
+    sizeof_has_bits = 4;
+  }
+  return sizeof_has_bits;
+}
+
+}  // anonymous namespace
+
+// A data member of a generated class, with its estimated size and alignment.
+// Only the size modulo the alignment affects padding, so members which align
+// to 8 bytes (pointers, strings, repeated fields, ...) are all counted as 8
+// bytes.
+struct DataMember {
+  enum Kind {
+    EXTENSIONS,          // _extensions_
+    INTERNAL_METADATA,   // _internal_metadata_, or _unknown_fields_ and
+                         // _arena_ptr_
+    HAS_BITS,            // _has_bits_
+    CACHED_SIZE,         // _cached_size_
+    COLD_FIELDS,         // _cold_
+    FIELD,               // the member which holds |field|
+    ONEOF,               // the union which holds the fields of |oneof|
+    ONEOF_CASE,          // _oneof_case_
+    IS_DEFAULT_INSTANCE  // _is_default_instance_
+  };
+
+  DataMember(Kind kind, int size, int alignment)
+      : kind(kind), field(NULL), oneof(NULL), size(size),
+        alignment(alignment) {}
+  explicit DataMember(const FieldDescriptor* field)
+      : kind(FIELD), field(field), oneof(NULL),
+        size(EstimateAlignmentSize(field)),
+        alignment(EstimateAlignmentSize(field)) {}
+  explicit DataMember(const OneofDescriptor* oneof)
+      : kind(ONEOF), field(NULL), oneof(oneof),
+        size(EstimateAlignmentSize(oneof)),
+        alignment(EstimateAlignmentSize(oneof)) {}
+
+  Kind kind;
+  const FieldDescriptor* field;
+  const OneofDescriptor* oneof;
+  int size;
+  int alignment;
+};
+
+namespace {
+
+// Returns the number of bytes of padding the compiler adds between and after
+// 'members' when they follow the vtable pointer, with the same assumptions as
+// EstimateAlignmentSize().  Since padding is the only thing that changes when
+// members are reordered, this is also how much sizeof() changes.
+int EstimatePadding(const vector<DataMember>& members) {
+  int offset = 8;  // vtable pointer
+  int padding = 0;
+  for (int i = 0; i < members.size(); i++) {
+    int misalignment = offset % members[i].alignment;
+    if (misalignment != 0) {
+      padding += members[i].alignment - misalignment;
+      offset += members[i].alignment - misalignment;
+    }
+    offset += members[i].size;
+  }
+  if (offset % 8 != 0) {
+    padding += 8 - offset % 8;
+  }
+  return padding;
+}
+
 string MessageTypeProtoName(const FieldDescriptor* field) {
   return field->message_type()->full_name();
 }
@@ -368,6 +453,123 @@ bool HasPrivateHasMethod(const FieldDescriptor* field) {
           field->containing_oneof() != NULL);
 }
 
+// Is the given field described by the message's parse table when
+// table-driven parsing is used?  Oneof members, maps and cold fields need
+// their generated accessors to be parsed correctly, so they keep generated
+// parsing code.
+bool IsTableDrivenField(const FieldDescriptor* field, const Options& options) {
+  return field->containing_oneof() == NULL && !field->is_map() &&
+         !IsColdField(field, options);
+}
+
+// A field which is not in the message table, or an extension range.  When
+// table-driven serialization is used, these are serialized by generated code
+// which the table-driven serializer calls at the right points.
+struct UnusualItem {
+  const FieldDescriptor* field;              // NULL for extension ranges.
+  const Descriptor::ExtensionRange* range;
+
+  int number() const { return field != NULL ? field->number() : range->start; }
+  bool operator<(const UnusualItem& other) const {
+    return number() < other.number();
+  }
+};
+
+// Groups the message's UnusualItems by the number of the first table field
+// following them, or FieldDescriptor::kMaxNumber + 1 for those following the
+// last table field.  Each group is sorted by field number.
+map<int, vector<UnusualItem> > GroupUnusualItems(const Descriptor* descriptor,
+                                                 const Options& options) {
+  vector<int> table_numbers;
+  vector<UnusualItem> items;
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const FieldDescriptor* field = descriptor->field(i);
+    if (IsTableDrivenField(field, options)) {
+      table_numbers.push_back(field->number());
+    } else {
+      UnusualItem item = { field, NULL };
+      items.push_back(item);
+    }
+  }
+  for (int i = 0; i < descriptor->extension_range_count(); i++) {
+    UnusualItem item = { NULL, descriptor->extension_range(i) };
+    items.push_back(item);
+  }
+  sort(table_numbers.begin(), table_numbers.end());
+  sort(items.begin(), items.end());
+
+  map<int, vector<UnusualItem> > groups;
+  for (int i = 0; i < items.size(); i++) {
+    vector<int>::const_iterator next = upper_bound(
+        table_numbers.begin(), table_numbers.end(), items[i].number());
+    int end = next == table_numbers.end() ?
+        FieldDescriptor::kMaxNumber + 1 : *next;
+    groups[end].push_back(items[i]);
+  }
+  return groups;
+}
+
+// Returns the fields which are in the message table, in table order.
+vector<const FieldDescriptor*> TableFields(const Descriptor* descriptor,
+                                           const Options& options) {
+  google::protobuf::scoped_array<const FieldDescriptor * > ordered_fields(
+      SortFieldsByNumber(descriptor));
+  vector<const FieldDescriptor*> fields;
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    if (IsTableDrivenField(ordered_fields[i], options)) {
+      fields.push_back(ordered_fields[i]);
+    }
+  }
+  return fields;
+}
+
+// Computes MessageTable::field_by_has_bit and MessageTable::always_visit,
+// which let table-driven ByteSize() skip fields which are not set.
+void ComputeVisitOrder(const Descriptor* descriptor, const Options& options,
+                       vector<int>* field_by_has_bit,
+                       vector<int>* always_visit) {
+  vector<const FieldDescriptor*> table_fields =
+      TableFields(descriptor, options);
+  const bool has_field_presence = HasFieldPresence(descriptor->file());
+  if (has_field_presence) {
+    field_by_has_bit->assign(descriptor->field_count(), -1);
+  }
+  for (int i = 0; i < table_fields.size(); i++) {
+    const FieldDescriptor* field = table_fields[i];
+    if (field->is_repeated() || !has_field_presence) {
+      always_visit->push_back(i);
+    }
+    if (!field->is_repeated() && has_field_presence) {
+      (*field_by_has_bit)[field->index()] = i;
+    }
+  }
+}
+
+// Returns the tag of the encoding which a packable field was not declared
+// with, but which parsers must accept anyway: unpacked for packed fields and
+// vice versa.
+uint32 AlternateTag(const FieldDescriptor* field) {
+  WireFormatLite::WireType wiretype = field->options().packed() ?
+      WireFormat::WireTypeForFieldType(field->type()) :
+      WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+  return WireFormatLite::MakeTag(field->number(), wiretype);
+}
+
+// Prints the initializer of a static int array, wrapping long lines.
+void PrintArrayInitializer(io::Printer* printer, const vector<int>& values) {
+  string line;
+  for (int i = 0; i < values.size(); i++) {
+    string value = SimpleItoa(values[i]) + ",";
+    if (!line.empty() && line.size() + value.size() + 1 > 76) {
+      printer->Print("  $line$\n", "line", line);
+      line.clear();
+    }
+    if (!line.empty()) line += " ";
+    line += value;
+  }
+  if (!line.empty()) printer->Print("  $line$\n", "line", line);
+}
+
 }  // anonymous namespace
 
 // ===================================================================
@@ -405,7 +607,13 @@ MessageGenerator::MessageGenerator(const Descriptor* descriptor,
     if (descriptor->field(i)->is_required()) {
       ++num_required_fields_;
     }
+    if (IsColdField(descriptor->field(i), options)) {
+      cold_fields_.push_back(descriptor->field(i));
+    } else if (!descriptor->field(i)->containing_oneof()) {
+      optimized_order_.push_back(descriptor->field(i));
+    }
   }
+  OptimizePadding(&optimized_order_);
 }
 
 MessageGenerator::~MessageGenerator() {}
@@ -497,6 +705,28 @@ void MessageGenerator::
 GenerateFieldAccessorDefinitions(io::Printer* printer) {
   printer->Print("// $classname$\n\n", "classname", classname_);
 
+  if (!cold_fields_.empty()) {
+    map<string, string> vars;
+    vars["classname"] = classname_;
+    printer->Print(vars,
+      "inline const $classname$::ColdFields& $classname$::cold() const {\n");
+    PrintHandlingOptionalStaticInitializers(
+      vars, descriptor_->file(), printer,
+      // With static initializers.
+      "  return _cold_ != NULL ? *_cold_ : *default_instance_->_cold_;\n",
+      // Without.
+      "  return _cold_ != NULL ? *_cold_ : *default_instance()._cold_;\n");
+    printer->Print(vars,
+      "}\n"
+      "inline $classname$::ColdFields* $classname$::mutable_cold() {\n"
+      "  if (_cold_ == NULL) {\n"
+      "    _cold_ = new ColdFields;\n"
+      "  }\n"
+      "  return _cold_;\n"
+      "}\n"
+      "\n");
+  }
+
   for (int i = 0; i < descriptor_->field_count(); i++) {
     const FieldDescriptor* field = descriptor_->field(i);
 
@@ -585,6 +815,16 @@ GenerateFieldAccessorDefinitions(io::Printer* printer) {
         "clear_has_$oneof_name$();\n");
       printer->Outdent();
       printer->Print("}\n");
+    } else if (IsColdField(field, options_)) {
+      // A set cold field guarantees that _cold_ is allocated.
+      printer->Print(vars,
+        "if (has_$name$()) {\n");
+      printer->Indent();
+      field_generators_.get(field).GenerateClearingCode(printer);
+      printer->Print(vars,
+        "clear_has_$name$();\n");
+      printer->Outdent();
+      printer->Print("}\n");
     } else {
       field_generators_.get(field).GenerateClearingCode(printer);
       if (HasFieldPresence(descriptor_->file())) {
@@ -648,6 +888,32 @@ static bool CanClearByZeroing(const FieldDescriptor* field) {
   }
 }
 
+// True if the constructor sets 'field' to all zero bytes, so that runs of
+// such fields can be initialized with one memset.
+static bool IsZeroInitialized(const FieldDescriptor* field) {
+  return CanClearByZeroing(field) ||
+      (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE &&
+       !field->is_repeated());
+}
+
+// Has-bit words covering at least this many fields with has-bits are merged
+// and serialized by visiting only the bits which are set, which is cheaper
+// than testing each field when few of them are set.
+static const int kMinFieldsToIterateHasBits = 8;
+
+// The generated code uses two macros to help it zero runs of fields:
+// OFFSET_OF_FIELD_ computes the offset (in bytes) of a field in the Message.
+// ZR_ zeroes a non-empty range of fields via memset.
+static const char kZeroRangeMacros[] =
+    "#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \\\n"
+    "  &reinterpret_cast<$classname$*>(16)->f) - \\\n"
+    "   reinterpret_cast<char*>(16))\n\n"
+    "#define ZR_(first, last) do {                              \\\n"
+    "    size_t f = OFFSET_OF_FIELD_(first);                    \\\n"
+    "    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \\\n"
+    "    ::memset(&first, 0, n);                                \\\n"
+    "  } while (0)\n\n";
+
 void MessageGenerator::
 GenerateClassDefinition(io::Printer* printer) {
   for (int i = 0; i < descriptor_->nested_type_count(); i++) {
@@ -689,6 +955,33 @@ GenerateClassDefinition(io::Printer* printer) {
     "}\n"
     "\n");
 
+  // Moving swaps unless the messages are on different arenas.  A message
+  // built by the move constructor is never on an arena.
+  printer->Outdent();
+  printer->Print("#ifdef GOOGLE_PROTOBUF_CXX11\n");
+  printer->Indent();
+  printer->Print(vars,
+    "inline $classname$($classname$&& from)\n"
+    "  : $classname$() {\n"
+    "  if (from.GetArenaNoVirtual() == NULL) {\n"
+    "    InternalSwap(&from);\n"
+    "  } else {\n"
+    "    CopyFrom(from);\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "inline $classname$& operator=($classname$&& from) {\n"
+    "  if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {\n"
+    "    if (this != &from) InternalSwap(&from);\n"
+    "  } else {\n"
+    "    CopyFrom(from);\n"
+    "  }\n"
+    "  return *this;\n"
+    "}\n");
+  printer->Outdent();
+  printer->Print("#endif\n\n");
+  printer->Indent();
+
   if (PreserveUnknownFields(descriptor_)) {
     if (UseUnknownFieldSet(descriptor_->file())) {
       printer->Print(
@@ -764,19 +1057,17 @@ GenerateClassDefinition(io::Printer* printer) {
         "\n");
   }
 
-  if (!StaticInitializersForced(descriptor_->file())) {
-    printer->Print(vars,
-      "#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER\n"
-      "// Returns the internal default instance pointer. This function can\n"
-      "// return NULL thus should not be used by the user. This is intended\n"
-      "// for Protobuf internal code. Please use default_instance() declared\n"
-      "// above instead.\n"
-      "static inline const $classname$* internal_default_instance() {\n"
-      "  return default_instance_;\n"
-      "}\n"
-      "#endif\n"
-      "\n");
-  }
+  // Generated unconditionally: files built without static initializers use
+  // it to link default instances of types from any file they depend on.
+  printer->Print(vars,
+    "// Returns the internal default instance pointer. This function can\n"
+    "// return NULL thus should not be used by the user. This is intended\n"
+    "// for Protobuf internal code. Please use default_instance() declared\n"
+    "// above instead.\n"
+    "static inline const $classname$* internal_default_instance() {\n"
+    "  return default_instance_;\n"
+    "}\n"
+    "\n");
 
 
   if (SupportsArenas(descriptor_)) {
@@ -858,6 +1149,35 @@ GenerateClassDefinition(io::Printer* printer) {
     "void SetCachedSize(int size) const;\n"
     "void InternalSwap($classname$* other);\n",
     "classname", classname_);
+  if (UseMessageTable()) {
+    printer->Print("static void InitMessageTable();\n");
+  }
+  if (UseTableDrivenParsing()) {
+    printer->Print(
+      "static bool MergeUnusualField(\n"
+      "    ::google::protobuf::MessageLite* msg, ::google::protobuf::uint32 tag,\n"
+      "    ::google::protobuf::io::CodedInputStream* input);\n"
+      "bool MergeUnusualFieldFromCodedStream(\n"
+      "    ::google::protobuf::uint32 tag, ::google::protobuf::io::CodedInputStream* input);\n");
+  }
+  if (UseTableDrivenSerialization() && HasUnusualFields()) {
+    printer->Print(
+      "static void SerializeUnusualFields(\n"
+      "    const ::google::protobuf::MessageLite* msg, int end,\n"
+      "    ::google::protobuf::io::CodedOutputStream* output);\n"
+      "void SerializeUnusualFieldsWithCachedSizes(\n"
+      "    int end, ::google::protobuf::io::CodedOutputStream* output) const;\n");
+    if (HasFastArraySerialization(descriptor_->file())) {
+      printer->Print(
+        "static ::google::protobuf::uint8* SerializeUnusualFieldsToArray(\n"
+        "    const ::google::protobuf::MessageLite* msg, int end, ::google::protobuf::uint8* target);\n"
+        "::google::protobuf::uint8* SerializeUnusualFieldsWithCachedSizesToArray(\n"
+        "    int end, ::google::protobuf::uint8* target) const;\n");
+    }
+    printer->Print(
+      "static int UnusualFieldsByteSize(const ::google::protobuf::MessageLite* msg);\n"
+      "int ComputeUnusualFieldsByteSize() const;\n");
+  }
   if (SupportsArenas(descriptor_)) {
     printer->Print(
       "protected:\n"
@@ -983,161 +1303,140 @@ GenerateClassDefinition(io::Printer* printer) {
 
   if (HasGeneratedMethods(descriptor_->file()) &&
       !descriptor_->options().message_set_wire_format() &&
+      !UseTableDrivenSerialization() &&
       num_required_fields_ > 1) {
     printer->Print(
         "// helper for ByteSize()\n"
         "int RequiredFieldsByteSizeFallback() const;\n\n");
   }
 
-  // Prepare decls for _cached_size_ and _has_bits_.  Their position in the
-  // output will be determined later.
-
-  bool need_to_emit_cached_size = true;
-  // TODO(kenton):  Make _cached_size_ an atomic<int> when C++ supports it.
-  const string cached_size_decl = "mutable int _cached_size_;\n";
-
-  // TODO(jieluo) - Optimize _has_bits_ for repeated and oneof fields.
-  size_t sizeof_has_bits = (descriptor_->field_count() + 31) / 32 * 4;
-  if (descriptor_->field_count() == 0) {
-    // Zero-size arrays aren't technically allowed, and MSVC in particular
-    // doesn't like them.  We still need to declare these arrays to make
-    // other code compile.  Since this is an uncommon case, we'll just declare
-    // them with size 1 and waste some space.  Oh well.
-    sizeof_has_bits = 4;
-  }
-  const string has_bits_decl = sizeof_has_bits == 0 ? "" :
-      "::google::protobuf::uint32 _has_bits_[" + SimpleItoa(sizeof_has_bits / 4) + "];\n";
-
-
-  // To minimize padding, data members are divided into three sections:
-  // (1) members assumed to align to 8 bytes
-  // (2) members corresponding to message fields, re-ordered to optimize
-  //     alignment.
-  // (3) members assumed to align to 4 bytes.
-
-  // Members assumed to align to 8 bytes:
-
-  if (descriptor_->extension_range_count() > 0) {
-    printer->Print(
-      "::google::protobuf::internal::ExtensionSet _extensions_;\n"
-      "\n");
-  }
-
-  if (UseUnknownFieldSet(descriptor_->file())) {
-    printer->Print(
-      "::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;\n");
-  } else {
-    printer->Print(
-      "::std::string _unknown_fields_;\n"
-      "::google::protobuf::Arena* _arena_ptr_;\n"
-      "\n");
-  }
-
-  if (SupportsArenas(descriptor_)) {
-    printer->Print(
-      "friend class ::google::protobuf::Arena;\n"
-      "typedef void InternalArenaConstructable_;\n"
-      "typedef void DestructorSkippable_;\n");
-  }
-
-  if (HasFieldPresence(descriptor_->file())) {
-    // _has_bits_ is frequently accessed, so to reduce code size and improve
-    // speed, it should be close to the start of the object.  But, try not to
-    // waste space:_has_bits_ by itself always makes sense if its size is a
-    // multiple of 8, but, otherwise, maybe _has_bits_ and cached_size_ together
-    // will work well.
-    printer->Print(has_bits_decl.c_str());
-    if ((sizeof_has_bits % 8) != 0) {
-      printer->Print(cached_size_decl.c_str());
-      need_to_emit_cached_size = false;
-    }
-  } else {
-    // Without field presence, we need another way to disambiguate the default
-    // instance, because the default instance's submessage fields (if any) store
-    // pointers to the default instances of the submessages even when they
-    // aren't present. Alternatives to this approach might be to (i) use a
-    // tagged pointer on all message fields, setting a tag bit for "not really
-    // present, just default instance"; or (ii) comparing |this| against the
-    // return value from GeneratedMessageFactory::GetPrototype() in all
-    // has_$field$() calls. However, both of these options are much more
-    // expensive (in code size and CPU overhead) than just checking a field in
-    // the message. Long-term, the best solution would be to rearchitect the
-    // default instance design not to store pointers to submessage default
-    // instances, and have reflection get those some other way; but that change
-    // would have too much impact on proto2.
-    printer->Print(
-      "bool _is_default_instance_;\n");
-  }
-
-  // Field members:
-
-  // List fields which doesn't belong to any oneof
-  vector<const FieldDescriptor*> fields;
+  // Emit the data members, together with the declarations which go with
+  // them.  Runs of fields which can be cleared by zeroing are broken where
+  // the has-bit word changes, since Clear() only visits the words with bits
+  // set.
   hash_map<string, int> fieldname_to_chunk;
-  for (int i = 0; i < descriptor_->field_count(); i++) {
-    if (!descriptor_->field(i)->containing_oneof()) {
-      const FieldDescriptor* field = descriptor_->field(i);
-      fields.push_back(field);
-      fieldname_to_chunk[FieldName(field)] = i / 8;
-    }
+  for (int i = 0; i < optimized_order_.size(); ++i) {
+    fieldname_to_chunk[FieldName(optimized_order_[i])] =
+        optimized_order_[i]->index() / 32;
   }
-  OptimizePadding(&fields);
-  // Emit some private and static members
   runs_of_fields_ = vector< vector<string> >(1);
-  for (int i = 0; i < fields.size(); ++i) {
-    const FieldDescriptor* field = fields[i];
-    const FieldGenerator& generator = field_generators_.get(field);
-    generator.GenerateStaticMembers(printer);
-    generator.GeneratePrivateMembers(printer);
-    if (CanClearByZeroing(field)) {
-      const string& fieldname = FieldName(field);
-      if (!runs_of_fields_.back().empty() &&
-          (fieldname_to_chunk[runs_of_fields_.back().back()] !=
-           fieldname_to_chunk[fieldname])) {
-        runs_of_fields_.push_back(vector<string>());
-      }
-      runs_of_fields_.back().push_back(fieldname);
-    } else if (!runs_of_fields_.back().empty()) {
-      runs_of_fields_.push_back(vector<string>());
-    }
-  }
+  vector<DataMember> members;
+  OrderDataMembers(false, &members);
+  for (int i = 0; i < members.size(); i++) {
+    switch (members[i].kind) {
+      case DataMember::EXTENSIONS:
+        printer->Print(
+          "::google::protobuf::internal::ExtensionSet _extensions_;\n"
+          "\n");
+        break;
 
-  // For each oneof generate a union
-  for (int i = 0; i < descriptor_->oneof_decl_count(); i++) {
-    printer->Print(
-        "union $camel_oneof_name$Union {\n"
-        // explicit empty constructor is needed when union contains
-        // ArenaStringPtr members for string fields.
-        "  $camel_oneof_name$Union() {}\n",
-        "camel_oneof_name",
-        UnderscoresToCamelCase(descriptor_->oneof_decl(i)->name(), true));
-    printer->Indent();
-    for (int j = 0; j < descriptor_->oneof_decl(i)->field_count(); j++) {
-      field_generators_.get(descriptor_->oneof_decl(i)->
-                            field(j)).GeneratePrivateMembers(printer);
-    }
-    printer->Outdent();
-    printer->Print(
-        "} $oneof_name$_;\n",
-        "oneof_name", descriptor_->oneof_decl(i)->name());
-    for (int j = 0; j < descriptor_->oneof_decl(i)->field_count(); j++) {
-      field_generators_.get(descriptor_->oneof_decl(i)->
-                            field(j)).GenerateStaticMembers(printer);
-    }
-  }
+      case DataMember::INTERNAL_METADATA:
+        if (UseUnknownFieldSet(descriptor_->file())) {
+          printer->Print(
+            "::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;\n");
+        } else {
+          printer->Print(
+            "::std::string _unknown_fields_;\n"
+            "::google::protobuf::Arena* _arena_ptr_;\n"
+            "\n");
+        }
+        if (SupportsArenas(descriptor_)) {
+          printer->Print(
+            "friend class ::google::protobuf::Arena;\n"
+            "typedef void InternalArenaConstructable_;\n"
+            "typedef void DestructorSkippable_;\n");
+        }
+        break;
+
+      case DataMember::HAS_BITS:
+        printer->Print(
+          "::google::protobuf::uint32 _has_bits_[$size$];\n",
+          "size", SimpleItoa(members[i].size / 4));
+        break;
+
+      case DataMember::CACHED_SIZE:
+        // TODO(kenton):  Make _cached_size_ an atomic<int> when C++ supports
+        //   it.
+        printer->Print("mutable int _cached_size_;\n");
+        break;
+
+      case DataMember::COLD_FIELDS: {
+        // Cold fields live in a struct which is only allocated when one of
+        // them is set; until then, reads see the default instance's struct.
+        vector<const FieldDescriptor*> cold_fields = cold_fields_;
+        OptimizePadding(&cold_fields);
+        printer->Print(
+          "struct ColdFields {\n"
+          "  ColdFields();\n"
+          "  ~ColdFields();\n");
+        printer->Indent();
+        for (int j = 0; j < cold_fields.size(); j++) {
+          field_generators_.get(cold_fields[j]).GeneratePrivateMembers(printer);
+        }
+        printer->Outdent();
+        printer->Print(
+          "};\n"
+          "ColdFields* _cold_;\n"
+          "inline const ColdFields& cold() const;\n"
+          "inline ColdFields* mutable_cold();\n");
+        if (HasDescriptorMethods(descriptor_->file())) {
+          printer->Print(
+            "static void* MutableColdFields(::google::protobuf::Message* message);\n");
+        }
+        for (int j = 0; j < cold_fields.size(); j++) {
+          field_generators_.get(cold_fields[j]).GenerateStaticMembers(printer);
+        }
+        break;
+      }
 
-  // Members assumed to align to 4 bytes:
+      case DataMember::FIELD: {
+        const FieldDescriptor* field = members[i].field;
+        const FieldGenerator& generator = field_generators_.get(field);
+        generator.GenerateStaticMembers(printer);
+        generator.GeneratePrivateMembers(printer);
+        if (CanClearByZeroing(field)) {
+          const string& fieldname = FieldName(field);
+          if (!runs_of_fields_.back().empty() &&
+              (fieldname_to_chunk[runs_of_fields_.back().back()] !=
+               fieldname_to_chunk[fieldname])) {
+            runs_of_fields_.push_back(vector<string>());
+          }
+          runs_of_fields_.back().push_back(fieldname);
+        } else if (!runs_of_fields_.back().empty()) {
+          runs_of_fields_.push_back(vector<string>());
+        }
+        break;
+      }
 
-  if (need_to_emit_cached_size) {
-    printer->Print(cached_size_decl.c_str());
-    need_to_emit_cached_size = false;
-  }
+      case DataMember::ONEOF:
+        GenerateOneofUnion(printer, members[i].oneof);
+        break;
 
-  // Generate _oneof_case_.
-  if (descriptor_->oneof_decl_count() > 0) {
-    printer->Print(vars,
-      "::google::protobuf::uint32 _oneof_case_[$oneof_decl_count$];\n"
-      "\n");
+      case DataMember::ONEOF_CASE:
+        printer->Print(vars,
+          "::google::protobuf::uint32 _oneof_case_[$oneof_decl_count$];\n"
+          "\n");
+        break;
+
+      case DataMember::IS_DEFAULT_INSTANCE:
+        // Without field presence, we need another way to disambiguate the
+        // default instance, because the default instance's submessage fields
+        // (if any) store pointers to the default instances of the
+        // submessages even when they aren't present. Alternatives to this
+        // approach might be to (i) use a tagged pointer on all message
+        // fields, setting a tag bit for "not really present, just default
+        // instance"; or (ii) comparing |this| against the return value from
+        // GeneratedMessageFactory::GetPrototype() in all has_$field$()
+        // calls. However, both of these options are much more expensive (in
+        // code size and CPU overhead) than just checking a field in the
+        // message. Long-term, the best solution would be to rearchitect the
+        // default instance design not to store pointers to submessage
+        // default instances, and have reflection get those some other way;
+        // but that change would have too much impact on proto2.
+        printer->Print(
+          "bool _is_default_instance_;\n");
+        break;
+    }
   }
 
   // Declare AddDescriptors(), BuildDescriptors(), and ShutdownFile() as
@@ -1169,7 +1468,141 @@ GenerateClassDefinition(io::Printer* printer) {
 
   printer->Outdent();
   printer->Print(vars, "};");
-  GOOGLE_DCHECK(!need_to_emit_cached_size);
+}
+
+void MessageGenerator::
+GenerateOneofUnion(io::Printer* printer, const OneofDescriptor* oneof) {
+  printer->Print(
+      "union $camel_oneof_name$Union {\n"
+      // explicit empty constructor is needed when union contains
+      // ArenaStringPtr members for string fields.
+      "  $camel_oneof_name$Union() {}\n",
+      "camel_oneof_name",
+      UnderscoresToCamelCase(oneof->name(), true));
+  printer->Indent();
+  for (int i = 0; i < oneof->field_count(); i++) {
+    field_generators_.get(oneof->field(i)).GeneratePrivateMembers(printer);
+  }
+  printer->Outdent();
+  printer->Print(
+      "} $oneof_name$_;\n",
+      "oneof_name", oneof->name());
+  for (int i = 0; i < oneof->field_count(); i++) {
+    field_generators_.get(oneof->field(i)).GenerateStaticMembers(printer);
+  }
+}
+
+void MessageGenerator::OrderDataMembers(bool previous_order,
+                                        vector<DataMember>* members) {
+  // To minimize padding, data members are divided into three sections:
+  // (1) members assumed to align to 8 bytes, including the pointer to the
+  //     cold fields and the unions of oneofs which hold 8-byte fields.
+  // (2) members corresponding to message fields, re-ordered to optimize
+  //     alignment.  An incomplete 4-byte block goes last.
+  // (3) members assumed to align to 4 bytes or less, which fill in after
+  //     that block.
+
+  // Members assumed to align to 8 bytes:
+
+  if (descriptor_->extension_range_count() > 0) {
+    members->push_back(DataMember(DataMember::EXTENSIONS, 8, 8));
+  }
+  members->push_back(DataMember(DataMember::INTERNAL_METADATA,
+      UseUnknownFieldSet(descriptor_->file()) ? 8 : 16, 8));
+
+  // _has_bits_ is frequently accessed, so to reduce code size and improve
+  // speed, it should be close to the start of the object.  But, try not to
+  // waste space:_has_bits_ by itself always makes sense if its size is a
+  // multiple of 8, but, otherwise, maybe _has_bits_ and cached_size_ together
+  // will work well.
+  bool need_cached_size = true;
+  if (HasFieldPresence(descriptor_->file())) {
+    int sizeof_has_bits = SizeOfHasBits(descriptor_);
+    members->push_back(DataMember(DataMember::HAS_BITS, sizeof_has_bits, 4));
+    if (sizeof_has_bits % 8 != 0) {
+      members->push_back(DataMember(DataMember::CACHED_SIZE, 4, 4));
+      need_cached_size = false;
+    }
+  } else if (previous_order) {
+    members->push_back(DataMember(DataMember::IS_DEFAULT_INSTANCE, 1, 1));
+  }
+
+  if (previous_order) {
+    // The pointer to the cold fields and all the oneof unions used to follow
+    // the fields, and _is_default_instance_ went in front of them.
+    for (int i = 0; i < optimized_order_.size(); i++) {
+      members->push_back(DataMember(optimized_order_[i]));
+    }
+    if (!cold_fields_.empty()) {
+      members->push_back(DataMember(DataMember::COLD_FIELDS, 8, 8));
+    }
+    for (int i = 0; i < descriptor_->oneof_decl_count(); i++) {
+      members->push_back(DataMember(descriptor_->oneof_decl(i)));
+    }
+  } else {
+    if (!cold_fields_.empty()) {
+      members->push_back(DataMember(DataMember::COLD_FIELDS, 8, 8));
+    }
+    for (int i = 0; i < descriptor_->oneof_decl_count(); i++) {
+      if (EstimateAlignmentSize(descriptor_->oneof_decl(i)) == 8) {
+        members->push_back(DataMember(descriptor_->oneof_decl(i)));
+      }
+    }
+
+    // Field members:
+
+    for (int i = 0; i < optimized_order_.size(); i++) {
+      members->push_back(DataMember(optimized_order_[i]));
+    }
+
+    // Members assumed to align to 4 bytes or less:
+
+    for (int i = 0; i < descriptor_->oneof_decl_count(); i++) {
+      if (EstimateAlignmentSize(descriptor_->oneof_decl(i)) == 4) {
+        members->push_back(DataMember(descriptor_->oneof_decl(i)));
+      }
+    }
+  }
+
+  if (need_cached_size) {
+    members->push_back(DataMember(DataMember::CACHED_SIZE, 4, 4));
+  }
+  if (descriptor_->oneof_decl_count() > 0) {
+    members->push_back(DataMember(DataMember::ONEOF_CASE,
+                                  4 * descriptor_->oneof_decl_count(), 4));
+  }
+
+  if (!previous_order) {
+    for (int i = 0; i < descriptor_->oneof_decl_count(); i++) {
+      if (EstimateAlignmentSize(descriptor_->oneof_decl(i)) == 1) {
+        members->push_back(DataMember(descriptor_->oneof_decl(i)));
+      }
+    }
+    if (!HasFieldPresence(descriptor_->file())) {
+      members->push_back(DataMember(DataMember::IS_DEFAULT_INSTANCE, 1, 1));
+    }
+  }
+}
+
+void MessageGenerator::
+GenerateLayoutReport(io::Printer* printer) {
+  vector<DataMember> members, previous_members;
+  OrderDataMembers(false, &members);
+  OrderDataMembers(true, &previous_members);
+  int padding = EstimatePadding(members);
+  int previous_padding = EstimatePadding(previous_members);
+  printer->Print(
+    "$full_name$: $padding$ bytes of padding, $previous_padding$ "
+    "with the previous member order (saves $savings$ bytes)\n",
+    "full_name", descriptor_->full_name(),
+    "padding", SimpleItoa(padding),
+    "previous_padding", SimpleItoa(previous_padding),
+    "savings", SimpleItoa(previous_padding - padding));
+
+  for (int i = 0; i < descriptor_->nested_type_count(); i++) {
+    if (IsMapEntryMessage(descriptor_->nested_type(i))) continue;
+    nested_generators_[i]->GenerateLayoutReport(printer);
+  }
 }
 
 void MessageGenerator::
@@ -1226,7 +1659,9 @@ GenerateDescriptorDeclarations(io::Printer* printer) {
       for (int j = 0; j < descriptor_->oneof_decl(i)->field_count(); j++) {
         const FieldDescriptor* field = descriptor_->oneof_decl(i)->field(j);
         printer->Print("  ");
-        if (IsStringOrMessage(field)) {
+        // Only pointers can be const here: a const ArenaStringPtr would make
+        // the struct impossible to default-construct in C++11.
+        if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
           printer->Print("const ");
         }
         field_generators_.get(field).GeneratePrivateMembers(printer);
@@ -1346,8 +1781,14 @@ GenerateDescriptorInitializer(io::Printer* printer, int index) {
     "$classname$, _arena_),\n");
   }
 
-  // is_default_instance_ offset.
-  if (HasFieldPresence(descriptor_->file())) {
+  // is_default_instance_ offset, followed by the struct of cold fields, which
+  // only messages with field presence may have.
+  if (!cold_fields_.empty()) {
+    printer->Print(vars,
+    "    -1,\n"
+    "    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET($classname$, _cold_),\n"
+    "    &$classname$::MutableColdFields);\n");
+  } else if (HasFieldPresence(descriptor_->file())) {
     printer->Print(vars,
     "    -1);\n");
   } else {
@@ -1543,6 +1984,11 @@ GenerateClassMethods(io::Printer* printer) {
     GenerateClear(printer);
     printer->Print("\n");
 
+    if (UseMessageTable()) {
+      GenerateMessageTable(printer);
+      printer->Print("\n");
+    }
+
     GenerateMergeFromCodedStream(printer);
     printer->Print("\n");
 
@@ -1610,6 +2056,11 @@ GenerateOffsets(io::Printer* printer) {
           "$classname$_default_oneof_instance_, $name$_),\n",
           "classname", classname_,
           "name", FieldName(field));
+    } else if (IsColdField(field, options_)) {
+      printer->Print(
+          "PROTO2_GENERATED_COLD_FIELD_OFFSET($classname$, $name$_),\n",
+          "classname", classname_,
+          "name", FieldName(field));
     } else {
       printer->Print(
           "GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET($classname$, "
@@ -1647,12 +2098,44 @@ GenerateSharedConstructorCode(io::Printer* printer) {
       uses_string_ ? "::google::protobuf::internal::GetEmptyString();\n" : "",
       "_cached_size_ = 0;\n").c_str());
 
-  for (int i = 0; i < descriptor_->field_count(); i++) {
-    if (!descriptor_->field(i)->containing_oneof()) {
-      field_generators_.get(descriptor_->field(i))
+  // Fields are initialized in the order they are declared, so that runs of
+  // adjacent fields which start out as zero bytes can be initialized with
+  // one memset each.
+  // run_end[i] is the end of the run of such fields starting at i.
+  vector<int> run_end(optimized_order_.size() + 1, 0);
+  bool macros_are_needed = false;
+  for (int i = optimized_order_.size() - 1; i >= 0; i--) {
+    run_end[i] = IsZeroInitialized(optimized_order_[i]) ?
+        max(run_end[i + 1], i + 1) : i;
+    macros_are_needed |= run_end[i] - i >= 2;
+  }
+  if (macros_are_needed) {
+    printer->Outdent();
+    printer->Print(kZeroRangeMacros,
+                   "classname", classname_);
+    printer->Indent();
+  }
+  for (int i = 0; i < optimized_order_.size(); ) {
+    if (run_end[i] - i >= 2) {
+      printer->Print(
+        "ZR_($first$_, $last$_);\n",
+        "first", FieldName(optimized_order_[i]),
+        "last", FieldName(optimized_order_[run_end[i] - 1]));
+      i = run_end[i];
+    } else {
+      field_generators_.get(optimized_order_[i])
           .GenerateConstructorCode(printer);
+      i++;
     }
   }
+  if (macros_are_needed) {
+    printer->Outdent();
+    printer->Print("\n#undef OFFSET_OF_FIELD_\n#undef ZR_\n\n");
+    printer->Indent();
+  }
+  if (!cold_fields_.empty()) {
+    printer->Print("_cold_ = NULL;\n");
+  }
 
   if (HasFieldPresence(descriptor_->file())) {
     printer->Print(
@@ -1683,9 +2166,11 @@ GenerateSharedDestructorCode(io::Printer* printer) {
       "}\n"
       "\n");
   }
-  // Write the destructors for each field except oneof members.
+  // Write the destructors for each field except oneof members and cold
+  // fields, which ColdFields' destructor handles.
   for (int i = 0; i < descriptor_->field_count(); i++) {
-    if (!descriptor_->field(i)->containing_oneof()) {
+    if (!descriptor_->field(i)->containing_oneof() &&
+        !IsColdField(descriptor_->field(i), options_)) {
       field_generators_.get(descriptor_->field(i))
                        .GenerateDestructorCode(printer);
     }
@@ -1700,12 +2185,11 @@ GenerateSharedDestructorCode(io::Printer* printer) {
         "oneof_name", descriptor_->oneof_decl(i)->name());
   }
 
-  PrintHandlingOptionalStaticInitializers(
-    descriptor_->file(), printer,
-    // With static initializers.
-    "if (this != default_instance_) {\n",
-    // Without.
-    "if (this != &default_instance()) {\n");
+  // Compare against the raw pointer even without static initializers: a
+  // message destroyed before the default instance exists cannot be it, and
+  // calling default_instance() here could recurse into AddDescriptors().
+  printer->Print(
+    "if (this != default_instance_) {\n");
 
   // We need to delete all embedded messages.
   // TODO(kenton):  If we make unset messages point at default instances
@@ -1716,8 +2200,8 @@ GenerateSharedDestructorCode(io::Printer* printer) {
 
     if (!field->is_repeated() &&
         field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-      // Skip oneof members
-      if (!field->containing_oneof()) {
+      // Skip oneof members and cold fields
+      if (!field->containing_oneof() && !IsColdField(field, options_)) {
         printer->Print(
             "  delete $name$_;\n",
             "name", FieldName(field));
@@ -1725,11 +2209,70 @@ GenerateSharedDestructorCode(io::Printer* printer) {
     }
   }
 
+  // Cold message fields are deleted here rather than by ColdFields'
+  // destructor, since the default instance's point at other default
+  // instances.
+  bool has_cold_messages = false;
+  for (int i = 0; i < cold_fields_.size(); i++) {
+    if (cold_fields_[i]->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (!has_cold_messages) {
+        printer->Print("  if (_cold_ != NULL) {\n");
+        has_cold_messages = true;
+      }
+      printer->Print(
+          "    delete _cold_->$name$_;\n",
+          "name", FieldName(cold_fields_[i]));
+    }
+  }
+  if (has_cold_messages) {
+    printer->Print("  }\n");
+  }
+
+  printer->Print("}\n");
+  if (!cold_fields_.empty()) {
+    printer->Print("delete _cold_;\n");
+  }
+
+  printer->Outdent();
+  printer->Print(
+    "}\n"
+    "\n");
+}
+
+void MessageGenerator::
+GenerateColdFieldsStructors(io::Printer* printer) {
+  printer->Print(
+    "$classname$::ColdFields::ColdFields() {\n",
+    "classname", classname_);
+  printer->Indent();
+  for (int i = 0; i < cold_fields_.size(); i++) {
+    field_generators_.get(cold_fields_[i]).GenerateConstructorCode(printer);
+  }
+  printer->Outdent();
+  printer->Print(
+    "}\n"
+    "\n"
+    "$classname$::ColdFields::~ColdFields() {\n",
+    "classname", classname_);
+  printer->Indent();
+  // Message fields are deleted by the message's SharedDtor(), which knows
+  // whether it is the default instance.
+  for (int i = 0; i < cold_fields_.size(); i++) {
+    field_generators_.get(cold_fields_[i]).GenerateDestructorCode(printer);
+  }
   printer->Outdent();
   printer->Print(
-    "  }\n"
     "}\n"
     "\n");
+
+  if (HasDescriptorMethods(descriptor_->file())) {
+    printer->Print(
+      "void* $classname$::MutableColdFields(::google::protobuf::Message* message) {\n"
+      "  return static_cast<$classname$*>(message)->mutable_cold();\n"
+      "}\n"
+      "\n",
+      "classname", classname_);
+  }
 }
 
 void MessageGenerator::
@@ -1845,6 +2388,13 @@ GenerateStructors(io::Printer* printer) {
       "  _is_default_instance_ = true;\n");
   }
 
+  // Messages whose cold fields are not allocated read their defaults from the
+  // default instance's.
+  if (!cold_fields_.empty()) {
+    printer->Print(
+      "  _cold_ = new ColdFields;\n");
+  }
+
   // The default instance needs all of its embedded message pointers
   // cross-linked to other default instances.  We can't do this initialization
   // in the constructor because some other default instances may not have been
@@ -1861,6 +2411,8 @@ GenerateStructors(io::Printer* printer) {
       string name;
       if (field->containing_oneof()) {
         name = classname_ + "_default_oneof_instance_->";
+      } else if (IsColdField(field, options_)) {
+        name = "_cold_->";
       }
       name += FieldName(field);
       PrintHandlingOptionalStaticInitializers(
@@ -1922,6 +2474,10 @@ GenerateStructors(io::Printer* printer) {
   // Generate the shared destructor code.
   GenerateSharedDestructorCode(printer);
 
+  if (!cold_fields_.empty()) {
+    GenerateColdFieldsStructors(printer);
+  }
+
   // Generate the arena-specific destructor code.
   if (SupportsArenas(descriptor_)) {
     GenerateArenaDestructorCode(printer);
@@ -2014,11 +2570,12 @@ GenerateClear(io::Printer* printer) {
   }
 
   // Step 2: Everything but extensions, repeateds, unions.
-  // These are handled in chunks of 8.  The first chunk is
+  // These are handled in chunks of 32, one per has-bit word, so that words
+  // with no bits set are skipped with a single test.  The first chunk is
   // the non-extensions-non-repeateds-non-unions in
-  //  descriptor_->field(0), descriptor_->field(1), ... descriptor_->field(7),
+  //  descriptor_->field(0), descriptor_->field(1), ... descriptor_->field(31),
   // and the second chunk is the same for
-  //  descriptor_->field(8), descriptor_->field(9), ... descriptor_->field(15),
+  //  descriptor_->field(32), descriptor_->field(33), ... descriptor_->field(63),
   // etc.
   set<int> step2_indices;
   hash_map<string, int> fieldname_to_chunk;
@@ -2028,27 +2585,16 @@ GenerateClear(io::Printer* printer) {
   hash_map<int, uint32> fields_mask_for_chunk;
   for (int i = 0; i < descriptor_->field_count(); i++) {
     const FieldDescriptor* field = descriptor_->field(i);
-    if (!field->is_repeated() && !field->containing_oneof()) {
+    if (!field->is_repeated() && !field->containing_oneof() &&
+        !IsColdField(field, options_)) {
       step2_indices.insert(i);
-      int chunk = i / 8;
+      int chunk = i / 32;
       fieldname_to_chunk[FieldName(field)] = chunk;
       fields_mask_for_chunk[chunk] |= static_cast<uint32>(1) << (i % 32);
     }
   }
 
   // Step 2a: Greedily seek runs of fields that can be cleared by memset-to-0.
-  // The generated code uses two macros to help it clear runs of fields:
-  // OFFSET_OF_FIELD_ computes the offset (in bytes) of a field in the Message.
-  // ZR_ zeroes a non-empty range of fields via memset.
-  const char* macros =
-      "#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \\\n"
-      "  &reinterpret_cast<$classname$*>(16)->f) - \\\n"
-      "   reinterpret_cast<char*>(16))\n\n"
-      "#define ZR_(first, last) do {                              \\\n"
-      "    size_t f = OFFSET_OF_FIELD_(first);                    \\\n"
-      "    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \\\n"
-      "    ::memset(&first, 0, n);                                \\\n"
-      "  } while (0)\n\n";
   for (int i = 0; i < runs_of_fields_.size(); i++) {
     const vector<string>& run = runs_of_fields_[i];
     if (run.size() < 2) continue;
@@ -2066,7 +2612,7 @@ GenerateClear(io::Printer* printer) {
   const bool macros_are_needed = handled.size() > 0;
   if (macros_are_needed) {
     printer->Outdent();
-    printer->Print(macros,
+    printer->Print(kZeroRangeMacros,
                    "classname", classname_);
     printer->Indent();
   }
@@ -2077,7 +2623,7 @@ GenerateClear(io::Printer* printer) {
     if (step2_indices.count(i) == 0) continue;
     const FieldDescriptor* field = descriptor_->field(i);
     const string fieldname = FieldName(field);
-    if (i / 8 != last_index / 8 || last_index < 0) {
+    if (i / 32 != last_index / 32 || last_index < 0) {
       // End previous chunk, if there was one.
       if (chunk_block_in_progress) {
         printer->Outdent();
@@ -2085,18 +2631,18 @@ GenerateClear(io::Printer* printer) {
         chunk_block_in_progress = false;
       }
       // Start chunk.
-      const string& memsets = memsets_for_chunk[i / 8];
-      uint32 mask = fields_mask_for_chunk[i / 8];
+      const string& memsets = memsets_for_chunk[i / 32];
+      uint32 mask = fields_mask_for_chunk[i / 32];
       int count = popcnt(mask);
       GOOGLE_DCHECK_GE(count, 1);
       if (count == 1 ||
-          (count <= 4 && count == memset_field_count_for_chunk[i / 8])) {
+          (count <= 4 && count == memset_field_count_for_chunk[i / 32])) {
         // No "if" here because the chunk is trivial.
       } else {
         if (HasFieldPresence(descriptor_->file())) {
           printer->Print(
-            "if (_has_bits_[$index$ / 32] & $mask$) {\n",
-            "index", SimpleItoa(i / 8 * 8),
+            "if (_has_bits_[$index$] & $mask$u) {\n",
+            "index", SimpleItoa(i / 32),
             "mask", SimpleItoa(mask));
           printer->Indent();
           chunk_block_in_progress = true;
@@ -2141,6 +2687,30 @@ GenerateClear(io::Printer* printer) {
     printer->Indent();
   }
 
+  // Step 2c: Cold fields, which can only be set if _cold_ is allocated.  As
+  // above, primitive types are just overwritten.
+  if (!cold_fields_.empty()) {
+    printer->Print("if (_cold_ != NULL) {\n");
+    printer->Indent();
+    for (int i = 0; i < cold_fields_.size(); i++) {
+      const FieldDescriptor* field = cold_fields_[i];
+      bool should_check_bit =
+        field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE ||
+        field->cpp_type() == FieldDescriptor::CPPTYPE_STRING;
+      if (should_check_bit) {
+        printer->Print("if (has_$name$()) {\n", "name", FieldName(field));
+        printer->Indent();
+      }
+      field_generators_.get(field).GenerateClearingCode(printer);
+      if (should_check_bit) {
+        printer->Outdent();
+        printer->Print("}\n");
+      }
+    }
+    printer->Outdent();
+    printer->Print("}\n");
+  }
+
   // Step 3: Repeated fields don't use _has_bits_; emit code to clear them here.
   for (int i = 0; i < descriptor_->field_count(); i++) {
     const FieldDescriptor* field = descriptor_->field(i);
@@ -2276,6 +2846,10 @@ GenerateSwap(io::Printer* printer) {
       field_generators_.get(field).GenerateSwappingCode(printer);
     }
 
+    if (!cold_fields_.empty()) {
+      printer->Print("std::swap(_cold_, other->_cold_);\n");
+    }
+
     for (int i = 0; i < descriptor_->oneof_decl_count(); i++) {
       printer->Print(
         "std::swap($oneof_name$_, other->$oneof_name$_);\n"
@@ -2316,6 +2890,75 @@ GenerateSwap(io::Printer* printer) {
   printer->Print("}\n");
 }
 
+bool MessageGenerator::IterateHasBitsOfWord(int word) const {
+  int count = 0;
+  for (int i = word * 32;
+       i < descriptor_->field_count() && i < (word + 1) * 32; i++) {
+    const FieldDescriptor* field = descriptor_->field(i);
+    if (!field->is_repeated() && !field->containing_oneof()) {
+      count++;
+    }
+  }
+  return count >= kMinFieldsToIterateHasBits;
+}
+
+void MessageGenerator::GenerateHasBitsLoopBegin(
+    io::Printer* printer, const string& prefix, int word,
+    const vector<const FieldDescriptor*>& fields) {
+  uint32 mask = 0;
+  for (int i = 0; i < fields.size(); i++) {
+    GOOGLE_DCHECK_EQ(word, fields[i]->index() / 32);
+    mask |= static_cast<uint32>(1) << (fields[i]->index() % 32);
+  }
+  char buffer[kFastToBufferSize];
+  printer->Print(
+    "{\n"
+    "  ::google::protobuf::uint32 bits = $prefix$_has_bits_[$word$] & 0x$mask$u;\n"
+    "  while (bits != 0) {\n"
+    "    switch (::google::protobuf::internal::CountTrailingZeros32(bits)) {\n",
+    "prefix", prefix,
+    "word", SimpleItoa(word),
+    "mask", FastHex32ToBuffer(mask, buffer));
+  printer->Indent();
+  printer->Indent();
+  printer->Indent();
+}
+
+void MessageGenerator::GenerateHasBitsLoopEnd(io::Printer* printer) {
+  printer->Outdent();
+  printer->Outdent();
+  printer->Outdent();
+  printer->Print(
+    "    }\n"
+    "    bits &= bits - 1;\n"
+    "  }\n"
+    "}\n");
+}
+
+void MessageGenerator::
+GenerateMergeHasBitsWord(io::Printer* printer, int word) {
+  vector<const FieldDescriptor*> fields;
+  for (int i = word * 32;
+       i < descriptor_->field_count() && i < (word + 1) * 32; i++) {
+    const FieldDescriptor* field = descriptor_->field(i);
+    if (!field->is_repeated() && !field->containing_oneof()) {
+      fields.push_back(field);
+    }
+  }
+  GenerateHasBitsLoopBegin(printer, "from.", word, fields);
+  for (int i = 0; i < fields.size(); i++) {
+    printer->Print(
+      "case $bit$: {\n",
+      "bit", SimpleItoa(fields[i]->index() % 32));
+    printer->Indent();
+    field_generators_.get(fields[i]).GenerateMergingCode(printer);
+    printer->Print("break;\n");
+    printer->Outdent();
+    printer->Print("}\n");
+  }
+  GenerateHasBitsLoopEnd(printer);
+}
+
 void MessageGenerator::
 GenerateMergeFrom(io::Printer* printer) {
   if (HasDescriptorMethods(descriptor_->file())) {
@@ -2402,13 +3045,29 @@ GenerateMergeFrom(io::Printer* printer) {
         "}\n");
   }
 
-  // Merge Optional and Required fields (after a _has_bit check).
+  // Merge Optional and Required fields (after a _has_bit check).  Has-bit
+  // words with many fields are merged by visiting only the bits which are
+  // set; the fields of other words are checked in chunks of 8.
   int last_index = -1;
+  int last_iterated_word = -1;
 
   for (int i = 0; i < descriptor_->field_count(); ++i) {
     const FieldDescriptor* field = descriptor_->field(i);
 
     if (!field->is_repeated() && !field->containing_oneof()) {
+      if (HasFieldPresence(descriptor_->file()) &&
+          IterateHasBitsOfWord(i / 32)) {
+        if (i / 32 != last_iterated_word) {
+          if (last_index >= 0) {
+            printer->Outdent();
+            printer->Print("}\n");
+            last_index = -1;
+          }
+          GenerateMergeHasBitsWord(printer, i / 32);
+          last_iterated_word = i / 32;
+        }
+        continue;
+      }
       if (HasFieldPresence(descriptor_->file())) {
         // See above in GenerateClear for an explanation of this.
         if (i / 8 != last_index / 8 || last_index < 0) {
@@ -2534,6 +3193,11 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
     return;
   }
 
+  if (UseTableDrivenParsing()) {
+    GenerateTableDrivenMergeFromCodedStream(printer);
+    return;
+  }
+
   printer->Print(
     "bool $classname$::MergePartialFromCodedStream(\n"
     "    ::google::protobuf::io::CodedInputStream* input) {\n"
@@ -2549,6 +3213,53 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
       "      &unknown_fields_string);\n");
   }
 
+  google::protobuf::scoped_array<const FieldDescriptor * > ordered_fields(
+      SortFieldsByNumber(descriptor_));
+
+  // With the tag_dispatch_table option, small tags are mapped to the cases of
+  // the switch below by a lookup table, so that each case handles exactly one
+  // tag and the switch is dense.  This is meant to make fields which arrive
+  // out of order, and so are missed by the ExpectTag() predictions, cheaper
+  // to dispatch, but so far it has not measured faster and the tables make
+  // the code larger, so it is off by default.  Messages with large field
+  // numbers would need large tables, so they always switch on the field
+  // number and check the wire type in each case instead.
+  vector<int> tag_cases;
+  vector<int> field_cases(descriptor_->field_count(), 0);
+  vector<int> alternate_cases(descriptor_->field_count(), 0);
+  uint32 max_case_tag = 0;
+  for (int i = 0; i < descriptor_->field_count(); i++) {
+    max_case_tag = max(max_case_tag, WireFormat::MakeTag(ordered_fields[i]));
+    if (ordered_fields[i]->is_packable()) {
+      max_case_tag = max(max_case_tag,
+                         AlternateTag(ordered_fields[i]));
+    }
+  }
+  const uint32 kMaxTableTag = 2047;  // Field numbers up to 255.
+  if (options_.tag_dispatch_table && descriptor_->field_count() > 0 &&
+      max_case_tag <= kMaxTableTag) {
+    tag_cases.resize(max(max_case_tag + 1, 128u), 0);
+    int next_case = 1;
+    for (int i = 0; i < descriptor_->field_count(); i++) {
+      const FieldDescriptor* field = ordered_fields[i];
+      field_cases[i] = next_case++;
+      tag_cases[WireFormat::MakeTag(field)] = field_cases[i];
+      if (field->is_packable()) {
+        alternate_cases[i] = next_case++;
+        tag_cases[AlternateTag(field)] = alternate_cases[i];
+      }
+    }
+    printer->Print(
+      "  static const ::google::protobuf::$type$ kTagCases[$size$] = {\n",
+      "type", next_case <= 256 ? "uint8" : "uint16",
+      "size", SimpleItoa(tag_cases.size()));
+    printer->Indent();
+    PrintArrayInitializer(printer, tag_cases);
+    printer->Outdent();
+    printer->Print("  };\n");
+  }
+  const bool use_tag_table = !tag_cases.empty();
+
   printer->Print(
     "  // @@protoc_insertion_point(parse_start:$full_name$)\n",
     "full_name", descriptor_->full_name());
@@ -2557,30 +3268,36 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
   printer->Print("for (;;) {\n");
   printer->Indent();
 
-  google::protobuf::scoped_array<const FieldDescriptor * > ordered_fields(
-      SortFieldsByNumber(descriptor_));
   uint32 maxtag = descriptor_->field_count() == 0 ? 0 :
       WireFormat::MakeTag(ordered_fields[descriptor_->field_count() - 1]);
   const int kCutoff0 = 127;               // fits in 1-byte varint
   const int kCutoff1 = (127 << 7) + 127;  // fits in 2-byte varint
+  if (use_tag_table) {
+    // The cutoff keeps the tag within the table.
+    maxtag = tag_cases.size() - 1;
+  }
   printer->Print("::std::pair< ::google::protobuf::uint32, bool> p = "
                  "input->ReadTagWithCutoff($max$);\n"
                  "tag = p.first;\n"
                  "if (!p.second) goto handle_unusual;\n",
-                 "max", SimpleItoa(maxtag <= kCutoff0 ? kCutoff0 :
+                 "max", SimpleItoa(use_tag_table ? maxtag :
+                                   maxtag <= kCutoff0 ? kCutoff0 :
                                    (maxtag <= kCutoff1 ? kCutoff1 :
                                     maxtag)));
   if (descriptor_->field_count() > 0) {
     // We don't even want to print the switch() if we have no fields because
     // MSVC dislikes switch() statements that contain only a default value.
 
-    // Note:  If we just switched on the tag rather than the field number, we
-    // could avoid the need for the if() to check the wire type at the beginning
-    // of each case.  However, this is actually a bit slower in practice as it
-    // creates a jump table that is 8x larger and sparser, and meanwhile the
-    // if()s are highly predictable.
-    printer->Print("switch (::google::protobuf::internal::WireFormatLite::"
-                   "GetTagFieldNumber(tag)) {\n");
+    // Note:  Switching directly on the tag, rather than on the field number
+    // or the table's case numbers, would avoid checking the wire type in each
+    // case too.  However, this is actually a bit slower in practice as it
+    // creates a jump table that is 8x larger and sparser.
+    if (use_tag_table) {
+      printer->Print("switch (kTagCases[tag]) {\n");
+    } else {
+      printer->Print("switch (::google::protobuf::internal::WireFormatLite::"
+                     "GetTagFieldNumber(tag)) {\n");
+    }
 
     printer->Indent();
 
@@ -2591,13 +3308,15 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
 
       printer->Print(
         "case $number$: {\n",
-        "number", SimpleItoa(field->number()));
+        "number", SimpleItoa(use_tag_table ? field_cases[i] : field->number()));
       printer->Indent();
       const FieldGenerator& field_generator = field_generators_.get(field);
 
       // Emit code to parse the common, expected case.
-      printer->Print("if (tag == $commontag$) {\n",
-                     "commontag", SimpleItoa(WireFormat::MakeTag(field)));
+      if (!use_tag_table) {
+        printer->Print("if (tag == $commontag$) {\n",
+                       "commontag", SimpleItoa(WireFormat::MakeTag(field)));
+      }
 
       if (i > 0 || (field->is_repeated() && !field->options().packed())) {
         printer->Print(
@@ -2605,41 +3324,30 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
           "name", field->name());
       }
 
-      printer->Indent();
+      if (!use_tag_table) printer->Indent();
       if (field->options().packed()) {
         field_generator.GenerateMergeFromCodedStreamWithPacking(printer);
       } else {
         field_generator.GenerateMergeFromCodedStream(printer);
       }
-      printer->Outdent();
+      if (!use_tag_table) printer->Outdent();
 
-      // Emit code to parse unexpectedly packed or unpacked values.
-      if (field->is_packable() && field->options().packed()) {
-        internal::WireFormatLite::WireType wiretype =
-            WireFormat::WireTypeForFieldType(field->type());
-        printer->Print("} else if (tag == $uncommontag$) {\n",
-                       "uncommontag", SimpleItoa(
-                           internal::WireFormatLite::MakeTag(
-                               field->number(), wiretype)));
-        printer->Indent();
-        field_generator.GenerateMergeFromCodedStream(printer);
-        printer->Outdent();
-      } else if (field->is_packable() && !field->options().packed()) {
-        internal::WireFormatLite::WireType wiretype =
-            internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+      // Emit code to parse unexpectedly packed or unpacked values.  With the
+      // table, these get their own cases, below.
+      if (!use_tag_table && field->is_packable()) {
         printer->Print("} else if (tag == $uncommontag$) {\n",
-                       "uncommontag", SimpleItoa(
-                           internal::WireFormatLite::MakeTag(
-                               field->number(), wiretype)));
+                       "uncommontag", SimpleItoa(AlternateTag(field)));
         printer->Indent();
-        field_generator.GenerateMergeFromCodedStreamWithPacking(printer);
+        GenerateMergeAlternateEncoding(printer, field);
         printer->Outdent();
       }
 
-      printer->Print(
-        "} else {\n"
-        "  goto handle_unusual;\n"
-        "}\n");
+      if (!use_tag_table) {
+        printer->Print(
+          "} else {\n"
+          "  goto handle_unusual;\n"
+          "}\n");
+      }
 
       // switch() is slow since it can't be predicted well.  Insert some if()s
       // here that attempt to predict the next tag.
@@ -2670,6 +3378,17 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
 
       printer->Outdent();
       printer->Print("}\n\n");
+
+      if (use_tag_table && field->is_packable()) {
+        printer->Print(
+          "case $number$: {\n",
+          "number", SimpleItoa(alternate_cases[i]));
+        printer->Indent();
+        GenerateMergeAlternateEncoding(printer, field);
+        printer->Print("break;\n");
+        printer->Outdent();
+        printer->Print("}\n\n");
+      }
     }
 
     printer->Print("default: {\n");
@@ -2687,6 +3406,43 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
     "  goto success;\n"
     "}\n");
 
+  GenerateHandleUnusualTag(printer, "continue;");
+
+  if (descriptor_->field_count() > 0) {
+    printer->Print("break;\n");
+    printer->Outdent();
+    printer->Print("}\n");    // default:
+    printer->Outdent();
+    printer->Print("}\n");    // switch
+  }
+
+  printer->Outdent();
+  printer->Outdent();
+  printer->Print(
+    "  }\n"                   // for (;;)
+    "success:\n"
+    "  // @@protoc_insertion_point(parse_success:$full_name$)\n"
+    "  return true;\n"
+    "failure:\n"
+    "  // @@protoc_insertion_point(parse_failure:$full_name$)\n"
+    "  return false;\n"
+    "#undef DO_\n"
+    "}\n", "full_name", descriptor_->full_name());
+}
+
+void MessageGenerator::
+GenerateMergeAlternateEncoding(io::Printer* printer,
+                               const FieldDescriptor* field) {
+  const FieldGenerator& field_generator = field_generators_.get(field);
+  if (field->options().packed()) {
+    field_generator.GenerateMergeFromCodedStream(printer);
+  } else {
+    field_generator.GenerateMergeFromCodedStreamWithPacking(printer);
+  }
+}
+
+void MessageGenerator::
+GenerateHandleUnusualTag(io::Printer* printer, const char* done) {
   // Handle extension ranges.
   if (descriptor_->extension_range_count() > 0) {
     printer->Print(
@@ -2742,8 +3498,9 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
         "  DO_(_extensions_.ParseField(tag, input, &default_instance());\n");
     }
     printer->Print(
-      "  continue;\n"
-      "}\n");
+      "  $done$\n"
+      "}\n",
+      "done", done);
   }
 
   // We really don't recognize this tag.  Skip it.
@@ -2761,60 +3518,387 @@ GenerateMergeFromCodedStream(io::Printer* printer) {
     printer->Print(
       "DO_(::google::protobuf::internal::WireFormatLite::SkipField(input, tag));\n");
   }
+}
 
-  if (descriptor_->field_count() > 0) {
-    printer->Print("break;\n");
-    printer->Outdent();
-    printer->Print("}\n");    // default:
-    printer->Outdent();
-    printer->Print("}\n");    // switch
-  }
+bool MessageGenerator::UseTableDrivenParsing() const {
+  return options_.table_driven_parsing &&
+         HasGeneratedMethods(descriptor_->file()) &&
+         !descriptor_->options().message_set_wire_format();
+}
 
-  printer->Outdent();
-  printer->Outdent();
-  printer->Print(
-    "  }\n"                   // for (;;)
-    "success:\n"
-    "  // @@protoc_insertion_point(parse_success:$full_name$)\n"
-    "  return true;\n"
-    "failure:\n"
-    "  // @@protoc_insertion_point(parse_failure:$full_name$)\n"
-    "  return false;\n"
-    "#undef DO_\n"
-    "}\n", "full_name", descriptor_->full_name());
+bool MessageGenerator::UseTableDrivenSerialization() const {
+  return options_.table_driven_serialization &&
+         HasGeneratedMethods(descriptor_->file()) &&
+         !descriptor_->options().message_set_wire_format();
 }
 
-void MessageGenerator::GenerateSerializeOneField(
-    io::Printer* printer, const FieldDescriptor* field, bool to_array) {
-  PrintFieldComment(printer, field);
+bool MessageGenerator::UseMessageTable() const {
+  return UseTableDrivenParsing() || UseTableDrivenSerialization();
+}
 
-  bool have_enclosing_if = false;
-  if (!field->is_repeated() && HasFieldPresence(descriptor_->file())) {
-    printer->Print(
-      "if (has_$name$()) {\n",
-      "name", FieldName(field));
-    printer->Indent();
-    have_enclosing_if = true;
-  } else if (!HasFieldPresence(descriptor_->file())) {
-    have_enclosing_if = EmitFieldNonDefaultCondition(printer, "this->", field);
+bool MessageGenerator::HasUnusualFields() const {
+  if (descriptor_->extension_range_count() > 0 ||
+      PreserveUnknownFields(descriptor_)) {
+    return true;
   }
-
-  if (to_array) {
-    field_generators_.get(field).GenerateSerializeWithCachedSizesToArray(
-        printer);
-  } else {
-    field_generators_.get(field).GenerateSerializeWithCachedSizes(printer);
+  for (int i = 0; i < descriptor_->field_count(); i++) {
+    if (!IsTableDrivenField(descriptor_->field(i), options_)) return true;
   }
+  return false;
+}
 
-  if (have_enclosing_if) {
-    printer->Outdent();
-    printer->Print("}\n");
+void MessageGenerator::
+GenerateMessageTable(io::Printer* printer) {
+  int num_table_fields = 0;
+  for (int i = 0; i < descriptor_->field_count(); i++) {
+    if (IsTableDrivenField(descriptor_->field(i), options_)) {
+      num_table_fields++;
+    }
   }
-  printer->Print("\n");
-}
 
-void MessageGenerator::GenerateSerializeOneExtensionRange(
-    io::Printer* printer, const Descriptor::ExtensionRange* range,
+  printer->Print("namespace {\n\n");
+  if (num_table_fields > 0) {
+    printer->Print(
+      "::google::protobuf::internal::TableField $classname$_table_fields_[$count$];\n",
+      "classname", classname_,
+      "count", SimpleItoa(num_table_fields));
+  }
+  printer->Print(
+    "::google::protobuf::internal::MessageTable $classname$_table_;\n"
+    "GOOGLE_PROTOBUF_DECLARE_ONCE($classname$_table_once_);\n",
+    "classname", classname_);
+
+  if (UseTableDrivenSerialization()) {
+    vector<int> field_by_has_bit;
+    vector<int> always_visit;
+    ComputeVisitOrder(descriptor_, options_, &field_by_has_bit,
+                      &always_visit);
+    if (!field_by_has_bit.empty()) {
+      printer->Print(
+        "const ::google::protobuf::int32 $classname$_table_field_by_has_bit_[] = {\n",
+        "classname", classname_);
+      PrintArrayInitializer(printer, field_by_has_bit);
+      printer->Print("};\n");
+    }
+    if (!always_visit.empty()) {
+      printer->Print(
+        "const ::google::protobuf::int32 $classname$_table_always_visit_[] = {\n",
+        "classname", classname_);
+      PrintArrayInitializer(printer, always_visit);
+      printer->Print("};\n");
+    }
+  }
+
+  printer->Print(
+    "\n"
+    "}  // namespace\n"
+    "\n");
+
+  GenerateMessageTableInitializer(printer);
+}
+
+void MessageGenerator::
+GenerateTableDrivenMergeFromCodedStream(io::Printer* printer) {
+  printer->Print(
+    "bool $classname$::MergePartialFromCodedStream(\n"
+    "    ::google::protobuf::io::CodedInputStream* input) {\n"
+    "  ::google::protobuf::GoogleOnceInit(&$classname$_table_once_,\n"
+    "                 &$classname$::InitMessageTable);\n"
+    "  return ::google::protobuf::internal::TableDrivenMessage::"
+    "MergePartialFromCodedStream(\n"
+    "      this, $classname$_table_, input);\n"
+    "}\n"
+    "\n"
+    "bool $classname$::MergeUnusualField(\n"
+    "    ::google::protobuf::MessageLite* msg, ::google::protobuf::uint32 tag,\n"
+    "    ::google::protobuf::io::CodedInputStream* input) {\n"
+    "  return static_cast<$classname$*>(msg)->MergeUnusualFieldFromCodedStream(\n"
+    "      tag, input);\n"
+    "}\n"
+    "\n",
+    "classname", classname_);
+
+  GenerateMergeUnusualFieldFromCodedStream(printer);
+}
+
+void MessageGenerator::
+GenerateMessageTableInitializer(io::Printer* printer) {
+  printer->Print(
+    "void $classname$::InitMessageTable() {\n"
+    "  // Default values referenced by the table must be initialized first.\n"
+    "  default_instance();\n",
+    "classname", classname_);
+  printer->Indent();
+
+  map<int, vector<UnusualItem> > unusual_items;
+  if (UseTableDrivenSerialization()) {
+    unusual_items = GroupUnusualItems(descriptor_, options_);
+  }
+
+  // Work out the flags first, so that only the typedefs which are used are
+  // declared, avoiding compiler warnings.
+  vector<const FieldDescriptor*> table_fields =
+      TableFields(descriptor_, options_);
+  vector<string> table_flags;
+  bool uses_tf = false;
+  for (int i = 0; i < table_fields.size(); i++) {
+    const FieldDescriptor* field = table_fields[i];
+    vector<string> flags;
+    if (field->is_repeated()) {
+      flags.push_back("TF::kRepeated");
+      if (field->options().packed()) flags.push_back("TF::kPacked");
+    }
+    if (unusual_items.count(field->number()) > 0) {
+      flags.push_back("TF::kUnusualBefore");
+    }
+    if (!flags.empty()) uses_tf = true;
+    table_flags.push_back(flags.empty() ? "0" : Join(flags, " | "));
+  }
+  if (!table_fields.empty()) {
+    printer->Print(
+      "typedef ::google::protobuf::internal::WireFormatLite WFL;\n");
+  }
+  if (uses_tf) {
+    printer->Print(
+      "typedef ::google::protobuf::internal::TableField TF;\n");
+  }
+
+  vector<pair<int, const FieldDescriptor*> > utf8_fields;
+  for (int index = 0; index < table_fields.size(); index++) {
+    const FieldDescriptor* field = table_fields[index];
+
+    map<string, string> vars;
+    vars["classname"] = classname_;
+    vars["i"] = SimpleItoa(index);
+    vars["tag"] = SimpleItoa(WireFormat::MakeTag(field));
+    vars["type"] = "WFL::TYPE_" + ToUpper(FieldDescriptor::TypeName(field->type()));
+    vars["member"] = FieldName(field) + "_";
+    vars["has_bit"] = field->is_repeated() || !HasFieldPresence(descriptor_->file()) ?
+        "-1" : SimpleItoa(field->index());
+    vars["flags"] = table_flags[index];
+
+    PrintFieldComment(printer, field);
+    printer->Print(vars,
+      "$classname$_table_fields_[$i$].Set(\n"
+      "    $tag$u, $type$, $flags$,\n"
+      "    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET($classname$, $member$),"
+      " $has_bit$);\n");
+
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        vars["type"] = FieldMessageTypeName(field);
+        printer->Print(vars,
+          "$classname$_table_fields_[$i$].aux.message_default =\n"
+          "    &$type$::default_instance();\n");
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        if (!HasPreservingUnknownEnumSemantics(field->file())) {
+          vars["type"] = ClassName(field->enum_type(), true);
+          printer->Print(vars,
+            "$classname$_table_fields_[$i$].aux.enum_is_valid =\n"
+            "    &$type$_IsValid;\n");
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        if (!field->is_repeated()) {
+          vars["default_variable"] = field->default_value_string().empty() ?
+              "&::google::protobuf::internal::GetEmptyStringAlreadyInited()" :
+              "_default_" + FieldName(field) + "_";
+          printer->Print(vars,
+            "$classname$_table_fields_[$i$].aux.string_default =\n"
+            "    $default_variable$;\n");
+        }
+        if (HasUtf8Verification(field->file()) &&
+            field->type() == FieldDescriptor::TYPE_STRING) {
+          utf8_fields.push_back(make_pair(index, field));
+        }
+        break;
+      default:
+        break;
+    }
+    if (UseTableDrivenSerialization() && field->is_repeated() &&
+        field->options().packed()) {
+      vars["cached_size"] = "_" + FieldName(field) + "_cached_byte_size_";
+      printer->Print(vars,
+        "$classname$_table_fields_[$i$].cached_size_offset =\n"
+        "    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET("
+        "$classname$, $cached_size$);\n");
+    }
+  }
+
+  map<string, string> vars;
+  vars["classname"] = classname_;
+  vars["count"] = SimpleItoa(table_fields.size());
+  vars["fields"] = table_fields.empty() ? "NULL" : classname_ + "_table_fields_";
+  printer->Print(vars,
+    "$classname$_table_.fields = $fields$;\n"
+    "$classname$_table_.num_fields = $count$;\n");
+  // Messages without field presence have no _has_bits_.
+  if (HasFieldPresence(descriptor_->file())) {
+    printer->Print(vars,
+      "$classname$_table_.has_bits_offset =\n"
+      "    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET($classname$, _has_bits_);\n");
+  } else {
+    printer->Print(vars,
+      "$classname$_table_.has_bits_offset = -1;\n");
+  }
+  if (UseTableDrivenParsing()) {
+    printer->Print(vars,
+      "$classname$_table_.parse_unusual = &$classname$::MergeUnusualField;\n");
+  }
+  if (UseTableDrivenSerialization()) {
+    vector<int> field_by_has_bit;
+    vector<int> always_visit;
+    ComputeVisitOrder(descriptor_, options_, &field_by_has_bit,
+                      &always_visit);
+    if (!field_by_has_bit.empty()) {
+      vars["num_has_bits"] = SimpleItoa(field_by_has_bit.size());
+      printer->Print(vars,
+        "$classname$_table_.field_by_has_bit =\n"
+        "    $classname$_table_field_by_has_bit_;\n"
+        "$classname$_table_.num_has_bits = $num_has_bits$;\n");
+    }
+    if (!always_visit.empty()) {
+      vars["num_always_visit"] = SimpleItoa(always_visit.size());
+      printer->Print(vars,
+        "$classname$_table_.always_visit = $classname$_table_always_visit_;\n"
+        "$classname$_table_.num_always_visit = $num_always_visit$;\n");
+    }
+    printer->Print(vars,
+      "$classname$_table_.default_instance = default_instance_;\n");
+    if (HasUnusualFields()) {
+      printer->Print(vars,
+        "$classname$_table_.serialize_unusual =\n"
+        "    &$classname$::SerializeUnusualFields;\n");
+      if (HasFastArraySerialization(descriptor_->file())) {
+        printer->Print(vars,
+          "$classname$_table_.serialize_unusual_to_array =\n"
+          "    &$classname$::SerializeUnusualFieldsToArray;\n");
+      }
+      printer->Print(vars,
+        "$classname$_table_.unusual_byte_size =\n"
+        "    &$classname$::UnusualFieldsByteSize;\n");
+    }
+  }
+  if (!utf8_fields.empty()) {
+    printer->Print("#ifdef GOOGLE_PROTOBUF_UTF8_VALIDATION_ENABLED\n");
+    for (int i = 0; i < utf8_fields.size(); i++) {
+      vars["i"] = SimpleItoa(utf8_fields[i].first);
+      vars["full_name"] = utf8_fields[i].second->full_name();
+      printer->Print(vars,
+        "$classname$_table_fields_[$i$].flags |=\n"
+        "    ::google::protobuf::internal::TableField::kVerifyUtf8;\n"
+        "$classname$_table_fields_[$i$].full_name = \"$full_name$\";\n");
+    }
+    printer->Print(vars,
+      "$classname$_table_.verify_utf8 =\n"
+      "    &::google::protobuf::internal::WireFormat::VerifyUTF8StringFromTable;\n"
+      "#endif  // GOOGLE_PROTOBUF_UTF8_VALIDATION_ENABLED\n");
+  }
+
+  printer->Outdent();
+  printer->Print("}\n");
+}
+
+void MessageGenerator::
+GenerateMergeUnusualFieldFromCodedStream(io::Printer* printer) {
+  printer->Print(
+    "bool $classname$::MergeUnusualFieldFromCodedStream(\n"
+    "    ::google::protobuf::uint32 tag, ::google::protobuf::io::CodedInputStream* input) {\n"
+    "#define DO_(EXPRESSION) if (!(EXPRESSION)) return false\n",
+    "classname", classname_);
+  printer->Indent();
+
+  if (!UseUnknownFieldSet(descriptor_->file())) {
+    printer->Print(
+      "::google::protobuf::io::StringOutputStream unknown_fields_string(\n"
+      "    mutable_unknown_fields());\n"
+      "::google::protobuf::io::CodedOutputStream unknown_fields_stream(\n"
+      "    &unknown_fields_string);\n");
+  }
+
+  google::protobuf::scoped_array<const FieldDescriptor * > ordered_fields(
+      SortFieldsByNumber(descriptor_));
+  bool has_switch = false;
+  for (int i = 0; i < descriptor_->field_count(); i++) {
+    const FieldDescriptor* field = ordered_fields[i];
+    if (IsTableDrivenField(field, options_)) continue;
+
+    if (!has_switch) {
+      printer->Print("switch (::google::protobuf::internal::WireFormatLite::"
+                     "GetTagFieldNumber(tag)) {\n");
+      printer->Indent();
+      has_switch = true;
+    }
+
+    // Oneof members and maps are neither repeated primitives nor packable,
+    // so only their declared encoding needs handling here.
+    PrintFieldComment(printer, field);
+    printer->Print(
+      "case $number$: {\n"
+      "  if (tag == $tag$) {\n",
+      "number", SimpleItoa(field->number()),
+      "tag", SimpleItoa(WireFormat::MakeTag(field)));
+    printer->Indent();
+    printer->Indent();
+    field_generators_.get(field).GenerateMergeFromCodedStream(printer);
+    printer->Outdent();
+    printer->Outdent();
+    printer->Print(
+      "    return true;\n"
+      "  }\n"
+      "  break;\n"
+      "}\n"
+      "\n");
+  }
+  if (has_switch) {
+    printer->Print(
+      "default:\n"
+      "  break;\n");
+    printer->Outdent();
+    printer->Print("}\n");
+  }
+
+  GenerateHandleUnusualTag(printer, "return true;");
+
+  printer->Outdent();
+  printer->Print(
+    "  return true;\n"
+    "#undef DO_\n"
+    "}\n");
+}
+
+void MessageGenerator::GenerateSerializeOneField(
+    io::Printer* printer, const FieldDescriptor* field, bool to_array) {
+  PrintFieldComment(printer, field);
+
+  bool have_enclosing_if = false;
+  if (!field->is_repeated() && HasFieldPresence(descriptor_->file())) {
+    printer->Print(
+      "if (has_$name$()) {\n",
+      "name", FieldName(field));
+    printer->Indent();
+    have_enclosing_if = true;
+  } else if (!HasFieldPresence(descriptor_->file())) {
+    have_enclosing_if = EmitFieldNonDefaultCondition(printer, "this->", field);
+  }
+
+  if (to_array) {
+    field_generators_.get(field).GenerateSerializeWithCachedSizesToArray(
+        printer);
+  } else {
+    field_generators_.get(field).GenerateSerializeWithCachedSizes(printer);
+  }
+
+  if (have_enclosing_if) {
+    printer->Outdent();
+    printer->Print("}\n");
+  }
+  printer->Print("\n");
+}
+
+void MessageGenerator::GenerateSerializeOneExtensionRange(
+    io::Printer* printer, const Descriptor::ExtensionRange* range,
     bool to_array) {
   map<string, string> vars;
   vars["start"] = SimpleItoa(range->start);
@@ -2850,6 +3934,26 @@ GenerateSerializeWithCachedSizes(io::Printer* printer) {
     return;
   }
 
+  if (UseTableDrivenSerialization()) {
+    printer->Print(
+      "void $classname$::SerializeWithCachedSizes(\n"
+      "    ::google::protobuf::io::CodedOutputStream* output) const {\n"
+      "  // @@protoc_insertion_point(serialize_start:$full_name$)\n"
+      "  ::google::protobuf::GoogleOnceInit(&$classname$_table_once_,\n"
+      "                 &$classname$::InitMessageTable);\n"
+      "  ::google::protobuf::internal::TableDrivenMessage::SerializeWithCachedSizes(\n"
+      "      *this, $classname$_table_, output);\n"
+      "  // @@protoc_insertion_point(serialize_end:$full_name$)\n"
+      "}\n",
+      "classname", classname_,
+      "full_name", descriptor_->full_name());
+    if (HasUnusualFields()) {
+      printer->Print("\n");
+      GenerateSerializeUnusualFields(printer, false);
+    }
+    return;
+  }
+
   printer->Print(
     "void $classname$::SerializeWithCachedSizes(\n"
     "    ::google::protobuf::io::CodedOutputStream* output) const {\n",
@@ -2892,6 +3996,27 @@ GenerateSerializeWithCachedSizesToArray(io::Printer* printer) {
     return;
   }
 
+  if (UseTableDrivenSerialization()) {
+    printer->Print(
+      "::google::protobuf::uint8* $classname$::SerializeWithCachedSizesToArray(\n"
+      "    ::google::protobuf::uint8* target) const {\n"
+      "  // @@protoc_insertion_point(serialize_to_array_start:$full_name$)\n"
+      "  ::google::protobuf::GoogleOnceInit(&$classname$_table_once_,\n"
+      "                 &$classname$::InitMessageTable);\n"
+      "  target = ::google::protobuf::internal::TableDrivenMessage::\n"
+      "      SerializeWithCachedSizesToArray(*this, $classname$_table_, target);\n"
+      "  // @@protoc_insertion_point(serialize_to_array_end:$full_name$)\n"
+      "  return target;\n"
+      "}\n",
+      "classname", classname_,
+      "full_name", descriptor_->full_name());
+    if (HasUnusualFields()) {
+      printer->Print("\n");
+      GenerateSerializeUnusualFields(printer, true);
+    }
+    return;
+  }
+
   printer->Print(
     "::google::protobuf::uint8* $classname$::SerializeWithCachedSizesToArray(\n"
     "    ::google::protobuf::uint8* target) const {\n",
@@ -2935,10 +4060,53 @@ GenerateSerializeWithCachedSizesBody(io::Printer* printer, bool to_array) {
       GenerateSerializeOneExtensionRange(printer,
                                          sorted_extensions[j++],
                                          to_array);
-    } else if (j == sorted_extensions.size()) {
-      GenerateSerializeOneField(printer, ordered_fields[i++], to_array);
-    } else if (ordered_fields[i]->number() < sorted_extensions[j]->start) {
-      GenerateSerializeOneField(printer, ordered_fields[i++], to_array);
+    } else if (j == sorted_extensions.size() ||
+               ordered_fields[i]->number() < sorted_extensions[j]->start) {
+      // Fields which come next in both number order and has-bit order, with
+      // their has-bits in the same word, can be written by visiting only the
+      // bits which are set.
+      int end = i + 1;
+      if (HasFieldPresence(descriptor_->file()) &&
+          !ordered_fields[i]->is_repeated() &&
+          !ordered_fields[i]->containing_oneof()) {
+        while (end < descriptor_->field_count() &&
+               !ordered_fields[end]->is_repeated() &&
+               !ordered_fields[end]->containing_oneof() &&
+               ordered_fields[end]->index() / 32 ==
+                   ordered_fields[i]->index() / 32 &&
+               ordered_fields[end]->index() > ordered_fields[end - 1]->index() &&
+               (j == sorted_extensions.size() ||
+                ordered_fields[end]->number() < sorted_extensions[j]->start)) {
+          end++;
+        }
+      }
+      if (end - i >= kMinFieldsToIterateHasBits) {
+        vector<const FieldDescriptor*> fields(&ordered_fields[i],
+                                              &ordered_fields[end]);
+        GenerateHasBitsLoopBegin(printer, "", fields[0]->index() / 32, fields);
+        for (int k = 0; k < fields.size(); k++) {
+          PrintFieldComment(printer, fields[k]);
+          printer->Print(
+            "case $bit$: {\n",
+            "bit", SimpleItoa(fields[k]->index() % 32));
+          printer->Indent();
+          if (to_array) {
+            field_generators_.get(fields[k])
+                .GenerateSerializeWithCachedSizesToArray(printer);
+          } else {
+            field_generators_.get(fields[k])
+                .GenerateSerializeWithCachedSizes(printer);
+          }
+          printer->Print("break;\n");
+          printer->Outdent();
+          printer->Print("}\n");
+        }
+        GenerateHasBitsLoopEnd(printer);
+        printer->Print("\n");
+        i = end;
+      } else {
+        GenerateSerializeOneField(printer, ordered_fields[i++], to_array);
+      }
     } else {
       GenerateSerializeOneExtensionRange(printer,
                                          sorted_extensions[j++],
@@ -2946,6 +4114,11 @@ GenerateSerializeWithCachedSizesBody(io::Printer* printer, bool to_array) {
     }
   }
 
+  GenerateSerializeUnknownFields(printer, to_array);
+}
+
+void MessageGenerator::
+GenerateSerializeUnknownFields(io::Printer* printer, bool to_array) {
   if (PreserveUnknownFields(descriptor_)) {
     if (UseUnknownFieldSet(descriptor_->file())) {
       printer->Print("if (_internal_metadata_.have_unknown_fields()) {\n");
@@ -2972,6 +4145,74 @@ GenerateSerializeWithCachedSizesBody(io::Printer* printer, bool to_array) {
   }
 }
 
+void MessageGenerator::
+GenerateSerializeUnusualFields(io::Printer* printer, bool to_array) {
+  map<string, string> vars;
+  vars["classname"] = classname_;
+  if (to_array) {
+    printer->Print(vars,
+      "::google::protobuf::uint8* $classname$::SerializeUnusualFieldsToArray(\n"
+      "    const ::google::protobuf::MessageLite* msg, int end, ::google::protobuf::uint8* target) {\n"
+      "  return static_cast<const $classname$*>(msg)->\n"
+      "      SerializeUnusualFieldsWithCachedSizesToArray(end, target);\n"
+      "}\n"
+      "\n"
+      "::google::protobuf::uint8* $classname$::SerializeUnusualFieldsWithCachedSizesToArray(\n"
+      "    int end, ::google::protobuf::uint8* target) const {\n");
+  } else {
+    printer->Print(vars,
+      "void $classname$::SerializeUnusualFields(\n"
+      "    const ::google::protobuf::MessageLite* msg, int end,\n"
+      "    ::google::protobuf::io::CodedOutputStream* output) {\n"
+      "  static_cast<const $classname$*>(msg)->\n"
+      "      SerializeUnusualFieldsWithCachedSizes(end, output);\n"
+      "}\n"
+      "\n"
+      "void $classname$::SerializeUnusualFieldsWithCachedSizes(\n"
+      "    int end, ::google::protobuf::io::CodedOutputStream* output) const {\n");
+  }
+  printer->Indent();
+
+  // |end| is the number of the table field following the fields to write.
+  map<int, vector<UnusualItem> > groups =
+      GroupUnusualItems(descriptor_, options_);
+  const int kEnd = FieldDescriptor::kMaxNumber + 1;
+  if (PreserveUnknownFields(descriptor_)) groups[kEnd];
+
+  printer->Print("switch (end) {\n");
+  printer->Indent();
+  for (map<int, vector<UnusualItem> >::const_iterator it = groups.begin();
+       it != groups.end(); ++it) {
+    printer->Print("case $end$: {\n",
+      "end", it->first == kEnd ?
+          "::google::protobuf::internal::TableDrivenMessage::kFieldNumberEnd" :
+          SimpleItoa(it->first));
+    printer->Indent();
+    for (int i = 0; i < it->second.size(); i++) {
+      const UnusualItem& item = it->second[i];
+      if (item.field != NULL) {
+        GenerateSerializeOneField(printer, item.field, to_array);
+      } else {
+        GenerateSerializeOneExtensionRange(printer, item.range, to_array);
+      }
+    }
+    if (it->first == kEnd) {
+      GenerateSerializeUnknownFields(printer, to_array);
+    }
+    printer->Print("break;\n");
+    printer->Outdent();
+    printer->Print("}\n");
+  }
+  printer->Outdent();
+  printer->Print("}\n");
+  if (to_array) {
+    printer->Print("return target;\n");
+  }
+
+  printer->Outdent();
+  printer->Print("}\n");
+}
+
 static vector<uint32> RequiredFieldsBitMask(const Descriptor* desc) {
   vector<uint32> result;
   uint32 mask = 0;
@@ -3034,6 +4275,26 @@ GenerateByteSize(io::Printer* printer) {
     return;
   }
 
+  if (UseTableDrivenSerialization()) {
+    printer->Print(
+      "int $classname$::ByteSize() const {\n"
+      "  ::google::protobuf::GoogleOnceInit(&$classname$_table_once_,\n"
+      "                 &$classname$::InitMessageTable);\n"
+      "  int total_size = ::google::protobuf::internal::TableDrivenMessage::ByteSize(\n"
+      "      *this, $classname$_table_);\n"
+      "  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();\n"
+      "  _cached_size_ = total_size;\n"
+      "  GOOGLE_SAFE_CONCURRENT_WRITES_END();\n"
+      "  return total_size;\n"
+      "}\n",
+      "classname", classname_);
+    if (HasUnusualFields()) {
+      printer->Print("\n");
+      GenerateUnusualFieldsByteSize(printer);
+    }
+    return;
+  }
+
   if (num_required_fields_ > 1 && HasFieldPresence(descriptor_->file())) {
     // Emit a function (rarely used, we hope) that handles the required fields
     // by checking for each one individually.
@@ -3202,6 +4463,33 @@ GenerateByteSize(io::Printer* printer) {
 
   // Fields inside a oneof don't use _has_bits_ so we count them in a separate
   // pass.
+  GenerateOneofByteSize(printer);
+
+  if (descriptor_->extension_range_count() > 0) {
+    printer->Print(
+      "total_size += _extensions_.ByteSize();\n"
+      "\n");
+  }
+
+  GenerateUnknownFieldsByteSize(printer);
+
+  // We update _cached_size_ even though this is a const method.  In theory,
+  // this is not thread-compatible, because concurrent writes have undefined
+  // results.  In practice, since any concurrent writes will be writing the
+  // exact same value, it works on all common processors.  In a future version
+  // of C++, _cached_size_ should be made into an atomic<int>.
+  printer->Print(
+    "GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();\n"
+    "_cached_size_ = total_size;\n"
+    "GOOGLE_SAFE_CONCURRENT_WRITES_END();\n"
+    "return total_size;\n");
+
+  printer->Outdent();
+  printer->Print("}\n");
+}
+
+void MessageGenerator::
+GenerateOneofByteSize(io::Printer* printer) {
   for (int i = 0; i < descriptor_->oneof_decl_count(); i++) {
     printer->Print(
         "switch ($oneofname$_case()) {\n",
@@ -3231,13 +4519,10 @@ GenerateByteSize(io::Printer* printer) {
     printer->Print(
         "}\n");
   }
+}
 
-  if (descriptor_->extension_range_count() > 0) {
-    printer->Print(
-      "total_size += _extensions_.ByteSize();\n"
-      "\n");
-  }
-
+void MessageGenerator::
+GenerateUnknownFieldsByteSize(io::Printer* printer) {
   if (PreserveUnknownFields(descriptor_)) {
     if (UseUnknownFieldSet(descriptor_->file())) {
       printer->Print(
@@ -3252,18 +4537,53 @@ GenerateByteSize(io::Printer* printer) {
         "\n");
     }
   }
+}
 
-  // We update _cached_size_ even though this is a const method.  In theory,
-  // this is not thread-compatible, because concurrent writes have undefined
-  // results.  In practice, since any concurrent writes will be writing the
-  // exact same value, it works on all common processors.  In a future version
-  // of C++, _cached_size_ should be made into an atomic<int>.
+void MessageGenerator::
+GenerateUnusualFieldsByteSize(io::Printer* printer) {
   printer->Print(
-    "GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();\n"
-    "_cached_size_ = total_size;\n"
-    "GOOGLE_SAFE_CONCURRENT_WRITES_END();\n"
-    "return total_size;\n");
+    "int $classname$::UnusualFieldsByteSize(const ::google::protobuf::MessageLite* msg) {\n"
+    "  return static_cast<const $classname$*>(msg)->ComputeUnusualFieldsByteSize();\n"
+    "}\n"
+    "\n"
+    "int $classname$::ComputeUnusualFieldsByteSize() const {\n",
+    "classname", classname_);
+  printer->Indent();
+  printer->Print(
+    "int total_size = 0;\n"
+    "\n");
+
+  // Map fields and cold fields.  Oneof members are handled below.
+  for (int i = 0; i < descriptor_->field_count(); i++) {
+    const FieldDescriptor* field = descriptor_->field(i);
+    if (IsTableDrivenField(field, options_) ||
+        field->containing_oneof() != NULL) {
+      continue;
+    }
+    PrintFieldComment(printer, field);
+    if (IsColdField(field, options_)) {
+      printer->Print("if (has_$name$()) {\n", "name", FieldName(field));
+      printer->Indent();
+      field_generators_.get(field).GenerateByteSize(printer);
+      printer->Outdent();
+      printer->Print("}\n");
+    } else {
+      field_generators_.get(field).GenerateByteSize(printer);
+    }
+    printer->Print("\n");
+  }
+
+  GenerateOneofByteSize(printer);
+
+  if (descriptor_->extension_range_count() > 0) {
+    printer->Print(
+      "total_size += _extensions_.ByteSize();\n"
+      "\n");
+  }
 
+  GenerateUnknownFieldsByteSize(printer);
+
+  printer->Print("return total_size;\n");
   printer->Outdent();
   printer->Print("}\n");
 }
@@ -3314,7 +4634,13 @@ GenerateIsInitialized(io::Printer* printer) {
           " return false;\n",
           "name", FieldName(field));
       } else {
-        if (field->options().weak() || !field->containing_oneof()) {
+        if (IsColdField(field, options_)) {
+          printer->Print(
+              "if (has_$name$()) {\n"
+              "  if (!_cold_->$name$_->IsInitialized()) return false;\n"
+              "}\n",
+            "name", FieldName(field));
+        } else if (field->options().weak() || !field->containing_oneof()) {
           // For weak fields, use the data member (::google::protobuf::Message*) instead
           // of the getter to avoid a link dependency on the weak message type
           // which is only forward declared.
@@ -57,6 +57,7 @@ namespace cpp {
 
 class EnumGenerator;           // enum.h
 class ExtensionGenerator;      // extension.h
+struct DataMember;             // cpp_message.cc
 
 class MessageGenerator {
  public:
@@ -113,6 +114,13 @@ class MessageGenerator {
   // Generate all non-inline methods for this class.
   void GenerateClassMethods(io::Printer* printer);
 
+  // Generate one line per message, for this class and its nested types, with
+  // the estimated padding between the class's data members and how much the
+  // member order chosen by GenerateClassDefinition() saves compared to the
+  // order earlier versions of the generator used.  See
+  // Options::layout_report.
+  void GenerateLayoutReport(io::Printer* printer);
+
  private:
   // Generate declarations and definitions of accessors for fields.
   void GenerateFieldAccessorDeclarations(io::Printer* printer);
@@ -134,6 +142,16 @@ class MessageGenerator {
   void GenerateSharedDestructorCode(io::Printer* printer);
   // Generate the arena-specific destructor code.
   void GenerateArenaDestructorCode(io::Printer* printer);
+  // Generate the constructor and destructor of the struct of cold fields.
+  void GenerateColdFieldsStructors(io::Printer* printer);
+
+  // Generate the union which holds the fields of a oneof.
+  void GenerateOneofUnion(io::Printer* printer, const OneofDescriptor* oneof);
+  // Append the data members of the class to |members|, in the order
+  // GenerateClassDefinition() emits them.  If |previous_order| is true, use
+  // the order earlier versions of the generator emitted them in instead,
+  // which GenerateLayoutReport() compares against.
+  void OrderDataMembers(bool previous_order, vector<DataMember>* members);
 
   // Generate standard Message methods.
   void GenerateClear(io::Printer* printer);
@@ -149,6 +167,41 @@ class MessageGenerator {
   void GenerateSwap(io::Printer* printer);
   void GenerateIsInitialized(io::Printer* printer);
 
+  // Helpers for GenerateMergeFrom() and GenerateSerializeWithCachedSizes(),
+  // which visit the set has-bits of a word of _has_bits_ with a loop around a
+  // switch on the bit index; the caller prints the cases in between.
+  bool IterateHasBitsOfWord(int word) const;
+  void GenerateHasBitsLoopBegin(io::Printer* printer, const string& prefix,
+                                int word,
+                                const vector<const FieldDescriptor*>& fields);
+  void GenerateHasBitsLoopEnd(io::Printer* printer);
+  // Merges the fields of one word of from._has_bits_ that way.
+  void GenerateMergeHasBitsWord(io::Printer* printer, int word);
+
+  // Helpers for GenerateMergeFromCodedStream().
+  void GenerateMergeAlternateEncoding(io::Printer* printer,
+                                      const FieldDescriptor* field);
+  void GenerateHandleUnusualTag(io::Printer* printer, const char* done);
+  void GenerateTableDrivenMergeFromCodedStream(io::Printer* printer);
+  void GenerateMergeUnusualFieldFromCodedStream(io::Printer* printer);
+
+  // Generates the message table used by table-driven parsing and
+  // serialization, and the function which fills it in.
+  void GenerateMessageTable(io::Printer* printer);
+  void GenerateMessageTableInitializer(io::Printer* printer);
+
+  // True if MergePartialFromCodedStream() uses the table-driven parser in
+  // generated_message_util.h; see Options::table_driven_parsing.
+  bool UseTableDrivenParsing() const;
+  // True if SerializeWithCachedSizes() and ByteSize() use the table-driven
+  // serializer; see Options::table_driven_serialization.
+  bool UseTableDrivenSerialization() const;
+  // True if either of the above is, so the message has a MessageTable.
+  bool UseMessageTable() const;
+  // True if the message has fields or extensions which the table-driven
+  // serializer leaves to generated code, or preserves unknown fields.
+  bool HasUnusualFields() const;
+
   // Helpers for GenerateSerializeWithCachedSizes().
   void GenerateSerializeOneField(io::Printer* printer,
                                  const FieldDescriptor* field,
@@ -156,18 +209,31 @@ class MessageGenerator {
   void GenerateSerializeOneExtensionRange(
       io::Printer* printer, const Descriptor::ExtensionRange* range,
       bool unbounded);
+  void GenerateSerializeUnknownFields(io::Printer* printer, bool to_array);
+  void GenerateSerializeUnusualFields(io::Printer* printer, bool to_array);
+
+  // Helpers for GenerateByteSize().
+  void GenerateOneofByteSize(io::Printer* printer);
+  void GenerateUnknownFieldsByteSize(io::Printer* printer);
+  void GenerateUnusualFieldsByteSize(io::Printer* printer);
 
 
   const Descriptor* descriptor_;
   string classname_;
   Options options_;
   FieldGeneratorMap field_generators_;
+  // Fields which are data members of the class, in the order they are
+  // declared in it (see OptimizePadding()).
+  vector<const FieldDescriptor*> optimized_order_;
   vector< vector<string> > runs_of_fields_;  // that might be trivially cleared
   google::protobuf::scoped_array<google::protobuf::scoped_ptr<MessageGenerator> > nested_generators_;
   google::protobuf::scoped_array<google::protobuf::scoped_ptr<EnumGenerator> > enum_generators_;
   google::protobuf::scoped_array<google::protobuf::scoped_ptr<ExtensionGenerator> > extension_generators_;
   int num_required_fields_;
   bool uses_string_;
+  // Fields kept in the struct of cold fields (see IsColdField()), in
+  // declaration order.
+  vector<const FieldDescriptor*> cold_fields_;
 
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MessageGenerator);
 };
@@ -503,6 +503,86 @@ GenerateConstructorCode(io::Printer* printer) const {
 
 // ===================================================================
 
+MessageColdFieldGenerator::
+MessageColdFieldGenerator(const FieldDescriptor* descriptor,
+                          const Options& options)
+  : MessageFieldGenerator(descriptor, options) {
+  variables_["non_null_ptr_to_name"] =
+      StrCat("this->_cold_->", variables_["name"], "_");
+}
+
+MessageColdFieldGenerator::~MessageColdFieldGenerator() {}
+
+void MessageColdFieldGenerator::
+GenerateInlineAccessorDefinitions(io::Printer* printer) const {
+  printer->Print(variables_,
+    "inline const $type$& $classname$::$name$() const {\n"
+    "  // @@protoc_insertion_point(field_get:$full_name$)\n");
+
+  PrintHandlingOptionalStaticInitializers(
+    variables_, descriptor_->file(), printer,
+    // With static initializers.
+    "  return cold().$name$_ != NULL ? *cold().$name$_\n"
+    "                                : *default_instance_->_cold_->$name$_;\n",
+    // Without.
+    "  return cold().$name$_ != NULL ? *cold().$name$_\n"
+    "                                : *default_instance()._cold_->$name$_;\n");
+
+  printer->Print(variables_,
+    "}\n"
+    "inline $type$* $classname$::mutable_$name$() {\n"
+    "  $set_hasbit$\n"
+    "  if (mutable_cold()->$name$_ == NULL) {\n"
+    "    _cold_->$name$_ = new $type$;\n"
+    "  }\n"
+    "  // @@protoc_insertion_point(field_mutable:$full_name$)\n"
+    "  return _cold_->$name$_;\n"
+    "}\n"
+    "inline $type$* $classname$::$release_name$() {\n"
+    "  $clear_hasbit$\n"
+    "  if (_cold_ == NULL) {\n"
+    "    return NULL;\n"
+    "  }\n"
+    "  $type$* temp = _cold_->$name$_;\n"
+    "  _cold_->$name$_ = NULL;\n"
+    "  return temp;\n"
+    "}\n"
+    "inline void $classname$::set_allocated_$name$($type$* $name$) {\n"
+    "  delete mutable_cold()->$name$_;\n");
+
+  if (SupportsArenas(descriptor_->message_type())) {
+    printer->Print(variables_,
+    "  if ($name$ != NULL && $name$->GetArena() != NULL) {\n"
+    "    $type$* new_$name$ = new $type$;\n"
+    "    new_$name$->CopyFrom(*$name$);\n"
+    "    $name$ = new_$name$;\n"
+    "  }\n");
+  }
+
+  printer->Print(variables_,
+    "  _cold_->$name$_ = $name$;\n"
+    "  if ($name$) {\n"
+    "    $set_hasbit$\n"
+    "  } else {\n"
+    "    $clear_hasbit$\n"
+    "  }\n"
+    "  // @@protoc_insertion_point(field_set_allocated:$full_name$)\n"
+    "}\n");
+}
+
+void MessageColdFieldGenerator::
+GenerateClearingCode(io::Printer* printer) const {
+  printer->Print(variables_,
+    "if (_cold_->$name$_ != NULL) _cold_->$name$_->$type$::Clear();\n");
+}
+
+void MessageColdFieldGenerator::
+GenerateSwappingCode(io::Printer* printer) const {
+  // Don't print any swapping code. Swapping _cold_ will swap this field.
+}
+
+// ===================================================================
+
 RepeatedMessageFieldGenerator::
 RepeatedMessageFieldGenerator(const FieldDescriptor* descriptor,
                               const Options& options)
@@ -87,6 +87,23 @@ class MessageOneofFieldGenerator : public MessageFieldGenerator {
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MessageOneofFieldGenerator);
 };
 
+// See PrimitiveColdFieldGenerator.  Fields of files which support arenas are
+// never cold, so only the non-arena accessors are generated.
+class MessageColdFieldGenerator : public MessageFieldGenerator {
+ public:
+  explicit MessageColdFieldGenerator(const FieldDescriptor* descriptor,
+                                     const Options& options);
+  ~MessageColdFieldGenerator();
+
+  // implements FieldGenerator ---------------------------------------
+  void GenerateInlineAccessorDefinitions(io::Printer* printer) const;
+  void GenerateClearingCode(io::Printer* printer) const;
+  void GenerateSwappingCode(io::Printer* printer) const;
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(MessageColdFieldGenerator);
+};
+
 class RepeatedMessageFieldGenerator : public FieldGenerator {
  public:
   explicit RepeatedMessageFieldGenerator(const FieldDescriptor* descriptor,
@@ -33,6 +33,7 @@
 #ifndef GOOGLE_PROTOBUF_COMPILER_CPP_OPTIONS_H__
 #define GOOGLE_PROTOBUF_COMPILER_CPP_OPTIONS_H__
 
+#include <set>
 #include <string>
 
 #include <google/protobuf/stubs/common.h>
@@ -43,10 +44,21 @@ namespace cpp {
 
 // Generator options:
 struct Options {
-  Options() : safe_boundary_check(false) {
+  Options() : safe_boundary_check(false), table_driven_parsing(false),
+              table_driven_serialization(false), tag_dispatch_table(false),
+              layout_report(false) {
   }
   string dllexport_decl;
   bool safe_boundary_check;
+  bool table_driven_parsing;
+  bool table_driven_serialization;
+  // Dispatch parsed tags through a lookup table.
+  bool tag_dispatch_table;
+  // Also write a report of the padding in each generated class.
+  bool layout_report;
+  // Full names of the fields which are kept in their message's struct of cold
+  // fields.  Filled in from the field_usage_profile option.
+  set<string> cold_fields;
 };
 
 }  // namespace cpp
@@ -244,6 +244,58 @@ TEST(CppPluginTest, PluginTest) {
   EXPECT_EQ(0, cli.Run(5, argv));
 }
 
+TEST(CppPluginTest, LayoutReport) {
+  GOOGLE_CHECK_OK(File::SetContents(TestTempDir() + "/layout.proto",
+                             "syntax = \"proto2\";\n"
+                             "package foo;\n"
+                             "\n"
+                             "message Padded {\n"
+                             "  message Nested { optional int32 x = 1; }\n"
+                             "  optional int64 a = 1;\n"
+                             "  optional int32 b = 2;\n"
+                             "  oneof o {\n"
+                             "    int64 c = 3;\n"
+                             "    string d = 4;\n"
+                             "  }\n"
+                             "}\n",
+                             true));
+
+  google::protobuf::compiler::CommandLineInterface cli;
+  cli.SetInputsAreProtoPathRelative(true);
+
+  CppGenerator cpp_generator;
+  cli.RegisterGenerator("--cpp_out", &cpp_generator, "");
+
+  string proto_path = "-I" + TestTempDir();
+  string cpp_out = "--cpp_out=layout_report:" + TestTempDir();
+
+  const char* argv[] = {
+    "protoc",
+    proto_path.c_str(),
+    cpp_out.c_str(),
+    "layout.proto"
+  };
+
+  EXPECT_EQ(0, cli.Run(4, argv));
+
+  string report;
+  GOOGLE_CHECK_OK(File::GetContents(TestTempDir() + "/layout.pb.layout",
+                             &report, true));
+  // The previous member order put the union after the fields, which end in
+  // an incomplete 4-byte block, so it padded before the union and at the end
+  // of the class.  The generated order puts the union before the fields and
+  // needs no padding.
+  EXPECT_EQ(
+      "# Estimated padding in the classes generated for layout.proto, "
+      "assuming\n"
+      "# 64-bit pointers.\n"
+      "foo.Padded: 0 bytes of padding, 8 with the previous member order "
+      "(saves 8 bytes)\n"
+      "foo.Padded.Nested: 4 bytes of padding, 4 with the previous member "
+      "order (saves 0 bytes)\n",
+      report);
+}
+
 }  // namespace
 }  // namespace cpp
 }  // namespace compiler
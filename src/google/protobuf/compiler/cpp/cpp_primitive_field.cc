@@ -252,6 +252,49 @@ GenerateMergeFromCodedStream(io::Printer* printer) const {
 
 // ===================================================================
 
+PrimitiveColdFieldGenerator::
+PrimitiveColdFieldGenerator(const FieldDescriptor* descriptor,
+                            const Options& options)
+  : PrimitiveFieldGenerator(descriptor, options) {
+}
+
+PrimitiveColdFieldGenerator::~PrimitiveColdFieldGenerator() {}
+
+void PrimitiveColdFieldGenerator::
+GenerateInlineAccessorDefinitions(io::Printer* printer) const {
+  printer->Print(variables_,
+    "inline $type$ $classname$::$name$() const {\n"
+    "  // @@protoc_insertion_point(field_get:$full_name$)\n"
+    "  return cold().$name$_;\n"
+    "}\n"
+    "inline void $classname$::set_$name$($type$ value) {\n"
+    "  $set_hasbit$\n"
+    "  mutable_cold()->$name$_ = value;\n"
+    "  // @@protoc_insertion_point(field_set:$full_name$)\n"
+    "}\n");
+}
+
+void PrimitiveColdFieldGenerator::
+GenerateClearingCode(io::Printer* printer) const {
+  printer->Print(variables_, "_cold_->$name$_ = $default$;\n");
+}
+
+void PrimitiveColdFieldGenerator::
+GenerateSwappingCode(io::Printer* printer) const {
+  // Don't print any swapping code. Swapping _cold_ will swap this field.
+}
+
+void PrimitiveColdFieldGenerator::
+GenerateMergeFromCodedStream(io::Printer* printer) const {
+  printer->Print(variables_,
+    "DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<\n"
+    "         $type$, $wire_format_field_type$>(\n"
+    "       input, &mutable_cold()->$name$_)));\n"
+    "$set_hasbit$\n");
+}
+
+// ===================================================================
+
 RepeatedPrimitiveFieldGenerator::
 RepeatedPrimitiveFieldGenerator(const FieldDescriptor* descriptor,
                                 const Options& options)
@@ -88,6 +88,27 @@ class PrimitiveOneofFieldGenerator : public PrimitiveFieldGenerator {
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(PrimitiveOneofFieldGenerator);
 };
 
+// Generates a field which is kept in the message's struct of cold fields (see
+// IsColdField()).  The inherited GeneratePrivateMembers(),
+// GenerateConstructorCode() and GenerateDestructorCode() are used to declare,
+// initialize and destroy the member of that struct.  The clearing code is only
+// run if the field is set, so it may assume that the struct is allocated.
+class PrimitiveColdFieldGenerator : public PrimitiveFieldGenerator {
+ public:
+  explicit PrimitiveColdFieldGenerator(const FieldDescriptor* descriptor,
+                                       const Options& options);
+  ~PrimitiveColdFieldGenerator();
+
+  // implements FieldGenerator ---------------------------------------
+  void GenerateInlineAccessorDefinitions(io::Printer* printer) const;
+  void GenerateClearingCode(io::Printer* printer) const;
+  void GenerateSwappingCode(io::Printer* printer) const;
+  void GenerateMergeFromCodedStream(io::Printer* printer) const;
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(PrimitiveColdFieldGenerator);
+};
+
 class RepeatedPrimitiveFieldGenerator : public FieldGenerator {
  public:
   explicit RepeatedPrimitiveFieldGenerator(const FieldDescriptor* descriptor,
@@ -651,6 +651,87 @@ GenerateMergeFromCodedStream(io::Printer* printer) const {
 }
 
 
+// ===================================================================
+
+StringColdFieldGenerator::
+StringColdFieldGenerator(const FieldDescriptor* descriptor,
+                         const Options& options)
+  : StringFieldGenerator(descriptor, options) {
+}
+
+StringColdFieldGenerator::~StringColdFieldGenerator() {}
+
+void StringColdFieldGenerator::
+GenerateInlineAccessorDefinitions(io::Printer* printer) const {
+  printer->Print(variables_,
+    "inline const ::std::string& $classname$::$name$() const {\n"
+    "  // @@protoc_insertion_point(field_get:$full_name$)\n"
+    "  return cold().$name$_.GetNoArena($default_variable$);\n"
+    "}\n"
+    "inline void $classname$::set_$name$(const ::std::string& value) {\n"
+    "  $set_hasbit$\n"
+    "  mutable_cold()->$name$_.SetNoArena($default_variable$, value);\n"
+    "  // @@protoc_insertion_point(field_set:$full_name$)\n"
+    "}\n"
+    "inline void $classname$::set_$name$(const char* value) {\n"
+    "  $set_hasbit$\n"
+    "  mutable_cold()->$name$_.SetNoArena($default_variable$,\n"
+    "      $string_piece$(value));\n"
+    "  // @@protoc_insertion_point(field_set_char:$full_name$)\n"
+    "}\n"
+    "inline "
+    "void $classname$::set_$name$(const $pointer_type$* value, "
+    "size_t size) {\n"
+    "  $set_hasbit$\n"
+    "  mutable_cold()->$name$_.SetNoArena($default_variable$,\n"
+    "      $string_piece$(reinterpret_cast<const char*>(value), size));\n"
+    "  // @@protoc_insertion_point(field_set_pointer:$full_name$)\n"
+    "}\n"
+    "inline ::std::string* $classname$::mutable_$name$() {\n"
+    "  $set_hasbit$\n"
+    "  // @@protoc_insertion_point(field_mutable:$full_name$)\n"
+    "  return mutable_cold()->$name$_.MutableNoArena($default_variable$);\n"
+    "}\n"
+    "inline ::std::string* $classname$::$release_name$() {\n"
+    "  $clear_hasbit$\n"
+    "  if (_cold_ == NULL) {\n"
+    "    return NULL;\n"
+    "  }\n"
+    "  return _cold_->$name$_.ReleaseNoArena($default_variable$);\n"
+    "}\n"
+    "inline void $classname$::set_allocated_$name$(::std::string* $name$) {\n"
+    "  if ($name$ != NULL) {\n"
+    "    $set_hasbit$\n"
+    "  } else {\n"
+    "    $clear_hasbit$\n"
+    "  }\n"
+    "  mutable_cold()->$name$_.SetAllocatedNoArena($default_variable$, "
+    "$name$);\n"
+    "  // @@protoc_insertion_point(field_set_allocated:$full_name$)\n"
+    "}\n");
+}
+
+void StringColdFieldGenerator::
+GenerateClearingCode(io::Printer* printer) const {
+  if (descriptor_->default_value_string().empty()) {
+    printer->Print(variables_,
+      "_cold_->$name$_.ClearToEmptyNoArena($default_variable$);\n");
+  } else {
+    printer->Print(variables_,
+      "_cold_->$name$_.ClearToDefaultNoArena($default_variable$);\n");
+  }
+}
+
+void StringColdFieldGenerator::
+GenerateMergingCode(io::Printer* printer) const {
+  printer->Print(variables_, "set_$name$(from.$name$());\n");
+}
+
+void StringColdFieldGenerator::
+GenerateSwappingCode(io::Printer* printer) const {
+  // Don't print any swapping code. Swapping _cold_ will swap this field.
+}
+
 // ===================================================================
 
 RepeatedStringFieldGenerator::
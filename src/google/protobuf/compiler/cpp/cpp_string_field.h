@@ -94,6 +94,24 @@ class StringOneofFieldGenerator : public StringFieldGenerator {
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(StringOneofFieldGenerator);
 };
 
+// See PrimitiveColdFieldGenerator.  Fields of files which support arenas are
+// never cold, so only the non-arena accessors are generated.
+class StringColdFieldGenerator : public StringFieldGenerator {
+ public:
+  explicit StringColdFieldGenerator(const FieldDescriptor* descriptor,
+                                    const Options& options);
+  ~StringColdFieldGenerator();
+
+  // implements FieldGenerator ---------------------------------------
+  void GenerateInlineAccessorDefinitions(io::Printer* printer) const;
+  void GenerateClearingCode(io::Printer* printer) const;
+  void GenerateMergingCode(io::Printer* printer) const;
+  void GenerateSwappingCode(io::Printer* printer) const;
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(StringColdFieldGenerator);
+};
+
 class RepeatedStringFieldGenerator : public FieldGenerator {
  public:
   explicit RepeatedStringFieldGenerator(const FieldDescriptor* descriptor,
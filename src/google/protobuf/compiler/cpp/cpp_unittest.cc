@@ -50,6 +50,7 @@
 #ifndef _SHARED_PTR_H
 #include <google/protobuf/stubs/shared_ptr.h>
 #endif
+#include <utility>
 #include <vector>
 
 #include <google/protobuf/unittest.pb.h>
@@ -62,6 +63,7 @@
 #include <google/protobuf/compiler/importer.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/wire_format.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
 #include <google/protobuf/dynamic_message.h>
@@ -509,6 +511,37 @@ TEST(GeneratedMessageTest, CopyAssignmentOperator) {
   TestUtil::ExpectAllFieldsSet(message2);
 }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+TEST(GeneratedMessageTest, MoveConstructor) {
+  unittest::TestAllTypes message1;
+  TestUtil::SetAllFields(&message1);
+  const string* string_field = &message1.optional_string();
+
+  unittest::TestAllTypes message2(std::move(message1));
+  TestUtil::ExpectAllFieldsSet(message2);
+  // The fields were taken, not copied.
+  EXPECT_EQ(string_field, &message2.optional_string());
+  TestUtil::ExpectClear(message1);
+}
+
+TEST(GeneratedMessageTest, MoveAssignmentOperator) {
+  unittest::TestAllTypes message1;
+  TestUtil::SetAllFields(&message1);
+  const string* string_field = &message1.optional_string();
+
+  unittest::TestAllTypes message2;
+  message2.set_optional_int32(1);
+  message2 = std::move(message1);
+  TestUtil::ExpectAllFieldsSet(message2);
+  EXPECT_EQ(string_field, &message2.optional_string());
+
+  // Moving to self keeps the fields.
+  unittest::TestAllTypes& alias = message2;
+  message2 = std::move(alias);
+  TestUtil::ExpectAllFieldsSet(message2);
+}
+#endif  // GOOGLE_PROTOBUF_CXX11
+
 #if !defined(PROTOBUF_TEST_NO_DESCRIPTORS) || \
     !defined(GOOGLE_PROTOBUF_NO_RTTI)
 TEST(GeneratedMessageTest, UpcastCopyFrom) {
@@ -638,6 +671,51 @@ TEST(GeneratedMessageTest, SerializationToStream) {
 
 }
 
+// MergeFrom(), serialization and Clear() visit only the has-bits which are set
+// in wide has-bit words.
+TEST(GeneratedMessageTest, SparseFields) {
+  unittest::TestAllTypes message1, message2;
+  message1.set_default_int32(3);  // In the second has-bit word.
+  message1.set_optional_fixed32(2);
+  message1.set_optional_int32(1);
+  message1.mutable_optional_nested_message()->set_bb(4);
+
+  message2.MergeFrom(message1);
+  EXPECT_TRUE(message2.has_optional_int32());
+  EXPECT_FALSE(message2.has_optional_int64());
+  EXPECT_TRUE(message2.has_optional_fixed32());
+  EXPECT_TRUE(message2.has_optional_nested_message());
+  EXPECT_FALSE(message2.has_optional_string());
+  EXPECT_TRUE(message2.has_default_int32());
+  EXPECT_EQ(1, message2.optional_int32());
+  EXPECT_EQ(2, message2.optional_fixed32());
+  EXPECT_EQ(4, message2.optional_nested_message().bb());
+  EXPECT_EQ(3, message2.default_int32());
+
+  // Fields are written in field number order.
+  string expected;
+  {
+    io::StringOutputStream raw_output(&expected);
+    io::CodedOutputStream output(&raw_output);
+    internal::WireFormatLite::WriteInt32(1, 1, &output);
+    internal::WireFormatLite::WriteFixed32(7, 2, &output);
+    output.WriteTag(internal::WireFormatLite::MakeTag(
+        18, internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+    output.WriteVarint32(2);
+    internal::WireFormatLite::WriteInt32(1, 4, &output);
+    internal::WireFormatLite::WriteInt32(61, 3, &output);
+  }
+  EXPECT_EQ(expected, message2.SerializeAsString());
+
+  message2.Clear();
+  EXPECT_FALSE(message2.has_optional_int32());
+  EXPECT_FALSE(message2.has_default_int32());
+  EXPECT_EQ(0, message2.optional_int32());
+  EXPECT_EQ(41, message2.default_int32());
+  EXPECT_EQ(0, message2.optional_nested_message().bb());
+  EXPECT_EQ(0, message2.ByteSize());
+}
+
 TEST(GeneratedMessageTest, PackedFieldsSerializationToStream) {
   unittest::TestPackedTypes message1, message2;
   TestUtil::SetPackedFields(&message1);
@@ -656,6 +734,50 @@ TEST(GeneratedMessageTest, PackedFieldsSerializationToStream) {
   TestUtil::ExpectPackedFieldsSet(message2);
 }
 
+#ifndef PROTOBUF_TEST_NO_DESCRIPTORS
+
+TEST(GeneratedMessageTest, ParseFieldsInReverseOrder) {
+  // Generated parsers predict that fields arrive in field number order.
+  // Check that fields arriving in the opposite order still land in the right
+  // places.
+  unittest::TestAllTypes message1, message2;
+  TestUtil::SetAllFields(&message1);
+  message1.ByteSize();
+  vector<const FieldDescriptor*> fields;
+  message1.GetReflection()->ListFields(message1, &fields);
+  string data;
+  {
+    io::StringOutputStream string_stream(&data);
+    io::CodedOutputStream output_stream(&string_stream);
+    for (int i = fields.size() - 1; i >= 0; i--) {
+      internal::WireFormat::SerializeFieldWithCachedSizes(
+          fields[i], message1, &output_stream);
+    }
+  }
+  EXPECT_TRUE(message2.ParseFromString(data));
+  TestUtil::ExpectAllFieldsSet(message2);
+}
+
+#endif  // !PROTOBUF_TEST_NO_DESCRIPTORS
+
+TEST(GeneratedMessageTest, ParsePackedAndUnpackedEncodings) {
+  // Packed fields must accept unpacked values and vice versa.
+  unittest::TestPackedTypes packed;
+  unittest::TestUnpackedTypes unpacked;
+  TestUtil::SetPackedFields(&packed);
+  TestUtil::SetUnpackedFields(&unpacked);
+
+  unittest::TestPackedTypes packed_from_unpacked;
+  EXPECT_TRUE(packed_from_unpacked.ParseFromString(
+      unpacked.SerializeAsString()));
+  TestUtil::ExpectPackedFieldsSet(packed_from_unpacked);
+
+  unittest::TestUnpackedTypes unpacked_from_packed;
+  EXPECT_TRUE(unpacked_from_packed.ParseFromString(
+      packed.SerializeAsString()));
+  TestUtil::ExpectUnpackedFieldsSet(unpacked_from_packed);
+}
+
 
 TEST(GeneratedMessageTest, Required) {
   // Test that IsInitialized() returns false if required fields are missing.
@@ -972,6 +1094,41 @@ TEST(GeneratedEnumTest, IsValidValue) {
   EXPECT_FALSE(unittest::TestEnumWithDupValue_IsValid(4));
 }
 
+TEST(GeneratedEnumTest, IsValidValueLayouts) {
+  // IsValid() is generated differently for contiguous, gappy and sparse
+  // enums; check the edges of each.
+  EXPECT_FALSE(unittest::ForeignEnum_IsValid(3));
+  EXPECT_TRUE(unittest::ForeignEnum_IsValid(4));
+  EXPECT_TRUE(unittest::ForeignEnum_IsValid(6));
+  EXPECT_FALSE(unittest::ForeignEnum_IsValid(7));
+
+  EXPECT_FALSE(unittest::TestGappyEnum_IsValid(-6));
+  EXPECT_TRUE(unittest::TestGappyEnum_IsValid(-5));
+  EXPECT_FALSE(unittest::TestGappyEnum_IsValid(0));
+  EXPECT_TRUE(unittest::TestGappyEnum_IsValid(1));
+  EXPECT_TRUE(unittest::TestGappyEnum_IsValid(2));
+  EXPECT_FALSE(unittest::TestGappyEnum_IsValid(32));
+  EXPECT_TRUE(unittest::TestGappyEnum_IsValid(33));
+  EXPECT_TRUE(unittest::TestGappyEnum_IsValid(34));
+  EXPECT_FALSE(unittest::TestGappyEnum_IsValid(63));
+  EXPECT_TRUE(unittest::TestGappyEnum_IsValid(64));
+  EXPECT_FALSE(unittest::TestGappyEnum_IsValid(65));
+
+  EXPECT_TRUE(unittest::TestSparseEnum_IsValid(-53452));
+  EXPECT_TRUE(unittest::TestSparseEnum_IsValid(-15));
+  EXPECT_TRUE(unittest::TestSparseEnum_IsValid(0));
+  EXPECT_TRUE(unittest::TestSparseEnum_IsValid(12589234));
+  EXPECT_FALSE(unittest::TestSparseEnum_IsValid(-53453));
+  EXPECT_FALSE(unittest::TestSparseEnum_IsValid(1));
+  EXPECT_FALSE(unittest::TestSparseEnum_IsValid(12589235));
+
+  EXPECT_FALSE(unittest::TestAllTypes::NestedEnum_IsValid(kint32min));
+  EXPECT_FALSE(unittest::TestGappyEnum_IsValid(kint32min));
+  EXPECT_FALSE(unittest::TestGappyEnum_IsValid(kint32max));
+  EXPECT_FALSE(unittest::TestSparseEnum_IsValid(kint32min));
+  EXPECT_FALSE(unittest::TestSparseEnum_IsValid(kint32max));
+}
+
 TEST(GeneratedEnumTest, MinAndMax) {
   EXPECT_EQ(unittest::TestAllTypes::NEG,
             unittest::TestAllTypes::NestedEnum_MIN);
@@ -2052,6 +2209,28 @@ TEST_F(GeneratedServiceTest, NoGenericServices) {
 
 // ===================================================================
 
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+
+// Without static initializers, files that do not define extensions construct
+// their default instances the first time they are used rather than at load
+// time.  Nothing else in this test binary uses
+// unittest_embed_optimize_for.proto.
+TEST(StaticInitializerTest, DefaultInstanceConstructedOnFirstUse) {
+  EXPECT_TRUE(protobuf_unittest::TestEmbedOptimizedForSize::
+                  internal_default_instance() == NULL);
+
+  const protobuf_unittest::TestEmbedOptimizedForSize& message =
+      protobuf_unittest::TestEmbedOptimizedForSize::default_instance();
+  EXPECT_EQ(&message, protobuf_unittest::TestEmbedOptimizedForSize::
+                          internal_default_instance());
+  EXPECT_FALSE(message.has_optional_message());
+  EXPECT_EQ(0, message.optional_message().i());
+}
+
+#endif  // GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+
+// ===================================================================
+
 // This test must run last.  It verifies that descriptors were or were not
 // initialized depending on whether PROTOBUF_TEST_NO_DESCRIPTORS was defined.
 // When this is defined, we skip all tests which are expected to trigger
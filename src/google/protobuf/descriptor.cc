@@ -33,6 +33,7 @@
 //  Sanjay Ghemawat, Jeff Dean, and others.
 
 #include <google/protobuf/stubs/hash.h>
+#include <functional>
 #include <map>
 #include <set>
 #include <string>
@@ -52,6 +53,7 @@
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/tokenizer.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/stubs/atomicops.h>
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/stubs/once.h>
 #include <google/protobuf/stubs/stringprintf.h>
@@ -187,13 +189,13 @@ string ToCamelCase(const string& input, bool lower_first) {
   return result;
 }
 
-// A DescriptorPool contains a bunch of hash_maps to implement the
+// A DescriptorPool contains a bunch of hash tables to implement the
 // various Find*By*() methods.  Since hashtable lookups are O(1), it's
-// most efficient to construct a fixed set of large hash_maps used by
+// most efficient to construct a fixed set of large hash tables used by
 // all objects in the pool rather than construct one or more small
-// hash_maps for each object.
+// hash tables for each object.
 //
-// The keys to these hash_maps are (parent, name) or (parent, number)
+// The keys to these hash tables are (parent, name) or (parent, number)
 // pairs.  Unfortunately STL doesn't provide hash functions for pair<>,
 // so we must invent our own.
 //
@@ -203,6 +205,16 @@ string ToCamelCase(const string& input, bool lower_first) {
 
 typedef pair<const void*, const char*> PointerStringPair;
 
+// FNV-1a.  hash<const char*> cannot be used, since it is not a hash
+// function on platforms which lack hash_map.
+inline size_t HashCString(const char* str) {
+  size_t result = 2166136261u;
+  for (; *str != '\0'; str++) {
+    result = (result ^ static_cast<unsigned char>(*str)) * 16777619u;
+  }
+  return result;
+}
+
 struct PointerStringPairEqual {
   inline bool operator()(const PointerStringPair& a,
                          const PointerStringPair& b) const {
@@ -217,15 +229,22 @@ struct PointerIntegerPairHash {
     // no idea!  This seems a bit better than an XOR.
     return reinterpret_cast<intptr_t>(p.first) * ((1 << 16) - 1) + p.second;
   }
+};
 
-#ifdef _MSC_VER
-  // Used only by MSVC and platforms where hash_map is not available.
-  static const size_t bucket_size = 4;
-  static const size_t min_buckets = 8;
-#endif
-  inline bool operator()(const PairType& a, const PairType& b) const {
-    return a.first < b.first ||
-          (a.first == b.first && a.second < b.second);
+// Hashes and compares the strings pointed to, which may contain NULs.
+struct StringPointerHash {
+  size_t operator()(const string* s) const {
+    size_t result = 2166136261u;
+    for (int i = 0; i < s->size(); i++) {
+      result = (result ^ static_cast<unsigned char>((*s)[i])) * 16777619u;
+    }
+    return result;
+  }
+};
+
+struct StringPointerEqual {
+  inline bool operator()(const string* a, const string* b) const {
+    return *a == *b;
   }
 };
 
@@ -236,24 +255,118 @@ struct PointerStringPairHash {
   size_t operator()(const PointerStringPair& p) const {
     // FIXME(kenton):  What is the best way to compute this hash?  I have
     // no idea!  This seems a bit better than an XOR.
-    hash<const char*> cstring_hash;
     return reinterpret_cast<intptr_t>(p.first) * ((1 << 16) - 1) +
-           cstring_hash(p.second);
+           HashCString(p.second);
   }
+};
 
-#ifdef _MSC_VER
-  // Used only by MSVC and platforms where hash_map is not available.
-  static const size_t bucket_size = 4;
-  static const size_t min_buckets = 8;
-#endif
-  inline bool operator()(const PointerStringPair& a,
-                         const PointerStringPair& b) const {
-    if (a.first < b.first) return true;
-    if (a.first > b.first) return false;
-    return strcmp(a.second, b.second) < 0;
+// Spreads the bits of a hash over 32 bits, which pick an entry in a
+// FlatHashMap.  The hashes above leave the low bits of pointers, which are
+// always zero, in place.
+inline uint32 MixHash(size_t hash) {
+  return static_cast<uint32>(
+      (static_cast<uint64>(hash) * GOOGLE_ULONGLONG(0x9E3779B97F4A7C15)) >> 32);
+}
+
+// Keys in a FlatHashMap whose pointer is NULL mark empty entries.
+template<typename PairType>
+inline bool IsEmptyKey(const PairType& key) {
+  return key.first == NULL;
+}
+inline bool IsEmptyKey(const string* key) {
+  return key == NULL;
+}
+
+// An open-addressed hash table with linear probing, which the tables below
+// use in place of hash_map.  It keeps its entries in a single array rather
+// than allocating a node for each one, which takes less memory and usually
+// lets a lookup find its entry in the first cache line it touches.  Entries
+// are never removed.  The key's pointer must not be NULL.
+//
+// The capacity need not be a power of two, so that Compact() can size the
+// array to fit once everything has been added.
+template<typename Key, typename Value, typename Hash, typename Equal>
+class FlatHashMap {
+ public:
+  FlatHashMap() : entries_(NULL), capacity_(0), size_(0) {}
+  ~FlatHashMap() { delete [] entries_; }
+
+  // Returns NULL if not found.
+  const Value* Find(const Key& key) const {
+    if (entries_ == NULL) return NULL;
+    Equal equal;
+    // The table is never full, so this finds an empty entry.
+    for (uint32 i = Bucket(key);; i = Next(i)) {
+      const Entry& entry = entries_[i];
+      if (IsEmptyKey(entry.key)) return NULL;
+      if (equal(entry.key, key)) return &entry.value;
+    }
   }
+
+  // Returns false, and leaves the table unchanged, if the key is present.
+  bool Insert(const Key& key, const Value& value) {
+    if ((size_ + 1) * 4 > capacity_ * 3) {
+      Resize(capacity_ == 0 ? 4 : capacity_ * 2);
+    }
+    Equal equal;
+    uint32 i = Bucket(key);
+    for (; !IsEmptyKey(entries_[i].key); i = Next(i)) {
+      if (equal(entries_[i].key, key)) return false;
+    }
+    entries_[i].key = key;
+    entries_[i].value = value;
+    ++size_;
+    return true;
+  }
+
+  // Shrinks the array to the smallest one which is at most 3/4 full.  Call
+  // this when nothing more will be added.
+  void Compact() {
+    Resize(size_ == 0 ? 0 : size_ + size_ / 3 + 1);
+  }
+
+ private:
+  struct Entry {
+    Entry() : key(), value() {}
+    Key key;
+    Value value;
+  };
+
+  // Maps the mixed hash onto [0, capacity_) without dividing.
+  uint32 Bucket(const Key& key) const {
+    return static_cast<uint32>(
+        (static_cast<uint64>(MixHash(Hash()(key))) * capacity_) >> 32);
+  }
+  uint32 Next(uint32 i) const { return i + 1 == capacity_ ? 0 : i + 1; }
+
+  void Resize(uint32 capacity) {
+    Entry* old_entries = entries_;
+    uint32 old_capacity = capacity_;
+    entries_ = capacity == 0 ? NULL : new Entry[capacity];
+    capacity_ = capacity;
+    for (uint32 i = 0; i < old_capacity; i++) {
+      if (IsEmptyKey(old_entries[i].key)) continue;
+      uint32 j = Bucket(old_entries[i].key);
+      while (!IsEmptyKey(entries_[j].key)) j = Next(j);
+      entries_[j] = old_entries[i];
+    }
+    delete [] old_entries;
+  }
+
+  Entry* entries_;
+  uint32 capacity_;
+  uint32 size_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(FlatHashMap);
 };
 
+// Like FindPtrOrNull() in map_util.h.
+template<typename Key, typename Value, typename Hash, typename Equal>
+inline Value FindPtrOrNull(const FlatHashMap<Key, Value, Hash, Equal>& map,
+                           const Key& key) {
+  const Value* result = map.Find(key);
+  return result == NULL ? NULL : *result;
+}
 
 struct Symbol {
   enum Type {
@@ -316,25 +429,173 @@ struct Symbol {
 
 const Symbol kNullSymbol;
 
-typedef hash_map<const char*, Symbol,
-                 hash<const char*>, streq>
-  SymbolsByNameMap;
-typedef hash_map<PointerStringPair, Symbol,
-                 PointerStringPairHash, PointerStringPairEqual>
+// The tables of symbols and files by full name in DescriptorPool::Tables.
+// Like FlatHashMap, but it can be read without the pool's mutex while a file
+// is being built.  Entries are added as pending, and each is later either
+// committed, once the file which defines it has been built, or erased, if
+// building it failed.  FindCommitted() sees only committed entries and is
+// lock-free: an entry's state is stored with release semantics after the
+// rest of it has been written, and a committed entry never changes again.
+// Erased entries stay in place, so that they do not break probe sequences,
+// until the table grows.  Growing publishes a copy twice the size.  If reads
+// may overlap writes, the old array is kept until the table is destroyed,
+// since readers may still be probing it.  The names are not copied, so they
+// must outlive the table.
+template<typename Value>
+class NameTable {
+ public:
+  explicit NameTable(bool concurrent_reads)
+      : current_(0), used_(0), concurrent_reads_(concurrent_reads) {}
+  ~NameTable() { STLDeleteElements(&arrays_); }
+
+  // Finds a pending or committed entry.  Must be called with writes
+  // serialized.  Returns false if not found.
+  bool Find(const char* name, Value* value) const {
+    const Entry* entry = FindEntry(name);
+    if (entry == NULL) return false;
+    *value = entry->value;
+    return true;
+  }
+
+  // Finds a committed entry.  Lock-free.  Returns false if not found.
+  bool FindCommitted(const char* name, Value* value) const {
+    const Array* array =
+        reinterpret_cast<const Array*>(internal::Acquire_Load(&current_));
+    if (array == NULL) return false;
+    uint32 hash = HashCString(name);
+    // The array is never full, so this finds an empty entry.
+    for (uint32 i = hash & array->mask;; i = (i + 1) & array->mask) {
+      const Entry& entry = array->entries[i];
+      internal::Atomic32 state = internal::Acquire_Load(&entry.state);
+      if (state == EMPTY) return false;
+      if (state == COMMITTED && entry.hash == hash &&
+          strcmp(entry.name, name) == 0) {
+        *value = entry.value;
+        return true;
+      }
+    }
+  }
+
+  // Adds a pending entry.  Returns false, and leaves the table unchanged, if
+  // a pending or committed entry has the name.
+  bool Insert(const char* name, const Value& value) {
+    if (FindEntry(name) != NULL) return false;
+    Array* array = arrays_.empty() ? NULL : arrays_.back();
+    if (array == NULL || (used_ + 1) * 4 > (array->mask + 1) * 3) {
+      array = Grow(array);
+    }
+    Store(array, name, HashCString(name), value, PENDING);
+    ++used_;
+    return true;
+  }
+
+  // Commits or erases a pending entry.
+  void Commit(const char* name) { SetState(name, COMMITTED); }
+  void Erase(const char* name) { SetState(name, ERASED); }
+
+ private:
+  enum State { EMPTY = 0, PENDING, COMMITTED, ERASED };
+
+  struct Entry {
+    Entry() : state(EMPTY), hash(0), name(NULL), value() {}
+    internal::Atomic32 state;
+    uint32 hash;
+    const char* name;
+    Value value;
+  };
+  struct Array {
+    explicit Array(uint32 capacity)
+        : mask(capacity - 1), entries(new Entry[capacity]) {}
+    const uint32 mask;  // The capacity, a power of two, minus one.
+    scoped_array<Entry> entries;
+  };
+
+  Entry* FindEntry(const char* name) const {
+    if (arrays_.empty()) return NULL;
+    Array* array = arrays_.back();
+    uint32 hash = HashCString(name);
+    for (uint32 i = hash & array->mask;; i = (i + 1) & array->mask) {
+      Entry* entry = &array->entries[i];
+      if (entry->state == EMPTY) return NULL;
+      if (entry->state != ERASED && entry->hash == hash &&
+          strcmp(entry->name, name) == 0) {
+        return entry;
+      }
+    }
+  }
+
+  void SetState(const char* name, State state) {
+    Entry* entry = FindEntry(name);
+    GOOGLE_DCHECK(entry != NULL && entry->state == PENDING);
+    internal::Release_Store(&entry->state, state);
+  }
+
+  // Replaces the array with one at most 3/8 full, leaving out erased
+  // entries.  Without erased entries, it is twice the size.
+  Array* Grow(Array* array) {
+    uint32 live = 0;
+    for (uint32 i = 0; array != NULL && i <= array->mask; i++) {
+      State state = static_cast<State>(array->entries[i].state);
+      if (state == PENDING || state == COMMITTED) ++live;
+    }
+    uint32 capacity = 64;
+    while (capacity * 3 < (live + 1) * 8) capacity *= 2;
+    Array* bigger = new Array(capacity);
+    for (uint32 i = 0; array != NULL && i <= array->mask; i++) {
+      const Entry& entry = array->entries[i];
+      if (entry.state == PENDING || entry.state == COMMITTED) {
+        Store(bigger, entry.name, entry.hash, entry.value,
+              static_cast<State>(entry.state));
+      }
+    }
+    used_ = live;
+    internal::Release_Store(&current_,
+                            reinterpret_cast<internal::AtomicWord>(bigger));
+    if (!concurrent_reads_) STLDeleteElements(&arrays_);
+    arrays_.push_back(bigger);
+    return bigger;
+  }
+
+  static void Store(Array* array, const char* name, uint32 hash,
+                    const Value& value, State state) {
+    uint32 i = hash & array->mask;
+    while (array->entries[i].state != EMPTY) i = (i + 1) & array->mask;
+    Entry* entry = &array->entries[i];
+    entry->hash = hash;
+    entry->name = name;
+    entry->value = value;
+    internal::Release_Store(&entry->state, state);
+  }
+
+  internal::AtomicWord current_;  // Really a const Array*.
+  uint32 used_;  // Entries in the current array which are not empty.
+  const bool concurrent_reads_;
+  vector<Array*> arrays_;  // Every array still allocated; the last is current.
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(NameTable);
+};
+
+// Maps each interned string to itself.
+typedef FlatHashMap<const string*, const string*,
+                    StringPointerHash, StringPointerEqual>
+  InternedStringsMap;
+typedef NameTable<Symbol> SymbolsByNameMap;
+typedef FlatHashMap<PointerStringPair, Symbol,
+                    PointerStringPairHash, PointerStringPairEqual>
   SymbolsByParentMap;
-typedef hash_map<const char*, const FileDescriptor*,
-                 hash<const char*>, streq>
-  FilesByNameMap;
-typedef hash_map<PointerStringPair, const FieldDescriptor*,
-                 PointerStringPairHash, PointerStringPairEqual>
+typedef NameTable<const FileDescriptor*> FilesByNameMap;
+typedef FlatHashMap<PointerStringPair, const FieldDescriptor*,
+                    PointerStringPairHash, PointerStringPairEqual>
   FieldsByNameMap;
-typedef hash_map<DescriptorIntPair, const FieldDescriptor*,
-                 PointerIntegerPairHash<DescriptorIntPair> >
+typedef FlatHashMap<DescriptorIntPair, const FieldDescriptor*,
+                    PointerIntegerPairHash<DescriptorIntPair>,
+                    std::equal_to<DescriptorIntPair> >
   FieldsByNumberMap;
-typedef hash_map<EnumIntPair, const EnumValueDescriptor*,
-                 PointerIntegerPairHash<EnumIntPair> >
+typedef FlatHashMap<EnumIntPair, const EnumValueDescriptor*,
+                    PointerIntegerPairHash<EnumIntPair>,
+                    std::equal_to<EnumIntPair> >
   EnumValuesByNumberMap;
-// This is a map rather than a hash_map, since we use it to iterate
+// This is a map rather than a hash table, since we use it to iterate
 // through all the extensions that extend a given Descriptor, and an
 // ordered data structure that implements lower_bound is convenient
 // for that.
@@ -373,7 +634,10 @@ bool AllowedExtendeeInProto3(const string& name) {
 
 class DescriptorPool::Tables {
  public:
-  Tables();
+  // If concurrent_reads, lookups of committed symbols and files may run
+  // while a file is being built, which is the case when the pool has a
+  // mutex.
+  explicit Tables(bool concurrent_reads);
   ~Tables();
 
   // Record the current state of the tables to the stack of checkpoints.
@@ -442,6 +706,12 @@ class DescriptorPool::Tables {
   // if not found.
   inline Symbol FindSymbol(const string& key) const;
 
+  // Find symbols and files which have been committed, without taking the
+  // pool's mutex.  These return false if not found.
+  inline bool FindCommittedSymbol(const string& key, Symbol* symbol) const;
+  inline bool FindCommittedFile(const string& key,
+                                const FileDescriptor** file) const;
+
   // This implements the body of DescriptorPool::Find*ByName().  It should
   // really be a private method of DescriptorPool, but that would require
   // declaring Symbol in descriptor.h, which would drag all kinds of other
@@ -484,6 +754,12 @@ class DescriptorPool::Tables {
   // The string is initialized to the given value for convenience.
   string* AllocateString(const string& value);
 
+  // Returns a string with the given value which is shared by everything in
+  // the pool that asks for the same value, such as the names of fields which
+  // are called "id" in many messages.  Interned strings outlive rollbacks,
+  // and are destroyed with the pool.
+  const string* InternString(const string& value);
+
   // Allocate a protocol message object.  Some older versions of GCC have
   // trouble understanding explicit template instantiations in some cases, so
   // in those cases we have to pass a dummy pointer of the right type as the
@@ -494,11 +770,24 @@ class DescriptorPool::Tables {
   FileDescriptorTables* AllocateFileTables();
 
  private:
-  vector<string*> strings_;    // All strings in the pool.
+  vector<string*> strings_;    // All strings in the pool, in arena blocks.
   vector<Message*> messages_;  // All messages in the pool.
   vector<FileDescriptorTables*> file_tables_;  // All file tables in the pool.
-  vector<void*> allocations_;  // All other memory allocated in the pool.
+  vector<void*> allocations_;  // All arena blocks.
 
+  // AllocateBytes() hands out memory from the current arena block, between
+  // arena_next_ and arena_end_, and starts a new block, twice as big as the
+  // last one up to a limit, when it runs out.  Large allocations get a block
+  // of their own.  Rolling back a checkpoint frees the blocks started since
+  // and rewinds arena_next_, so the arena is used like a stack.
+  char* arena_next_;
+  char* arena_end_;
+  int arena_block_size_;
+
+  vector<string*> interned_strings_;  // Not rolled back.
+  InternedStringsMap interned_strings_by_value_;
+
+  // Committed entries can be read while another thread is building a file.
   SymbolsByNameMap      symbols_by_name_;
   FilesByNameMap        files_by_name_;
   ExtensionsGroupedByDescriptorMap extensions_;
@@ -509,6 +798,8 @@ class DescriptorPool::Tables {
         messages_before_checkpoint(tables->messages_.size()),
         file_tables_before_checkpoint(tables->file_tables_.size()),
         allocations_before_checkpoint(tables->allocations_.size()),
+        arena_next_before_checkpoint(tables->arena_next_),
+        arena_end_before_checkpoint(tables->arena_end_),
         pending_symbols_before_checkpoint(
             tables->symbols_after_checkpoint_.size()),
         pending_files_before_checkpoint(
@@ -520,6 +811,8 @@ class DescriptorPool::Tables {
     int messages_before_checkpoint;
     int file_tables_before_checkpoint;
     int allocations_before_checkpoint;
+    char* arena_next_before_checkpoint;
+    char* arena_end_before_checkpoint;
     int pending_symbols_before_checkpoint;
     int pending_files_before_checkpoint;
     int pending_extensions_before_checkpoint;
@@ -532,6 +825,10 @@ class DescriptorPool::Tables {
   // Allocate some bytes which will be reclaimed when the pool is
   // destroyed.
   void* AllocateBytes(int size);
+
+  static const int kArenaAlignment = 8;
+  static const int kMinArenaBlockSize = 512;
+  static const int kMaxArenaBlockSize = 16384;
 };
 
 // Contains tables specific to a particular file.  These tables are not
@@ -591,6 +888,10 @@ class FileDescriptorTables {
   // fails because we allow duplicates; the first field by the name wins.
   void AddFieldByStylizedNames(const FieldDescriptor* field);
 
+  // Shrinks the tables to fit.  Called once the file has been built, since
+  // nothing is added to them after that.
+  void Compact();
+
   // Populates p->first->locations_by_path_ from p->second.
   // Unusual signature dictated by GoogleOnceDynamic.
   static void BuildLocationsByPath(
@@ -621,13 +922,16 @@ class FileDescriptorTables {
   mutable Mutex unknown_enum_values_mu_;
 };
 
-DescriptorPool::Tables::Tables()
+DescriptorPool::Tables::Tables(bool concurrent_reads)
     // Start some hash_map and hash_set objects with a small # of buckets
     : known_bad_files_(3),
       known_bad_symbols_(3),
       extensions_loaded_from_db_(3),
-      symbols_by_name_(3),
-      files_by_name_(3) {}
+      arena_next_(NULL),
+      arena_end_(NULL),
+      arena_block_size_(kMinArenaBlockSize),
+      symbols_by_name_(concurrent_reads),
+      files_by_name_(concurrent_reads) {}
 
 
 DescriptorPool::Tables::~Tables() {
@@ -635,22 +939,18 @@ DescriptorPool::Tables::~Tables() {
   // Note that the deletion order is important, since the destructors of some
   // messages may refer to objects in allocations_.
   STLDeleteElements(&messages_);
+  for (int i = 0; i < strings_.size(); i++) {
+    strings_[i]->~string();
+  }
   for (int i = 0; i < allocations_.size(); i++) {
     operator delete(allocations_[i]);
   }
-  STLDeleteElements(&strings_);
+  STLDeleteElements(&interned_strings_);
   STLDeleteElements(&file_tables_);
 }
 
-FileDescriptorTables::FileDescriptorTables()
-    // Initialize all the hash tables to start out with a small # of buckets
-    : symbols_by_parent_(3),
-      fields_by_lowercase_name_(3),
-      fields_by_camelcase_name_(3),
-      fields_by_number_(3),
-      enum_values_by_number_(3),
-      unknown_enum_values_by_number_(3) {
-}
+// The hash tables allocate nothing until something is added to them.
+FileDescriptorTables::FileDescriptorTables() {}
 
 FileDescriptorTables::~FileDescriptorTables() {}
 
@@ -666,6 +966,12 @@ void DescriptorPool::Tables::ClearLastCheckpoint() {
   if (checkpoints_.empty()) {
     // All checkpoints have been cleared: we can now commit all of the pending
     // data.
+    for (int i = 0; i < symbols_after_checkpoint_.size(); i++) {
+      symbols_by_name_.Commit(symbols_after_checkpoint_[i]);
+    }
+    for (int i = 0; i < files_after_checkpoint_.size(); i++) {
+      files_by_name_.Commit(files_after_checkpoint_[i]);
+    }
     symbols_after_checkpoint_.clear();
     files_after_checkpoint_.clear();
     extensions_after_checkpoint_.clear();
@@ -679,12 +985,12 @@ void DescriptorPool::Tables::RollbackToLastCheckpoint() {
   for (int i = checkpoint.pending_symbols_before_checkpoint;
        i < symbols_after_checkpoint_.size();
        i++) {
-    symbols_by_name_.erase(symbols_after_checkpoint_[i]);
+    symbols_by_name_.Erase(symbols_after_checkpoint_[i]);
   }
   for (int i = checkpoint.pending_files_before_checkpoint;
        i < files_after_checkpoint_.size();
        i++) {
-    files_by_name_.erase(files_after_checkpoint_[i]);
+    files_by_name_.Erase(files_after_checkpoint_[i]);
   }
   for (int i = checkpoint.pending_extensions_before_checkpoint;
        i < extensions_after_checkpoint_.size();
@@ -698,8 +1004,10 @@ void DescriptorPool::Tables::RollbackToLastCheckpoint() {
   extensions_after_checkpoint_.resize(
       checkpoint.pending_extensions_before_checkpoint);
 
-  STLDeleteContainerPointers(
-      strings_.begin() + checkpoint.strings_before_checkpoint, strings_.end());
+  for (int i = checkpoint.strings_before_checkpoint; i < strings_.size();
+       i++) {
+    strings_[i]->~string();
+  }
   STLDeleteContainerPointers(
       messages_.begin() + checkpoint.messages_before_checkpoint,
       messages_.end());
@@ -716,24 +1024,23 @@ void DescriptorPool::Tables::RollbackToLastCheckpoint() {
   messages_.resize(checkpoint.messages_before_checkpoint);
   file_tables_.resize(checkpoint.file_tables_before_checkpoint);
   allocations_.resize(checkpoint.allocations_before_checkpoint);
+  arena_next_ = checkpoint.arena_next_before_checkpoint;
+  arena_end_ = checkpoint.arena_end_before_checkpoint;
   checkpoints_.pop_back();
 }
 
 // -------------------------------------------------------------------
 
 inline Symbol DescriptorPool::Tables::FindSymbol(const string& key) const {
-  const Symbol* result = FindOrNull(symbols_by_name_, key.c_str());
-  if (result == NULL) {
-    return kNullSymbol;
-  } else {
-    return *result;
-  }
+  Symbol result;
+  symbols_by_name_.Find(key.c_str(), &result);
+  return result;
 }
 
 inline Symbol FileDescriptorTables::FindNestedSymbol(
     const void* parent, const string& name) const {
   const Symbol* result =
-    FindOrNull(symbols_by_parent_, PointerStringPair(parent, name.c_str()));
+    symbols_by_parent_.Find(PointerStringPair(parent, name.c_str()));
   if (result == NULL) {
     return kNullSymbol;
   } else {
@@ -748,12 +1055,31 @@ inline Symbol FileDescriptorTables::FindNestedSymbolOfType(
   return result;
 }
 
+inline bool DescriptorPool::Tables::FindCommittedSymbol(
+    const string& key, Symbol* symbol) const {
+  return symbols_by_name_.FindCommitted(key.c_str(), symbol);
+}
+
+inline bool DescriptorPool::Tables::FindCommittedFile(
+    const string& key, const FileDescriptor** file) const {
+  return files_by_name_.FindCommitted(key.c_str(), file);
+}
+
 Symbol DescriptorPool::Tables::FindByNameHelper(
     const DescriptorPool* pool, const string& name) {
+  // Symbols which have already been built are found without locking.  Only
+  // a miss, which may have to load a file from the fallback database, takes
+  // the mutex.  Without a mutex, the lookup below is all a hit needs, and a
+  // miss would otherwise probe the table twice.
+  Symbol result;
+  if (pool->mutex_ != NULL && FindCommittedSymbol(name, &result)) {
+    return result;
+  }
+
   MutexLockMaybe lock(pool->mutex_);
   known_bad_symbols_.clear();
   known_bad_files_.clear();
-  Symbol result = FindSymbol(name);
+  result = FindSymbol(name);
 
   if (result.IsNull() && pool->underlay_ != NULL) {
     // Symbol not found; check the underlay.
@@ -773,12 +1099,14 @@ Symbol DescriptorPool::Tables::FindByNameHelper(
 
 inline const FileDescriptor* DescriptorPool::Tables::FindFile(
     const string& key) const {
-  return FindPtrOrNull(files_by_name_, key.c_str());
+  const FileDescriptor* result = NULL;
+  files_by_name_.Find(key.c_str(), &result);
+  return result;
 }
 
 inline const FieldDescriptor* FileDescriptorTables::FindFieldByNumber(
     const Descriptor* parent, int number) const {
-  return FindPtrOrNull(fields_by_number_, make_pair(parent, number));
+  return FindPtrOrNull(fields_by_number_, DescriptorIntPair(parent, number));
 }
 
 inline const FieldDescriptor* FileDescriptorTables::FindFieldByLowercaseName(
@@ -795,7 +1123,7 @@ inline const FieldDescriptor* FileDescriptorTables::FindFieldByCamelcaseName(
 
 inline const EnumValueDescriptor* FileDescriptorTables::FindEnumValueByNumber(
     const EnumDescriptor* parent, int number) const {
-  return FindPtrOrNull(enum_values_by_number_, make_pair(parent, number));
+  return FindPtrOrNull(enum_values_by_number_, EnumIntPair(parent, number));
 }
 
 inline const EnumValueDescriptor*
@@ -804,7 +1132,7 @@ FileDescriptorTables::FindEnumValueByNumberCreatingIfUnknown(
   // First try, with map of compiled-in values.
   {
     const EnumValueDescriptor* desc = FindPtrOrNull(
-        enum_values_by_number_, make_pair(parent, number));
+        enum_values_by_number_, EnumIntPair(parent, number));
     if (desc != NULL) {
       return desc;
     }
@@ -813,7 +1141,7 @@ FileDescriptorTables::FindEnumValueByNumberCreatingIfUnknown(
   {
     ReaderMutexLock l(&unknown_enum_values_mu_);
     const EnumValueDescriptor* desc = FindPtrOrNull(
-        unknown_enum_values_by_number_, make_pair(parent, number));
+        unknown_enum_values_by_number_, EnumIntPair(parent, number));
     if (desc != NULL) {
       return desc;
     }
@@ -823,7 +1151,7 @@ FileDescriptorTables::FindEnumValueByNumberCreatingIfUnknown(
   {
     WriterMutexLock l(&unknown_enum_values_mu_);
     const EnumValueDescriptor* desc = FindPtrOrNull(
-        unknown_enum_values_by_number_, make_pair(parent, number));
+        unknown_enum_values_by_number_, EnumIntPair(parent, number));
     if (desc != NULL) {
       return desc;
     }
@@ -844,9 +1172,7 @@ FileDescriptorTables::FindEnumValueByNumberCreatingIfUnknown(
     result->number_ = number;
     result->type_ = parent;
     result->options_ = &EnumValueOptions::default_instance();
-    InsertIfNotPresent(&unknown_enum_values_by_number_,
-                       make_pair(parent, number),
-                       result);
+    unknown_enum_values_by_number_.Insert(EnumIntPair(parent, number), result);
     return result;
   }
 }
@@ -870,7 +1196,7 @@ inline void DescriptorPool::Tables::FindAllExtensions(
 
 bool DescriptorPool::Tables::AddSymbol(
     const string& full_name, Symbol symbol) {
-  if (InsertIfNotPresent(&symbols_by_name_, full_name.c_str(), symbol)) {
+  if (symbols_by_name_.Insert(full_name.c_str(), symbol)) {
     symbols_after_checkpoint_.push_back(full_name.c_str());
     return true;
   } else {
@@ -881,11 +1207,11 @@ bool DescriptorPool::Tables::AddSymbol(
 bool FileDescriptorTables::AddAliasUnderParent(
     const void* parent, const string& name, Symbol symbol) {
   PointerStringPair by_parent_key(parent, name.c_str());
-  return InsertIfNotPresent(&symbols_by_parent_, by_parent_key, symbol);
+  return symbols_by_parent_.Insert(by_parent_key, symbol);
 }
 
 bool DescriptorPool::Tables::AddFile(const FileDescriptor* file) {
-  if (InsertIfNotPresent(&files_by_name_, file->name().c_str(), file)) {
+  if (files_by_name_.Insert(file->name().c_str(), file)) {
     files_after_checkpoint_.push_back(file->name().c_str());
     return true;
   } else {
@@ -907,21 +1233,29 @@ void FileDescriptorTables::AddFieldByStylizedNames(
   }
 
   PointerStringPair lowercase_key(parent, field->lowercase_name().c_str());
-  InsertIfNotPresent(&fields_by_lowercase_name_, lowercase_key, field);
+  fields_by_lowercase_name_.Insert(lowercase_key, field);
 
   PointerStringPair camelcase_key(parent, field->camelcase_name().c_str());
-  InsertIfNotPresent(&fields_by_camelcase_name_, camelcase_key, field);
+  fields_by_camelcase_name_.Insert(camelcase_key, field);
 }
 
 bool FileDescriptorTables::AddFieldByNumber(const FieldDescriptor* field) {
   DescriptorIntPair key(field->containing_type(), field->number());
-  return InsertIfNotPresent(&fields_by_number_, key, field);
+  return fields_by_number_.Insert(key, field);
 }
 
 bool FileDescriptorTables::AddEnumValueByNumber(
     const EnumValueDescriptor* value) {
   EnumIntPair key(value->type(), value->number());
-  return InsertIfNotPresent(&enum_values_by_number_, key, value);
+  return enum_values_by_number_.Insert(key, value);
+}
+
+void FileDescriptorTables::Compact() {
+  symbols_by_parent_.Compact();
+  fields_by_lowercase_name_.Compact();
+  fields_by_camelcase_name_.Compact();
+  fields_by_number_.Compact();
+  enum_values_by_number_.Compact();
 }
 
 bool DescriptorPool::Tables::AddExtension(const FieldDescriptor* field) {
@@ -947,11 +1281,22 @@ Type* DescriptorPool::Tables::AllocateArray(int count) {
 }
 
 string* DescriptorPool::Tables::AllocateString(const string& value) {
-  string* result = new string(value);
+  string* result = new(AllocateBytes(sizeof(string))) string(value);
   strings_.push_back(result);
   return result;
 }
 
+const string* DescriptorPool::Tables::InternString(const string& value) {
+  const string* result = FindPtrOrNull(interned_strings_by_value_, &value);
+  if (result == NULL) {
+    string* interned = new string(value);
+    interned_strings_.push_back(interned);
+    interned_strings_by_value_.Insert(interned, interned);
+    result = interned;
+  }
+  return result;
+}
+
 template<typename Type>
 Type* DescriptorPool::Tables::AllocateMessage(Type* /* dummy */) {
   Type* result = new Type;
@@ -966,14 +1311,23 @@ FileDescriptorTables* DescriptorPool::Tables::AllocateFileTables() {
 }
 
 void* DescriptorPool::Tables::AllocateBytes(int size) {
-  // TODO(kenton):  Would it be worthwhile to implement this in some more
-  // sophisticated way?  Probably not for the open source release, but for
-  // internal use we could easily plug in one of our existing memory pool
-  // allocators...
   if (size == 0) return NULL;
 
-  void* result = operator new(size);
-  allocations_.push_back(result);
+  // Keep everything aligned for the widest fields of the descriptors.
+  size = (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+  if (size > arena_end_ - arena_next_) {
+    if (size > arena_block_size_ / 4) {
+      void* result = operator new(size);
+      allocations_.push_back(result);
+      return result;
+    }
+    arena_next_ = static_cast<char*>(operator new(arena_block_size_));
+    arena_end_ = arena_next_ + arena_block_size_;
+    allocations_.push_back(arena_next_);
+    if (arena_block_size_ < kMaxArenaBlockSize) arena_block_size_ *= 2;
+  }
+  void* result = arena_next_;
+  arena_next_ += size;
   return result;
 }
 
@@ -1003,10 +1357,11 @@ DescriptorPool::DescriptorPool()
     fallback_database_(NULL),
     default_error_collector_(NULL),
     underlay_(NULL),
-    tables_(new Tables),
+    tables_(new Tables(false)),
     enforce_dependencies_(true),
     allow_unknown_(false),
-    enforce_weak_(false) {}
+    enforce_weak_(false),
+    discard_build_only_data_(false) {}
 
 DescriptorPool::DescriptorPool(DescriptorDatabase* fallback_database,
                                ErrorCollector* error_collector)
@@ -1014,10 +1369,11 @@ DescriptorPool::DescriptorPool(DescriptorDatabase* fallback_database,
     fallback_database_(fallback_database),
     default_error_collector_(error_collector),
     underlay_(NULL),
-    tables_(new Tables),
+    tables_(new Tables(true)),
     enforce_dependencies_(true),
     allow_unknown_(false),
-    enforce_weak_(false) {
+    enforce_weak_(false),
+    discard_build_only_data_(false) {
 }
 
 DescriptorPool::DescriptorPool(const DescriptorPool* underlay)
@@ -1025,10 +1381,11 @@ DescriptorPool::DescriptorPool(const DescriptorPool* underlay)
     fallback_database_(NULL),
     default_error_collector_(NULL),
     underlay_(underlay),
-    tables_(new Tables),
+    tables_(new Tables(false)),
     enforce_dependencies_(true),
     allow_unknown_(false),
-    enforce_weak_(false) {}
+    enforce_weak_(false),
+    discard_build_only_data_(false) {}
 
 DescriptorPool::~DescriptorPool() {
   if (mutex_ != NULL) delete mutex_;
@@ -1061,6 +1418,7 @@ namespace {
 
 EncodedDescriptorDatabase* generated_database_ = NULL;
 DescriptorPool* generated_pool_ = NULL;
+GOOGLE_PROTOBUF_DECLARE_ONCE(generated_database_init_);
 GOOGLE_PROTOBUF_DECLARE_ONCE(generated_pool_init_);
 
 void DeleteGeneratedPool() {
@@ -1070,13 +1428,24 @@ void DeleteGeneratedPool() {
   generated_pool_ = NULL;
 }
 
-static void InitGeneratedPool() {
+static void InitGeneratedDatabase() {
   generated_database_ = new EncodedDescriptorDatabase;
-  generated_pool_ = new DescriptorPool(generated_database_);
 
   internal::OnShutdown(&DeleteGeneratedPool);
 }
 
+inline void InitGeneratedDatabaseOnce() {
+  ::google::protobuf::GoogleOnceInit(&generated_database_init_,
+                                     &InitGeneratedDatabase);
+}
+
+// The pool itself is only created once someone asks for it, so that
+// registering generated files at startup does not have to set it up.
+static void InitGeneratedPool() {
+  InitGeneratedDatabaseOnce();
+  generated_pool_ = new DescriptorPool(generated_database_);
+}
+
 inline void InitGeneratedPoolOnce() {
   ::google::protobuf::GoogleOnceInit(&generated_pool_init_, &InitGeneratedPool);
 }
@@ -1098,8 +1467,10 @@ void DescriptorPool::InternalAddGeneratedFile(
   // So, this function is called in the process of initializing the
   // descriptors for generated proto classes.  Each generated .pb.cc file
   // has an internal procedure called AddDescriptors() which is called at
-  // process startup, and that function calls this one in order to register
-  // the raw bytes of the FileDescriptorProto representing the file.
+  // process startup (or, with GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER, when one
+  // of the file's types is first used), and that function calls this one in
+  // order to register the raw bytes of the FileDescriptorProto representing
+  // the file.
   //
   // We do not actually construct the descriptor objects right away.  We just
   // hang on to the bytes until they are actually needed.  We actually construct
@@ -1111,14 +1482,16 @@ void DescriptorPool::InternalAddGeneratedFile(
   //
   // Once one of these happens, the DescriptorPool actually parses the
   // FileDescriptorProto and generates a FileDescriptor (and all its children)
-  // based on it.
+  // based on it.  Looking a file up by name only parses that file and its
+  // dependencies; the bytes of the other files are not even indexed until
+  // someone looks up a symbol or extension by name.
   //
   // Note that FileDescriptorProto is itself a generated protocol message.
   // Therefore, when we parse one, we have to be very careful to avoid using
   // any descriptor-based operations, since this might cause infinite recursion
   // or deadlock.
-  InitGeneratedPoolOnce();
-  GOOGLE_CHECK(generated_database_->Add(encoded_file_descriptor, size));
+  InitGeneratedDatabaseOnce();
+  generated_database_->AddUnindexed(encoded_file_descriptor, size);
 }
 
 
@@ -1129,10 +1502,15 @@ void DescriptorPool::InternalAddGeneratedFile(
 //   there's nothing more important to do (read: never).
 
 const FileDescriptor* DescriptorPool::FindFileByName(const string& name) const {
+  const FileDescriptor* result = NULL;
+  if (mutex_ != NULL && tables_->FindCommittedFile(name, &result)) {
+    return result;
+  }
+
   MutexLockMaybe lock(mutex_);
   tables_->known_bad_symbols_.clear();
   tables_->known_bad_files_.clear();
-  const FileDescriptor* result = tables_->FindFile(name);
+  result = tables_->FindFile(name);
   if (result != NULL) return result;
   if (underlay_ != NULL) {
     result = underlay_->FindFileByName(name);
@@ -1147,10 +1525,15 @@ const FileDescriptor* DescriptorPool::FindFileByName(const string& name) const {
 
 const FileDescriptor* DescriptorPool::FindFileContainingSymbol(
     const string& symbol_name) const {
+  Symbol result;
+  if (mutex_ != NULL && tables_->FindCommittedSymbol(symbol_name, &result)) {
+    return result.GetFile();
+  }
+
   MutexLockMaybe lock(mutex_);
   tables_->known_bad_symbols_.clear();
   tables_->known_bad_files_.clear();
-  Symbol result = tables_->FindSymbol(symbol_name);
+  result = tables_->FindSymbol(symbol_name);
   if (!result.IsNull()) return result.GetFile();
   if (underlay_ != NULL) {
     const FileDescriptor* file_result =
@@ -3598,10 +3981,33 @@ void DescriptorBuilder::AddImportError(const FileDescriptorProto& proto,
   AddError(proto.name(), proto, DescriptorPool::ErrorCollector::OTHER, message);
 }
 
+// Clears the file options which are only read by code generators, for
+// DescriptorPool::DiscardBuildOnlyData().
+static void DiscardCodeGeneratorOptions(FileOptions* options) {
+  delete options->release_java_package();
+  delete options->release_java_outer_classname();
+  options->clear_java_multiple_files();
+  options->clear_java_generate_equals_and_hash();
+  options->clear_java_string_check_utf8();
+  delete options->release_go_package();
+  options->clear_cc_generic_services();
+  options->clear_java_generic_services();
+  options->clear_py_generic_services();
+}
+
 static bool ExistingFileMatchesProto(const FileDescriptor* existing_file,
-                                     const FileDescriptorProto& proto) {
+                                     const FileDescriptorProto& proto,
+                                     bool discard_build_only_data) {
   FileDescriptorProto existing_proto;
   existing_file->CopyTo(&existing_proto);
+  if (discard_build_only_data && proto.has_options()) {
+    // The existing file was built without some of the options.
+    FileDescriptorProto discarded_proto;
+    discarded_proto.CopyFrom(proto);
+    DiscardCodeGeneratorOptions(discarded_proto.mutable_options());
+    return existing_proto.SerializeAsString() ==
+           discarded_proto.SerializeAsString();
+  }
   return existing_proto.SerializeAsString() == proto.SerializeAsString();
 }
 
@@ -3617,7 +4023,8 @@ const FileDescriptor* DescriptorBuilder::BuildFile(
   const FileDescriptor* existing_file = tables_->FindFile(filename_);
   if (existing_file != NULL) {
     // File already in pool.  Compare the existing one to the input.
-    if (ExistingFileMatchesProto(existing_file, proto)) {
+    if (ExistingFileMatchesProto(existing_file, proto,
+                                 pool_->discard_build_only_data_)) {
       // They're identical.  Return the existing descriptor.
       return existing_file;
     }
@@ -3664,7 +4071,7 @@ const FileDescriptor* DescriptorBuilder::BuildFile(
   file_ = result;
 
   result->is_placeholder_ = false;
-  if (proto.has_source_code_info()) {
+  if (proto.has_source_code_info() && !pool_->discard_build_only_data_) {
     SourceCodeInfo *info = tables_->AllocateMessage<SourceCodeInfo>();
     info->CopyFrom(proto.source_code_info());
     result->source_code_info_ = info;
@@ -3695,13 +4102,13 @@ const FileDescriptor* DescriptorBuilder::BuildFile(
 
   result->name_ = tables_->AllocateString(proto.name());
   if (proto.has_package()) {
-    result->package_ = tables_->AllocateString(proto.package());
+    result->package_ = tables_->InternString(proto.package());
   } else {
     // We cannot rely on proto.package() returning a valid string if
     // proto.has_package() is false, because we might be running at static
     // initialization time, in which case default values have not yet been
     // initialized.
-    result->package_ = tables_->AllocateString("");
+    result->package_ = tables_->InternString("");
   }
   result->pool_ = pool_;
 
@@ -3853,6 +4260,11 @@ const FileDescriptor* DescriptorBuilder::BuildFile(
     tables_->RollbackToLastCheckpoint();
     return NULL;
   } else {
+    if (pool_->discard_build_only_data_ &&
+        result->options_ != &FileOptions::default_instance()) {
+      DiscardCodeGeneratorOptions(const_cast<FileOptions*>(result->options_));
+    }
+    file_tables_->Compact();
     tables_->ClearLastCheckpoint();
     return result;
   }
@@ -3869,7 +4281,7 @@ void DescriptorBuilder::BuildMessage(const DescriptorProto& proto,
 
   ValidateSymbolName(proto.name(), *full_name, proto);
 
-  result->name_            = tables_->AllocateString(proto.name());
+  result->name_            = tables_->InternString(proto.name());
   result->full_name_       = full_name;
   result->file_            = file_;
   result->containing_type_ = parent;
@@ -3939,7 +4351,7 @@ void DescriptorBuilder::BuildFieldOrExtension(const FieldDescriptorProto& proto,
 
   ValidateSymbolName(proto.name(), *full_name, proto);
 
-  result->name_         = tables_->AllocateString(proto.name());
+  result->name_         = tables_->InternString(proto.name());
   result->full_name_    = full_name;
   result->file_         = file_;
   result->number_       = proto.number();
@@ -3953,15 +4365,15 @@ void DescriptorBuilder::BuildFieldOrExtension(const FieldDescriptorProto& proto,
   if (lowercase_name == proto.name()) {
     result->lowercase_name_ = result->name_;
   } else {
-    result->lowercase_name_ = tables_->AllocateString(lowercase_name);
+    result->lowercase_name_ = tables_->InternString(lowercase_name);
   }
 
   // Don't bother with the above optimization for camel-case names since
   // .proto files that follow the guide shouldn't be using names in this
   // format, so the optimization wouldn't help much.
   result->camelcase_name_ =
-      tables_->AllocateString(ToCamelCase(proto.name(),
-                                          /* lower_first = */ true));
+      tables_->InternString(ToCamelCase(proto.name(),
+                                        /* lower_first = */ true));
 
   // Some compilers do not allow static_cast directly between two enum types,
   // so we must cast to int first.
@@ -4057,11 +4469,11 @@ void DescriptorBuilder::BuildFieldOrExtension(const FieldDescriptorProto& proto,
           break;
         case FieldDescriptor::CPPTYPE_STRING:
           if (result->type() == FieldDescriptor::TYPE_BYTES) {
-            result->default_value_string_ = tables_->AllocateString(
+            result->default_value_string_ = tables_->InternString(
               UnescapeCEscapeString(proto.default_value()));
           } else {
             result->default_value_string_ =
-                tables_->AllocateString(proto.default_value());
+                tables_->InternString(proto.default_value());
           }
           break;
         case FieldDescriptor::CPPTYPE_MESSAGE:
@@ -4234,7 +4646,7 @@ void DescriptorBuilder::BuildOneof(const OneofDescriptorProto& proto,
 
   ValidateSymbolName(proto.name(), *full_name, proto);
 
-  result->name_ = tables_->AllocateString(proto.name());
+  result->name_ = tables_->InternString(proto.name());
   result->full_name_ = full_name;
 
   result->containing_type_ = parent;
@@ -4258,7 +4670,7 @@ void DescriptorBuilder::BuildEnum(const EnumDescriptorProto& proto,
 
   ValidateSymbolName(proto.name(), *full_name, proto);
 
-  result->name_            = tables_->AllocateString(proto.name());
+  result->name_            = tables_->InternString(proto.name());
   result->full_name_       = full_name;
   result->file_            = file_;
   result->containing_type_ = parent;
@@ -4289,7 +4701,7 @@ void DescriptorBuilder::BuildEnum(const EnumDescriptorProto& proto,
 void DescriptorBuilder::BuildEnumValue(const EnumValueDescriptorProto& proto,
                                        const EnumDescriptor* parent,
                                        EnumValueDescriptor* result) {
-  result->name_   = tables_->AllocateString(proto.name());
+  result->name_   = tables_->InternString(proto.name());
   result->number_ = proto.number();
   result->type_   = parent;
 
@@ -4363,7 +4775,7 @@ void DescriptorBuilder::BuildService(const ServiceDescriptorProto& proto,
 
   ValidateSymbolName(proto.name(), *full_name, proto);
 
-  result->name_      = tables_->AllocateString(proto.name());
+  result->name_      = tables_->InternString(proto.name());
   result->full_name_ = full_name;
   result->file_      = file_;
 
@@ -4383,7 +4795,7 @@ void DescriptorBuilder::BuildService(const ServiceDescriptorProto& proto,
 void DescriptorBuilder::BuildMethod(const MethodDescriptorProto& proto,
                                     const ServiceDescriptor* parent,
                                     MethodDescriptor* result) {
-  result->name_    = tables_->AllocateString(proto.name());
+  result->name_    = tables_->InternString(proto.name());
   result->service_ = parent;
 
   string* full_name = tables_->AllocateString(parent->full_name());
@@ -1267,9 +1267,10 @@ class LIBPROTOBUF_EXPORT DescriptorPool {
   //   DescriptorDatabase blocks.  This in turn means that parsing messages
   //   may block if they need to look up extensions.
   // - The Find*By*() methods will use mutexes for thread-safety, thus making
-  //   them slower even when they don't have to fall back to the database.
-  //   In fact, even the Find*By*() methods of descriptor objects owned by
-  //   this pool will be slower, since they will have to obtain locks too.
+  //   them slower when they have to fall back to the database.  Looking up a
+  //   file or a symbol by name which has already been built does not lock.
+  //   The other Find*By*() methods, including those of descriptor objects
+  //   owned by this pool, lock even when they find what they are looking for.
   // - An ErrorCollector may optionally be given to collect validation errors
   //   in files loaded from the database.  If not given, errors will be printed
   //   to GOOGLE_LOG(ERROR).  Remember that files are built on-demand, so this
@@ -1288,6 +1289,12 @@ class LIBPROTOBUF_EXPORT DescriptorPool {
   // Get a pointer to the generated pool.  Generated protocol message classes
   // which are compiled into the binary will allocate their descriptors in
   // this pool.  Do not add your own descriptors to this pool.
+  //
+  // If the generated code was compiled with
+  // GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER defined, a .proto file which does
+  // not define extensions is only added to this pool once one of its types
+  // has been used (e.g. by calling default_instance() or descriptor()), so
+  // looking up its symbols by name before that point will fail.
   static const DescriptorPool* generated_pool();
 
   // Find a FileDescriptor in the pool by file name.  Returns NULL if not
@@ -1413,6 +1420,20 @@ class LIBPROTOBUF_EXPORT DescriptorPool {
   // DescriptorPool will report a import not found error.
   void EnforceWeakDependencies(bool enforce) { enforce_weak_ = enforce; }
 
+  // By default, files built from FileDescriptorProtos keep everything in the
+  // proto.  If you call DiscardBuildOnlyData(true) before building files,
+  // the pool instead drops what only compilers and code generators need: the
+  // SourceCodeInfo, including comments, and the FileOptions which only code
+  // generators read (java_*, go_package and the *_generic_services options).
+  // GetSourceLocation() then returns false, CopySourceCodeInfoTo() copies
+  // nothing, and the dropped options read as their defaults.  Options still
+  // get interpreted, and everything else in them, including custom options,
+  // is kept.  This saves memory in processes which load many .proto files at
+  // run time.
+  void DiscardBuildOnlyData(bool discard) {
+    discard_build_only_data_ = discard;
+  }
+
   // Internal stuff --------------------------------------------------
   // These methods MUST NOT be called from outside the proto2 library.
   // These methods may contain hidden pitfalls and may be removed in a
@@ -1504,7 +1525,8 @@ class LIBPROTOBUF_EXPORT DescriptorPool {
     const FileDescriptorProto& proto) const;
 
   // If fallback_database_ is NULL, this is NULL.  Otherwise, this is a mutex
-  // which must be locked while accessing tables_.
+  // which must be locked while accessing tables_, except for the tables of
+  // committed symbols and files, which may be read without it.
   Mutex* mutex_;
 
   // See constructor.
@@ -1520,6 +1542,7 @@ class LIBPROTOBUF_EXPORT DescriptorPool {
   bool enforce_dependencies_;
   bool allow_unknown_;
   bool enforce_weak_;
+  bool discard_build_only_data_;
   std::set<string> unused_import_track_files_;
 
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(DescriptorPool);
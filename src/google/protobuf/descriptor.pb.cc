@@ -594,12 +594,18 @@ void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto() {
   delete SourceCodeInfo_Location_reflection_;
 }
 
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+void protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl() {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+#else
 void protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto() {
   static bool already_here = false;
   if (already_here) return;
   already_here = true;
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
+#endif
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
     "\n google/protobuf/descriptor.proto\022\017goog"
     "le.protobuf\"G\n\021FileDescriptorSet\0222\n\004file"
@@ -762,12 +768,20 @@ void protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto() {
   ::google::protobuf::internal::OnShutdown(&protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto);
 }
 
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+GOOGLE_PROTOBUF_DECLARE_ONCE(protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_once_);
+void protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto() {
+  ::google::protobuf::GoogleOnceInit(&protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_once_,
+                 &protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl);
+}
+#else
 // Force AddDescriptors() to be called at static initialization time.
 struct StaticDescriptorInitializer_google_2fprotobuf_2fdescriptor_2eproto {
   StaticDescriptorInitializer_google_2fprotobuf_2fdescriptor_2eproto() {
     protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
   }
 } static_descriptor_initializer_google_2fprotobuf_2fdescriptor_2eproto_;
+#endif
 
 namespace {
 
@@ -828,7 +842,11 @@ const ::google::protobuf::Descriptor* FileDescriptorSet::descriptor() {
 }
 
 const FileDescriptorSet& FileDescriptorSet::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -1034,8 +1052,18 @@ FileDescriptorProto::FileDescriptorProto()
 }
 
 void FileDescriptorProto::InitAsDefaultInstance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  options_ = const_cast< ::google::protobuf::FileOptions*>(
+      ::google::protobuf::FileOptions::internal_default_instance());
+#else
   options_ = const_cast< ::google::protobuf::FileOptions*>(&::google::protobuf::FileOptions::default_instance());
+#endif
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  source_code_info_ = const_cast< ::google::protobuf::SourceCodeInfo*>(
+      ::google::protobuf::SourceCodeInfo::internal_default_instance());
+#else
   source_code_info_ = const_cast< ::google::protobuf::SourceCodeInfo*>(&::google::protobuf::SourceCodeInfo::default_instance());
+#endif
 }
 
 FileDescriptorProto::FileDescriptorProto(const FileDescriptorProto& from)
@@ -1049,11 +1077,24 @@ FileDescriptorProto::FileDescriptorProto(const FileDescriptorProto& from)
 void FileDescriptorProto::SharedCtor() {
   ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<FileDescriptorProto*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
   name_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   package_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  options_ = NULL;
-  source_code_info_ = NULL;
+  ZR_(options_, source_code_info_);
   syntax_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -1083,7 +1124,11 @@ const ::google::protobuf::Descriptor* FileDescriptorProto::descriptor() {
 }
 
 const FileDescriptorProto& FileDescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -1098,15 +1143,13 @@ FileDescriptorProto* FileDescriptorProto::New(::google::protobuf::Arena* arena)
 }
 
 void FileDescriptorProto::Clear() {
-  if (_has_bits_[0 / 32] & 3) {
+  if (_has_bits_[0] & 3587u) {
     if (has_name()) {
       name_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
     if (has_package()) {
       package_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
-  }
-  if (_has_bits_[8 / 32] & 3584) {
     if (has_options()) {
       if (options_ != NULL) options_->::google::protobuf::FileOptions::Clear();
     }
@@ -1798,8 +1841,21 @@ DescriptorProto_ExtensionRange::DescriptorProto_ExtensionRange(const DescriptorP
 
 void DescriptorProto_ExtensionRange::SharedCtor() {
   _cached_size_ = 0;
-  start_ = 0;
-  end_ = 0;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<DescriptorProto_ExtensionRange*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
+  ZR_(start_, end_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -1824,7 +1880,11 @@ const ::google::protobuf::Descriptor* DescriptorProto_ExtensionRange::descriptor
 }
 
 const DescriptorProto_ExtensionRange& DescriptorProto_ExtensionRange::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -2077,7 +2137,12 @@ DescriptorProto::DescriptorProto()
 }
 
 void DescriptorProto::InitAsDefaultInstance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  options_ = const_cast< ::google::protobuf::MessageOptions*>(
+      ::google::protobuf::MessageOptions::internal_default_instance());
+#else
   options_ = const_cast< ::google::protobuf::MessageOptions*>(&::google::protobuf::MessageOptions::default_instance());
+#endif
 }
 
 DescriptorProto::DescriptorProto(const DescriptorProto& from)
@@ -2119,7 +2184,11 @@ const ::google::protobuf::Descriptor* DescriptorProto::descriptor() {
 }
 
 const DescriptorProto& DescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -2134,7 +2203,7 @@ DescriptorProto* DescriptorProto::New(::google::protobuf::Arena* arena) const {
 }
 
 void DescriptorProto::Clear() {
-  if (_has_bits_[0 / 32] & 129) {
+  if (_has_bits_[0] & 129u) {
     if (has_name()) {
       name_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -2602,29 +2671,7 @@ const ::google::protobuf::EnumDescriptor* FieldDescriptorProto_Type_descriptor()
   return FieldDescriptorProto_Type_descriptor_;
 }
 bool FieldDescriptorProto_Type_IsValid(int value) {
-  switch(value) {
-    case 1:
-    case 2:
-    case 3:
-    case 4:
-    case 5:
-    case 6:
-    case 7:
-    case 8:
-    case 9:
-    case 10:
-    case 11:
-    case 12:
-    case 13:
-    case 14:
-    case 15:
-    case 16:
-    case 17:
-    case 18:
-      return true;
-    default:
-      return false;
-  }
+  return 1 <= value && value <= 18;
 }
 
 #ifndef _MSC_VER
@@ -2655,14 +2702,7 @@ const ::google::protobuf::EnumDescriptor* FieldDescriptorProto_Label_descriptor(
   return FieldDescriptorProto_Label_descriptor_;
 }
 bool FieldDescriptorProto_Label_IsValid(int value) {
-  switch(value) {
-    case 1:
-    case 2:
-    case 3:
-      return true;
-    default:
-      return false;
-  }
+  return 1 <= value && value <= 3;
 }
 
 #ifndef _MSC_VER
@@ -2692,7 +2732,12 @@ FieldDescriptorProto::FieldDescriptorProto()
 }
 
 void FieldDescriptorProto::InitAsDefaultInstance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  options_ = const_cast< ::google::protobuf::FieldOptions*>(
+      ::google::protobuf::FieldOptions::internal_default_instance());
+#else
   options_ = const_cast< ::google::protobuf::FieldOptions*>(&::google::protobuf::FieldOptions::default_instance());
+#endif
 }
 
 FieldDescriptorProto::FieldDescriptorProto(const FieldDescriptorProto& from)
@@ -2709,11 +2754,11 @@ void FieldDescriptorProto::SharedCtor() {
   name_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   number_ = 0;
   label_ = 1;
-  type_ = 1;
   type_name_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   extendee_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  default_value_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  type_ = 1;
   oneof_index_ = 0;
+  default_value_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   options_ = NULL;
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
@@ -2744,7 +2789,11 @@ const ::google::protobuf::Descriptor* FieldDescriptorProto::descriptor() {
 }
 
 const FieldDescriptorProto& FieldDescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -2759,7 +2808,7 @@ FieldDescriptorProto* FieldDescriptorProto::New(::google::protobuf::Arena* arena
 }
 
 void FieldDescriptorProto::Clear() {
-  if (_has_bits_[0 / 32] & 255) {
+  if (_has_bits_[0] & 511u) {
     if (has_name()) {
       name_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -2776,9 +2825,9 @@ void FieldDescriptorProto::Clear() {
       default_value_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
     oneof_index_ = 0;
-  }
-  if (has_options()) {
-    if (options_ != NULL) options_->::google::protobuf::FieldOptions::Clear();
+    if (has_options()) {
+      if (options_ != NULL) options_->::google::protobuf::FieldOptions::Clear();
+    }
   }
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   if (_internal_metadata_.have_unknown_fields()) {
@@ -3221,39 +3270,52 @@ void FieldDescriptorProto::MergeFrom(const ::google::protobuf::Message& from) {
 
 void FieldDescriptorProto::MergeFrom(const FieldDescriptorProto& from) {
   if (GOOGLE_PREDICT_FALSE(&from == this)) MergeFromFail(__LINE__);
-  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
-    if (from.has_name()) {
-      set_has_name();
-      name_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.name_);
-    }
-    if (from.has_number()) {
-      set_number(from.number());
-    }
-    if (from.has_label()) {
-      set_label(from.label());
-    }
-    if (from.has_type()) {
-      set_type(from.type());
-    }
-    if (from.has_type_name()) {
-      set_has_type_name();
-      type_name_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.type_name_);
-    }
-    if (from.has_extendee()) {
-      set_has_extendee();
-      extendee_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.extendee_);
-    }
-    if (from.has_default_value()) {
-      set_has_default_value();
-      default_value_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.default_value_);
-    }
-    if (from.has_oneof_index()) {
-      set_oneof_index(from.oneof_index());
-    }
-  }
-  if (from._has_bits_[8 / 32] & (0xffu << (8 % 32))) {
-    if (from.has_options()) {
-      mutable_options()->::google::protobuf::FieldOptions::MergeFrom(from.options());
+  {
+    ::google::protobuf::uint32 bits = from._has_bits_[0] & 0x000001ffu;
+    while (bits != 0) {
+      switch (::google::protobuf::internal::CountTrailingZeros32(bits)) {
+        case 0: {
+          set_has_name();
+          name_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.name_);
+          break;
+        }
+        case 1: {
+          set_number(from.number());
+          break;
+        }
+        case 2: {
+          set_label(from.label());
+          break;
+        }
+        case 3: {
+          set_type(from.type());
+          break;
+        }
+        case 4: {
+          set_has_type_name();
+          type_name_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.type_name_);
+          break;
+        }
+        case 5: {
+          set_has_extendee();
+          extendee_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.extendee_);
+          break;
+        }
+        case 6: {
+          set_has_default_value();
+          default_value_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.default_value_);
+          break;
+        }
+        case 7: {
+          set_oneof_index(from.oneof_index());
+          break;
+        }
+        case 8: {
+          mutable_options()->::google::protobuf::FieldOptions::MergeFrom(from.options());
+          break;
+        }
+      }
+      bits &= bits - 1;
     }
   }
   if (from._internal_metadata_.have_unknown_fields()) {
@@ -3361,7 +3423,11 @@ const ::google::protobuf::Descriptor* OneofDescriptorProto::descriptor() {
 }
 
 const OneofDescriptorProto& OneofDescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -3573,7 +3639,12 @@ EnumDescriptorProto::EnumDescriptorProto()
 }
 
 void EnumDescriptorProto::InitAsDefaultInstance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  options_ = const_cast< ::google::protobuf::EnumOptions*>(
+      ::google::protobuf::EnumOptions::internal_default_instance());
+#else
   options_ = const_cast< ::google::protobuf::EnumOptions*>(&::google::protobuf::EnumOptions::default_instance());
+#endif
 }
 
 EnumDescriptorProto::EnumDescriptorProto(const EnumDescriptorProto& from)
@@ -3615,7 +3686,11 @@ const ::google::protobuf::Descriptor* EnumDescriptorProto::descriptor() {
 }
 
 const EnumDescriptorProto& EnumDescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -3630,7 +3705,7 @@ EnumDescriptorProto* EnumDescriptorProto::New(::google::protobuf::Arena* arena)
 }
 
 void EnumDescriptorProto::Clear() {
-  if (_has_bits_[0 / 32] & 5) {
+  if (_has_bits_[0] & 5u) {
     if (has_name()) {
       name_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -3913,7 +3988,12 @@ EnumValueDescriptorProto::EnumValueDescriptorProto()
 }
 
 void EnumValueDescriptorProto::InitAsDefaultInstance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  options_ = const_cast< ::google::protobuf::EnumValueOptions*>(
+      ::google::protobuf::EnumValueOptions::internal_default_instance());
+#else
   options_ = const_cast< ::google::protobuf::EnumValueOptions*>(&::google::protobuf::EnumValueOptions::default_instance());
+#endif
 }
 
 EnumValueDescriptorProto::EnumValueDescriptorProto(const EnumValueDescriptorProto& from)
@@ -3927,9 +4007,22 @@ EnumValueDescriptorProto::EnumValueDescriptorProto(const EnumValueDescriptorProt
 void EnumValueDescriptorProto::SharedCtor() {
   ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<EnumValueDescriptorProto*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
   name_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  number_ = 0;
-  options_ = NULL;
+  ZR_(options_, number_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -3956,7 +4049,11 @@ const ::google::protobuf::Descriptor* EnumValueDescriptorProto::descriptor() {
 }
 
 const EnumValueDescriptorProto& EnumValueDescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -3971,7 +4068,7 @@ EnumValueDescriptorProto* EnumValueDescriptorProto::New(::google::protobuf::Aren
 }
 
 void EnumValueDescriptorProto::Clear() {
-  if (_has_bits_[0 / 32] & 7) {
+  if (_has_bits_[0] & 7u) {
     if (has_name()) {
       name_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -4252,7 +4349,12 @@ ServiceDescriptorProto::ServiceDescriptorProto()
 }
 
 void ServiceDescriptorProto::InitAsDefaultInstance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  options_ = const_cast< ::google::protobuf::ServiceOptions*>(
+      ::google::protobuf::ServiceOptions::internal_default_instance());
+#else
   options_ = const_cast< ::google::protobuf::ServiceOptions*>(&::google::protobuf::ServiceOptions::default_instance());
+#endif
 }
 
 ServiceDescriptorProto::ServiceDescriptorProto(const ServiceDescriptorProto& from)
@@ -4294,7 +4396,11 @@ const ::google::protobuf::Descriptor* ServiceDescriptorProto::descriptor() {
 }
 
 const ServiceDescriptorProto& ServiceDescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -4309,7 +4415,7 @@ ServiceDescriptorProto* ServiceDescriptorProto::New(::google::protobuf::Arena* a
 }
 
 void ServiceDescriptorProto::Clear() {
-  if (_has_bits_[0 / 32] & 5) {
+  if (_has_bits_[0] & 5u) {
     if (has_name()) {
       name_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -4595,7 +4701,12 @@ MethodDescriptorProto::MethodDescriptorProto()
 }
 
 void MethodDescriptorProto::InitAsDefaultInstance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  options_ = const_cast< ::google::protobuf::MethodOptions*>(
+      ::google::protobuf::MethodOptions::internal_default_instance());
+#else
   options_ = const_cast< ::google::protobuf::MethodOptions*>(&::google::protobuf::MethodOptions::default_instance());
+#endif
 }
 
 MethodDescriptorProto::MethodDescriptorProto(const MethodDescriptorProto& from)
@@ -4609,12 +4720,24 @@ MethodDescriptorProto::MethodDescriptorProto(const MethodDescriptorProto& from)
 void MethodDescriptorProto::SharedCtor() {
   ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<MethodDescriptorProto*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
   name_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   input_type_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   output_type_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  options_ = NULL;
-  client_streaming_ = false;
-  server_streaming_ = false;
+  ZR_(options_, server_streaming_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -4643,7 +4766,11 @@ const ::google::protobuf::Descriptor* MethodDescriptorProto::descriptor() {
 }
 
 const MethodDescriptorProto& MethodDescriptorProto::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -4668,7 +4795,7 @@ void MethodDescriptorProto::Clear() {
     ::memset(&first, 0, n);                                \
   } while (0)
 
-  if (_has_bits_[0 / 32] & 63) {
+  if (_has_bits_[0] & 63u) {
     ZR_(client_streaming_, server_streaming_);
     if (has_name()) {
       name_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
@@ -5083,14 +5210,7 @@ const ::google::protobuf::EnumDescriptor* FileOptions_OptimizeMode_descriptor()
   return FileOptions_OptimizeMode_descriptor_;
 }
 bool FileOptions_OptimizeMode_IsValid(int value) {
-  switch(value) {
-    case 1:
-    case 2:
-    case 3:
-      return true;
-    default:
-      return false;
-  }
+  return 1 <= value && value <= 3;
 }
 
 #ifndef _MSC_VER
@@ -5137,18 +5257,26 @@ FileOptions::FileOptions(const FileOptions& from)
 void FileOptions::SharedCtor() {
   ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<FileOptions*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
   java_package_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   java_outer_classname_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  java_multiple_files_ = false;
-  java_generate_equals_and_hash_ = false;
-  java_string_check_utf8_ = false;
+  ZR_(java_multiple_files_, cc_generic_services_);
   optimize_for_ = 1;
   go_package_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  cc_generic_services_ = false;
-  java_generic_services_ = false;
-  py_generic_services_ = false;
-  deprecated_ = false;
-  cc_enable_arenas_ = false;
+  ZR_(java_generic_services_, cc_enable_arenas_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -5176,7 +5304,11 @@ const ::google::protobuf::Descriptor* FileOptions::descriptor() {
 }
 
 const FileOptions& FileOptions::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -5202,8 +5334,9 @@ void FileOptions::Clear() {
     ::memset(&first, 0, n);                                \
   } while (0)
 
-  if (_has_bits_[0 / 32] & 255) {
+  if (_has_bits_[0] & 4095u) {
     ZR_(java_multiple_files_, cc_generic_services_);
+    ZR_(java_generic_services_, cc_enable_arenas_);
     if (has_java_package()) {
       java_package_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -5215,7 +5348,6 @@ void FileOptions::Clear() {
       go_package_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
   }
-  ZR_(java_generic_services_, cc_enable_arenas_);
 
 #undef OFFSET_OF_FIELD_
 #undef ZR_
@@ -5449,8 +5581,13 @@ bool FileOptions::MergePartialFromCodedStream(
           goto success;
         }
         if ((8000u <= tag)) {
+        #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+          DO_(_extensions_.ParseField(tag, input, &default_instance(),
+                                      mutable_unknown_fields()));
+        #else
           DO_(_extensions_.ParseField(tag, input, default_instance_,
                                       mutable_unknown_fields()));
+        #endif
           continue;
         }
         DO_(::google::protobuf::internal::WireFormat::SkipField(
@@ -5775,47 +5912,63 @@ void FileOptions::MergeFrom(const ::google::protobuf::Message& from) {
 void FileOptions::MergeFrom(const FileOptions& from) {
   if (GOOGLE_PREDICT_FALSE(&from == this)) MergeFromFail(__LINE__);
   uninterpreted_option_.MergeFrom(from.uninterpreted_option_);
-  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
-    if (from.has_java_package()) {
-      set_has_java_package();
-      java_package_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.java_package_);
-    }
-    if (from.has_java_outer_classname()) {
-      set_has_java_outer_classname();
-      java_outer_classname_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.java_outer_classname_);
-    }
-    if (from.has_java_multiple_files()) {
-      set_java_multiple_files(from.java_multiple_files());
-    }
-    if (from.has_java_generate_equals_and_hash()) {
-      set_java_generate_equals_and_hash(from.java_generate_equals_and_hash());
-    }
-    if (from.has_java_string_check_utf8()) {
-      set_java_string_check_utf8(from.java_string_check_utf8());
-    }
-    if (from.has_optimize_for()) {
-      set_optimize_for(from.optimize_for());
-    }
-    if (from.has_go_package()) {
-      set_has_go_package();
-      go_package_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.go_package_);
-    }
-    if (from.has_cc_generic_services()) {
-      set_cc_generic_services(from.cc_generic_services());
-    }
-  }
-  if (from._has_bits_[8 / 32] & (0xffu << (8 % 32))) {
-    if (from.has_java_generic_services()) {
-      set_java_generic_services(from.java_generic_services());
-    }
-    if (from.has_py_generic_services()) {
-      set_py_generic_services(from.py_generic_services());
-    }
-    if (from.has_deprecated()) {
-      set_deprecated(from.deprecated());
-    }
-    if (from.has_cc_enable_arenas()) {
-      set_cc_enable_arenas(from.cc_enable_arenas());
+  {
+    ::google::protobuf::uint32 bits = from._has_bits_[0] & 0x00000fffu;
+    while (bits != 0) {
+      switch (::google::protobuf::internal::CountTrailingZeros32(bits)) {
+        case 0: {
+          set_has_java_package();
+          java_package_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.java_package_);
+          break;
+        }
+        case 1: {
+          set_has_java_outer_classname();
+          java_outer_classname_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.java_outer_classname_);
+          break;
+        }
+        case 2: {
+          set_java_multiple_files(from.java_multiple_files());
+          break;
+        }
+        case 3: {
+          set_java_generate_equals_and_hash(from.java_generate_equals_and_hash());
+          break;
+        }
+        case 4: {
+          set_java_string_check_utf8(from.java_string_check_utf8());
+          break;
+        }
+        case 5: {
+          set_optimize_for(from.optimize_for());
+          break;
+        }
+        case 6: {
+          set_has_go_package();
+          go_package_.AssignWithDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited(), from.go_package_);
+          break;
+        }
+        case 7: {
+          set_cc_generic_services(from.cc_generic_services());
+          break;
+        }
+        case 8: {
+          set_java_generic_services(from.java_generic_services());
+          break;
+        }
+        case 9: {
+          set_py_generic_services(from.py_generic_services());
+          break;
+        }
+        case 10: {
+          set_deprecated(from.deprecated());
+          break;
+        }
+        case 11: {
+          set_cc_enable_arenas(from.cc_enable_arenas());
+          break;
+        }
+      }
+      bits &= bits - 1;
     }
   }
   _extensions_.MergeFrom(from._extensions_);
@@ -5905,10 +6058,21 @@ MessageOptions::MessageOptions(const MessageOptions& from)
 
 void MessageOptions::SharedCtor() {
   _cached_size_ = 0;
-  message_set_wire_format_ = false;
-  no_standard_descriptor_accessor_ = false;
-  deprecated_ = false;
-  map_entry_ = false;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<MessageOptions*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
+  ZR_(message_set_wire_format_, map_entry_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -5933,7 +6097,11 @@ const ::google::protobuf::Descriptor* MessageOptions::descriptor() {
 }
 
 const MessageOptions& MessageOptions::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -6062,8 +6230,13 @@ bool MessageOptions::MergePartialFromCodedStream(
           goto success;
         }
         if ((8000u <= tag)) {
+        #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+          DO_(_extensions_.ParseField(tag, input, &default_instance(),
+                                      mutable_unknown_fields()));
+        #else
           DO_(_extensions_.ParseField(tag, input, default_instance_,
                                       mutable_unknown_fields()));
+        #endif
           continue;
         }
         DO_(::google::protobuf::internal::WireFormat::SkipField(
@@ -6295,14 +6468,7 @@ const ::google::protobuf::EnumDescriptor* FieldOptions_CType_descriptor() {
   return FieldOptions_CType_descriptor_;
 }
 bool FieldOptions_CType_IsValid(int value) {
-  switch(value) {
-    case 0:
-    case 1:
-    case 2:
-      return true;
-    default:
-      return false;
-  }
+  return 0 <= value && value <= 2;
 }
 
 #ifndef _MSC_VER
@@ -6341,11 +6507,21 @@ FieldOptions::FieldOptions(const FieldOptions& from)
 
 void FieldOptions::SharedCtor() {
   _cached_size_ = 0;
-  ctype_ = 0;
-  packed_ = false;
-  lazy_ = false;
-  deprecated_ = false;
-  weak_ = false;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<FieldOptions*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
+  ZR_(ctype_, weak_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -6370,7 +6546,11 @@ const ::google::protobuf::Descriptor* FieldOptions::descriptor() {
 }
 
 const FieldOptions& FieldOptions::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -6396,7 +6576,7 @@ void FieldOptions::Clear() {
     ::memset(&first, 0, n);                                \
   } while (0)
 
-  if (_has_bits_[0 / 32] & 31) {
+  if (_has_bits_[0] & 31u) {
     ZR_(ctype_, weak_);
   }
 
@@ -6521,8 +6701,13 @@ bool FieldOptions::MergePartialFromCodedStream(
           goto success;
         }
         if ((8000u <= tag)) {
+        #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+          DO_(_extensions_.ParseField(tag, input, &default_instance(),
+                                      mutable_unknown_fields()));
+        #else
           DO_(_extensions_.ParseField(tag, input, default_instance_,
                                       mutable_unknown_fields()));
+        #endif
           continue;
         }
         DO_(::google::protobuf::internal::WireFormat::SkipField(
@@ -6796,8 +6981,21 @@ EnumOptions::EnumOptions(const EnumOptions& from)
 
 void EnumOptions::SharedCtor() {
   _cached_size_ = 0;
-  allow_alias_ = false;
-  deprecated_ = false;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<EnumOptions*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
+  ZR_(allow_alias_, deprecated_);
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -6822,7 +7020,11 @@ const ::google::protobuf::Descriptor* EnumOptions::descriptor() {
 }
 
 const EnumOptions& EnumOptions::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -6921,8 +7123,13 @@ bool EnumOptions::MergePartialFromCodedStream(
           goto success;
         }
         if ((8000u <= tag)) {
+        #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+          DO_(_extensions_.ParseField(tag, input, &default_instance(),
+                                      mutable_unknown_fields()));
+        #else
           DO_(_extensions_.ParseField(tag, input, default_instance_,
                                       mutable_unknown_fields()));
+        #endif
           continue;
         }
         DO_(::google::protobuf::internal::WireFormat::SkipField(
@@ -7160,7 +7367,11 @@ const ::google::protobuf::Descriptor* EnumValueOptions::descriptor() {
 }
 
 const EnumValueOptions& EnumValueOptions::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -7230,8 +7441,13 @@ bool EnumValueOptions::MergePartialFromCodedStream(
           goto success;
         }
         if ((8000u <= tag)) {
+        #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+          DO_(_extensions_.ParseField(tag, input, &default_instance(),
+                                      mutable_unknown_fields()));
+        #else
           DO_(_extensions_.ParseField(tag, input, default_instance_,
                                       mutable_unknown_fields()));
+        #endif
           continue;
         }
         DO_(::google::protobuf::internal::WireFormat::SkipField(
@@ -7448,7 +7664,11 @@ const ::google::protobuf::Descriptor* ServiceOptions::descriptor() {
 }
 
 const ServiceOptions& ServiceOptions::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -7518,8 +7738,13 @@ bool ServiceOptions::MergePartialFromCodedStream(
           goto success;
         }
         if ((8000u <= tag)) {
+        #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+          DO_(_extensions_.ParseField(tag, input, &default_instance(),
+                                      mutable_unknown_fields()));
+        #else
           DO_(_extensions_.ParseField(tag, input, default_instance_,
                                       mutable_unknown_fields()));
+        #endif
           continue;
         }
         DO_(::google::protobuf::internal::WireFormat::SkipField(
@@ -7736,7 +7961,11 @@ const ::google::protobuf::Descriptor* MethodOptions::descriptor() {
 }
 
 const MethodOptions& MethodOptions::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -7806,8 +8035,13 @@ bool MethodOptions::MergePartialFromCodedStream(
           goto success;
         }
         if ((8000u <= tag)) {
+        #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+          DO_(_extensions_.ParseField(tag, input, &default_instance(),
+                                      mutable_unknown_fields()));
+        #else
           DO_(_extensions_.ParseField(tag, input, default_instance_,
                                       mutable_unknown_fields()));
+        #endif
           continue;
         }
         DO_(::google::protobuf::internal::WireFormat::SkipField(
@@ -8027,7 +8261,11 @@ const ::google::protobuf::Descriptor* UninterpretedOption_NamePart::descriptor()
 }
 
 const UninterpretedOption_NamePart& UninterpretedOption_NamePart::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -8042,7 +8280,7 @@ UninterpretedOption_NamePart* UninterpretedOption_NamePart::New(::google::protob
 }
 
 void UninterpretedOption_NamePart::Clear() {
-  if (_has_bits_[0 / 32] & 3) {
+  if (_has_bits_[0] & 3u) {
     if (has_name_part()) {
       name_part_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -8311,12 +8549,24 @@ UninterpretedOption::UninterpretedOption(const UninterpretedOption& from)
 void UninterpretedOption::SharedCtor() {
   ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
+#define OFFSET_OF_FIELD_(f) (reinterpret_cast<char*>(      \
+  &reinterpret_cast<UninterpretedOption*>(16)->f) - \
+   reinterpret_cast<char*>(16))
+
+#define ZR_(first, last) do {                              \
+    size_t f = OFFSET_OF_FIELD_(first);                    \
+    size_t n = OFFSET_OF_FIELD_(last) - f + sizeof(last);  \
+    ::memset(&first, 0, n);                                \
+  } while (0)
+
   identifier_value_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
-  positive_int_value_ = GOOGLE_ULONGLONG(0);
-  negative_int_value_ = GOOGLE_LONGLONG(0);
-  double_value_ = 0;
+  ZR_(positive_int_value_, double_value_);
   string_value_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
   aggregate_value_.UnsafeSetDefault(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+
+#undef OFFSET_OF_FIELD_
+#undef ZR_
+
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -8344,7 +8594,11 @@ const ::google::protobuf::Descriptor* UninterpretedOption::descriptor() {
 }
 
 const UninterpretedOption& UninterpretedOption::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -8369,7 +8623,7 @@ void UninterpretedOption::Clear() {
     ::memset(&first, 0, n);                                \
   } while (0)
 
-  if (_has_bits_[0 / 32] & 126) {
+  if (_has_bits_[0] & 126u) {
     ZR_(positive_int_value_, double_value_);
     if (has_identifier_value()) {
       identifier_value_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
@@ -8857,7 +9111,11 @@ const ::google::protobuf::Descriptor* SourceCodeInfo_Location::descriptor() {
 }
 
 const SourceCodeInfo_Location& SourceCodeInfo_Location::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
@@ -8872,7 +9130,7 @@ SourceCodeInfo_Location* SourceCodeInfo_Location::New(::google::protobuf::Arena*
 }
 
 void SourceCodeInfo_Location::Clear() {
-  if (_has_bits_[0 / 32] & 12) {
+  if (_has_bits_[0] & 12u) {
     if (has_leading_comments()) {
       leading_comments_.ClearToEmptyNoArena(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
     }
@@ -9284,7 +9542,11 @@ const ::google::protobuf::Descriptor* SourceCodeInfo::descriptor() {
 }
 
 const SourceCodeInfo& SourceCodeInfo::default_instance() {
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#else
   if (default_instance_ == NULL) protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+#endif
   return *default_instance_;
 }
 
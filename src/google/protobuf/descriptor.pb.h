@@ -169,6 +169,26 @@ class LIBPROTOBUF_EXPORT FileDescriptorSet : public ::google::protobuf::Message
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline FileDescriptorSet(FileDescriptorSet&& from)
+    : FileDescriptorSet() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline FileDescriptorSet& operator=(FileDescriptorSet&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -180,6 +200,14 @@ class LIBPROTOBUF_EXPORT FileDescriptorSet : public ::google::protobuf::Message
   static const ::google::protobuf::Descriptor* descriptor();
   static const FileDescriptorSet& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const FileDescriptorSet* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(FileDescriptorSet* other);
 
   // implements Message ----------------------------------------------
@@ -240,7 +268,11 @@ class LIBPROTOBUF_EXPORT FileDescriptorSet : public ::google::protobuf::Message
   ::google::protobuf::uint32 _has_bits_[1];
   mutable int _cached_size_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::FileDescriptorProto > file_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -261,6 +293,26 @@ class LIBPROTOBUF_EXPORT FileDescriptorProto : public ::google::protobuf::Messag
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline FileDescriptorProto(FileDescriptorProto&& from)
+    : FileDescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline FileDescriptorProto& operator=(FileDescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -272,6 +324,14 @@ class LIBPROTOBUF_EXPORT FileDescriptorProto : public ::google::protobuf::Messag
   static const ::google::protobuf::Descriptor* descriptor();
   static const FileDescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const FileDescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(FileDescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -483,7 +543,11 @@ class LIBPROTOBUF_EXPORT FileDescriptorProto : public ::google::protobuf::Messag
   ::google::protobuf::FileOptions* options_;
   ::google::protobuf::SourceCodeInfo* source_code_info_;
   ::google::protobuf::internal::ArenaStringPtr syntax_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -504,6 +568,26 @@ class LIBPROTOBUF_EXPORT DescriptorProto_ExtensionRange : public ::google::proto
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline DescriptorProto_ExtensionRange(DescriptorProto_ExtensionRange&& from)
+    : DescriptorProto_ExtensionRange() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline DescriptorProto_ExtensionRange& operator=(DescriptorProto_ExtensionRange&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -515,6 +599,14 @@ class LIBPROTOBUF_EXPORT DescriptorProto_ExtensionRange : public ::google::proto
   static const ::google::protobuf::Descriptor* descriptor();
   static const DescriptorProto_ExtensionRange& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const DescriptorProto_ExtensionRange* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(DescriptorProto_ExtensionRange* other);
 
   // implements Message ----------------------------------------------
@@ -582,7 +674,11 @@ class LIBPROTOBUF_EXPORT DescriptorProto_ExtensionRange : public ::google::proto
   mutable int _cached_size_;
   ::google::protobuf::int32 start_;
   ::google::protobuf::int32 end_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -603,6 +699,26 @@ class LIBPROTOBUF_EXPORT DescriptorProto : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline DescriptorProto(DescriptorProto&& from)
+    : DescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline DescriptorProto& operator=(DescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -614,6 +730,14 @@ class LIBPROTOBUF_EXPORT DescriptorProto : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const DescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const DescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(DescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -768,7 +892,11 @@ class LIBPROTOBUF_EXPORT DescriptorProto : public ::google::protobuf::Message {
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::DescriptorProto_ExtensionRange > extension_range_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::OneofDescriptorProto > oneof_decl_;
   ::google::protobuf::MessageOptions* options_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -789,6 +917,26 @@ class LIBPROTOBUF_EXPORT FieldDescriptorProto : public ::google::protobuf::Messa
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline FieldDescriptorProto(FieldDescriptorProto&& from)
+    : FieldDescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline FieldDescriptorProto& operator=(FieldDescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -800,6 +948,14 @@ class LIBPROTOBUF_EXPORT FieldDescriptorProto : public ::google::protobuf::Messa
   static const ::google::protobuf::Descriptor* descriptor();
   static const FieldDescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const FieldDescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(FieldDescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -1024,7 +1180,11 @@ class LIBPROTOBUF_EXPORT FieldDescriptorProto : public ::google::protobuf::Messa
   ::google::protobuf::int32 oneof_index_;
   ::google::protobuf::internal::ArenaStringPtr default_value_;
   ::google::protobuf::FieldOptions* options_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -1045,6 +1205,26 @@ class LIBPROTOBUF_EXPORT OneofDescriptorProto : public ::google::protobuf::Messa
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline OneofDescriptorProto(OneofDescriptorProto&& from)
+    : OneofDescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline OneofDescriptorProto& operator=(OneofDescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -1056,6 +1236,14 @@ class LIBPROTOBUF_EXPORT OneofDescriptorProto : public ::google::protobuf::Messa
   static const ::google::protobuf::Descriptor* descriptor();
   static const OneofDescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const OneofDescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(OneofDescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -1118,7 +1306,11 @@ class LIBPROTOBUF_EXPORT OneofDescriptorProto : public ::google::protobuf::Messa
   ::google::protobuf::uint32 _has_bits_[1];
   mutable int _cached_size_;
   ::google::protobuf::internal::ArenaStringPtr name_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -1139,6 +1331,26 @@ class LIBPROTOBUF_EXPORT EnumDescriptorProto : public ::google::protobuf::Messag
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline EnumDescriptorProto(EnumDescriptorProto&& from)
+    : EnumDescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline EnumDescriptorProto& operator=(EnumDescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -1150,6 +1362,14 @@ class LIBPROTOBUF_EXPORT EnumDescriptorProto : public ::google::protobuf::Messag
   static const ::google::protobuf::Descriptor* descriptor();
   static const EnumDescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const EnumDescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(EnumDescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -1237,7 +1457,11 @@ class LIBPROTOBUF_EXPORT EnumDescriptorProto : public ::google::protobuf::Messag
   ::google::protobuf::internal::ArenaStringPtr name_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::EnumValueDescriptorProto > value_;
   ::google::protobuf::EnumOptions* options_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -1258,6 +1482,26 @@ class LIBPROTOBUF_EXPORT EnumValueDescriptorProto : public ::google::protobuf::M
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline EnumValueDescriptorProto(EnumValueDescriptorProto&& from)
+    : EnumValueDescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline EnumValueDescriptorProto& operator=(EnumValueDescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -1269,6 +1513,14 @@ class LIBPROTOBUF_EXPORT EnumValueDescriptorProto : public ::google::protobuf::M
   static const ::google::protobuf::Descriptor* descriptor();
   static const EnumValueDescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const EnumValueDescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(EnumValueDescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -1353,7 +1605,11 @@ class LIBPROTOBUF_EXPORT EnumValueDescriptorProto : public ::google::protobuf::M
   ::google::protobuf::internal::ArenaStringPtr name_;
   ::google::protobuf::EnumValueOptions* options_;
   ::google::protobuf::int32 number_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -1374,6 +1630,26 @@ class LIBPROTOBUF_EXPORT ServiceDescriptorProto : public ::google::protobuf::Mes
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline ServiceDescriptorProto(ServiceDescriptorProto&& from)
+    : ServiceDescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline ServiceDescriptorProto& operator=(ServiceDescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -1385,6 +1661,14 @@ class LIBPROTOBUF_EXPORT ServiceDescriptorProto : public ::google::protobuf::Mes
   static const ::google::protobuf::Descriptor* descriptor();
   static const ServiceDescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const ServiceDescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(ServiceDescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -1472,7 +1756,11 @@ class LIBPROTOBUF_EXPORT ServiceDescriptorProto : public ::google::protobuf::Mes
   ::google::protobuf::internal::ArenaStringPtr name_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::MethodDescriptorProto > method_;
   ::google::protobuf::ServiceOptions* options_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -1493,6 +1781,26 @@ class LIBPROTOBUF_EXPORT MethodDescriptorProto : public ::google::protobuf::Mess
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline MethodDescriptorProto(MethodDescriptorProto&& from)
+    : MethodDescriptorProto() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline MethodDescriptorProto& operator=(MethodDescriptorProto&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -1504,6 +1812,14 @@ class LIBPROTOBUF_EXPORT MethodDescriptorProto : public ::google::protobuf::Mess
   static const ::google::protobuf::Descriptor* descriptor();
   static const MethodDescriptorProto& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const MethodDescriptorProto* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(MethodDescriptorProto* other);
 
   // implements Message ----------------------------------------------
@@ -1628,7 +1944,11 @@ class LIBPROTOBUF_EXPORT MethodDescriptorProto : public ::google::protobuf::Mess
   ::google::protobuf::MethodOptions* options_;
   bool client_streaming_;
   bool server_streaming_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -1649,6 +1969,26 @@ class LIBPROTOBUF_EXPORT FileOptions : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline FileOptions(FileOptions&& from)
+    : FileOptions() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline FileOptions& operator=(FileOptions&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -1660,6 +2000,14 @@ class LIBPROTOBUF_EXPORT FileOptions : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const FileOptions& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const FileOptions* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(FileOptions* other);
 
   // implements Message ----------------------------------------------
@@ -1883,7 +2231,11 @@ class LIBPROTOBUF_EXPORT FileOptions : public ::google::protobuf::Message {
   bool py_generic_services_;
   bool deprecated_;
   bool cc_enable_arenas_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -1904,6 +2256,26 @@ class LIBPROTOBUF_EXPORT MessageOptions : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline MessageOptions(MessageOptions&& from)
+    : MessageOptions() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline MessageOptions& operator=(MessageOptions&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -1915,6 +2287,14 @@ class LIBPROTOBUF_EXPORT MessageOptions : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const MessageOptions& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const MessageOptions* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(MessageOptions* other);
 
   // implements Message ----------------------------------------------
@@ -2018,7 +2398,11 @@ class LIBPROTOBUF_EXPORT MessageOptions : public ::google::protobuf::Message {
   bool no_standard_descriptor_accessor_;
   bool deprecated_;
   bool map_entry_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2039,6 +2423,26 @@ class LIBPROTOBUF_EXPORT FieldOptions : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline FieldOptions(FieldOptions&& from)
+    : FieldOptions() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline FieldOptions& operator=(FieldOptions&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2050,6 +2454,14 @@ class LIBPROTOBUF_EXPORT FieldOptions : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const FieldOptions& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const FieldOptions* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(FieldOptions* other);
 
   // implements Message ----------------------------------------------
@@ -2188,7 +2600,11 @@ class LIBPROTOBUF_EXPORT FieldOptions : public ::google::protobuf::Message {
   bool deprecated_;
   bool weak_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::UninterpretedOption > uninterpreted_option_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2209,6 +2625,26 @@ class LIBPROTOBUF_EXPORT EnumOptions : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline EnumOptions(EnumOptions&& from)
+    : EnumOptions() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline EnumOptions& operator=(EnumOptions&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2220,6 +2656,14 @@ class LIBPROTOBUF_EXPORT EnumOptions : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const EnumOptions& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const EnumOptions* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(EnumOptions* other);
 
   // implements Message ----------------------------------------------
@@ -2303,7 +2747,11 @@ class LIBPROTOBUF_EXPORT EnumOptions : public ::google::protobuf::Message {
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::UninterpretedOption > uninterpreted_option_;
   bool allow_alias_;
   bool deprecated_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2324,6 +2772,26 @@ class LIBPROTOBUF_EXPORT EnumValueOptions : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline EnumValueOptions(EnumValueOptions&& from)
+    : EnumValueOptions() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline EnumValueOptions& operator=(EnumValueOptions&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2335,6 +2803,14 @@ class LIBPROTOBUF_EXPORT EnumValueOptions : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const EnumValueOptions& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const EnumValueOptions* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(EnumValueOptions* other);
 
   // implements Message ----------------------------------------------
@@ -2408,7 +2884,11 @@ class LIBPROTOBUF_EXPORT EnumValueOptions : public ::google::protobuf::Message {
   mutable int _cached_size_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::UninterpretedOption > uninterpreted_option_;
   bool deprecated_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2429,6 +2909,26 @@ class LIBPROTOBUF_EXPORT ServiceOptions : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline ServiceOptions(ServiceOptions&& from)
+    : ServiceOptions() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline ServiceOptions& operator=(ServiceOptions&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2440,6 +2940,14 @@ class LIBPROTOBUF_EXPORT ServiceOptions : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const ServiceOptions& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const ServiceOptions* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(ServiceOptions* other);
 
   // implements Message ----------------------------------------------
@@ -2513,7 +3021,11 @@ class LIBPROTOBUF_EXPORT ServiceOptions : public ::google::protobuf::Message {
   mutable int _cached_size_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::UninterpretedOption > uninterpreted_option_;
   bool deprecated_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2534,6 +3046,26 @@ class LIBPROTOBUF_EXPORT MethodOptions : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline MethodOptions(MethodOptions&& from)
+    : MethodOptions() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline MethodOptions& operator=(MethodOptions&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2545,6 +3077,14 @@ class LIBPROTOBUF_EXPORT MethodOptions : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const MethodOptions& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const MethodOptions* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(MethodOptions* other);
 
   // implements Message ----------------------------------------------
@@ -2618,7 +3158,11 @@ class LIBPROTOBUF_EXPORT MethodOptions : public ::google::protobuf::Message {
   mutable int _cached_size_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::UninterpretedOption > uninterpreted_option_;
   bool deprecated_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2639,6 +3183,26 @@ class LIBPROTOBUF_EXPORT UninterpretedOption_NamePart : public ::google::protobu
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline UninterpretedOption_NamePart(UninterpretedOption_NamePart&& from)
+    : UninterpretedOption_NamePart() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline UninterpretedOption_NamePart& operator=(UninterpretedOption_NamePart&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2650,6 +3214,14 @@ class LIBPROTOBUF_EXPORT UninterpretedOption_NamePart : public ::google::protobu
   static const ::google::protobuf::Descriptor* descriptor();
   static const UninterpretedOption_NamePart& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const UninterpretedOption_NamePart* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(UninterpretedOption_NamePart* other);
 
   // implements Message ----------------------------------------------
@@ -2725,7 +3297,11 @@ class LIBPROTOBUF_EXPORT UninterpretedOption_NamePart : public ::google::protobu
   mutable int _cached_size_;
   ::google::protobuf::internal::ArenaStringPtr name_part_;
   bool is_extension_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2746,6 +3322,26 @@ class LIBPROTOBUF_EXPORT UninterpretedOption : public ::google::protobuf::Messag
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline UninterpretedOption(UninterpretedOption&& from)
+    : UninterpretedOption() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline UninterpretedOption& operator=(UninterpretedOption&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2757,6 +3353,14 @@ class LIBPROTOBUF_EXPORT UninterpretedOption : public ::google::protobuf::Messag
   static const ::google::protobuf::Descriptor* descriptor();
   static const UninterpretedOption& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const UninterpretedOption* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(UninterpretedOption* other);
 
   // implements Message ----------------------------------------------
@@ -2894,7 +3498,11 @@ class LIBPROTOBUF_EXPORT UninterpretedOption : public ::google::protobuf::Messag
   double double_value_;
   ::google::protobuf::internal::ArenaStringPtr string_value_;
   ::google::protobuf::internal::ArenaStringPtr aggregate_value_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -2915,6 +3523,26 @@ class LIBPROTOBUF_EXPORT SourceCodeInfo_Location : public ::google::protobuf::Me
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline SourceCodeInfo_Location(SourceCodeInfo_Location&& from)
+    : SourceCodeInfo_Location() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline SourceCodeInfo_Location& operator=(SourceCodeInfo_Location&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -2926,6 +3554,14 @@ class LIBPROTOBUF_EXPORT SourceCodeInfo_Location : public ::google::protobuf::Me
   static const ::google::protobuf::Descriptor* descriptor();
   static const SourceCodeInfo_Location& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const SourceCodeInfo_Location* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(SourceCodeInfo_Location* other);
 
   // implements Message ----------------------------------------------
@@ -3031,7 +3667,11 @@ class LIBPROTOBUF_EXPORT SourceCodeInfo_Location : public ::google::protobuf::Me
   mutable int _span_cached_byte_size_;
   ::google::protobuf::internal::ArenaStringPtr leading_comments_;
   ::google::protobuf::internal::ArenaStringPtr trailing_comments_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -3052,6 +3692,26 @@ class LIBPROTOBUF_EXPORT SourceCodeInfo : public ::google::protobuf::Message {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  inline SourceCodeInfo(SourceCodeInfo&& from)
+    : SourceCodeInfo() {
+    if (from.GetArenaNoVirtual() == NULL) {
+      InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+  }
+
+  inline SourceCodeInfo& operator=(SourceCodeInfo&& from) {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+#endif
+
   inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
     return _internal_metadata_.unknown_fields();
   }
@@ -3063,6 +3723,14 @@ class LIBPROTOBUF_EXPORT SourceCodeInfo : public ::google::protobuf::Message {
   static const ::google::protobuf::Descriptor* descriptor();
   static const SourceCodeInfo& default_instance();
 
+  // Returns the internal default instance pointer. This function can
+  // return NULL thus should not be used by the user. This is intended
+  // for Protobuf internal code. Please use default_instance() declared
+  // above instead.
+  static inline const SourceCodeInfo* internal_default_instance() {
+    return default_instance_;
+  }
+
   void Swap(SourceCodeInfo* other);
 
   // implements Message ----------------------------------------------
@@ -3125,7 +3793,11 @@ class LIBPROTOBUF_EXPORT SourceCodeInfo : public ::google::protobuf::Message {
   ::google::protobuf::uint32 _has_bits_[1];
   mutable int _cached_size_;
   ::google::protobuf::RepeatedPtrField< ::google::protobuf::SourceCodeInfo_Location > location_;
+  #ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto_impl();
+  #else
   friend void LIBPROTOBUF_EXPORT protobuf_AddDesc_google_2fprotobuf_2fdescriptor_2eproto();
+  #endif
   friend void protobuf_AssignDesc_google_2fprotobuf_2fdescriptor_2eproto();
   friend void protobuf_ShutdownFile_google_2fprotobuf_2fdescriptor_2eproto();
 
@@ -3529,7 +4201,11 @@ inline void FileDescriptorProto::clear_options() {
 }
 inline const ::google::protobuf::FileOptions& FileDescriptorProto::options() const {
   // @@protoc_insertion_point(field_get:google.protobuf.FileDescriptorProto.options)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return options_ != NULL ? *options_ : *default_instance().options_;
+#else
   return options_ != NULL ? *options_ : *default_instance_->options_;
+#endif
 }
 inline ::google::protobuf::FileOptions* FileDescriptorProto::mutable_options() {
   set_has_options();
@@ -3572,7 +4248,11 @@ inline void FileDescriptorProto::clear_source_code_info() {
 }
 inline const ::google::protobuf::SourceCodeInfo& FileDescriptorProto::source_code_info() const {
   // @@protoc_insertion_point(field_get:google.protobuf.FileDescriptorProto.source_code_info)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return source_code_info_ != NULL ? *source_code_info_ : *default_instance().source_code_info_;
+#else
   return source_code_info_ != NULL ? *source_code_info_ : *default_instance_->source_code_info_;
+#endif
 }
 inline ::google::protobuf::SourceCodeInfo* FileDescriptorProto::mutable_source_code_info() {
   set_has_source_code_info();
@@ -3957,7 +4637,11 @@ inline void DescriptorProto::clear_options() {
 }
 inline const ::google::protobuf::MessageOptions& DescriptorProto::options() const {
   // @@protoc_insertion_point(field_get:google.protobuf.DescriptorProto.options)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return options_ != NULL ? *options_ : *default_instance().options_;
+#else
   return options_ != NULL ? *options_ : *default_instance_->options_;
+#endif
 }
 inline ::google::protobuf::MessageOptions* DescriptorProto::mutable_options() {
   set_has_options();
@@ -4314,7 +4998,11 @@ inline void FieldDescriptorProto::clear_options() {
 }
 inline const ::google::protobuf::FieldOptions& FieldDescriptorProto::options() const {
   // @@protoc_insertion_point(field_get:google.protobuf.FieldDescriptorProto.options)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return options_ != NULL ? *options_ : *default_instance().options_;
+#else
   return options_ != NULL ? *options_ : *default_instance_->options_;
+#endif
 }
 inline ::google::protobuf::FieldOptions* FieldDescriptorProto::mutable_options() {
   set_has_options();
@@ -4501,7 +5189,11 @@ inline void EnumDescriptorProto::clear_options() {
 }
 inline const ::google::protobuf::EnumOptions& EnumDescriptorProto::options() const {
   // @@protoc_insertion_point(field_get:google.protobuf.EnumDescriptorProto.options)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return options_ != NULL ? *options_ : *default_instance().options_;
+#else
   return options_ != NULL ? *options_ : *default_instance_->options_;
+#endif
 }
 inline ::google::protobuf::EnumOptions* EnumDescriptorProto::mutable_options() {
   set_has_options();
@@ -4625,7 +5317,11 @@ inline void EnumValueDescriptorProto::clear_options() {
 }
 inline const ::google::protobuf::EnumValueOptions& EnumValueDescriptorProto::options() const {
   // @@protoc_insertion_point(field_get:google.protobuf.EnumValueDescriptorProto.options)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return options_ != NULL ? *options_ : *default_instance().options_;
+#else
   return options_ != NULL ? *options_ : *default_instance_->options_;
+#endif
 }
 inline ::google::protobuf::EnumValueOptions* EnumValueDescriptorProto::mutable_options() {
   set_has_options();
@@ -4755,7 +5451,11 @@ inline void ServiceDescriptorProto::clear_options() {
 }
 inline const ::google::protobuf::ServiceOptions& ServiceDescriptorProto::options() const {
   // @@protoc_insertion_point(field_get:google.protobuf.ServiceDescriptorProto.options)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return options_ != NULL ? *options_ : *default_instance().options_;
+#else
   return options_ != NULL ? *options_ : *default_instance_->options_;
+#endif
 }
 inline ::google::protobuf::ServiceOptions* ServiceDescriptorProto::mutable_options() {
   set_has_options();
@@ -4961,7 +5661,11 @@ inline void MethodDescriptorProto::clear_options() {
 }
 inline const ::google::protobuf::MethodOptions& MethodDescriptorProto::options() const {
   // @@protoc_insertion_point(field_get:google.protobuf.MethodDescriptorProto.options)
+#ifdef GOOGLE_PROTOBUF_NO_STATIC_INITIALIZER
+  return options_ != NULL ? *options_ : *default_instance().options_;
+#else
   return options_ != NULL ? *options_ : *default_instance_->options_;
+#endif
 }
 inline ::google::protobuf::MethodOptions* MethodDescriptorProto::mutable_options() {
   set_has_options();
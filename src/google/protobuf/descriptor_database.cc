@@ -299,6 +299,36 @@ bool SimpleDescriptorDatabase::MaybeCopy(const FileDescriptorProto* file,
 
 // -------------------------------------------------------------------
 
+namespace {
+
+// Reads the name of an encoded FileDescriptorProto without parsing the rest
+// of it where possible.
+bool ReadEncodedFileName(pair<const void*, int> encoded_file, string* output) {
+  // Optimization:  The name should be the first field in the encoded message.
+  //   Try to just read it directly.
+  io::CodedInputStream input(reinterpret_cast<const uint8*>(encoded_file.first),
+                             encoded_file.second);
+
+  const uint32 kNameTag = internal::WireFormatLite::MakeTag(
+      FileDescriptorProto::kNameFieldNumber,
+      internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+  if (input.ReadTag() == kNameTag) {
+    // Success!
+    return internal::WireFormatLite::ReadString(&input, output);
+  } else {
+    // Slow path.  Parse whole message.
+    FileDescriptorProto file_proto;
+    if (!file_proto.ParseFromArray(encoded_file.first, encoded_file.second)) {
+      return false;
+    }
+    *output = file_proto.name();
+    return true;
+  }
+}
+
+}  // namespace
+
 EncodedDescriptorDatabase::EncodedDescriptorDatabase() {}
 EncodedDescriptorDatabase::~EncodedDescriptorDatabase() {
   for (int i = 0; i < files_to_delete_.size(); i++) {
@@ -326,51 +356,43 @@ bool EncodedDescriptorDatabase::AddCopy(
   return Add(copy, size);
 }
 
+void EncodedDescriptorDatabase::AddUnindexed(
+    const void* encoded_file_descriptor, int size) {
+  MutexLock lock(&unindexed_mutex_);
+  unindexed_.push_back(make_pair(encoded_file_descriptor, size));
+}
+
 bool EncodedDescriptorDatabase::FindFileByName(
     const string& filename,
     FileDescriptorProto* output) {
-  return MaybeParse(index_.FindFile(filename), output);
+  pair<const void*, int> encoded_file = index_.FindFile(filename);
+  if (encoded_file.first == NULL) {
+    return FindUnindexedFile(filename, output);
+  }
+  return MaybeParse(encoded_file, output);
 }
 
 bool EncodedDescriptorDatabase::FindFileContainingSymbol(
     const string& symbol_name,
     FileDescriptorProto* output) {
+  IndexAll();
   return MaybeParse(index_.FindSymbol(symbol_name), output);
 }
 
 bool EncodedDescriptorDatabase::FindNameOfFileContainingSymbol(
     const string& symbol_name,
     string* output) {
+  IndexAll();
   pair<const void*, int> encoded_file = index_.FindSymbol(symbol_name);
   if (encoded_file.first == NULL) return false;
-
-  // Optimization:  The name should be the first field in the encoded message.
-  //   Try to just read it directly.
-  io::CodedInputStream input(reinterpret_cast<const uint8*>(encoded_file.first),
-                             encoded_file.second);
-
-  const uint32 kNameTag = internal::WireFormatLite::MakeTag(
-      FileDescriptorProto::kNameFieldNumber,
-      internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
-
-  if (input.ReadTag() == kNameTag) {
-    // Success!
-    return internal::WireFormatLite::ReadString(&input, output);
-  } else {
-    // Slow path.  Parse whole message.
-    FileDescriptorProto file_proto;
-    if (!file_proto.ParseFromArray(encoded_file.first, encoded_file.second)) {
-      return false;
-    }
-    *output = file_proto.name();
-    return true;
-  }
+  return ReadEncodedFileName(encoded_file, output);
 }
 
 bool EncodedDescriptorDatabase::FindFileContainingExtension(
     const string& containing_type,
     int field_number,
     FileDescriptorProto* output) {
+  IndexAll();
   return MaybeParse(index_.FindExtension(containing_type, field_number),
                     output);
 }
@@ -378,6 +400,7 @@ bool EncodedDescriptorDatabase::FindFileContainingExtension(
 bool EncodedDescriptorDatabase::FindAllExtensionNumbers(
     const string& extendee_type,
     vector<int>* output) {
+  IndexAll();
   return index_.FindAllExtensionNumbers(extendee_type, output);
 }
 
@@ -388,6 +411,73 @@ bool EncodedDescriptorDatabase::MaybeParse(
   return output->ParseFromArray(encoded_file.first, encoded_file.second);
 }
 
+void EncodedDescriptorDatabase::ReadUnindexedNames() {
+  vector<pair<const void*, int> > files;
+  {
+    MutexLock lock(&unindexed_mutex_);
+    files.swap(unindexed_);
+  }
+
+  for (int i = 0; i < files.size(); i++) {
+    string name;
+    if (!ReadEncodedFileName(files[i], &name)) {
+      GOOGLE_LOG(DFATAL) << "Invalid file descriptor data passed to "
+                     "EncodedDescriptorDatabase::AddUnindexed().";
+    } else if (!InsertIfNotPresent(&unindexed_by_name_, name, files[i])) {
+      GOOGLE_LOG(DFATAL) << "File already exists in database: " << name;
+    }
+  }
+}
+
+bool EncodedDescriptorDatabase::FindUnindexedFile(
+    const string& filename,
+    FileDescriptorProto* output) {
+  ReadUnindexedNames();
+
+  map<string, pair<const void*, int> >::iterator iter =
+      unindexed_by_name_.find(filename);
+  if (iter == unindexed_by_name_.end()) return false;
+  pair<const void*, int> encoded_file = iter->second;
+
+  if (!MaybeParse(encoded_file, output)) {
+    GOOGLE_LOG(DFATAL) << "Invalid file descriptor data passed to "
+                   "EncodedDescriptorDatabase::AddUnindexed().";
+    return false;
+  }
+  // We had to parse the file anyway, so index it now rather than parsing it
+  // again in IndexAll().  AddFile() records the file's name before its
+  // symbols, so even if one of them conflicts with another file, later
+  // lookups of this file find it in index_.
+  if (!index_.AddFile(*output, encoded_file)) {
+    GOOGLE_LOG(DFATAL) << "Conflicting file descriptor data passed to "
+                   "EncodedDescriptorDatabase::AddUnindexed(): " << filename;
+  }
+  unindexed_by_name_.erase(iter);
+  return true;
+}
+
+void EncodedDescriptorDatabase::IndexAll() {
+  ReadUnindexedNames();
+  if (unindexed_by_name_.empty()) return;
+
+  FileDescriptorProto file;
+  for (map<string, pair<const void*, int> >::iterator iter =
+           unindexed_by_name_.begin();
+       iter != unindexed_by_name_.end(); ++iter) {
+    if (!MaybeParse(iter->second, &file)) {
+      GOOGLE_LOG(DFATAL) << "Invalid file descriptor data passed to "
+                     "EncodedDescriptorDatabase::AddUnindexed().";
+      continue;
+    }
+    if (!index_.AddFile(file, iter->second)) {
+      GOOGLE_LOG(DFATAL) << "Conflicting file descriptor data passed to "
+                     "EncodedDescriptorDatabase::AddUnindexed(): "
+                         << iter->first;
+    }
+  }
+  unindexed_by_name_.clear();
+}
+
 // ===================================================================
 
 DescriptorPoolDatabase::DescriptorPoolDatabase(const DescriptorPool& pool)
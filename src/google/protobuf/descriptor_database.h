@@ -282,6 +282,15 @@ class LIBPROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   // need to keep it around.
   bool AddCopy(const void* encoded_file_descriptor, int size);
 
+  // Like Add(), but does not look at the bytes at all until a lookup needs
+  // them.  FindFileByName() only parses the file it returns; the other Find*
+  // methods index every file added this way the first time they are called.
+  // Since nothing is parsed here, invalid or conflicting files are reported
+  // by that later lookup instead of to the caller: they are fatal in debug
+  // builds, and are logged as errors otherwise.  May be called from any
+  // thread, even while another thread is doing lookups.
+  void AddUnindexed(const void* encoded_file_descriptor, int size);
+
   // Like FindFileContainingSymbol but returns only the name of the file.
   bool FindNameOfFileContainingSymbol(const string& symbol_name,
                                       string* output);
@@ -301,11 +310,29 @@ class LIBPROTOBUF_EXPORT EncodedDescriptorDatabase : public DescriptorDatabase {
   SimpleDescriptorDatabase::DescriptorIndex<pair<const void*, int> > index_;
   vector<void*> files_to_delete_;
 
+  // Files passed to AddUnindexed() that no lookup has looked at yet.
+  Mutex unindexed_mutex_;
+  vector<pair<const void*, int> > unindexed_;  // Guarded by unindexed_mutex_.
+
+  // Files passed to AddUnindexed() whose names have been read, but which are
+  // not in index_ yet.
+  map<string, pair<const void*, int> > unindexed_by_name_;
+
   // If encoded_file.first is non-NULL, parse the data into *output and return
   // true, otherwise return false.
   bool MaybeParse(pair<const void*, int> encoded_file,
                   FileDescriptorProto* output);
 
+  // Moves the files in unindexed_ into unindexed_by_name_.
+  void ReadUnindexedNames();
+
+  // Looks for a file added by AddUnindexed().  If found, parses it into
+  // *output and moves it into index_.  An invalid file is left where it is.
+  bool FindUnindexedFile(const string& filename, FileDescriptorProto* output);
+
+  // Parses and indexes all files added by AddUnindexed() so far.
+  void IndexAll();
+
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(EncodedDescriptorDatabase);
 };
 
@@ -514,6 +514,138 @@ TEST(EncodedDescriptorDatabaseExtraTest, FindNameOfFileContainingSymbol) {
   EXPECT_FALSE(db.FindNameOfFileContainingSymbol("baz.Baz", &filename));
 }
 
+TEST(EncodedDescriptorDatabaseExtraTest, AddUnindexed) {
+  FileDescriptorProto file1, file2a, file2b;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "name: \"foo.proto\" "
+    "package: \"foo\" "
+    "message_type { "
+    "  name: \"Foo\" "
+    "  extension_range { start: 1 end: 100 } "
+    "}", &file1));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "name: \"bar.proto\" "
+    "dependency: \"foo.proto\"", &file2a));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "package: \"bar\" "
+    "message_type { name: \"Bar\" } "
+    "extension { name: \"qux\" extendee: \".foo.Foo\" number: 5 "
+    "            label: LABEL_OPTIONAL type: TYPE_INT32 }", &file2b));
+
+  // Force out-of-order serialization for bar.proto, so that reading its name
+  // has to parse the whole file.
+  string data1 = file1.SerializeAsString();
+  string data2 = file2b.SerializeAsString() + file2a.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  db.AddUnindexed(data1.data(), data1.size());
+  db.AddUnindexed(data2.data(), data2.size());
+
+  {
+    FileDescriptorProto file;
+    EXPECT_TRUE(db.FindFileByName("bar.proto", &file));
+    EXPECT_EQ("bar.proto", file.name());
+    ExpectContainsType(file, "Bar");
+    EXPECT_FALSE(db.FindFileByName("baz.proto", &file));
+  }
+
+  {
+    // foo.proto has not been looked at yet, but symbol lookups still find it.
+    FileDescriptorProto file;
+    EXPECT_TRUE(db.FindFileContainingSymbol("foo.Foo", &file));
+    EXPECT_EQ("foo.proto", file.name());
+    EXPECT_TRUE(db.FindFileContainingExtension("foo.Foo", 5, &file));
+    EXPECT_EQ("bar.proto", file.name());
+  }
+
+  {
+    vector<int> numbers;
+    EXPECT_TRUE(db.FindAllExtensionNumbers("foo.Foo", &numbers));
+    ASSERT_EQ(1, numbers.size());
+    EXPECT_EQ(5, numbers[0]);
+  }
+
+  {
+    FileDescriptorProto file;
+    EXPECT_TRUE(db.FindFileByName("foo.proto", &file));
+    EXPECT_EQ("foo.proto", file.name());
+  }
+}
+
+#ifdef PROTOBUF_HAS_DEATH_TEST
+TEST(EncodedDescriptorDatabaseExtraTest, AddUnindexedInvalidFile) {
+  // The name can be read, but the rest does not parse.
+  string data("\x0a\x09" "foo.proto" "\x00", 12);
+  EncodedDescriptorDatabase db;
+  db.AddUnindexed(data.data(), data.size());
+
+  // Fatal in debug builds, only logged otherwise.
+  FileDescriptorProto file;
+  EXPECT_DEBUG_DEATH(EXPECT_FALSE(db.FindFileByName("foo.proto", &file)),
+                     "Invalid file descriptor data");
+}
+
+TEST(EncodedDescriptorDatabaseExtraTest, AddUnindexedConflictingFiles) {
+  FileDescriptorProto file1, file2;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "name: \"foo.proto\" "
+    "package: \"foo\" "
+    "message_type { name: \"Foo\" }", &file1));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "name: \"bar.proto\" "
+    "package: \"foo\" "
+    "message_type { name: \"Foo\" }", &file2));
+  string data1 = file1.SerializeAsString();
+  string data2 = file2.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  db.AddUnindexed(data1.data(), data1.size());
+  db.AddUnindexed(data2.data(), data2.size());
+
+  FileDescriptorProto file;
+  EXPECT_DEBUG_DEATH(db.FindFileContainingSymbol("foo.Foo", &file),
+                     "Conflicting file descriptor data");
+}
+#endif  // PROTOBUF_HAS_DEATH_TEST
+
+TEST(EncodedDescriptorDatabaseExtraTest, AddUnindexedBuildsOnlyWhatIsUsed) {
+  FileDescriptorProto file1, file2, file3;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "name: \"foo.proto\" "
+    "message_type { name: \"Foo\" }", &file1));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "name: \"bar.proto\" "
+    "dependency: \"foo.proto\" "
+    "message_type { "
+    "  name: \"Bar\" "
+    "  field { name: \"foo\" number: 1 label: LABEL_OPTIONAL "
+    "          type_name: \".Foo\" } "
+    "}", &file2));
+  ASSERT_TRUE(TextFormat::ParseFromString(
+    "name: \"baz.proto\" "
+    "message_type { name: \"Baz\" }", &file3));
+
+  string data1 = file1.SerializeAsString();
+  string data2 = file2.SerializeAsString();
+  string data3 = file3.SerializeAsString();
+
+  EncodedDescriptorDatabase db;
+  db.AddUnindexed(data1.data(), data1.size());
+  db.AddUnindexed(data2.data(), data2.size());
+  db.AddUnindexed(data3.data(), data3.size());
+
+  // Building bar.proto pulls in its dependency, but not unrelated files.
+  DescriptorPool pool(&db);
+  const FileDescriptor* bar = pool.FindFileByName("bar.proto");
+  ASSERT_TRUE(bar != NULL);
+  EXPECT_EQ("Foo", bar->message_type(0)->field(0)->message_type()->name());
+  EXPECT_TRUE(pool.InternalIsFileLoaded("foo.proto"));
+  EXPECT_FALSE(pool.InternalIsFileLoaded("baz.proto"));
+
+  EXPECT_TRUE(pool.FindMessageTypeByName("Baz") != NULL);
+  EXPECT_TRUE(pool.InternalIsFileLoaded("baz.proto"));
+}
+
 // ===================================================================
 
 class MergedDescriptorDatabaseTest : public testing::Test {
@@ -4716,6 +4716,87 @@ TEST_F(ValidationErrorTest, RollbackAfterError) {
     "}");
 }
 
+TEST_F(ValidationErrorTest, RollbackManyTimes) {
+  // Rolled-back symbols are left in the symbol table, marked as erased,
+  // until it grows.  Make sure that enough of them to make it grow neither
+  // hide nor block the symbols which are built afterwards.
+  FileDescriptorProto file_proto;
+  file_proto.set_name("foo.proto");
+  for (int i = 0; i < 50; i++) {
+    file_proto.add_message_type()->set_name("Message" + SimpleItoa(i));
+  }
+  FieldDescriptorProto* field =
+      file_proto.mutable_message_type(0)->add_field();
+  field->set_name("foo");
+  field->set_number(1);
+  field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+  field->set_type_name("NoSuchType");  // error
+
+  for (int i = 0; i < 20; i++) {
+    MockErrorCollector error_collector;
+    EXPECT_TRUE(
+      pool_.BuildFileCollectingErrors(file_proto, &error_collector) == NULL);
+    EXPECT_TRUE(pool_.FindMessageTypeByName("Message1") == NULL);
+  }
+
+  field->set_type_name("Message1");
+  const FileDescriptor* file = pool_.BuildFile(file_proto);
+  ASSERT_TRUE(file != NULL);
+  for (int i = 0; i < 50; i++) {
+    EXPECT_EQ(file->message_type(i),
+              pool_.FindMessageTypeByName("Message" + SimpleItoa(i)));
+  }
+  EXPECT_EQ(file, pool_.FindFileByName("foo.proto"));
+}
+
+TEST_F(ValidationErrorTest, SharesEqualNames) {
+  // Names, and other strings which many descriptors have in common, are
+  // stored once per pool, even across files and failed builds.
+  BuildFileWithErrors(
+    "name: \"foo.proto\" "
+    "package: \"pkg\" "
+    "message_type {"
+    "  name: \"Foo\""
+    "  field { name:\"id\" label:LABEL_OPTIONAL type_name:\"NoSuchType\""
+    "          number:1 }"
+    "}",
+
+    "foo.proto: pkg.Foo.id: TYPE: \"NoSuchType\" is not defined.\n");
+  BuildFile(
+    "name: \"foo.proto\" "
+    "package: \"pkg\" "
+    "message_type {"
+    "  name: \"Foo\""
+    "  field { name:\"id\" label:LABEL_OPTIONAL type:TYPE_STRING number:1"
+    "          default_value:\"x\" }"
+    "  field { name:\"foo_bar\" label:LABEL_OPTIONAL type:TYPE_INT32"
+    "          number:2 }"
+    "}");
+  BuildFile(
+    "name: \"bar.proto\" "
+    "package: \"pkg\" "
+    "message_type {"
+    "  name: \"Bar\""
+    "  field { name:\"id\" label:LABEL_OPTIONAL type:TYPE_STRING number:1"
+    "          default_value:\"x\" }"
+    "  field { name:\"fooBar\" label:LABEL_OPTIONAL type:TYPE_INT32"
+    "          number:2 }"
+    "}");
+
+  const Descriptor* foo = pool_.FindMessageTypeByName("pkg.Foo");
+  const Descriptor* bar = pool_.FindMessageTypeByName("pkg.Bar");
+  ASSERT_TRUE(foo != NULL);
+  ASSERT_TRUE(bar != NULL);
+  EXPECT_EQ(&foo->file()->package(), &bar->file()->package());
+  EXPECT_EQ(&foo->field(0)->name(), &bar->field(0)->name());
+  EXPECT_EQ(&foo->field(0)->default_value_string(),
+            &bar->field(0)->default_value_string());
+  EXPECT_EQ("fooBar", foo->field(1)->camelcase_name());
+  EXPECT_EQ(&foo->field(1)->camelcase_name(), &bar->field(1)->name());
+  EXPECT_EQ("pkg.Foo.id", foo->field(0)->full_name());
+  EXPECT_EQ("pkg.Bar.id", bar->field(0)->full_name());
+}
+
 TEST_F(ValidationErrorTest, ErrorsReportedToLogError) {
   // Test that errors are reported to GOOGLE_LOG(ERROR) if no error collector is
   // provided.
@@ -5733,6 +5814,42 @@ TEST_F(DatabaseBackedPoolTest, DoesntRetryDbUnnecessarily) {
   EXPECT_EQ(0, call_counter.call_count_);
 }
 
+TEST_F(DatabaseBackedPoolTest, FindsBuiltSymbolsWithoutDatabase) {
+  // Once a file has been built, looking up its symbols, or the file itself,
+  // must not consult the database.  unittest.proto has enough symbols to
+  // make the tables of committed symbols grow a few times.
+  const FileDescriptor* original_file =
+    protobuf_unittest::TestAllTypes::descriptor()->file();
+  DescriptorPoolDatabase database(*DescriptorPool::generated_pool());
+  CallCountingDatabase call_counter(&database);
+  DescriptorPool pool(&call_counter);
+
+  const FileDescriptor* file = pool.FindFileByName(original_file->name());
+  ASSERT_TRUE(file != NULL);
+  EXPECT_NE(0, call_counter.call_count_);
+  call_counter.Clear();
+
+  EXPECT_EQ(file, pool.FindFileByName(original_file->name()));
+  EXPECT_EQ(file->dependency(0),
+            pool.FindFileByName(original_file->dependency(0)->name()));
+  for (int i = 0; i < file->message_type_count(); i++) {
+    const Descriptor* message = file->message_type(i);
+    EXPECT_EQ(message, pool.FindMessageTypeByName(message->full_name()));
+    EXPECT_EQ(file, pool.FindFileContainingSymbol(message->full_name()));
+    for (int j = 0; j < message->field_count(); j++) {
+      const FieldDescriptor* field = message->field(j);
+      EXPECT_EQ(field, pool.FindFieldByName(field->full_name()));
+    }
+  }
+  for (int i = 0; i < file->extension_count(); i++) {
+    const FieldDescriptor* extension = file->extension(i);
+    EXPECT_EQ(extension, pool.FindExtensionByName(extension->full_name()));
+    EXPECT_TRUE(pool.FindFieldByName(extension->full_name()) == NULL);
+  }
+
+  EXPECT_EQ(0, call_counter.call_count_);
+}
+
 TEST_F(DatabaseBackedPoolTest, DoesntReloadFilesUncesessarily) {
   // If FindFileContainingSymbol() or FindFileContainingExtension() return a
   // file that is already in the DescriptorPool, it should not attempt to
@@ -6062,6 +6179,42 @@ TEST_F(SourceLocationTest, GetSourceLocation_BogusSourceCodeInfo) {
   EXPECT_FALSE(bad2_a_desc->GetSourceLocation(&loc));
 }
 
+TEST_F(SourceLocationTest, GetSourceLocation_DiscardedBuildOnlyData) {
+  SourceLocation loc;
+
+  const FileDescriptor *file_desc =
+      GOOGLE_CHECK_NOTNULL(pool_.FindFileByName("/test/test.proto"));
+
+  FileDescriptorProto proto;
+  file_desc->CopyTo(&proto);
+  file_desc->CopySourceCodeInfoTo(&proto);
+  EXPECT_TRUE(proto.has_source_code_info());
+  proto.mutable_options()->set_java_package("com.example.test");
+  proto.mutable_options()->set_cc_generic_services(true);
+  proto.mutable_options()->set_cc_enable_arenas(true);
+
+  DescriptorPool discarding_pool(&pool_);
+  discarding_pool.DiscardBuildOnlyData(true);
+  const FileDescriptor* discarding_file_desc =
+      GOOGLE_CHECK_NOTNULL(discarding_pool.BuildFile(proto));
+  const Descriptor *discarding_a_desc =
+      discarding_file_desc->FindMessageTypeByName("A");
+  EXPECT_FALSE(discarding_a_desc->GetSourceLocation(&loc));
+
+  FileDescriptorProto copy;
+  discarding_file_desc->CopySourceCodeInfoTo(&copy);
+  EXPECT_FALSE(copy.has_source_code_info());
+
+  // Options which only code generators use are dropped; the rest are kept.
+  EXPECT_FALSE(discarding_file_desc->options().has_java_package());
+  EXPECT_FALSE(discarding_file_desc->options().cc_generic_services());
+  EXPECT_TRUE(discarding_file_desc->options().cc_enable_arenas());
+
+  // Building the same file again still finds the existing one.
+  proto.clear_source_code_info();
+  EXPECT_EQ(discarding_file_desc, discarding_pool.BuildFile(proto));
+}
+
 // ===================================================================
 
 const char* const kCopySourceCodeInfoToTestInput =
@@ -53,6 +53,29 @@
 // each type it sees (each unique Descriptor pointer).  The code
 // refers to the "default" copy of the class as the "prototype".
 //
+// Parsing, serialization and ByteSize() are the exception: going through
+// Reflection costs a field lookup and several virtual calls per value.
+// Instead, DynamicMessageFactory also describes each type's layout with a
+// MessageTable, the same structure that generated code uses with the
+// "table_driven_parsing" and "table_driven_serialization" options, and
+// DynamicMessage hands it to TableDrivenMessage.  Only the fields the table
+// cannot describe (oneof members and maps), extensions and unknown fields go
+// through WireFormat.
+//
+// Generated messages built with optimize_for = CODE_SIZE still parse and
+// serialize through WireFormat, walking the descriptor field by field.  The
+// generator options above do not help them, since they only apply to files
+// whose messages have generated methods, and WireFormat does not build a
+// MessageTable for GeneratedMessageReflection-backed types.  Doing so is left
+// for later.
+//
+// The memory following the DynamicMessage object holds its fields and
+// bookkeeping (has-bits, oneof cases, etc.) in decreasing order of
+// alignment, so that no padding is needed between them.  A DynamicMessage
+// created by New(Arena*) is allocated on the arena, and so are the strings,
+// repeated fields and sub-messages it allocates, except in types with map
+// fields, which are not arena-aware.
+//
 // Note on memory allocation:  This module often calls "operator new()"
 // to allocate untyped memory, rather than calling something like
 // "new uint8[]".  This is because "operator new()" means "Give me some
@@ -63,9 +86,12 @@
 // I don't have the book on me right now so I'm not sure.
 
 #include <algorithm>
+#include <vector>
 #include <google/protobuf/stubs/hash.h>
 
+#include <google/protobuf/stubs/atomicops.h>
 #include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/stl_util.h>
 
 #include <google/protobuf/dynamic_message.h>
 #include <google/protobuf/descriptor.h>
@@ -206,6 +232,51 @@ inline int AlignOffset(int offset) {
 
 #define bitsizeof(T) (sizeof(T) * 8)
 
+// One part of a DynamicMessage's memory: a field, the has-bits, etc.
+struct LayoutItem {
+  int alignment;
+  int size;
+  int* offset;  // Where to store the part's offset once it is decided.
+};
+
+inline void AddLayoutItem(int alignment, int size, int* offset,
+                          vector<LayoutItem>* items) {
+  LayoutItem item = { alignment, size, offset };
+  items->push_back(item);
+}
+
+struct AlignmentGreater {
+  bool operator()(const LayoutItem& a, const LayoutItem& b) const {
+    return a.alignment > b.alignment;
+  }
+};
+
+// Places the items one after the other starting at the given offset (which
+// must be aligned for any type) and returns the offset following the last.
+// The items are placed in decreasing order of alignment, so that no padding
+// is needed between them; items with the same alignment keep their order,
+// which for fields is the order of declaration.
+int LayOut(int offset, vector<LayoutItem>* items) {
+  stable_sort(items->begin(), items->end(), AlignmentGreater());
+  for (int i = 0; i < items->size(); i++) {
+    const LayoutItem& item = (*items)[i];
+    offset = AlignTo(offset, item.alignment);
+    *item.offset = offset;
+    offset += item.size;
+  }
+  return offset;
+}
+
+// Orders fields by number.
+struct FieldNumberLess {
+  bool operator()(const FieldDescriptor* a, const FieldDescriptor* b) const {
+    return a->number() < b->number();
+  }
+  bool operator()(const FieldDescriptor* field, int number) const {
+    return field->number() < number;
+  }
+};
+
 }  // namespace
 
 // ===================================================================
@@ -219,6 +290,11 @@ class DynamicMessage : public Message {
     int unknown_fields_offset;
     int extensions_offset;
     int is_default_instance_offset;
+    int arena_offset;
+
+    // False for types with map fields, which are not arena-aware.  New() on
+    // an arena then allocates on the heap and lets the arena own the message.
+    bool arena_constructable;
 
     // Not owned by the TypeInfo.
     DynamicMessageFactory* factory;  // The factory that created this object.
@@ -236,7 +312,22 @@ class DynamicMessage : public Message {
     const DynamicMessage* prototype;
     void* default_oneof_instance;
 
-    TypeInfo() : prototype(NULL), default_oneof_instance(NULL) {}
+    // Describes the type to TableDrivenMessage.  Not used for MessageSets
+    // and map entries, whose wire format WireFormat special-cases.
+    bool use_table;
+    internal::MessageTable table;
+    vector<internal::TableField> table_fields;
+    vector<int32> field_by_has_bit;
+    vector<int32> always_visit;
+    // The valid values of the closed enum fields in |table_fields|; see
+    // TableField::kEnumValueList.
+    vector<int> enum_values;
+    // The fields which are not in |table_fields|, sorted by number.
+    vector<const FieldDescriptor*> unusual_fields;
+
+    TypeInfo()
+        : arena_constructable(false), prototype(NULL),
+          default_oneof_instance(NULL), use_table(false), table() {}
 
     ~TypeInfo() {
       delete prototype;
@@ -254,18 +345,56 @@ class DynamicMessage : public Message {
 
   Message* New() const;
   Message* New(::google::protobuf::Arena* arena) const;
-  ::google::protobuf::Arena* GetArena() const { return NULL; };
+  ::google::protobuf::Arena* GetArena() const {
+    return *reinterpret_cast< ::google::protobuf::Arena* const*>(
+        OffsetToPointer(type_info_->arena_offset));
+  }
 
   int GetCachedSize() const;
   void SetCachedSize(int size) const;
 
   Metadata GetMetadata() const;
 
+  bool MergePartialFromCodedStream(io::CodedInputStream* input);
+  void SerializeWithCachedSizes(io::CodedOutputStream* output) const;
+  uint8* SerializeWithCachedSizesToArray(uint8* target) const;
+  int ByteSize() const;
+
+  // Fills in type_info->table.  Called once the prototype has been
+  // cross-linked.  cached_size_offsets gives, for each packed field, the
+  // offset of the int which caches the size of its data.
+  static void InitMessageTable(TypeInfo* type_info,
+                               const vector<int>& cached_size_offsets);
 
  private:
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(DynamicMessage);
   DynamicMessage(const TypeInfo* type_info, ::google::protobuf::Arena* arena);
-  void SharedCtor();
+  void SharedCtor(::google::protobuf::Arena* arena);
+
+  // MessageTable functions handling everything which is not in the table.
+  static bool MergeUnusualField(MessageLite* message, uint32 tag,
+                                io::CodedInputStream* input);
+  static void SerializeUnusualFields(const MessageLite* message, int end,
+                                     io::CodedOutputStream* output);
+  static uint8* SerializeUnusualFieldsToArray(const MessageLite* message,
+                                              int end, uint8* target);
+  static int UnusualFieldsByteSize(const MessageLite* message);
+
+  // Returns the range of unusual_fields which SerializeUnusualFields() writes
+  // for |end|, and the number of the table field preceding them, or 0.
+  void FindUnusualFields(int end, int* start_number, int* begin,
+                         int* limit) const;
+
+  inline const ExtensionSet* extensions() const {
+    return type_info_->extensions_offset == -1 ? NULL :
+        reinterpret_cast<const ExtensionSet*>(
+            OffsetToPointer(type_info_->extensions_offset));
+  }
+  // Goes through the reflection, which drops the unknown fields of proto3
+  // messages.
+  inline const UnknownFieldSet& unknown_fields() const {
+    return type_info_->reflection->GetUnknownFields(*this);
+  }
 
   inline bool is_prototype() const {
     return type_info_->prototype == this ||
@@ -289,17 +418,17 @@ class DynamicMessage : public Message {
 DynamicMessage::DynamicMessage(const TypeInfo* type_info)
   : type_info_(type_info),
     cached_byte_size_(0) {
-  SharedCtor();
+  SharedCtor(NULL);
 }
 
 DynamicMessage::DynamicMessage(const TypeInfo* type_info,
                                ::google::protobuf::Arena* arena)
   : type_info_(type_info),
     cached_byte_size_(0) {
-  SharedCtor();
+  SharedCtor(arena);
 }
 
-void DynamicMessage::SharedCtor() {
+void DynamicMessage::SharedCtor(::google::protobuf::Arena* arena) {
   // We need to call constructors for various fields manually and set
   // default values where appropriate.  We use placement new to call
   // constructors.  If you haven't heard of placement new, I suggest Googling
@@ -311,6 +440,9 @@ void DynamicMessage::SharedCtor() {
 
   const Descriptor* descriptor = type_info_->type;
 
+  new(OffsetToPointer(type_info_->arena_offset))
+      ::google::protobuf::Arena*(arena);
+
   // Initialize oneof cases.
   for (int i = 0 ; i < descriptor->oneof_decl_count(); ++i) {
     new(OffsetToPointer(type_info_->oneof_case_offset + sizeof(uint32) * i))
@@ -325,7 +457,7 @@ void DynamicMessage::SharedCtor() {
   new(OffsetToPointer(type_info_->unknown_fields_offset)) UnknownFieldSet;
 
   if (type_info_->extensions_offset != -1) {
-    new(OffsetToPointer(type_info_->extensions_offset)) ExtensionSet;
+    new(OffsetToPointer(type_info_->extensions_offset)) ExtensionSet(arena);
   }
 
   for (int i = 0; i < descriptor->field_count(); i++) {
@@ -340,7 +472,7 @@ void DynamicMessage::SharedCtor() {
         if (!field->is_repeated()) {                                         \
           new(field_ptr) TYPE(field->default_value_##TYPE());                \
         } else {                                                             \
-          new(field_ptr) RepeatedField<TYPE>();                              \
+          new(field_ptr) RepeatedField<TYPE>(arena);                         \
         }                                                                    \
         break;
 
@@ -357,7 +489,7 @@ void DynamicMessage::SharedCtor() {
         if (!field->is_repeated()) {
           new(field_ptr) int(field->default_value_enum()->number());
         } else {
-          new(field_ptr) RepeatedField<int>();
+          new(field_ptr) RepeatedField<int>(arena);
         }
         break;
 
@@ -378,7 +510,7 @@ void DynamicMessage::SharedCtor() {
               ArenaStringPtr* asp = new(field_ptr) ArenaStringPtr();
               asp->UnsafeSetDefault(default_value);
             } else {
-              new(field_ptr) RepeatedPtrField<string>();
+              new(field_ptr) RepeatedPtrField<string>(arena);
             }
             break;
         }
@@ -391,7 +523,7 @@ void DynamicMessage::SharedCtor() {
           if (IsMapFieldInApi(field)) {
             new (field_ptr) MapFieldBase();
           } else {
-            new (field_ptr) RepeatedPtrField<Message>();
+            new (field_ptr) RepeatedPtrField<Message>(arena);
           }
         }
         break;
@@ -402,11 +534,15 @@ void DynamicMessage::SharedCtor() {
 
 DynamicMessage::~DynamicMessage() {
   const Descriptor* descriptor = type_info_->type;
+  // Strings and sub-messages allocated on the arena are freed with it.
+  ::google::protobuf::Arena* arena = GetArena();
 
   reinterpret_cast<UnknownFieldSet*>(
     OffsetToPointer(type_info_->unknown_fields_offset))->~UnknownFieldSet();
 
-  if (type_info_->extensions_offset != -1) {
+  // An ExtensionSet constructed on an arena registers its own destructor
+  // with that arena.
+  if (type_info_->extensions_offset != -1 && arena == NULL) {
     reinterpret_cast<ExtensionSet*>(
       OffsetToPointer(type_info_->extensions_offset))->~ExtensionSet();
   }
@@ -438,12 +574,14 @@ DynamicMessage::~DynamicMessage() {
                       type_info_->prototype->OffsetToPointer(
                           type_info_->offsets[i]))->Get(NULL));
               reinterpret_cast<ArenaStringPtr*>(field_ptr)->Destroy(default_value,
-                                                                    NULL);
+                                                                    arena);
               break;
             }
           }
         } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+          if (arena == NULL) {
             delete *reinterpret_cast<Message**>(field_ptr);
+          }
         }
       }
       continue;
@@ -497,12 +635,12 @@ DynamicMessage::~DynamicMessage() {
                   type_info_->prototype->OffsetToPointer(
                       type_info_->offsets[i]))->Get(NULL));
           reinterpret_cast<ArenaStringPtr*>(field_ptr)->Destroy(default_value,
-                                                                NULL);
+                                                                arena);
           break;
         }
       }
     } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
-      if (!is_prototype()) {
+      if (!is_prototype() && arena == NULL) {
         Message* message = *reinterpret_cast<Message**>(field_ptr);
         if (message != NULL) {
           delete message;
@@ -555,13 +693,21 @@ Message* DynamicMessage::New() const {
 }
 
 Message* DynamicMessage::New(::google::protobuf::Arena* arena) const {
-  if (arena != NULL) {
+  if (arena == NULL) {
+    return New();
+  } else if (!type_info_->arena_constructable) {
     Message* message = New();
     arena->Own(message);
     return message;
-  } else {
-    return New();
   }
+  void* new_base = ::google::protobuf::Arena::CreateArray<uint8>(
+      arena, type_info_->size);
+  memset(new_base, 0, type_info_->size);
+  DynamicMessage* message = new(new_base) DynamicMessage(type_info_, arena);
+  // The unknown fields are not on the arena, so the destructor still has
+  // to run.
+  arena->OwnDestructor(message);
+  return message;
 }
 
 int DynamicMessage::GetCachedSize() const {
@@ -584,11 +730,377 @@ Metadata DynamicMessage::GetMetadata() const {
   return metadata;
 }
 
+bool DynamicMessage::MergePartialFromCodedStream(io::CodedInputStream* input) {
+  if (!type_info_->use_table) {
+    return Message::MergePartialFromCodedStream(input);
+  }
+  return internal::TableDrivenMessage::MergePartialFromCodedStream(
+      this, type_info_->table, input);
+}
+
+void DynamicMessage::SerializeWithCachedSizes(
+    io::CodedOutputStream* output) const {
+  if (!type_info_->use_table) {
+    Message::SerializeWithCachedSizes(output);
+    return;
+  }
+  internal::TableDrivenMessage::SerializeWithCachedSizes(
+      *this, type_info_->table, output);
+}
+
+uint8* DynamicMessage::SerializeWithCachedSizesToArray(uint8* target) const {
+  // WireFormat can only write oneof members and maps to a stream, so types
+  // which have them are serialized through one.
+  if (!type_info_->use_table ||
+      type_info_->table.serialize_unusual_to_array == NULL) {
+    return Message::SerializeWithCachedSizesToArray(target);
+  }
+  return internal::TableDrivenMessage::SerializeWithCachedSizesToArray(
+      *this, type_info_->table, target);
+}
+
+int DynamicMessage::ByteSize() const {
+  if (!type_info_->use_table) {
+    return Message::ByteSize();
+  }
+  int size = internal::TableDrivenMessage::ByteSize(*this, type_info_->table);
+  SetCachedSize(size);
+  return size;
+}
+
+void DynamicMessage::InitMessageTable(TypeInfo* type_info,
+                                      const vector<int>& cached_size_offsets) {
+  typedef internal::TableField TableField;
+  const Descriptor* type = type_info->type;
+  if (type->options().message_set_wire_format() ||
+      type->options().map_entry()) {
+    return;
+  }
+  type_info->use_table = true;
+
+  // Oneof members and maps need reflection to be set.
+  vector<const FieldDescriptor*> fields;
+  vector<int> unusual_numbers;
+  for (int i = 0; i < type->field_count(); i++) {
+    const FieldDescriptor* field = type->field(i);
+    if (field->containing_oneof() != NULL || field->is_map()) {
+      type_info->unusual_fields.push_back(field);
+      unusual_numbers.push_back(field->number());
+    } else {
+      fields.push_back(field);
+    }
+  }
+  for (int i = 0; i < type->extension_range_count(); i++) {
+    unusual_numbers.push_back(type->extension_range(i)->start);
+  }
+  sort(fields.begin(), fields.end(), FieldNumberLess());
+  sort(type_info->unusual_fields.begin(), type_info->unusual_fields.end(),
+       FieldNumberLess());
+  sort(unusual_numbers.begin(), unusual_numbers.end());
+
+  const bool has_field_presence = type_info->has_bits_offset != -1;
+  if (has_field_presence) {
+    type_info->field_by_has_bit.assign(type->field_count(), -1);
+  }
+  // Indices into enum_values, which may be reallocated until all the fields
+  // have been seen.
+  vector<int> enum_value_lists(fields.size(), -1);
+
+  type_info->table_fields.resize(fields.size());
+  for (int i = 0; i < fields.size(); i++) {
+    const FieldDescriptor* field = fields[i];
+    int flags = 0;
+    if (field->is_repeated()) {
+      flags |= TableField::kRepeated;
+      if (field->options().packed()) flags |= TableField::kPacked;
+    }
+    int previous_number = i > 0 ? fields[i - 1]->number() : 0;
+    vector<int>::const_iterator unusual = upper_bound(
+        unusual_numbers.begin(), unusual_numbers.end(), previous_number);
+    if (unusual != unusual_numbers.end() && *unusual < field->number()) {
+      flags |= TableField::kUnusualBefore;
+    }
+    const bool has_bit = has_field_presence && !field->is_repeated();
+
+    TableField* table_field = &type_info->table_fields[i];
+    table_field->Set(WireFormat::MakeTag(field), field->type(), flags,
+                     type_info->offsets[field->index()],
+                     has_bit ? field->index() : -1);
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        table_field->aux.message_default =
+            type_info->factory->GetPrototypeNoLock(field->message_type());
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        // Unknown values of proto3 enums are kept in the field.
+        if (type->file()->syntax() != FileDescriptor::SYNTAX_PROTO3) {
+          const EnumDescriptor* enum_type = field->enum_type();
+          vector<int> values;
+          for (int j = 0; j < enum_type->value_count(); j++) {
+            values.push_back(enum_type->value(j)->number());
+          }
+          sort(values.begin(), values.end());
+          values.erase(unique(values.begin(), values.end()), values.end());
+          enum_value_lists[i] = type_info->enum_values.size();
+          type_info->enum_values.push_back(values.size());
+          type_info->enum_values.insert(type_info->enum_values.end(),
+                                        values.begin(), values.end());
+          table_field->flags |= TableField::kEnumValueList;
+        }
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        if (!field->is_repeated()) {
+          table_field->aux.string_default = &field->default_value_string();
+        }
+#ifdef GOOGLE_PROTOBUF_UTF8_VALIDATION_ENABLED
+        if (field->type() == FieldDescriptor::TYPE_STRING) {
+          table_field->flags |= TableField::kVerifyUtf8;
+          table_field->full_name = field->full_name().c_str();
+        }
+#endif
+        break;
+      default:
+        break;
+    }
+    if (flags & TableField::kPacked) {
+      table_field->cached_size_offset = cached_size_offsets[field->index()];
+    }
+
+    if (field->is_repeated() || !has_field_presence) {
+      type_info->always_visit.push_back(i);
+    } else {
+      type_info->field_by_has_bit[field->index()] = i;
+    }
+  }
+  for (int i = 0; i < fields.size(); i++) {
+    if (enum_value_lists[i] != -1) {
+      type_info->table_fields[i].aux.enum_values =
+          &type_info->enum_values[enum_value_lists[i]];
+    }
+  }
+
+  internal::MessageTable* table = &type_info->table;
+  if (!fields.empty()) {
+    table->fields = &type_info->table_fields[0];
+    table->num_fields = fields.size();
+  }
+  table->has_bits_offset = type_info->has_bits_offset;
+  if (!type_info->field_by_has_bit.empty()) {
+    table->field_by_has_bit = &type_info->field_by_has_bit[0];
+    table->num_has_bits = type_info->field_by_has_bit.size();
+  }
+  if (!type_info->always_visit.empty()) {
+    table->always_visit = &type_info->always_visit[0];
+    table->num_always_visit = type_info->always_visit.size();
+  }
+  table->default_instance = type_info->prototype;
+  table->parse_unusual = &MergeUnusualField;
+  table->serialize_unusual = &SerializeUnusualFields;
+  if (type_info->unusual_fields.empty()) {
+    table->serialize_unusual_to_array = &SerializeUnusualFieldsToArray;
+  }
+  table->unusual_byte_size = &UnusualFieldsByteSize;
+#ifdef GOOGLE_PROTOBUF_UTF8_VALIDATION_ENABLED
+  table->verify_utf8 = &WireFormat::VerifyUTF8StringFromTable;
+#endif
+}
+
+bool DynamicMessage::MergeUnusualField(MessageLite* message, uint32 tag,
+                                       io::CodedInputStream* input) {
+  // As in WireFormat::ParseAndMergePartial(), except that MessageSets do not
+  // use the table.
+  DynamicMessage* dynamic = static_cast<DynamicMessage*>(message);
+  const Descriptor* descriptor = dynamic->type_info_->type;
+  const int number = internal::WireFormatLite::GetTagFieldNumber(tag);
+  const FieldDescriptor* field = descriptor->FindFieldByNumber(number);
+  if (field == NULL && descriptor->IsExtensionNumber(number)) {
+    if (input->GetExtensionPool() == NULL) {
+      field = dynamic->type_info_->reflection->FindKnownExtensionByNumber(
+          number);
+    } else {
+      field = input->GetExtensionPool()->FindExtensionByNumber(descriptor,
+                                                               number);
+    }
+  }
+  return WireFormat::ParseAndMergeField(tag, field, dynamic, input);
+}
+
+void DynamicMessage::FindUnusualFields(int end, int* start_number, int* begin,
+                                       int* limit) const {
+  const vector<internal::TableField>& table_fields = type_info_->table_fields;
+  int lo = 0;
+  int hi = table_fields.size();
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (internal::WireFormatLite::GetTagFieldNumber(table_fields[mid].tag) <
+        end) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *start_number = lo == 0 ? 0 :
+      internal::WireFormatLite::GetTagFieldNumber(table_fields[lo - 1].tag);
+
+  const vector<const FieldDescriptor*>& fields = type_info_->unusual_fields;
+  *begin = lower_bound(fields.begin(), fields.end(), *start_number,
+                       FieldNumberLess()) - fields.begin();
+  *limit = lower_bound(fields.begin() + *begin, fields.end(), end,
+                       FieldNumberLess()) - fields.begin();
+}
+
+void DynamicMessage::SerializeUnusualFields(const MessageLite* message,
+                                            int end,
+                                            io::CodedOutputStream* output) {
+  const DynamicMessage* dynamic = static_cast<const DynamicMessage*>(message);
+  const vector<const FieldDescriptor*>& fields =
+      dynamic->type_info_->unusual_fields;
+  const ExtensionSet* extensions = dynamic->extensions();
+  int next_number, begin, limit;
+  dynamic->FindUnusualFields(end, &next_number, &begin, &limit);
+
+  // Extensions are interleaved with the fields in number order.
+  for (int i = begin; i < limit; i++) {
+    if (extensions != NULL) {
+      extensions->SerializeWithCachedSizes(next_number, fields[i]->number(),
+                                           output);
+    }
+    WireFormat::SerializeFieldWithCachedSizes(fields[i], *dynamic, output);
+    next_number = fields[i]->number() + 1;
+  }
+  if (extensions != NULL) {
+    extensions->SerializeWithCachedSizes(next_number, end, output);
+  }
+  if (end == internal::TableDrivenMessage::kFieldNumberEnd) {
+    WireFormat::SerializeUnknownFields(dynamic->unknown_fields(), output);
+  }
+}
+
+uint8* DynamicMessage::SerializeUnusualFieldsToArray(const MessageLite* message,
+                                                     int end, uint8* target) {
+  // Only used by types whose fields are all in the table.
+  const DynamicMessage* dynamic = static_cast<const DynamicMessage*>(message);
+  const ExtensionSet* extensions = dynamic->extensions();
+  if (extensions != NULL) {
+    int start_number, begin, limit;
+    dynamic->FindUnusualFields(end, &start_number, &begin, &limit);
+    GOOGLE_DCHECK_EQ(begin, limit);
+    target = extensions->SerializeWithCachedSizesToArray(start_number, end,
+                                                         target);
+  }
+  if (end == internal::TableDrivenMessage::kFieldNumberEnd) {
+    target = WireFormat::SerializeUnknownFieldsToArray(
+        dynamic->unknown_fields(), target);
+  }
+  return target;
+}
+
+int DynamicMessage::UnusualFieldsByteSize(const MessageLite* message) {
+  const DynamicMessage* dynamic = static_cast<const DynamicMessage*>(message);
+  const Reflection* reflection = dynamic->type_info_->reflection.get();
+  const vector<const FieldDescriptor*>& fields =
+      dynamic->type_info_->unusual_fields;
+  int size = 0;
+  for (int i = 0; i < fields.size(); i++) {
+    // Oneof members are sized only if they are the one which is set.
+    if (fields[i]->is_repeated() ||
+        reflection->HasField(*dynamic, fields[i])) {
+      size += WireFormat::FieldByteSize(fields[i], *dynamic);
+    }
+  }
+  if (dynamic->extensions() != NULL) {
+    size += dynamic->extensions()->ByteSize();
+  }
+  size += WireFormat::ComputeUnknownFieldsSize(dynamic->unknown_fields());
+  return size;
+}
+
 // ===================================================================
 
 struct DynamicMessageFactory::PrototypeMap {
   typedef hash_map<const Descriptor*, const DynamicMessage::TypeInfo*> Map;
-  Map map_;
+  Map map_;  // Protected by prototypes_mutex_.
+
+  // The prototypes GetPrototype() has returned, in an open-addressed hash
+  // table which it reads without taking prototypes_mutex_.  Entries are
+  // only ever added, under the mutex: an entry's prototype is written
+  // before its key is published with a release store.  When the table
+  // gets half full, a copy twice its size is published in its place.  The
+  // old tables are kept until the factory is destroyed, since readers may
+  // still be probing them.
+  struct PublishedTable {
+    struct Entry {
+      internal::AtomicWord type;  // Really a const Descriptor*, or 0.
+      const Message* prototype;
+    };
+    explicit PublishedTable(int capacity)
+        : mask(capacity - 1), size(0), entries(new Entry[capacity]) {
+      memset(entries.get(), 0, capacity * sizeof(Entry));
+    }
+
+    const int mask;  // The capacity, a power of two, minus one.
+    int size;
+    scoped_array<Entry> entries;
+  };
+  internal::AtomicWord published_;  // Really a const PublishedTable*.
+  vector<PublishedTable*> tables_;   // Every table, for deletion.
+
+  PrototypeMap() : published_(0) {}
+  ~PrototypeMap() { STLDeleteElements(&tables_); }
+
+  static int Hash(internal::AtomicWord type) {
+    // Descriptors are at least 16 bytes apart.
+    return static_cast<int>(static_cast<uint32>(type >> 4) * 0x9E3779B1u);
+  }
+
+  // Returns the prototype for the given type, or NULL if it has not been
+  // published yet.  Lock-free.
+  const Message* FindPublished(const Descriptor* type) const {
+    const PublishedTable* table = reinterpret_cast<const PublishedTable*>(
+        internal::Acquire_Load(&published_));
+    if (table == NULL) return NULL;
+    internal::AtomicWord key = reinterpret_cast<internal::AtomicWord>(type);
+    // The table is never more than half full, so this finds an empty entry.
+    for (int i = Hash(key) & table->mask;; i = (i + 1) & table->mask) {
+      internal::AtomicWord entry_key =
+          internal::Acquire_Load(&table->entries[i].type);
+      if (entry_key == key) return table->entries[i].prototype;
+      if (entry_key == 0) return NULL;
+    }
+  }
+
+  // Makes the prototype visible to FindPublished().  Must be called with
+  // prototypes_mutex_ held.
+  void Publish(const Descriptor* type, const Message* prototype) {
+    PublishedTable* table = tables_.empty() ? NULL : tables_.back();
+    if (table == NULL || (table->size + 1) * 2 > table->mask + 1) {
+      PublishedTable* bigger =
+          new PublishedTable(table == NULL ? 16 : (table->mask + 1) * 2);
+      if (table != NULL) {
+        for (int i = 0; i <= table->mask; i++) {
+          const PublishedTable::Entry& entry = table->entries[i];
+          if (entry.type != 0) Insert(bigger, entry.type, entry.prototype);
+        }
+      }
+      tables_.push_back(bigger);
+      internal::Release_Store(&published_,
+                              reinterpret_cast<internal::AtomicWord>(bigger));
+      table = bigger;
+    }
+    Insert(table, reinterpret_cast<internal::AtomicWord>(type), prototype);
+  }
+
+  static void Insert(PublishedTable* table, internal::AtomicWord key,
+                     const Message* prototype) {
+    int i = Hash(key) & table->mask;
+    while (table->entries[i].type != 0) {
+      if (table->entries[i].type == key) return;  // Already published.
+      i = (i + 1) & table->mask;
+    }
+    table->entries[i].prototype = prototype;
+    internal::Release_Store(&table->entries[i].type, key);
+    ++table->size;
+  }
 };
 
 DynamicMessageFactory::DynamicMessageFactory()
@@ -612,8 +1124,21 @@ DynamicMessageFactory::~DynamicMessageFactory() {
 }
 
 const Message* DynamicMessageFactory::GetPrototype(const Descriptor* type) {
+  if (delegate_to_generated_factory_ &&
+      type->file()->pool() == DescriptorPool::generated_pool()) {
+    return MessageFactory::generated_factory()->GetPrototype(type);
+  }
+
+  // Once a type's prototype has been returned, later calls need no lock.
+  const Message* result = prototypes_->FindPublished(type);
+  if (result != NULL) return result;
+
   MutexLock lock(&prototypes_mutex_);
-  return GetPrototypeNoLock(type);
+  result = GetPrototypeNoLock(type);
+  // The prototypes of the types it refers to may have been constructed
+  // along the way, but they are published when they are first asked for.
+  prototypes_->Publish(type, result);
+  return result;
 }
 
 const Message* DynamicMessageFactory::GetPrototypeNoLock(
@@ -648,72 +1173,83 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
   int* offsets = new int[type->field_count() + type->oneof_decl_count()];
   type_info->offsets.reset(offsets);
 
-  // Decide all field offsets by packing in order.
-  // We place the DynamicMessage object itself at the beginning of the allocated
-  // space.
-  int size = sizeof(DynamicMessage);
-  size = AlignOffset(size);
+  // Decide the offsets of everything which follows the DynamicMessage object
+  // itself at the beginning of the allocated space.
+  vector<LayoutItem> items;
+  const bool is_proto3 = type->file()->syntax() == FileDescriptor::SYNTAX_PROTO3;
 
-  // Next the has_bits, which is an array of uint32s.
-  if (type->file()->syntax() == FileDescriptor::SYNTAX_PROTO3) {
+  // The has_bits, which is an array of uint32s.
+  if (is_proto3) {
     type_info->has_bits_offset = -1;
   } else {
-    type_info->has_bits_offset = size;
     int has_bits_array_size =
       DivideRoundingUp(type->field_count(), bitsizeof(uint32));
-    size += has_bits_array_size * sizeof(uint32);
-    size = AlignOffset(size);
+    AddLayoutItem(sizeof(uint32), has_bits_array_size * sizeof(uint32),
+                  &type_info->has_bits_offset, &items);
   }
 
   // The is_default_instance member, if any.
-  if (type->file()->syntax() == FileDescriptor::SYNTAX_PROTO3) {
-    type_info->is_default_instance_offset = size;
-    size += sizeof(bool);
-    size = AlignOffset(size);
+  if (is_proto3) {
+    AddLayoutItem(sizeof(bool), sizeof(bool),
+                  &type_info->is_default_instance_offset, &items);
   } else {
     type_info->is_default_instance_offset = -1;
   }
 
   // The oneof_case, if any. It is an array of uint32s.
   if (type->oneof_decl_count() > 0) {
-    type_info->oneof_case_offset = size;
-    size += type->oneof_decl_count() * sizeof(uint32);
-    size = AlignOffset(size);
+    AddLayoutItem(sizeof(uint32), type->oneof_decl_count() * sizeof(uint32),
+                  &type_info->oneof_case_offset, &items);
   }
 
   // The ExtensionSet, if any.
   if (type->extension_range_count() > 0) {
-    type_info->extensions_offset = size;
-    size += sizeof(ExtensionSet);
-    size = AlignOffset(size);
+    AddLayoutItem(kSafeAlignment, sizeof(ExtensionSet),
+                  &type_info->extensions_offset, &items);
   } else {
     // No extensions.
     type_info->extensions_offset = -1;
   }
 
-  // All the fields.
+  // The arena the message was created on, if any.
+  AddLayoutItem(sizeof(Arena*), sizeof(Arena*), &type_info->arena_offset,
+                &items);
+
+  // The UnknownFieldSet.
+  AddLayoutItem(kSafeAlignment, sizeof(UnknownFieldSet),
+                &type_info->unknown_fields_offset, &items);
+
+  // All the fields.  Oneof fields do not use any space.
+  type_info->arena_constructable = true;
   for (int i = 0; i < type->field_count(); i++) {
-    // Make sure field is aligned to avoid bus errors.
-    // Oneof fields do not use any space.
     if (!type->field(i)->containing_oneof()) {
       int field_size = FieldSpaceUsed(type->field(i));
-      size = AlignTo(size, min(kSafeAlignment, field_size));
-      offsets[i] = size;
-      size += field_size;
+      AddLayoutItem(min(kSafeAlignment, field_size), field_size, &offsets[i],
+                    &items);
+    }
+    if (type->field(i)->is_map()) {
+      type_info->arena_constructable = false;
+    }
+  }
+
+  // The cached sizes of the packed fields, which ByteSize() sets for
+  // serialization to use, like the _*_cached_byte_size_ members of generated
+  // messages.
+  vector<int> cached_size_offsets(type->field_count(), -1);
+  for (int i = 0; i < type->field_count(); i++) {
+    if (type->field(i)->options().packed()) {
+      AddLayoutItem(sizeof(int), sizeof(int), &cached_size_offsets[i],
+                    &items);
     }
   }
 
   // The oneofs.
   for (int i = 0; i < type->oneof_decl_count(); i++) {
-    size = AlignTo(size, kSafeAlignment);
-    offsets[type->field_count() + i] = size;
-    size += kMaxOneofUnionSize;
+    AddLayoutItem(kSafeAlignment, kMaxOneofUnionSize,
+                  &offsets[type->field_count() + i], &items);
   }
 
-  // Add the UnknownFieldSet to the end.
-  size = AlignOffset(size);
-  type_info->unknown_fields_offset = size;
-  size += sizeof(UnknownFieldSet);
+  int size = LayOut(AlignOffset(sizeof(DynamicMessage)), &items);
 
   // Align the final size to make sure no clever allocators think that
   // alignment is not necessary.
@@ -758,7 +1294,7 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
             type_info->pool,
             this,
             type_info->size,
-            -1 /* arena_offset */,
+            type_info->arena_offset,
             type_info->is_default_instance_offset));
   } else {
     type_info->reflection.reset(
@@ -772,12 +1308,14 @@ const Message* DynamicMessageFactory::GetPrototypeNoLock(
             type_info->pool,
             this,
             type_info->size,
-            -1 /* arena_offset */,
+            type_info->arena_offset,
             type_info->is_default_instance_offset));
   }
   // Cross link prototypes.
   prototype->CrossLinkPrototypes();
 
+  DynamicMessage::InitMessageTable(type_info, cached_size_offsets);
+
   return prototype;
 }
 
@@ -113,14 +113,16 @@ class LIBPROTOBUF_EXPORT DynamicMessageFactory : public MessageFactory {
   // The given descriptor must outlive the returned message, and hence must
   // outlive the DynamicMessageFactory.
   //
-  // The method is thread-safe.
+  // The method is thread-safe.  Only the first call for each type takes a
+  // lock; later calls for it do not block.
   const Message* GetPrototype(const Descriptor* type);
 
  private:
   const DescriptorPool* pool_;
   bool delegate_to_generated_factory_;
 
-  // This struct just contains a hash_map.  We can't #include <google/protobuf/stubs/hash.h> from
+  // This struct contains a hash_map, and the lock-free table GetPrototype()
+  // checks first.  We can't #include <google/protobuf/stubs/hash.h> from
   // this header due to hacks needed for hash_map portability in the open source
   // release.  Namely, stubs/hash.h, which defines hash_map portably, is not a
   // public header (for good reason), but dynamic_message.h is, and public
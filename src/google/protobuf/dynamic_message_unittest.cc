@@ -38,12 +38,16 @@
 // GenericMessageReflection needs to use.  So, we focus on that in this
 // test.  Other tests, such as generic_message_reflection_unittest and
 // reflection_ops_unittest, cover the rest of the functionality used by
-// DynamicMessage.
+// DynamicMessage.  The exception is the wire format, which DynamicMessage
+// implements with a MessageTable rather than through reflection.
 
 #include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/strutil.h>
 #include <google/protobuf/dynamic_message.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/test_util.h>
 #include <google/protobuf/unittest.pb.h>
 #include <google/protobuf/unittest_no_field_presence.pb.h>
@@ -132,6 +136,22 @@ TEST_F(DynamicMessageTest, OnePrototype) {
   EXPECT_EQ(prototype_, factory_.GetPrototype(descriptor_));
 }
 
+TEST_F(DynamicMessageTest, ManyPrototypes) {
+  // Enough types that the factory's lock-free lookup table has to grow,
+  // some of which were constructed as parts of earlier types.
+  const FileDescriptor* file = descriptor_->file();
+  vector<const Message*> prototypes;
+  for (int i = 0; i < file->message_type_count(); i++) {
+    prototypes.push_back(factory_.GetPrototype(file->message_type(i)));
+    EXPECT_EQ(file->message_type(i), prototypes.back()->GetDescriptor());
+  }
+  ASSERT_GT(file->message_type_count(), 32);
+  for (int i = 0; i < file->message_type_count(); i++) {
+    EXPECT_EQ(prototypes[i], factory_.GetPrototype(file->message_type(i)));
+  }
+  EXPECT_EQ(prototype_, factory_.GetPrototype(descriptor_));
+}
+
 TEST_F(DynamicMessageTest, Defaults) {
   // Check that all default values are set correctly in the initial message.
   TestUtil::ReflectionTester reflection_tester(descriptor_);
@@ -242,10 +262,82 @@ TEST_F(DynamicMessageTest, SpaceUsed) {
 TEST_F(DynamicMessageTest, Arena) {
   Arena arena;
   Message* message = prototype_->New(&arena);
-  (void)message;  // avoid unused-variable error.
+  EXPECT_EQ(&arena, message->GetArena());
+  TestUtil::ReflectionTester reflection_tester(descriptor_);
+  reflection_tester.SetAllFieldsViaReflection(message);
+  reflection_tester.ExpectAllFieldsSetViaReflection(*message);
+  // Sub-messages are allocated on the same arena.
+  EXPECT_EQ(&arena, message->GetReflection()->GetMessage(
+      *message, descriptor_->FindFieldByName("optional_nested_message"))
+      .GetArena());
+
+  Message* parsed = prototype_->New(&arena);
+  ASSERT_TRUE(parsed->ParseFromString(message->SerializeAsString()));
+  reflection_tester.ExpectAllFieldsSetViaReflection(*parsed);
+
+  // Swapping with a message on the heap copies the contents.
+  scoped_ptr<Message> heap_message(prototype_->New());
+  heap_message->GetReflection()->Swap(heap_message.get(), parsed);
+  reflection_tester.ExpectAllFieldsSetViaReflection(*heap_message);
+  reflection_tester.ExpectClearViaReflection(*parsed);
   // Return without freeing: should not leak.
 }
 
+TEST_F(DynamicMessageTest, ArenaOneofsAndExtensions) {
+  Arena arena;
+  Message* message = oneof_prototype_->New(&arena);
+  TestUtil::ReflectionTester oneof_tester(oneof_descriptor_);
+  oneof_tester.SetOneofViaReflection(message);
+  oneof_tester.ExpectOneofSetViaReflection(*message);
+  // Switching to another member clears the message on the arena.
+  message->GetReflection()->SetInt32(
+      message, oneof_descriptor_->FindFieldByName("foo_int"), 7);
+  message->GetReflection()->MutableMessage(
+      message, oneof_descriptor_->FindFieldByName("foo_message"));
+  message->GetReflection()->SetInt32(
+      message, oneof_descriptor_->FindFieldByName("foo_int"), 7);
+
+  Message* extensions = extensions_prototype_->New(&arena);
+  TestUtil::ReflectionTester extensions_tester(extensions_descriptor_);
+  extensions_tester.SetAllFieldsViaReflection(extensions);
+  extensions_tester.ExpectAllFieldsSetViaReflection(*extensions);
+  // Return without freeing: should not leak.
+}
+
+TEST_F(DynamicMessageTest, CompactLayout) {
+  // Fields are packed by alignment, so a message with small fields between
+  // large ones needs no padding between them.
+  FileDescriptorProto file;
+  file.set_name("compact.proto");
+  DescriptorProto* message_type = file.add_message_type();
+  message_type->set_name("Compact");
+  for (int i = 1; i <= 8; i++) {
+    FieldDescriptorProto* field = message_type->add_field();
+    field->set_name("field" + SimpleItoa(i));
+    field->set_number(i);
+    field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+    field->set_type(i % 2 == 0 ? FieldDescriptorProto::TYPE_BOOL
+                               : FieldDescriptorProto::TYPE_INT64);
+  }
+  const FileDescriptor* compact_file = pool_.BuildFile(file);
+  ASSERT_TRUE(compact_file != NULL);
+  const Message* prototype =
+      factory_.GetPrototype(compact_file->message_type(0));
+  scoped_ptr<Message> message(prototype->New());
+
+  // Four int64s, four bools and a word of has-bits, plus the fixed parts.
+  FileDescriptorProto empty_file;
+  empty_file.set_name("empty.proto");
+  empty_file.add_message_type()->set_name("Empty");
+  const FileDescriptor* built_empty_file = pool_.BuildFile(empty_file);
+  ASSERT_TRUE(built_empty_file != NULL);
+  scoped_ptr<Message> empty(
+      factory_.GetPrototype(built_empty_file->message_type(0))->New());
+  EXPECT_LE(message->SpaceUsed(),
+            empty->SpaceUsed() + 4 * sizeof(int64) + 4 * sizeof(bool) +
+            sizeof(uint32) + 8);
+}
+
 TEST_F(DynamicMessageTest, Proto3) {
   Message* message = proto3_prototype_->New();
   const Reflection* refl = message->GetReflection();
@@ -280,6 +372,114 @@ TEST_F(DynamicMessageTest, Proto3) {
   delete message;
 }
 
+// DynamicMessage parses and serializes using a MessageTable built by
+// DynamicMessageFactory, rather than through reflection.  Check that it
+// reads what generated code writes and writes it back identically, both
+// through a stream and to a flat array.
+void ExpectRoundTrip(const Message& prototype, const string& data) {
+  scoped_ptr<Message> message(prototype.New());
+  ASSERT_TRUE(message->ParseFromString(data));
+  EXPECT_EQ(data, message->SerializeAsString());
+
+  string streamed;
+  {
+    io::StringOutputStream output(&streamed);
+    io::CodedOutputStream coded_output(&output);
+    EXPECT_EQ(static_cast<int>(data.size()), message->ByteSize());
+    message->SerializeWithCachedSizes(&coded_output);
+  }
+  EXPECT_EQ(data, streamed);
+}
+
+TEST_F(DynamicMessageTest, WireFormat) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  ExpectRoundTrip(*prototype_, message.SerializeAsString());
+
+  scoped_ptr<Message> dynamic_message(prototype_->New());
+  ASSERT_TRUE(dynamic_message->ParseFromString(message.SerializeAsString()));
+  TestUtil::ReflectionTester reflection_tester(descriptor_);
+  reflection_tester.ExpectAllFieldsSetViaReflection(*dynamic_message);
+
+  // Merging keeps what is already set.
+  string data = message.SerializeAsString();
+  io::CodedInputStream input(reinterpret_cast<const uint8*>(data.data()),
+                             data.size());
+  ASSERT_TRUE(dynamic_message->MergeFromCodedStream(&input));
+  EXPECT_EQ(4, dynamic_message->GetReflection()->FieldSize(
+      *dynamic_message, descriptor_->FindFieldByName("repeated_int32")));
+}
+
+TEST_F(DynamicMessageTest, WireFormatPackedFields) {
+  unittest::TestPackedTypes message;
+  TestUtil::SetPackedFields(&message);
+  ExpectRoundTrip(*packed_prototype_, message.SerializeAsString());
+
+  // Packed fields also accept the unpacked encoding.
+  unittest::TestUnpackedTypes unpacked;
+  TestUtil::SetUnpackedFields(&unpacked);
+  scoped_ptr<Message> dynamic_message(packed_prototype_->New());
+  ASSERT_TRUE(dynamic_message->ParseFromString(unpacked.SerializeAsString()));
+  EXPECT_EQ(message.SerializeAsString(), dynamic_message->SerializeAsString());
+}
+
+TEST_F(DynamicMessageTest, WireFormatExtensionsAndOneofs) {
+  unittest::TestAllExtensions extensions;
+  TestUtil::SetAllExtensions(&extensions);
+  ExpectRoundTrip(*extensions_prototype_, extensions.SerializeAsString());
+
+  // Extensions are written in order with the fields.
+  unittest::TestFieldOrderings orderings;
+  TestUtil::SetAllFieldsAndExtensions(&orderings);
+  const Descriptor* orderings_descriptor =
+      pool_.FindMessageTypeByName("protobuf_unittest.TestFieldOrderings");
+  ASSERT_TRUE(orderings_descriptor != NULL);
+  ExpectRoundTrip(*factory_.GetPrototype(orderings_descriptor),
+                  orderings.SerializeAsString());
+
+  unittest::TestOneof2 oneof;
+  TestUtil::SetOneof1(&oneof);
+  ExpectRoundTrip(*oneof_prototype_, oneof.SerializeAsString());
+  TestUtil::SetOneof2(&oneof);
+  ExpectRoundTrip(*oneof_prototype_, oneof.SerializeAsString());
+}
+
+TEST_F(DynamicMessageTest, WireFormatUnknownFields) {
+  unittest::TestEmptyMessage unknown;
+  UnknownFieldSet* unknown_fields = unknown.mutable_unknown_fields();
+  // Not a value of optional_nested_enum's type, so kept as an unknown field.
+  unknown_fields->AddVarint(
+      unittest::TestAllTypes::kOptionalNestedEnumFieldNumber, 12345);
+  unknown_fields->AddLengthDelimited(12345, "unknown");
+  ExpectRoundTrip(*prototype_, unknown.SerializeAsString());
+
+  scoped_ptr<Message> message(prototype_->New());
+  ASSERT_TRUE(message->ParseFromString(unknown.SerializeAsString()));
+  EXPECT_FALSE(message->GetReflection()->HasField(
+      *message, descriptor_->FindFieldByName("optional_nested_enum")));
+  EXPECT_EQ(2, message->GetReflection()->GetUnknownFields(*message)
+                   .field_count());
+}
+
+TEST_F(DynamicMessageTest, WireFormatProto3) {
+  proto2_nofieldpresence_unittest::TestAllTypes message;
+  message.set_optional_int32(1);
+  message.set_optional_string("abc");
+  message.mutable_optional_nested_message()->set_bb(2);
+  message.add_repeated_int32(3);
+  message.add_repeated_nested_enum(
+      proto2_nofieldpresence_unittest::TestAllTypes::BAZ);
+  ExpectRoundTrip(*proto3_prototype_, message.SerializeAsString());
+
+  // Fields set to their defaults are not written.
+  scoped_ptr<Message> dynamic_message(proto3_prototype_->New());
+  ASSERT_TRUE(dynamic_message->ParseFromString(message.SerializeAsString()));
+  dynamic_message->GetReflection()->SetInt32(
+      dynamic_message.get(), proto3_descriptor_->FindFieldByName(
+          "optional_int32"), 0);
+  message.set_optional_int32(0);
+  EXPECT_EQ(message.SerializeAsString(), dynamic_message->SerializeAsString());
+}
 
 }  // namespace protobuf
 }  // namespace google
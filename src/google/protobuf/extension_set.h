@@ -186,6 +186,15 @@ class LIBPROTOBUF_EXPORT ExtensionSet {
                     const DescriptorPool* pool,
                     std::vector<const FieldDescriptor*>* output) const;
 
+  // Find the lowest-numbered extension which is currently present and whose
+  // number is at least start_number.  On success, sets *number and
+  // *descriptor and returns true.  This lets Reflection::VisitFields() walk
+  // the present extensions in order without building a list.
+  bool FindPresentExtension(const Descriptor* containing_type,
+                            const DescriptorPool* pool,
+                            int start_number, int* number,
+                            const FieldDescriptor** descriptor) const;
+
   // =================================================================
   // Accessors
   //
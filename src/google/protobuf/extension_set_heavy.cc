@@ -119,6 +119,27 @@ void ExtensionSet::AppendToList(const Descriptor* containing_type,
   }
 }
 
+bool ExtensionSet::FindPresentExtension(
+    const Descriptor* containing_type, const DescriptorPool* pool,
+    int start_number, int* number,
+    const FieldDescriptor** descriptor) const {
+  for (map<int, Extension>::const_iterator iter =
+           extensions_.lower_bound(start_number);
+       iter != extensions_.end(); ++iter) {
+    if (iter->second.is_repeated ? iter->second.GetSize() == 0
+                                 : iter->second.is_cleared) {
+      continue;
+    }
+    *number = iter->first;
+    // See the comment in AppendToList() about looking up by number.
+    *descriptor = iter->second.descriptor != NULL ?
+        iter->second.descriptor :
+        pool->FindExtensionByNumber(containing_type, iter->first);
+    return true;
+  }
+  return false;
+}
+
 inline FieldDescriptor::Type real_type(FieldType type) {
   GOOGLE_DCHECK(type > 0 && type <= FieldDescriptor::MAX_TYPE);
   return static_cast<FieldDescriptor::Type>(type);
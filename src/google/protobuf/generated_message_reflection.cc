@@ -42,6 +42,7 @@
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/generated_message_util.h>
 #include <google/protobuf/map_field.h>
+#include <google/protobuf/reflection.h>
 #include <google/protobuf/repeated_field.h>
 
 
@@ -194,7 +195,9 @@ GeneratedMessageReflection::GeneratedMessageReflection(
     MessageFactory* factory,
     int object_size,
     int arena_offset,
-    int is_default_instance_offset)
+    int is_default_instance_offset,
+    int cold_fields_offset,
+    void* (*mutable_cold_fields)(Message*))
   : descriptor_       (descriptor),
     default_instance_ (default_instance),
     offsets_          (offsets),
@@ -204,10 +207,13 @@ GeneratedMessageReflection::GeneratedMessageReflection(
     arena_offset_     (arena_offset),
     is_default_instance_offset_(is_default_instance_offset),
     object_size_      (object_size),
+    cold_fields_offset_(cold_fields_offset),
+    mutable_cold_fields_(mutable_cold_fields),
     descriptor_pool_  ((descriptor_pool == NULL) ?
                          DescriptorPool::generated_pool() :
                          descriptor_pool),
     message_factory_  (factory) {
+  InitFieldsByNumber();
 }
 
 GeneratedMessageReflection::GeneratedMessageReflection(
@@ -223,7 +229,9 @@ GeneratedMessageReflection::GeneratedMessageReflection(
     MessageFactory* factory,
     int object_size,
     int arena_offset,
-    int is_default_instance_offset)
+    int is_default_instance_offset,
+    int cold_fields_offset,
+    void* (*mutable_cold_fields)(Message*))
   : descriptor_       (descriptor),
     default_instance_ (default_instance),
     default_oneof_instance_ (default_oneof_instance),
@@ -235,14 +243,42 @@ GeneratedMessageReflection::GeneratedMessageReflection(
     arena_offset_     (arena_offset),
     is_default_instance_offset_(is_default_instance_offset),
     object_size_      (object_size),
+    cold_fields_offset_(cold_fields_offset),
+    mutable_cold_fields_(mutable_cold_fields),
     descriptor_pool_  ((descriptor_pool == NULL) ?
                          DescriptorPool::generated_pool() :
                          descriptor_pool),
     message_factory_  (factory) {
+  InitFieldsByNumber();
 }
 
 GeneratedMessageReflection::~GeneratedMessageReflection() {}
 
+namespace {
+// Comparison functor for sorting FieldDescriptors by field number.
+struct FieldNumberSorter {
+  bool operator()(const FieldDescriptor* left,
+                  const FieldDescriptor* right) const {
+    return left->number() < right->number();
+  }
+};
+}  // namespace
+
+void GeneratedMessageReflection::InitFieldsByNumber() {
+  for (int i = 1; i < descriptor_->field_count(); i++) {
+    if (descriptor_->field(i)->number() <
+        descriptor_->field(i - 1)->number()) {
+      fields_by_number_.reserve(descriptor_->field_count());
+      for (int j = 0; j < descriptor_->field_count(); j++) {
+        fields_by_number_.push_back(descriptor_->field(j));
+      }
+      sort(fields_by_number_.begin(), fields_by_number_.end(),
+           FieldNumberSorter());
+      return;
+    }
+  }
+}
+
 namespace {
 UnknownFieldSet* empty_unknown_field_set_ = NULL;
 GOOGLE_PROTOBUF_DECLARE_ONCE(empty_unknown_field_set_once_);
@@ -341,6 +377,11 @@ int GeneratedMessageReflection::SpaceUsed(const Message& message) const {
       if (field->containing_oneof() && !HasOneofField(message, field)) {
         continue;
       }
+      if ((offsets_[field->index()] & kColdFieldOffsetBit) &&
+          RawColdFields(message) == NULL) {
+        // The field is read from the default instance's cold fields.
+        continue;
+      }
       switch (field->cpp_type()) {
         case FieldDescriptor::CPPTYPE_INT32 :
         case FieldDescriptor::CPPTYPE_INT64 :
@@ -972,12 +1013,15 @@ void GeneratedMessageReflection::SwapElements(
 }
 
 namespace {
-// Comparison functor for sorting FieldDescriptors by field number.
-struct FieldNumberSorter {
-  bool operator()(const FieldDescriptor* left,
-                  const FieldDescriptor* right) const {
-    return left->number() < right->number();
-  }
+// Appends each field it visits to a vector.
+class FieldListBuilder : public Reflection::FieldVisitor {
+ public:
+  explicit FieldListBuilder(vector<const FieldDescriptor*>* output)
+      : output_(output) {}
+  void Visit(const FieldDescriptor* field) { output_->push_back(field); }
+
+ private:
+  vector<const FieldDescriptor*>* output_;
 };
 }  // namespace
 
@@ -985,34 +1029,48 @@ void GeneratedMessageReflection::ListFields(
     const Message& message,
     vector<const FieldDescriptor*>* output) const {
   output->clear();
+  FieldListBuilder builder(output);
+  VisitFields(message, &builder);
+}
 
+void GeneratedMessageReflection::VisitFields(
+    const Message& message, FieldVisitor* visitor) const {
   // Optimization:  The default instance never has any fields set.
   if (&message == default_instance_) return;
 
-  for (int i = 0; i < descriptor_->field_count(); i++) {
-    const FieldDescriptor* field = descriptor_->field(i);
-    if (field->is_repeated()) {
-      if (FieldSize(message, field) > 0) {
-        output->push_back(field);
-      }
-    } else {
-      if (field->containing_oneof()) {
-        if (HasOneofField(message, field)) {
-          output->push_back(field);
-        }
-      } else if (HasBit(message, field)) {
-        output->push_back(field);
-      }
+  // Present extensions are merged in while walking the fields in number
+  // order.  ExtensionSet keeps them sorted by number.
+  const ExtensionSet* extensions = NULL;
+  int extension_number = 0;
+  const FieldDescriptor* extension = NULL;
+  bool has_extension = false;
+  if (extensions_offset_ != -1) {
+    extensions = &GetExtensionSet(message);
+    has_extension = extensions->FindPresentExtension(
+        descriptor_, descriptor_pool_, 0, &extension_number, &extension);
+  }
+
+  const int field_count = descriptor_->field_count();
+  const bool sorted = fields_by_number_.empty();
+  for (int i = 0; i < field_count; i++) {
+    const FieldDescriptor* field =
+        sorted ? descriptor_->field(i) : fields_by_number_[i];
+    while (has_extension && extension_number < field->number()) {
+      visitor->Visit(extension);
+      has_extension = extensions->FindPresentExtension(
+          descriptor_, descriptor_pool_, extension_number + 1,
+          &extension_number, &extension);
+    }
+    if (IsFieldPresent(message, field)) {
+      visitor->Visit(field);
     }
   }
-
-  if (extensions_offset_ != -1) {
-    GetExtensionSet(message).AppendToList(descriptor_, descriptor_pool_,
-                                          output);
+  while (has_extension) {
+    visitor->Visit(extension);
+    has_extension = extensions->FindPresentExtension(
+        descriptor_, descriptor_pool_, extension_number + 1,
+        &extension_number, &extension);
   }
-
-  // ListFields() must sort output by field number.
-  sort(output->begin(), output->end(), FieldNumberSorter());
 }
 
 // -------------------------------------------------------------------
@@ -1732,8 +1790,13 @@ inline const Type& GeneratedMessageReflection::GetRaw(
   int index = field->containing_oneof() ?
       descriptor_->field_count() + field->containing_oneof()->index() :
       field->index();
-  const void* ptr = reinterpret_cast<const uint8*>(&message) +
-      offsets_[index];
+  int offset = offsets_[index];
+  if (offset & kColdFieldOffsetBit) {
+    const void* ptr = reinterpret_cast<const uint8*>(GetColdFields(message)) +
+        (offset & ~kColdFieldOffsetBit);
+    return *reinterpret_cast<const Type*>(ptr);
+  }
+  const void* ptr = reinterpret_cast<const uint8*>(&message) + offset;
   return *reinterpret_cast<const Type*>(ptr);
 }
 
@@ -1743,21 +1806,49 @@ inline Type* GeneratedMessageReflection::MutableRaw(
   int index = field->containing_oneof() ?
       descriptor_->field_count() + field->containing_oneof()->index() :
       field->index();
-  void* ptr = reinterpret_cast<uint8*>(message) + offsets_[index];
+  int offset = offsets_[index];
+  if (offset & kColdFieldOffsetBit) {
+    void* ptr = reinterpret_cast<uint8*>(mutable_cold_fields_(message)) +
+        (offset & ~kColdFieldOffsetBit);
+    return reinterpret_cast<Type*>(ptr);
+  }
+  void* ptr = reinterpret_cast<uint8*>(message) + offset;
   return reinterpret_cast<Type*>(ptr);
 }
 
 template <typename Type>
 inline const Type& GeneratedMessageReflection::DefaultRaw(
     const FieldDescriptor* field) const {
-  const void* ptr = field->containing_oneof() ?
-      reinterpret_cast<const uint8*>(default_oneof_instance_) +
-      offsets_[field->index()] :
-      reinterpret_cast<const uint8*>(default_instance_) +
-      offsets_[field->index()];
+  int offset = offsets_[field->index()];
+  const void* ptr;
+  if (field->containing_oneof()) {
+    ptr = reinterpret_cast<const uint8*>(default_oneof_instance_) + offset;
+  } else if (offset & kColdFieldOffsetBit) {
+    ptr = reinterpret_cast<const uint8*>(DefaultColdFields()) +
+        (offset & ~kColdFieldOffsetBit);
+  } else {
+    ptr = reinterpret_cast<const uint8*>(default_instance_) + offset;
+  }
   return *reinterpret_cast<const Type*>(ptr);
 }
 
+inline const void* GeneratedMessageReflection::RawColdFields(
+    const Message& message) const {
+  const void* ptr = reinterpret_cast<const uint8*>(&message) +
+                    cold_fields_offset_;
+  return *reinterpret_cast<const void* const*>(ptr);
+}
+
+inline const void* GeneratedMessageReflection::GetColdFields(
+    const Message& message) const {
+  const void* cold_fields = RawColdFields(message);
+  return cold_fields != NULL ? cold_fields : DefaultColdFields();
+}
+
+inline const void* GeneratedMessageReflection::DefaultColdFields() const {
+  return RawColdFields(*default_instance_);
+}
+
 inline const uint32* GeneratedMessageReflection::GetHasBits(
     const Message& message) const {
   if (has_bits_offset_ == -1) {  // proto3 with no has-bits.
@@ -1946,6 +2037,17 @@ inline bool GeneratedMessageReflection::HasOneofField(
   return (GetOneofCase(message, field->containing_oneof()) == field->number());
 }
 
+inline bool GeneratedMessageReflection::IsFieldPresent(
+    const Message& message, const FieldDescriptor* field) const {
+  if (field->is_repeated()) {
+    return FieldSize(message, field) > 0;
+  } else if (field->containing_oneof()) {
+    return HasOneofField(message, field);
+  } else {
+    return HasBit(message, field);
+  }
+}
+
 inline void GeneratedMessageReflection::SetOneofCase(
     Message* message, const FieldDescriptor* field) const {
   *MutableOneofCase(message, field->containing_oneof()) = field->number();
@@ -1982,7 +2084,9 @@ inline void GeneratedMessageReflection::ClearOneof(
       }
 
       case FieldDescriptor::CPPTYPE_MESSAGE:
-        delete *MutableRaw<Message*>(message, field);
+        if (GetArena(message) == NULL) {
+          delete *MutableRaw<Message*>(message, field);
+        }
         break;
       default:
         break;
@@ -2087,6 +2191,56 @@ void* GeneratedMessageReflection::RepeatedFieldData(
   }
 }
 
+bool GeneratedMessageReflection::GetFieldLayout(
+    const FieldDescriptor* field, internal::FieldLayout* layout) const {
+  if (field->is_extension() || field->is_map() ||
+      field->containing_type() != descriptor_) {
+    return false;
+  }
+  const OneofDescriptor* oneof = field->containing_oneof();
+  int index = oneof != NULL ?
+      descriptor_->field_count() + oneof->index() : field->index();
+  int offset = offsets_[index];
+  // Cold fields live in a separately allocated block.
+  if (offset & kColdFieldOffsetBit) return false;
+
+  layout->offset = offset;
+  layout->has_bit_offset = -1;
+  layout->has_bit_mask = 0;
+  layout->oneof_case_offset = -1;
+  if (oneof != NULL) {
+    layout->oneof_case_offset =
+        oneof_case_offset_ + oneof->index() * sizeof(uint32);
+  } else if (has_bits_offset_ != -1) {
+    layout->has_bit_offset =
+        has_bits_offset_ + (field->index() / 32) * sizeof(uint32);
+    layout->has_bit_mask = 1u << (field->index() % 32);
+  }
+  layout->is_default_instance_offset =
+      is_default_instance_offset_ == kHasNoDefaultInstanceField ?
+      -1 : is_default_instance_offset_;
+  if (field->is_repeated()) {
+    layout->has_bit_offset = -1;
+    layout->has_bit_mask = 0;
+    layout->default_value = NULL;
+    return true;
+  }
+
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+      layout->default_value = &DefaultRaw<ArenaStringPtr>(field).Get(NULL);
+      break;
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      layout->default_value = DefaultRaw<const Message*>(field);
+      if (layout->default_value == NULL) return false;
+      break;
+    default:
+      layout->default_value = &DefaultRaw<char>(field);
+      break;
+  }
+  return true;
+}
+
 GeneratedMessageReflection*
 GeneratedMessageReflection::NewGeneratedMessageReflection(
     const Descriptor* descriptor,
@@ -2099,7 +2253,9 @@ GeneratedMessageReflection::NewGeneratedMessageReflection(
     int oneof_case_offset,
     int object_size,
     int arena_offset,
-    int is_default_instance_offset) {
+    int is_default_instance_offset,
+    int cold_fields_offset,
+    void* (*mutable_cold_fields)(Message*)) {
   return new GeneratedMessageReflection(descriptor,
                                         default_instance,
                                         offsets,
@@ -2112,7 +2268,9 @@ GeneratedMessageReflection::NewGeneratedMessageReflection(
                                         MessageFactory::generated_factory(),
                                         object_size,
                                         arena_offset,
-                                        is_default_instance_offset);
+                                        is_default_instance_offset,
+                                        cold_fields_offset,
+                                        mutable_cold_fields);
 }
 
 GeneratedMessageReflection*
@@ -2125,7 +2283,9 @@ GeneratedMessageReflection::NewGeneratedMessageReflection(
     int extensions_offset,
     int object_size,
     int arena_offset,
-    int is_default_instance_offset) {
+    int is_default_instance_offset,
+    int cold_fields_offset,
+    void* (*mutable_cold_fields)(Message*)) {
   return new GeneratedMessageReflection(descriptor,
                                         default_instance,
                                         offsets,
@@ -2136,7 +2296,9 @@ GeneratedMessageReflection::NewGeneratedMessageReflection(
                                         MessageFactory::generated_factory(),
                                         object_size,
                                         arena_offset,
-                                        is_default_instance_offset);
+                                        is_default_instance_offset,
+                                        cold_fields_offset,
+                                        mutable_cold_fields);
 }
 
 }  // namespace internal
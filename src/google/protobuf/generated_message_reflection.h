@@ -44,6 +44,7 @@
 // TODO(jasonh): Remove this once the compiler change to directly include this
 // is released to components.
 #include <google/protobuf/generated_enum_reflection.h>
+#include <google/protobuf/generated_message_util.h>
 #include <google/protobuf/message.h>
 #include <google/protobuf/metadata.h>
 #include <google/protobuf/unknown_field_set.h>
@@ -109,7 +110,7 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
   //                  the start of the message object, of each field.  These can
   //                  be computed at compile time using the
   //                  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET() macro, defined
-  //                  below.
+  //                  in generated_message_util.h.
   //   has_bits_offset:  Offset in the message of an array of uint32s of size
   //                  descriptor->field_count()/32, rounded up.  This is a
   //                  bitfield where each bit indicates whether or not the
@@ -127,6 +128,18 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
   //   factory:       MessageFactory to use to construct extension messages.
   //   object_size:   The size of a message object of this type, as measured
   //                  by sizeof().
+  //   cold_fields_offset:  Offset in the message of a pointer to the struct
+  //                  which holds its cold fields, or -1 if it has none.  The
+  //                  C++ code generator moves fields which are rarely used
+  //                  into such a struct, allocated when one of them is first
+  //                  set, if asked to by a field usage profile.  Their
+  //                  offsets are relative to the struct and are computed
+  //                  using the PROTO2_GENERATED_COLD_FIELD_OFFSET() macro.
+  //                  The default instance's struct must always be allocated;
+  //                  it provides the defaults read from messages whose own
+  //                  struct has not been allocated yet.
+  //   mutable_cold_fields:  Returns the message's struct of cold fields,
+  //                  allocating it if it has not been allocated yet.
   GeneratedMessageReflection(const Descriptor* descriptor,
                              const Message* default_instance,
                              const int offsets[],
@@ -137,7 +150,9 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
                              MessageFactory* factory,
                              int object_size,
                              int arena_offset,
-                             int is_default_instance_offset = -1);
+                             int is_default_instance_offset = -1,
+                             int cold_fields_offset = -1,
+                             void* (*mutable_cold_fields)(Message*) = NULL);
 
   // Similar with the construction above. Call this construction if the
   // message has oneof definition.
@@ -175,7 +190,9 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
                              MessageFactory* factory,
                              int object_size,
                              int arena_offset,
-                             int is_default_instance_offset = -1);
+                             int is_default_instance_offset = -1,
+                             int cold_fields_offset = -1,
+                             void* (*mutable_cold_fields)(Message*) = NULL);
   ~GeneratedMessageReflection();
 
   // Shorter-to-call helpers for the above two constructions that work if the
@@ -193,7 +210,9 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
       int oneof_case_offset,
       int object_size,
       int arena_offset,
-      int is_default_instance_offset = -1);
+      int is_default_instance_offset = -1,
+      int cold_fields_offset = -1,
+      void* (*mutable_cold_fields)(Message*) = NULL);
 
   static GeneratedMessageReflection* NewGeneratedMessageReflection(
       const Descriptor* descriptor,
@@ -204,7 +223,13 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
       int extensions_offset,
       int object_size,
       int arena_offset,
-      int is_default_instance_offset = -1);
+      int is_default_instance_offset = -1,
+      int cold_fields_offset = -1,
+      void* (*mutable_cold_fields)(Message*) = NULL);
+
+  // Set in the offsets of fields which are kept in the message's struct of
+  // cold fields.  See PROTO2_GENERATED_COLD_FIELD_OFFSET().
+  static const int kColdFieldOffsetBit = 1 << 30;
 
   // implements Reflection -------------------------------------------
 
@@ -228,6 +253,7 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
                     int index1, int index2) const;
   void ListFields(const Message& message,
                   vector<const FieldDescriptor*>* output) const;
+  void VisitFields(const Message& message, FieldVisitor* visitor) const;
 
   int32  GetInt32 (const Message& message,
                    const FieldDescriptor* field) const;
@@ -401,6 +427,9 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
       FieldDescriptor::CppType cpp_type,
       const Descriptor* message_type) const;
 
+  virtual bool GetFieldLayout(const FieldDescriptor* field,
+                              internal::FieldLayout* layout) const;
+
  private:
   friend class GeneratedMessage;
 
@@ -420,12 +449,20 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
   int arena_offset_;
   int is_default_instance_offset_;
   int object_size_;
+  int cold_fields_offset_;
+  void* (*mutable_cold_fields_)(Message*);
 
   static const int kHasNoDefaultInstanceField = -1;
 
   const DescriptorPool* descriptor_pool_;
   MessageFactory* message_factory_;
 
+  // descriptor_'s fields sorted by number, for VisitFields().  Left empty in
+  // the usual case where the fields are declared in number order.
+  vector<const FieldDescriptor*> fields_by_number_;
+
+  void InitFieldsByNumber();
+
   template <typename Type>
   inline const Type& GetRaw(const Message& message,
                             const FieldDescriptor* field) const;
@@ -437,6 +474,13 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
   template <typename Type>
   inline const Type& DefaultOneofRaw(const FieldDescriptor* field) const;
 
+  // Return the struct of cold fields which GetRaw() and DefaultRaw() read
+  // from.  RawColdFields() returns NULL if the message has not allocated its
+  // own.
+  inline const void* RawColdFields(const Message& message) const;
+  inline const void* GetColdFields(const Message& message) const;
+  inline const void* DefaultColdFields() const;
+
   inline const uint32* GetHasBits(const Message& message) const;
   inline uint32* MutableHasBits(Message* message) const;
   inline uint32 GetOneofCase(
@@ -477,6 +521,9 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
 
   inline bool HasOneofField(const Message& message,
                             const FieldDescriptor* field) const;
+  // Whether ListFields() would list the given non-extension field.
+  inline bool IsFieldPresent(const Message& message,
+                             const FieldDescriptor* field) const;
   inline void SetOneofCase(Message* message,
                            const FieldDescriptor* field) const;
   inline void ClearOneofField(Message* message,
@@ -541,30 +588,18 @@ class LIBPROTOBUF_EXPORT GeneratedMessageReflection : public Reflection {
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(GeneratedMessageReflection);
 };
 
-// Returns the offset of the given field within the given aggregate type.
-// This is equivalent to the ANSI C offsetof() macro.  However, according
-// to the C++ standard, offsetof() only works on POD types, and GCC
-// enforces this requirement with a warning.  In practice, this rule is
-// unnecessarily strict; there is probably no compiler or platform on
-// which the offsets of the direct fields of a class are non-constant.
-// Fields inherited from superclasses *can* have non-constant offsets,
-// but that's not what this macro will be used for.
-//
-// Note that we calculate relative to the pointer value 16 here since if we
-// just use zero, GCC complains about dereferencing a NULL pointer.  We
-// choose 16 rather than some other number just in case the compiler would
-// be confused by an unaligned pointer.
-#define GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TYPE, FIELD)    \
-  static_cast<int>(                                           \
-      reinterpret_cast<const char*>(                          \
-          &reinterpret_cast<const TYPE*>(16)->FIELD) -        \
-      reinterpret_cast<const char*>(16))
-
 #define PROTO2_GENERATED_DEFAULT_ONEOF_FIELD_OFFSET(ONEOF, FIELD)     \
   static_cast<int>(                                                   \
       reinterpret_cast<const char*>(&(ONEOF->FIELD))                  \
       - reinterpret_cast<const char*>(ONEOF))
 
+// Computes the offset of a field which TYPE keeps in its struct of cold
+// fields, TYPE::ColdFields.  The result is marked so that
+// GeneratedMessageReflection can tell it from the offsets of other fields.
+#define PROTO2_GENERATED_COLD_FIELD_OFFSET(TYPE, FIELD)                \
+  (GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TYPE::ColdFields, FIELD) | \
+   ::google::protobuf::internal::GeneratedMessageReflection::kColdFieldOffsetBit)
+
 // There are some places in proto2 where dynamic_cast would be useful as an
 // optimization.  For example, take Message::MergeFrom(const Message& other).
 // For a given generated message FooMessage, we generate these two methods:
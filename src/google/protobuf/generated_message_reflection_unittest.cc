@@ -44,8 +44,10 @@
 
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/descriptor.h>
+#include <google/protobuf/reflection.h>
 #include <google/protobuf/test_util.h>
 #include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/unittest_no_field_presence.pb.h>
 
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/testing/googletest.h>
@@ -738,6 +740,214 @@ TEST(GeneratedMessageReflectionTest, ReleaseOneofMessageTest) {
   EXPECT_TRUE(released == NULL);
 }
 
+TEST(GeneratedMessageReflectionTest, FieldAccessors) {
+  unittest::TestAllTypes message;
+  const Reflection* reflection = message.GetReflection();
+
+  FieldAccessor<int32> int32_accessor =
+      reflection->GetAccessor<int32>(F("optional_int32"));
+  FieldAccessor<double> double_accessor =
+      reflection->GetAccessor<double>(F("default_double"));
+  FieldAccessor<bool> bool_accessor =
+      reflection->GetAccessor<bool>(F("optional_bool"));
+  FieldAccessor<int32> enum_accessor =
+      reflection->GetAccessor<int32>(F("default_nested_enum"));
+  FieldAccessor<string> string_accessor =
+      reflection->GetAccessor<string>(F("default_string"));
+  FieldAccessor<Message> message_accessor =
+      reflection->GetAccessor<Message>(F("optional_nested_message"));
+  EXPECT_EQ(F("optional_int32"), int32_accessor.field());
+
+  // Unset fields read as their defaults.
+  EXPECT_FALSE(int32_accessor.Has(message));
+  EXPECT_EQ(0, int32_accessor.Get(message));
+  EXPECT_FALSE(double_accessor.Has(message));
+  EXPECT_EQ(52e3, double_accessor.Get(message));
+  EXPECT_FALSE(bool_accessor.Has(message));
+  EXPECT_FALSE(bool_accessor.Get(message));
+  EXPECT_FALSE(enum_accessor.Has(message));
+  EXPECT_EQ(unittest::TestAllTypes::BAR, enum_accessor.Get(message));
+  EXPECT_FALSE(string_accessor.Has(message));
+  EXPECT_EQ("hello", string_accessor.Get(message));
+  EXPECT_FALSE(message_accessor.Has(message));
+  EXPECT_EQ(&unittest::TestAllTypes::NestedMessage::default_instance(),
+            &message_accessor.Get(message));
+
+  // Values set through the generated accessors are seen.
+  TestUtil::SetAllFields(&message);
+  EXPECT_TRUE(int32_accessor.Has(message));
+  EXPECT_EQ(101, int32_accessor.Get(message));
+  EXPECT_EQ(412, double_accessor.Get(message));
+  EXPECT_TRUE(bool_accessor.Get(message));
+  EXPECT_EQ(unittest::TestAllTypes::FOO, enum_accessor.Get(message));
+  string scratch;
+  EXPECT_EQ(&message.default_string(),
+            &string_accessor.GetReference(message, &scratch));
+  EXPECT_TRUE(message_accessor.Has(message));
+  EXPECT_EQ(&message.optional_nested_message(),
+            &message_accessor.Get(message));
+
+  // Values set through the FieldAccessors are seen by the generated code.
+  message.Clear();
+  int32_accessor.Set(&message, 12);
+  double_accessor.Set(&message, 1.5);
+  bool_accessor.Set(&message, true);
+  enum_accessor.Set(&message, unittest::TestAllTypes::BAZ);
+  string_accessor.Set(&message, "foo");
+  Message* sub_message = message_accessor.Mutable(&message);
+  EXPECT_EQ(sub_message, message_accessor.Mutable(&message));
+  EXPECT_TRUE(message.has_optional_int32());
+  EXPECT_EQ(12, message.optional_int32());
+  EXPECT_TRUE(message.has_default_double());
+  EXPECT_EQ(1.5, message.default_double());
+  EXPECT_TRUE(message.optional_bool());
+  EXPECT_EQ(unittest::TestAllTypes::BAZ, message.default_nested_enum());
+  EXPECT_EQ("foo", message.default_string());
+  EXPECT_TRUE(message.has_optional_nested_message());
+  EXPECT_EQ(message.mutable_optional_nested_message(), sub_message);
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorsOneof) {
+  unittest::TestOneof2 message;
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  FieldAccessor<int32> int_accessor =
+      reflection->GetAccessor<int32>(descriptor->FindFieldByName("foo_int"));
+  FieldAccessor<string> string_accessor = reflection->GetAccessor<string>(
+      descriptor->FindFieldByName("foo_string"));
+  FieldAccessor<Message> message_accessor = reflection->GetAccessor<Message>(
+      descriptor->FindFieldByName("foo_message"));
+
+  EXPECT_FALSE(int_accessor.Has(message));
+  EXPECT_EQ(0, int_accessor.Get(message));
+
+  message.set_foo_string("foo");
+  EXPECT_FALSE(int_accessor.Has(message));
+  EXPECT_EQ(0, int_accessor.Get(message));
+  EXPECT_TRUE(string_accessor.Has(message));
+  EXPECT_EQ("foo", string_accessor.Get(message));
+
+  // Setting another member of the oneof clears the string.
+  int_accessor.Set(&message, 123);
+  EXPECT_TRUE(message.has_foo_int());
+  EXPECT_EQ(123, int_accessor.Get(message));
+  EXPECT_FALSE(string_accessor.Has(message));
+  EXPECT_EQ("", string_accessor.Get(message));
+  EXPECT_FALSE(message_accessor.Has(message));
+  EXPECT_EQ(&unittest::TestOneof2::NestedMessage::default_instance(),
+            &message_accessor.Get(message));
+
+  message_accessor.Mutable(&message);
+  EXPECT_TRUE(message.has_foo_message());
+  EXPECT_FALSE(int_accessor.Has(message));
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorsExtensions) {
+  // Extensions are not stored at a fixed offset, so these go through the
+  // regular reflection methods.
+  unittest::TestAllExtensions message;
+  const FieldDescriptor* extension =
+      message.GetDescriptor()->file()->FindExtensionByName(
+          "optional_int32_extension");
+  ASSERT_TRUE(extension != NULL);
+  FieldAccessor<int32> accessor =
+      message.GetReflection()->GetAccessor<int32>(extension);
+  EXPECT_FALSE(accessor.Has(message));
+  accessor.Set(&message, 5);
+  EXPECT_TRUE(accessor.Has(message));
+  EXPECT_EQ(5, accessor.Get(message));
+  EXPECT_EQ(5, message.GetExtension(unittest::optional_int32_extension));
+}
+
+TEST(GeneratedMessageReflectionTest, FieldAccessorsNoFieldPresence) {
+  proto2_nofieldpresence_unittest::TestAllTypes message;
+  const Reflection* reflection = message.GetReflection();
+  const Descriptor* descriptor = message.GetDescriptor();
+  FieldAccessor<int32> int32_accessor = reflection->GetAccessor<int32>(
+      descriptor->FindFieldByName("optional_int32"));
+  FieldAccessor<string> string_accessor = reflection->GetAccessor<string>(
+      descriptor->FindFieldByName("optional_string"));
+  FieldAccessor<Message> message_accessor = reflection->GetAccessor<Message>(
+      descriptor->FindFieldByName("optional_nested_message"));
+
+  // Without has-bits, scalars are present when they are non-zero.
+  EXPECT_FALSE(int32_accessor.Has(message));
+  int32_accessor.Set(&message, 7);
+  EXPECT_TRUE(int32_accessor.Has(message));
+  EXPECT_EQ(7, message.optional_int32());
+  int32_accessor.Set(&message, 0);
+  EXPECT_FALSE(int32_accessor.Has(message));
+
+  EXPECT_FALSE(string_accessor.Has(message));
+  string_accessor.Set(&message, "foo");
+  EXPECT_TRUE(string_accessor.Has(message));
+  EXPECT_EQ("foo", string_accessor.Get(message));
+
+  EXPECT_FALSE(message_accessor.Has(message));
+  EXPECT_FALSE(message_accessor.Has(message.default_instance()));
+  message_accessor.Mutable(&message);
+  EXPECT_TRUE(message_accessor.Has(message));
+  EXPECT_TRUE(message.has_optional_nested_message());
+}
+
+// Records the numbers of the fields it visits.
+class FieldNumberRecorder : public Reflection::FieldVisitor {
+ public:
+  void Visit(const FieldDescriptor* field) {
+    numbers.push_back(field->number());
+  }
+  vector<int> numbers;
+};
+
+TEST(GeneratedMessageReflectionTest, VisitFields) {
+  // Fields are declared out of order and extensions interleave with them.
+  unittest::TestFieldOrderings message;
+  const Reflection* reflection = message.GetReflection();
+  FieldNumberRecorder empty;
+  reflection->VisitFields(message, &empty);
+  EXPECT_TRUE(empty.numbers.empty());
+
+  TestUtil::SetAllFieldsAndExtensions(&message);
+  message.mutable_optional_nested_message()->set_bb(1);
+  FieldNumberRecorder recorder;
+  reflection->VisitFields(message, &recorder);
+  const int kExpected[] = {1, 5, 11, 50, 101, 200};
+  ASSERT_EQ(GOOGLE_ARRAYSIZE(kExpected), recorder.numbers.size());
+  for (int i = 0; i < GOOGLE_ARRAYSIZE(kExpected); i++) {
+    EXPECT_EQ(kExpected[i], recorder.numbers[i]);
+  }
+
+  // Cleared fields and extensions are skipped.
+  message.clear_my_int();
+  message.ClearExtension(unittest::my_extension_string);
+  vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  FieldNumberRecorder cleared;
+  reflection->VisitFields(message, &cleared);
+  ASSERT_EQ(fields.size(), cleared.numbers.size());
+  for (int i = 0; i < fields.size(); i++) {
+    EXPECT_EQ(fields[i]->number(), cleared.numbers[i]);
+  }
+  EXPECT_EQ(4, fields.size());
+}
+
+TEST(GeneratedMessageReflectionTest, VisitFieldsAllTypes) {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  const Reflection* reflection = message.GetReflection();
+  vector<const FieldDescriptor*> fields;
+  reflection->ListFields(message, &fields);
+  FieldNumberRecorder recorder;
+  reflection->VisitFields(message, &recorder);
+  ASSERT_EQ(fields.size(), recorder.numbers.size());
+  for (int i = 0; i < fields.size(); i++) {
+    EXPECT_EQ(fields[i]->number(), recorder.numbers[i]);
+    if (i > 0) {
+      EXPECT_LT(recorder.numbers[i - 1], recorder.numbers[i]);
+    }
+  }
+}
+
 #ifdef PROTOBUF_HAS_DEATH_TEST
 
 TEST(GeneratedMessageReflectionTest, UsageErrors) {
@@ -36,6 +36,13 @@
 
 #include <limits>
 
+#include <google/protobuf/arenastring.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/message_lite.h>
+#include <google/protobuf/repeated_field.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/wire_format_lite_inl.h>
+
 
 namespace google {
 namespace protobuf {
@@ -60,6 +67,904 @@ void InitEmptyString() {
   OnShutdown(&DeleteEmptyString);
 }
 
+// ===================================================================
+// TableDrivenMessage
+
+void TableField::Set(uint32 tag_value, int type_value, int flags_value,
+                     int offset_value, int has_bit_value) {
+  tag = tag_value;
+  offset = offset_value;
+  has_bit = has_bit_value;
+  type = static_cast<uint8>(type_value);
+  flags = static_cast<uint8>(flags_value);
+  tag_size = static_cast<uint8>(io::CodedOutputStream::VarintSize32(tag_value));
+  aux.message_default = NULL;
+  full_name = NULL;
+}
+
+namespace {
+
+template <typename Type>
+inline Type* Raw(MessageLite* message, uint32 offset) {
+  return reinterpret_cast<Type*>(reinterpret_cast<char*>(message) + offset);
+}
+
+template <typename Type>
+inline const Type* Raw(const MessageLite* message, uint32 offset) {
+  return reinterpret_cast<const Type*>(
+      reinterpret_cast<const char*>(message) + offset);
+}
+
+inline bool HasBit(const uint32* has_bits, int index) {
+  return (has_bits[index / 32] & (static_cast<uint32>(1) << (index % 32))) != 0;
+}
+
+inline void SetHasBit(uint32* has_bits, int index) {
+  has_bits[index / 32] |= static_cast<uint32>(1) << (index % 32);
+}
+
+// Returns the index of the field with the given number, or -1.  Fields
+// usually appear in field number order, but often with some fields missing,
+// so the fields following |next| are checked before searching the table.
+int FindField(const MessageTable& table, int number, int next) {
+  const int kMaxScan = 8;
+  int lo = 0;
+  int hi = table.num_fields;
+  if (next == 0 ||
+      WireFormatLite::GetTagFieldNumber(table.fields[next - 1].tag) < number) {
+    for (lo = next; lo < hi && lo < next + kMaxScan; lo++) {
+      int lo_number = WireFormatLite::GetTagFieldNumber(table.fields[lo].tag);
+      if (lo_number >= number) {
+        return lo_number == number ? lo : -1;
+      }
+    }
+  } else {
+    hi = next;
+  }
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    int mid_number = WireFormatLite::GetTagFieldNumber(table.fields[mid].tag);
+    if (mid_number < number) {
+      lo = mid + 1;
+    } else if (mid_number > number) {
+      hi = mid;
+    } else {
+      return mid;
+    }
+  }
+  return -1;
+}
+
+// Returns true if |tag| is the packed encoding of a repeated primitive field
+// declared unpacked, or vice versa.  Both must be accepted by the parser.
+bool IsAlternateEncoding(const TableField& field, uint32 tag) {
+  if ((field.flags & TableField::kRepeated) == 0) return false;
+  WireFormatLite::FieldType type =
+      static_cast<WireFormatLite::FieldType>(field.type);
+  WireFormatLite::WireType wire_type =
+      WireFormatLite::WireTypeForFieldType(type);
+  if (wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+      wire_type == WireFormatLite::WIRETYPE_START_GROUP) {
+    return false;
+  }
+  WireFormatLite::WireType expected =
+      (field.flags & TableField::kPacked) != 0 ?
+      wire_type : WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+  return WireFormatLite::GetTagWireType(tag) == expected;
+}
+
+// Returns true if |value| may be stored in the enum field.
+inline bool IsValidEnumValue(const TableField& field, int value) {
+  if (field.flags & TableField::kEnumValueList) {
+    return SortedArrayContains(field.aux.enum_values + 1,
+                               field.aux.enum_values[0], value);
+  }
+  return field.aux.enum_is_valid == NULL || field.aux.enum_is_valid(value);
+}
+
+// Like WireFormatLite::ReadPackedEnumNoInline(), for fields with
+// kEnumValueList.
+bool ReadPackedEnumValueList(io::CodedInputStream* input,
+                             const TableField& field,
+                             RepeatedField<int>* values) {
+  uint32 length;
+  if (!input->ReadVarint32(&length)) return false;
+  io::CodedInputStream::Limit limit = input->PushLimit(length);
+  while (input->BytesUntilLimit() > 0) {
+    int value;
+    if (!WireFormatLite::ReadPrimitive<int, WireFormatLite::TYPE_ENUM>(
+            input, &value)) {
+      return false;
+    }
+    if (IsValidEnumValue(field, value)) values->Add(value);
+  }
+  input->PopLimit(limit);
+  return true;
+}
+
+// Hands an enum value which its field's type does not define to the
+// message's parse_unusual function, which stores it with the unknown fields
+// exactly as if the field were not known at all.
+bool ParseUnknownEnumValue(MessageLite* message, const MessageTable& table,
+                           uint32 tag, int value) {
+  uint8 buffer[10];
+  uint8* end = io::CodedOutputStream::WriteVarint64ToArray(
+      static_cast<uint64>(static_cast<int64>(value)), buffer);
+  io::CodedInputStream input(buffer, end - buffer);
+  return table.parse_unusual(message, tag, &input);
+}
+
+}  // namespace
+
+bool TableDrivenMessage::MergePartialFromCodedStream(
+    MessageLite* message, const MessageTable& table,
+    io::CodedInputStream* input) {
+  const TableField* const fields = table.fields;
+  const int num_fields = table.num_fields;
+  uint32* const has_bits = table.has_bits_offset < 0 ? NULL :
+      Raw<uint32>(message, table.has_bits_offset);
+  Arena* const arena = message->GetArena();
+
+  // Fields are normally written in field number order, so the field after
+  // the previous one is checked before searching the table.
+  int next = 0;
+  for (;;) {
+    const uint32 tag = input->ReadTag();
+    int index;
+    if (GOOGLE_PREDICT_TRUE(next < num_fields && fields[next].tag == tag)) {
+      index = next;
+    } else {
+      // If tag is 0 or an end-group tag then this must be the end of the
+      // message.
+      if (tag == 0 || WireFormatLite::GetTagWireType(tag) ==
+                          WireFormatLite::WIRETYPE_END_GROUP) {
+        return true;
+      }
+      index = FindField(table, WireFormatLite::GetTagFieldNumber(tag), next);
+      if (index < 0 || (fields[index].tag != tag &&
+                        !IsAlternateEncoding(fields[index], tag))) {
+        if (!table.parse_unusual(message, tag, input)) return false;
+        continue;
+      }
+    }
+    next = index + 1;
+
+    const TableField& field = fields[index];
+    const uint32 offset = field.offset;
+
+    if ((field.flags & TableField::kRepeated) == 0) {
+      switch (field.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE)                                          \
+        case WireFormatLite::TYPE_##TYPE:                                   \
+          if (!WireFormatLite::ReadPrimitive<                               \
+                  CPPTYPE, WireFormatLite::TYPE_##TYPE>(                    \
+                  input, Raw<CPPTYPE>(message, offset))) {                  \
+            return false;                                                   \
+          }                                                                 \
+          break;
+
+        HANDLE_TYPE(INT32, int32)
+        HANDLE_TYPE(INT64, int64)
+        HANDLE_TYPE(UINT32, uint32)
+        HANDLE_TYPE(UINT64, uint64)
+        HANDLE_TYPE(SINT32, int32)
+        HANDLE_TYPE(SINT64, int64)
+        HANDLE_TYPE(FIXED32, uint32)
+        HANDLE_TYPE(FIXED64, uint64)
+        HANDLE_TYPE(SFIXED32, int32)
+        HANDLE_TYPE(SFIXED64, int64)
+        HANDLE_TYPE(FLOAT, float)
+        HANDLE_TYPE(DOUBLE, double)
+        HANDLE_TYPE(BOOL, bool)
+#undef HANDLE_TYPE
+
+        case WireFormatLite::TYPE_ENUM: {
+          int value;
+          if (!WireFormatLite::ReadPrimitive<int, WireFormatLite::TYPE_ENUM>(
+                  input, &value)) {
+            return false;
+          }
+          if (!IsValidEnumValue(field, value)) {
+            if (!ParseUnknownEnumValue(message, table, tag, value)) {
+              return false;
+            }
+            continue;  // The has-bit stays as it was.
+          }
+          *Raw<int>(message, offset) = value;
+          break;
+        }
+
+        case WireFormatLite::TYPE_STRING:
+        case WireFormatLite::TYPE_BYTES: {
+          if (field.has_bit >= 0) SetHasBit(has_bits, field.has_bit);
+          string* value = Raw<ArenaStringPtr>(message, offset)->Mutable(
+              field.aux.string_default, arena);
+          if (!WireFormatLite::ReadBytes(input, value)) return false;
+          if (field.flags & TableField::kVerifyUtf8) {
+            table.verify_utf8(value->data(), value->size(), true,
+                              field.full_name);
+          }
+          continue;
+        }
+
+        case WireFormatLite::TYPE_MESSAGE:
+        case WireFormatLite::TYPE_GROUP: {
+          if (field.has_bit >= 0) SetHasBit(has_bits, field.has_bit);
+          MessageLite** value = Raw<MessageLite*>(message, offset);
+          if (*value == NULL) *value = field.aux.message_default->New(arena);
+          if (field.type == WireFormatLite::TYPE_MESSAGE) {
+            if (!WireFormatLite::ReadMessage(input, *value)) return false;
+          } else {
+            if (!WireFormatLite::ReadGroup(
+                    WireFormatLite::GetTagFieldNumber(tag), input, *value)) {
+              return false;
+            }
+          }
+          continue;
+        }
+
+        default:
+          GOOGLE_LOG(FATAL) << "Invalid field type in message table: "
+                     << static_cast<int>(field.type);
+          return false;
+      }
+      if (field.has_bit >= 0) SetHasBit(has_bits, field.has_bit);
+      continue;
+    }
+
+    // Repeated fields.
+    const bool packed = WireFormatLite::GetTagWireType(tag) ==
+                        WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+    switch (field.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE)                                          \
+      case WireFormatLite::TYPE_##TYPE: {                                   \
+        RepeatedField<CPPTYPE>* values =                                    \
+            Raw<RepeatedField<CPPTYPE> >(message, offset);                  \
+        if (packed ?                                                        \
+            !WireFormatLite::ReadPackedPrimitive<                           \
+                CPPTYPE, WireFormatLite::TYPE_##TYPE>(input, values) :      \
+            !WireFormatLite::ReadRepeatedPrimitive<                         \
+                CPPTYPE, WireFormatLite::TYPE_##TYPE>(                      \
+                io::CodedOutputStream::VarintSize32(tag), tag, input,       \
+                values)) {                                                  \
+          return false;                                                     \
+        }                                                                   \
+        break;                                                              \
+      }
+
+      HANDLE_TYPE(INT32, int32)
+      HANDLE_TYPE(INT64, int64)
+      HANDLE_TYPE(UINT32, uint32)
+      HANDLE_TYPE(UINT64, uint64)
+      HANDLE_TYPE(SINT32, int32)
+      HANDLE_TYPE(SINT64, int64)
+      HANDLE_TYPE(FIXED32, uint32)
+      HANDLE_TYPE(FIXED64, uint64)
+      HANDLE_TYPE(SFIXED32, int32)
+      HANDLE_TYPE(SFIXED64, int64)
+      HANDLE_TYPE(FLOAT, float)
+      HANDLE_TYPE(DOUBLE, double)
+      HANDLE_TYPE(BOOL, bool)
+#undef HANDLE_TYPE
+
+      case WireFormatLite::TYPE_ENUM: {
+        RepeatedField<int>* values = Raw<RepeatedField<int> >(message, offset);
+        if (packed) {
+          if (field.flags & TableField::kEnumValueList ?
+              !ReadPackedEnumValueList(input, field, values) :
+              !WireFormatLite::ReadPackedEnumNoInline(
+                  input, field.aux.enum_is_valid, values)) {
+            return false;
+          }
+          break;
+        }
+        do {
+          int value;
+          if (!WireFormatLite::ReadPrimitive<int, WireFormatLite::TYPE_ENUM>(
+                  input, &value)) {
+            return false;
+          }
+          if (IsValidEnumValue(field, value)) {
+            values->Add(value);
+          } else if (!ParseUnknownEnumValue(message, table, tag, value)) {
+            return false;
+          }
+        } while (input->ExpectTag(tag));
+        break;
+      }
+
+      case WireFormatLite::TYPE_STRING:
+      case WireFormatLite::TYPE_BYTES: {
+        RepeatedPtrField<string>* values =
+            Raw<RepeatedPtrField<string> >(message, offset);
+        do {
+          string* value = values->Add();
+          if (!WireFormatLite::ReadBytes(input, value)) return false;
+          if (field.flags & TableField::kVerifyUtf8) {
+            table.verify_utf8(value->data(), value->size(), true,
+                              field.full_name);
+          }
+        } while (input->ExpectTag(tag));
+        break;
+      }
+
+      case WireFormatLite::TYPE_MESSAGE:
+      case WireFormatLite::TYPE_GROUP: {
+        RepeatedPtrFieldBase* values =
+            Raw<RepeatedPtrFieldBase>(message, offset);
+        do {
+          MessageLite* value =
+              values->AddFromCleared<GenericTypeHandler<MessageLite> >();
+          if (value == NULL) {
+            value = field.aux.message_default->New(arena);
+            values->UnsafeArenaAddAllocated<GenericTypeHandler<MessageLite> >(
+                value);
+          }
+          if (field.type == WireFormatLite::TYPE_MESSAGE) {
+            if (!WireFormatLite::ReadMessage(input, value)) return false;
+          } else {
+            if (!WireFormatLite::ReadGroup(
+                    WireFormatLite::GetTagFieldNumber(tag), input, value)) {
+              return false;
+            }
+          }
+        } while (input->ExpectTag(tag));
+        break;
+      }
+
+      default:
+        GOOGLE_LOG(FATAL) << "Invalid field type in message table: "
+                   << static_cast<int>(field.type);
+        return false;
+    }
+  }
+}
+
+
+// -------------------------------------------------------------------
+// Serialization
+
+#ifndef _MSC_VER
+const int TableDrivenMessage::kFieldNumberEnd;
+#endif
+
+namespace {
+
+inline int FieldNumber(const TableField& field) {
+  return WireFormatLite::GetTagFieldNumber(field.tag);
+}
+
+// Returns true if a singular field which has no has-bit (because its file
+// does not have field presence) has a value other than the default, and so
+// must be serialized.
+bool HasNonDefaultValue(const MessageLite& message, const MessageTable& table,
+                        const TableField& field) {
+  const MessageLite* const m = &message;
+  switch (field.type) {
+    case WireFormatLite::TYPE_INT32:
+    case WireFormatLite::TYPE_UINT32:
+    case WireFormatLite::TYPE_SINT32:
+    case WireFormatLite::TYPE_FIXED32:
+    case WireFormatLite::TYPE_SFIXED32:
+    case WireFormatLite::TYPE_ENUM:
+      return *Raw<uint32>(m, field.offset) != 0;
+    case WireFormatLite::TYPE_INT64:
+    case WireFormatLite::TYPE_UINT64:
+    case WireFormatLite::TYPE_SINT64:
+    case WireFormatLite::TYPE_FIXED64:
+    case WireFormatLite::TYPE_SFIXED64:
+      return *Raw<uint64>(m, field.offset) != 0;
+    case WireFormatLite::TYPE_FLOAT:
+      return *Raw<float>(m, field.offset) != 0;
+    case WireFormatLite::TYPE_DOUBLE:
+      return *Raw<double>(m, field.offset) != 0;
+    case WireFormatLite::TYPE_BOOL:
+      return *Raw<bool>(m, field.offset);
+    case WireFormatLite::TYPE_STRING:
+    case WireFormatLite::TYPE_BYTES:
+      return !Raw<ArenaStringPtr>(m, field.offset)->Get(
+          field.aux.string_default).empty();
+    case WireFormatLite::TYPE_MESSAGE:
+    case WireFormatLite::TYPE_GROUP:
+      return m != table.default_instance &&
+             *Raw<const MessageLite*>(m, field.offset) != NULL;
+  }
+  return false;
+}
+
+// Returns true if a singular field must be serialized.
+inline bool IsPresent(const MessageLite& message, const MessageTable& table,
+                      const uint32* has_bits, const TableField& field) {
+  return field.has_bit >= 0 ? HasBit(has_bits, field.has_bit) :
+                              HasNonDefaultValue(message, table, field);
+}
+
+// Returns the value of a singular message field.  The field's pointer may be
+// NULL even if its has-bit is set.
+inline const MessageLite& GetMessage(const MessageLite& message,
+                                     const TableField& field) {
+  const MessageLite* value = *Raw<const MessageLite*>(&message, field.offset);
+  return value != NULL ? *value : *field.aux.message_default;
+}
+
+// The Writers let TableDrivenMessage::Serialize() implement both
+// SerializeWithCachedSizes() and SerializeWithCachedSizesToArray().  Each
+// method writes a value and returns the new output position.
+
+// Writes to a CodedOutputStream.
+struct StreamWriter {
+  typedef io::CodedOutputStream* Output;
+
+  static inline Output WriteTag(uint32 tag, Output output) {
+    output->WriteTag(tag);
+    return output;
+  }
+  static inline Output WriteVarint32(uint32 value, Output output) {
+    output->WriteVarint32(value);
+    return output;
+  }
+
+#define WRITE_NO_TAG(NAME, CPPTYPE)                                         \
+  static inline Output Write##NAME##NoTag(CPPTYPE value, Output output) {   \
+    WireFormatLite::Write##NAME##NoTag(value, output);                      \
+    return output;                                                          \
+  }
+
+  WRITE_NO_TAG(Int32, int32)
+  WRITE_NO_TAG(Int64, int64)
+  WRITE_NO_TAG(UInt32, uint32)
+  WRITE_NO_TAG(UInt64, uint64)
+  WRITE_NO_TAG(SInt32, int32)
+  WRITE_NO_TAG(SInt64, int64)
+  WRITE_NO_TAG(Fixed32, uint32)
+  WRITE_NO_TAG(Fixed64, uint64)
+  WRITE_NO_TAG(SFixed32, int32)
+  WRITE_NO_TAG(SFixed64, int64)
+  WRITE_NO_TAG(Float, float)
+  WRITE_NO_TAG(Double, double)
+  WRITE_NO_TAG(Bool, bool)
+  WRITE_NO_TAG(Enum, int)
+#undef WRITE_NO_TAG
+
+  static inline Output WriteStringNoTag(const string& value, Output output) {
+    GOOGLE_CHECK(value.size() <= kint32max);
+    output->WriteVarint32(value.size());
+    output->WriteRawMaybeAliased(value.data(), value.size());
+    return output;
+  }
+  // Like WireFormatLite::WriteMessageMaybeToArray(), without the tag.
+  static inline Output WriteMessageNoTag(const MessageLite& value,
+                                         Output output) {
+    const int size = value.GetCachedSize();
+    output->WriteVarint32(size);
+    return WriteGroupNoTag(value, output);
+  }
+  static inline Output WriteGroupNoTag(const MessageLite& value,
+                                       Output output) {
+    const int size = value.GetCachedSize();
+    uint8* target = output->GetDirectBufferForNBytesAndAdvance(size);
+    if (target != NULL) {
+      uint8* end = value.SerializeWithCachedSizesToArray(target);
+      GOOGLE_DCHECK_EQ(end - target, size);
+    } else {
+      value.SerializeWithCachedSizes(output);
+    }
+    return output;
+  }
+  static inline Output SerializeUnusual(const MessageLite& message,
+                                        const MessageTable& table,
+                                        int end, Output output) {
+    table.serialize_unusual(&message, end, output);
+    return output;
+  }
+};
+
+// Writes to a flat array which is known to be large enough.
+struct ArrayWriter {
+  typedef uint8* Output;
+
+  static inline Output WriteTag(uint32 tag, Output target) {
+    return io::CodedOutputStream::WriteTagToArray(tag, target);
+  }
+  static inline Output WriteVarint32(uint32 value, Output target) {
+    return io::CodedOutputStream::WriteVarint32ToArray(value, target);
+  }
+
+#define WRITE_NO_TAG(NAME, CPPTYPE)                                         \
+  static inline Output Write##NAME##NoTag(CPPTYPE value, Output target) {   \
+    return WireFormatLite::Write##NAME##NoTagToArray(value, target);        \
+  }
+
+  WRITE_NO_TAG(Int32, int32)
+  WRITE_NO_TAG(Int64, int64)
+  WRITE_NO_TAG(UInt32, uint32)
+  WRITE_NO_TAG(UInt64, uint64)
+  WRITE_NO_TAG(SInt32, int32)
+  WRITE_NO_TAG(SInt64, int64)
+  WRITE_NO_TAG(Fixed32, uint32)
+  WRITE_NO_TAG(Fixed64, uint64)
+  WRITE_NO_TAG(SFixed32, int32)
+  WRITE_NO_TAG(SFixed64, int64)
+  WRITE_NO_TAG(Float, float)
+  WRITE_NO_TAG(Double, double)
+  WRITE_NO_TAG(Bool, bool)
+  WRITE_NO_TAG(Enum, int)
+#undef WRITE_NO_TAG
+
+  static inline Output WriteStringNoTag(const string& value, Output target) {
+    return io::CodedOutputStream::WriteStringWithSizeToArray(value, target);
+  }
+  static inline Output WriteMessageNoTag(const MessageLite& value,
+                                         Output target) {
+    target = io::CodedOutputStream::WriteVarint32ToArray(
+        value.GetCachedSize(), target);
+    return value.SerializeWithCachedSizesToArray(target);
+  }
+  static inline Output WriteGroupNoTag(const MessageLite& value,
+                                       Output target) {
+    return value.SerializeWithCachedSizesToArray(target);
+  }
+  static inline Output SerializeUnusual(const MessageLite& message,
+                                        const MessageTable& table,
+                                        int end, Output target) {
+    return table.serialize_unusual_to_array(&message, end, target);
+  }
+};
+
+// Serializes a singular field which is known to be present.
+template <typename Writer>
+typename Writer::Output SerializeSingularField(
+    const MessageLite& message, const MessageTable& table,
+    const TableField& field, typename Writer::Output output) {
+  const uint32 offset = field.offset;
+  output = Writer::WriteTag(field.tag, output);
+  switch (field.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, NAME)                                    \
+    case WireFormatLite::TYPE_##TYPE:                                       \
+      return Writer::Write##NAME##NoTag(*Raw<CPPTYPE>(&message, offset),    \
+                                        output);
+
+    HANDLE_TYPE(INT32, int32, Int32)
+    HANDLE_TYPE(INT64, int64, Int64)
+    HANDLE_TYPE(UINT32, uint32, UInt32)
+    HANDLE_TYPE(UINT64, uint64, UInt64)
+    HANDLE_TYPE(SINT32, int32, SInt32)
+    HANDLE_TYPE(SINT64, int64, SInt64)
+    HANDLE_TYPE(FIXED32, uint32, Fixed32)
+    HANDLE_TYPE(FIXED64, uint64, Fixed64)
+    HANDLE_TYPE(SFIXED32, int32, SFixed32)
+    HANDLE_TYPE(SFIXED64, int64, SFixed64)
+    HANDLE_TYPE(FLOAT, float, Float)
+    HANDLE_TYPE(DOUBLE, double, Double)
+    HANDLE_TYPE(BOOL, bool, Bool)
+    HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+    case WireFormatLite::TYPE_STRING:
+    case WireFormatLite::TYPE_BYTES: {
+      const string& value = Raw<ArenaStringPtr>(&message, offset)->Get(
+          field.aux.string_default);
+      if (field.flags & TableField::kVerifyUtf8) {
+        table.verify_utf8(value.data(), value.size(), false, field.full_name);
+      }
+      return Writer::WriteStringNoTag(value, output);
+    }
+
+    case WireFormatLite::TYPE_MESSAGE:
+      return Writer::WriteMessageNoTag(GetMessage(message, field), output);
+
+    case WireFormatLite::TYPE_GROUP:
+      output = Writer::WriteGroupNoTag(GetMessage(message, field), output);
+      return Writer::WriteTag(
+          WireFormatLite::MakeTag(FieldNumber(field),
+                                  WireFormatLite::WIRETYPE_END_GROUP),
+          output);
+  }
+
+  GOOGLE_LOG(FATAL) << "Invalid field type in message table: "
+             << static_cast<int>(field.type);
+  return output;
+}
+
+// Returns the serialized size of a singular field which is known to be
+// present, including its tag.
+int SingularFieldByteSize(const MessageLite& message,
+                          const TableField& field) {
+  const uint32 offset = field.offset;
+  switch (field.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, NAME)                                    \
+    case WireFormatLite::TYPE_##TYPE:                                       \
+      return field.tag_size +                                               \
+             WireFormatLite::NAME##Size(*Raw<CPPTYPE>(&message, offset));
+#define HANDLE_FIXED_TYPE(TYPE, NAME)                                       \
+    case WireFormatLite::TYPE_##TYPE:                                       \
+      return field.tag_size + WireFormatLite::k##NAME##Size;
+
+    HANDLE_TYPE(INT32, int32, Int32)
+    HANDLE_TYPE(INT64, int64, Int64)
+    HANDLE_TYPE(UINT32, uint32, UInt32)
+    HANDLE_TYPE(UINT64, uint64, UInt64)
+    HANDLE_TYPE(SINT32, int32, SInt32)
+    HANDLE_TYPE(SINT64, int64, SInt64)
+    HANDLE_TYPE(ENUM, int, Enum)
+    HANDLE_FIXED_TYPE(FIXED32, Fixed32)
+    HANDLE_FIXED_TYPE(FIXED64, Fixed64)
+    HANDLE_FIXED_TYPE(SFIXED32, SFixed32)
+    HANDLE_FIXED_TYPE(SFIXED64, SFixed64)
+    HANDLE_FIXED_TYPE(FLOAT, Float)
+    HANDLE_FIXED_TYPE(DOUBLE, Double)
+    HANDLE_FIXED_TYPE(BOOL, Bool)
+#undef HANDLE_FIXED_TYPE
+#undef HANDLE_TYPE
+
+    case WireFormatLite::TYPE_STRING:
+    case WireFormatLite::TYPE_BYTES:
+      return field.tag_size + WireFormatLite::StringSize(
+          Raw<ArenaStringPtr>(&message, offset)->Get(field.aux.string_default));
+
+    case WireFormatLite::TYPE_MESSAGE:
+      return field.tag_size +
+             WireFormatLite::MessageSize(GetMessage(message, field));
+
+    case WireFormatLite::TYPE_GROUP:
+      return 2 * field.tag_size +
+             WireFormatLite::GroupSize(GetMessage(message, field));
+  }
+
+  GOOGLE_LOG(FATAL) << "Invalid field type in message table: "
+             << static_cast<int>(field.type);
+  return 0;
+}
+
+}  // namespace
+
+// Serializes all of the elements of a repeated field.
+template <typename Writer>
+typename Writer::Output TableDrivenMessage::SerializeRepeatedField(
+    const MessageLite& message, const MessageTable& table,
+    const TableField& field, typename Writer::Output output) {
+  const uint32 offset = field.offset;
+  switch (field.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, NAME)                                    \
+    case WireFormatLite::TYPE_##TYPE: {                                     \
+      const RepeatedField<CPPTYPE>& values =                                \
+          *Raw<RepeatedField<CPPTYPE> >(&message, offset);                  \
+      const int size = values.size();                                       \
+      if (field.flags & TableField::kPacked) {                              \
+        if (size == 0) return output;                                       \
+        output = Writer::WriteTag(field.tag, output);                       \
+        output = Writer::WriteVarint32(                                     \
+            *Raw<int>(&message, field.cached_size_offset), output);         \
+        for (int i = 0; i < size; i++) {                                    \
+          output = Writer::Write##NAME##NoTag(values.Get(i), output);       \
+        }                                                                   \
+      } else {                                                              \
+        for (int i = 0; i < size; i++) {                                    \
+          output = Writer::WriteTag(field.tag, output);                     \
+          output = Writer::Write##NAME##NoTag(values.Get(i), output);       \
+        }                                                                   \
+      }                                                                     \
+      return output;                                                        \
+    }
+
+    HANDLE_TYPE(INT32, int32, Int32)
+    HANDLE_TYPE(INT64, int64, Int64)
+    HANDLE_TYPE(UINT32, uint32, UInt32)
+    HANDLE_TYPE(UINT64, uint64, UInt64)
+    HANDLE_TYPE(SINT32, int32, SInt32)
+    HANDLE_TYPE(SINT64, int64, SInt64)
+    HANDLE_TYPE(FIXED32, uint32, Fixed32)
+    HANDLE_TYPE(FIXED64, uint64, Fixed64)
+    HANDLE_TYPE(SFIXED32, int32, SFixed32)
+    HANDLE_TYPE(SFIXED64, int64, SFixed64)
+    HANDLE_TYPE(FLOAT, float, Float)
+    HANDLE_TYPE(DOUBLE, double, Double)
+    HANDLE_TYPE(BOOL, bool, Bool)
+    HANDLE_TYPE(ENUM, int, Enum)
+#undef HANDLE_TYPE
+
+    case WireFormatLite::TYPE_STRING:
+    case WireFormatLite::TYPE_BYTES: {
+      const RepeatedPtrField<string>& values =
+          *Raw<RepeatedPtrField<string> >(&message, offset);
+      for (int i = 0; i < values.size(); i++) {
+        const string& value = values.Get(i);
+        if (field.flags & TableField::kVerifyUtf8) {
+          table.verify_utf8(value.data(), value.size(), false,
+                            field.full_name);
+        }
+        output = Writer::WriteTag(field.tag, output);
+        output = Writer::WriteStringNoTag(value, output);
+      }
+      return output;
+    }
+
+    case WireFormatLite::TYPE_MESSAGE:
+    case WireFormatLite::TYPE_GROUP: {
+      const RepeatedPtrFieldBase& values =
+          *Raw<RepeatedPtrFieldBase>(&message, offset);
+      const uint32 end_tag = WireFormatLite::MakeTag(
+          FieldNumber(field), WireFormatLite::WIRETYPE_END_GROUP);
+      for (int i = 0; i < values.size(); i++) {
+        const MessageLite& value =
+            values.Get<GenericTypeHandler<MessageLite> >(i);
+        output = Writer::WriteTag(field.tag, output);
+        if (field.type == WireFormatLite::TYPE_MESSAGE) {
+          output = Writer::WriteMessageNoTag(value, output);
+        } else {
+          output = Writer::WriteGroupNoTag(value, output);
+          output = Writer::WriteTag(end_tag, output);
+        }
+      }
+      return output;
+    }
+  }
+
+  GOOGLE_LOG(FATAL) << "Invalid field type in message table: "
+             << static_cast<int>(field.type);
+  return output;
+}
+
+// Returns the serialized size of a repeated field, including tags.  Also
+// caches the data size of packed fields for serialization.
+int TableDrivenMessage::RepeatedFieldByteSize(const MessageLite& message,
+                                              const TableField& field) {
+  const uint32 offset = field.offset;
+  int count = 0;
+  int data_size = 0;
+  switch (field.type) {
+#define HANDLE_TYPE(TYPE, CPPTYPE, NAME)                                    \
+    case WireFormatLite::TYPE_##TYPE: {                                     \
+      const RepeatedField<CPPTYPE>& values =                                \
+          *Raw<RepeatedField<CPPTYPE> >(&message, offset);                  \
+      count = values.size();                                                \
+      for (int i = 0; i < count; i++) {                                     \
+        data_size += WireFormatLite::NAME##Size(values.Get(i));             \
+      }                                                                     \
+      break;                                                                \
+    }
+#define HANDLE_FIXED_TYPE(TYPE, CPPTYPE, NAME)                              \
+    case WireFormatLite::TYPE_##TYPE:                                       \
+      count = Raw<RepeatedField<CPPTYPE> >(&message, offset)->size();       \
+      data_size = WireFormatLite::k##NAME##Size * count;                    \
+      break;
+
+    HANDLE_TYPE(INT32, int32, Int32)
+    HANDLE_TYPE(INT64, int64, Int64)
+    HANDLE_TYPE(UINT32, uint32, UInt32)
+    HANDLE_TYPE(UINT64, uint64, UInt64)
+    HANDLE_TYPE(SINT32, int32, SInt32)
+    HANDLE_TYPE(SINT64, int64, SInt64)
+    HANDLE_TYPE(ENUM, int, Enum)
+    HANDLE_FIXED_TYPE(FIXED32, uint32, Fixed32)
+    HANDLE_FIXED_TYPE(FIXED64, uint64, Fixed64)
+    HANDLE_FIXED_TYPE(SFIXED32, int32, SFixed32)
+    HANDLE_FIXED_TYPE(SFIXED64, int64, SFixed64)
+    HANDLE_FIXED_TYPE(FLOAT, float, Float)
+    HANDLE_FIXED_TYPE(DOUBLE, double, Double)
+    HANDLE_FIXED_TYPE(BOOL, bool, Bool)
+#undef HANDLE_FIXED_TYPE
+#undef HANDLE_TYPE
+
+    case WireFormatLite::TYPE_STRING:
+    case WireFormatLite::TYPE_BYTES: {
+      const RepeatedPtrField<string>& values =
+          *Raw<RepeatedPtrField<string> >(&message, offset);
+      count = values.size();
+      for (int i = 0; i < count; i++) {
+        data_size += WireFormatLite::StringSize(values.Get(i));
+      }
+      break;
+    }
+
+    case WireFormatLite::TYPE_MESSAGE:
+    case WireFormatLite::TYPE_GROUP: {
+      const RepeatedPtrFieldBase& values =
+          *Raw<RepeatedPtrFieldBase>(&message, offset);
+      count = values.size();
+      for (int i = 0; i < count; i++) {
+        const MessageLite& value =
+            values.Get<GenericTypeHandler<MessageLite> >(i);
+        data_size += field.type == WireFormatLite::TYPE_MESSAGE ?
+            WireFormatLite::MessageSize(value) :
+            WireFormatLite::GroupSize(value) + field.tag_size;
+      }
+      break;
+    }
+
+    default:
+      GOOGLE_LOG(FATAL) << "Invalid field type in message table: "
+                 << static_cast<int>(field.type);
+  }
+
+  if (field.flags & TableField::kPacked) {
+    GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+    *Raw<int>(const_cast<MessageLite*>(&message), field.cached_size_offset) =
+        data_size;
+    GOOGLE_SAFE_CONCURRENT_WRITES_END();
+    if (data_size == 0) return 0;
+    return field.tag_size + WireFormatLite::Int32Size(data_size) + data_size;
+  }
+  return field.tag_size * count + data_size;
+}
+
+template <typename Writer>
+typename Writer::Output TableDrivenMessage::Serialize(
+    const MessageLite& message, const MessageTable& table,
+    typename Writer::Output output) {
+  const TableField* const fields = table.fields;
+  const uint32* const has_bits = table.has_bits_offset < 0 ? NULL :
+      Raw<uint32>(&message, table.has_bits_offset);
+
+  // Fields must be written in order, so unlike ByteSize(), this checks every
+  // field rather than only those whose has-bits are set.  That turned out to
+  // be faster than first collecting the present fields.
+  for (int i = 0; i < table.num_fields; i++) {
+    const TableField& field = fields[i];
+    if (field.flags & TableField::kUnusualBefore) {
+      output = Writer::SerializeUnusual(message, table, FieldNumber(field),
+                                        output);
+    }
+    if (field.flags & TableField::kRepeated) {
+      output = SerializeRepeatedField<Writer>(message, table, field, output);
+    } else if (IsPresent(message, table, has_bits, field)) {
+      output = SerializeSingularField<Writer>(message, table, field, output);
+    }
+  }
+
+  // serialize_unusual_to_array is set whenever serialize_unusual is and the
+  // message supports serializing to arrays.
+  if (table.serialize_unusual != NULL) {
+    output = Writer::SerializeUnusual(message, table, kFieldNumberEnd, output);
+  }
+  return output;
+}
+
+void TableDrivenMessage::SerializeWithCachedSizes(
+    const MessageLite& message, const MessageTable& table,
+    io::CodedOutputStream* output) {
+  Serialize<StreamWriter>(message, table, output);
+}
+
+uint8* TableDrivenMessage::SerializeWithCachedSizesToArray(
+    const MessageLite& message, const MessageTable& table, uint8* target) {
+  return Serialize<ArrayWriter>(message, table, target);
+}
+
+int TableDrivenMessage::ByteSize(const MessageLite& message,
+                                 const MessageTable& table) {
+  const TableField* const fields = table.fields;
+  const uint32* const has_bits = table.has_bits_offset < 0 ? NULL :
+      Raw<uint32>(&message, table.has_bits_offset);
+
+  // Order does not matter here, so fields with has-bits are found directly
+  // from the set bits.
+  int total_size = 0;
+  const int num_has_bit_words = (table.num_has_bits + 31) / 32;
+  for (int i = 0; i < num_has_bit_words; i++) {
+    for (uint32 bits = has_bits[i]; bits != 0; bits &= bits - 1) {
+      const int index =
+          table.field_by_has_bit[i * 32 + CountTrailingZeros32(bits)];
+      if (index >= 0) {
+        total_size += SingularFieldByteSize(message, fields[index]);
+      }
+    }
+  }
+
+  for (int i = 0; i < table.num_always_visit; i++) {
+    const TableField& field = fields[table.always_visit[i]];
+    if (field.flags & TableField::kRepeated) {
+      total_size += RepeatedFieldByteSize(message, field);
+    } else if (HasNonDefaultValue(message, table, field)) {
+      total_size += SingularFieldByteSize(message, field);
+    }
+  }
+
+  if (table.unusual_byte_size != NULL) {
+    total_size += table.unusual_byte_size(&message);
+  }
+  return total_size;
+}
 
 }  // namespace internal
 }  // namespace protobuf
@@ -47,6 +47,13 @@
 namespace google {
 
 namespace protobuf {
+
+class MessageLite;
+namespace io {
+class CodedInputStream;
+class CodedOutputStream;
+}  // namespace io
+
 namespace internal {
 
 
@@ -106,6 +113,202 @@ template <class Type> bool AllAreInitialized(const Type& t) {
   return true;
 }
 
+// Returns the index of the lowest set bit of n, which must not be zero.
+// Generated MergeFrom() and SerializeWithCachedSizes() use this to visit
+// only the fields whose has-bits are set.
+inline int CountTrailingZeros32(uint32 n) {
+  GOOGLE_DCHECK_NE(n, 0);
+#if defined(__GNUC__)
+  return __builtin_ctz(n);
+#else
+  int count = 0;
+  while ((n & 1) == 0) {
+    n >>= 1;
+    count++;
+  }
+  return count;
+#endif
+}
+
+// Returns whether value is one of the first count elements of the sorted
+// array values, which must not be empty.  Generated <Enum>_IsValid()
+// functions use this for enums whose values are too spread out for a bitmap.
+// The search narrows the range without data-dependent branches, which
+// unpredictable inputs would keep mispredicting.
+inline bool SortedArrayContains(const int* values, int count, int value) {
+  while (count > 1) {
+    int half = count / 2;
+    if (values[half] <= value) values += half;
+    count -= half;
+  }
+  return *values == value;
+}
+
+// Returns the offset of the given field within the given aggregate type.
+// This is equivalent to the ANSI C offsetof() macro.  However, according
+// to the C++ standard, offsetof() only works on POD types, and GCC
+// enforces this requirement with a warning.  In practice, this rule is
+// unnecessarily strict; there is probably no compiler or platform on
+// which the offsets of the direct fields of a class are non-constant.
+// Fields inherited from superclasses *can* have non-constant offsets,
+// but that's not what this macro will be used for.
+//
+// Note that we calculate relative to the pointer value 16 here since if we
+// just use zero, GCC complains about dereferencing a NULL pointer.  We
+// choose 16 rather than some other number just in case the compiler would
+// be confused by an unaligned pointer.
+#define GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TYPE, FIELD)    \
+  static_cast<int>(                                           \
+      reinterpret_cast<const char*>(                          \
+          &reinterpret_cast<const TYPE*>(16)->FIELD) -        \
+      reinterpret_cast<const char*>(16))
+
+
+// Table-driven parsing and serialization ---------------------------
+//
+// When the C++ code generator is run with the "table_driven_parsing" or
+// "table_driven_serialization" option, a message's
+// MergePartialFromCodedStream() or its SerializeWithCachedSizes() and
+// ByteSize(), respectively, do not contain code for each field.  Instead, the
+// generated code describes the message's fields with a MessageTable, which is
+// interpreted by TableDrivenMessage.  This makes the generated code much
+// smaller, since all messages share a single loop, at some cost in speed,
+// since the loop has to dispatch on each field's type.  Both options are off
+// by default.  DynamicMessage describes its types with MessageTables too, and
+// uses TableDrivenMessage for parsing, serialization and ByteSize().
+//
+// Oneof and map fields are not described by the table; like extensions and
+// unknown fields, they are handled by fallback functions.
+
+// Describes one field of a message.
+struct LIBPROTOBUF_EXPORT TableField {
+  enum Flags {
+    kRepeated      = 1 << 0,
+    kPacked        = 1 << 1,  // Declared [packed = true].
+    kVerifyUtf8    = 1 << 2,  // A string field whose contents are checked.
+    kUnusualBefore = 1 << 3,  // Fields which are not in the table, or
+                              // extension ranges, have numbers between this
+                              // field's and the previous field's.
+    kEnumValueList = 1 << 4,  // A TYPE_ENUM field validated by
+                              // aux.enum_values rather than a function.
+  };
+
+  uint32 tag;         // Tag of the field's declared encoding.
+  uint32 offset;      // Offset of the field's member within the message.
+  int32 has_bit;      // Index of the field's has-bit, or -1 if none.
+  uint8 type;         // WireFormatLite::FieldType.
+  uint8 flags;        // Bitwise-OR of Flags.
+  uint8 tag_size;     // Encoded size of |tag|.
+  union {
+    // TYPE_MESSAGE and TYPE_GROUP: the field type's default instance.
+    const MessageLite* message_default;
+    // TYPE_ENUM: validates values, or NULL if unknown values are preserved.
+    bool (*enum_is_valid)(int);
+    // TYPE_ENUM with kEnumValueList: the number of valid values, followed by
+    // the values in increasing order.  Used by DynamicMessage, which has no
+    // generated _IsValid() functions.
+    const int* enum_values;
+    // Singular TYPE_STRING and TYPE_BYTES: the field's default value.
+    const ::std::string* string_default;
+  } aux;
+  union {
+    // Fields with kVerifyUtf8: the field's name, for error messages.
+    const char* full_name;
+    // Fields with kPacked: offset of the member which caches the size of the
+    // packed data, as computed by ByteSize().
+    uint32 cached_size_offset;
+  };
+
+  void Set(uint32 tag_value, int type_value, int flags_value,
+           int offset_value, int has_bit_value);
+};
+
+// Describes a message type.  Filled in once, on first use, by generated code.
+struct MessageTable {
+  const TableField* fields;  // Sorted by field number.
+  int num_fields;
+  int has_bits_offset;       // Offset of _has_bits_, or -1 if none.
+
+  // Let ByteSize() skip fields which are not set.  field_by_has_bit maps each
+  // has-bit to the index in |fields| of its field, or -1 if the field is not
+  // in |fields|.  always_visit lists the indices of the fields which must be
+  // checked even if no has-bit is set: repeated fields and fields without
+  // has-bits.
+  const int32* field_by_has_bit;
+  int num_has_bits;
+  const int32* always_visit;
+  int num_always_visit;
+
+  // The message's default instance.  Singular message fields without
+  // has-bits are never serialized from it.
+  const MessageLite* default_instance;
+
+  // Parses a field which is not in |fields|, or which has an unexpected
+  // wire type: oneof members, map fields, extensions and unknown fields.
+  // Returns false if the input is malformed.
+  bool (*parse_unusual)(MessageLite* message, uint32 tag,
+                        io::CodedInputStream* input);
+
+  // Serializes the fields which are not in |fields|, and the extensions,
+  // whose numbers lie between |end| and the number of the field preceding it
+  // in |fields|.  If |end| is TableDrivenMessage::kFieldNumberEnd, serializes
+  // those following the last field in |fields|, then the unknown fields.
+  // NULL if the message has no such fields.
+  void (*serialize_unusual)(const MessageLite* message, int end,
+                            io::CodedOutputStream* output);
+  uint8* (*serialize_unusual_to_array)(const MessageLite* message, int end,
+                                       uint8* target);
+
+  // Computes the serialized size of everything written by serialize_unusual.
+  int (*unusual_byte_size)(const MessageLite* message);
+
+  // Checks a string field for valid UTF-8 and logs an error if it is not.
+  // Only used for fields with TableField::kVerifyUtf8.
+  void (*verify_utf8)(const char* data, int size, bool parsing,
+                      const char* field_name);
+};
+
+class LIBPROTOBUF_EXPORT TableDrivenMessage {
+ public:
+  // One past the largest valid field number.
+  static const int kFieldNumberEnd = 1 << 29;
+
+  // Implements MergePartialFromCodedStream() for a message described by
+  // |table|.
+  static bool MergePartialFromCodedStream(MessageLite* message,
+                                          const MessageTable& table,
+                                          io::CodedInputStream* input);
+
+  // Implement SerializeWithCachedSizes(), SerializeWithCachedSizesToArray()
+  // and ByteSize() for a message described by |table|.  ByteSize() does not
+  // set the message's cached size; the caller must do that.
+  static void SerializeWithCachedSizes(const MessageLite& message,
+                                       const MessageTable& table,
+                                       io::CodedOutputStream* output);
+  static uint8* SerializeWithCachedSizesToArray(const MessageLite& message,
+                                                const MessageTable& table,
+                                                uint8* target);
+  static int ByteSize(const MessageLite& message, const MessageTable& table);
+
+ private:
+  // Shared by both SerializeWithCachedSizes() variants.  Writer is a helper
+  // defined in generated_message_util.cc which abstracts away the output.
+  template <typename Writer>
+  static typename Writer::Output Serialize(const MessageLite& message,
+                                           const MessageTable& table,
+                                           typename Writer::Output output);
+
+  // Handle repeated fields, which need access to RepeatedPtrFieldBase.
+  template <typename Writer>
+  static typename Writer::Output SerializeRepeatedField(
+      const MessageLite& message, const MessageTable& table,
+      const TableField& field, typename Writer::Output output);
+  static int RepeatedFieldByteSize(const MessageLite& message,
+                                   const TableField& field);
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(TableDrivenMessage);
+};
+
 }  // namespace internal
 }  // namespace protobuf
 
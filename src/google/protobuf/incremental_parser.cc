@@ -0,0 +1,371 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/incremental_parser.h>
+
+#include <algorithm>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/generated_message_reflection.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/stubs/common.h>
+
+namespace google {
+namespace protobuf {
+
+using internal::WireFormatLite;
+
+namespace {
+
+const int kDefaultMinNestedSize = 4096;
+// Sub-messages nested deeper than this are buffered rather than descended
+// into, which bounds the recursion in ParsePending().
+const int kMaxFrames = 100;
+// Bytes to add to a pending field at a time while its length is unknown.
+const int kPendingStep = 16;
+
+// Decodes a varint of at most max_bytes bytes starting at ptr.  Returns the
+// number of bytes read, 0 if end comes first, or -1 if the varint is too
+// long.
+int ReadVarint(const uint8* ptr, const uint8* end, int max_bytes,
+               uint64* value) {
+  uint64 result = 0;
+  for (int i = 0; i < max_bytes; i++) {
+    if (ptr + i == end) return 0;
+    uint64 b = ptr[i];
+    result |= (b & 0x7f) << (7 * i);
+    if (b < 0x80) {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+// What ScanField() learned about a field.
+struct FieldInfo {
+  int number;
+  WireFormatLite::WireType wire_type;
+  // For a length-delimited field whose tag and length have been read, the
+  // size of both, and the length.  Otherwise header_size is zero.
+  int header_size;
+  uint32 length;
+};
+
+// Finds the end of the field starting at ptr, without looking inside
+// length-delimited values or groups.  Returns its size, 0 if it doesn't end
+// before end, or -1 if it is malformed.
+int ScanField(const uint8* ptr, const uint8* end, FieldInfo* info) {
+  info->header_size = 0;
+  uint64 tag;
+  int tag_size = ReadVarint(ptr, end, 5, &tag);
+  if (tag_size <= 0) return tag_size;
+  if (tag > kuint32max || WireFormatLite::GetTagFieldNumber(tag) == 0) {
+    return -1;
+  }
+  info->number = WireFormatLite::GetTagFieldNumber(tag);
+  info->wire_type = WireFormatLite::GetTagWireType(tag);
+
+  const uint8* value = ptr + tag_size;
+  uint64 unused;
+  int value_size;
+  switch (info->wire_type) {
+    case WireFormatLite::WIRETYPE_VARINT:
+      value_size = ReadVarint(value, end, 10, &unused);
+      if (value_size <= 0) return value_size;
+      return tag_size + value_size;
+    case WireFormatLite::WIRETYPE_FIXED64:
+      return end - value < 8 ? 0 : tag_size + 8;
+    case WireFormatLite::WIRETYPE_FIXED32:
+      return end - value < 4 ? 0 : tag_size + 4;
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+      uint64 length;
+      int length_size = ReadVarint(value, end, 5, &length);
+      if (length_size <= 0) return length_size;
+      if (length > kint32max - tag_size - length_size) return -1;
+      info->header_size = tag_size + length_size;
+      info->length = length;
+      if (end - ptr < info->header_size + length) return 0;
+      return info->header_size + length;
+    }
+    case WireFormatLite::WIRETYPE_START_GROUP:
+    case WireFormatLite::WIRETYPE_END_GROUP:
+      return tag_size;
+    default:
+      return -1;
+  }
+}
+
+// Keeps count of the groups a field leaves open.
+bool TrackGroups(const FieldInfo& info, int* depth) {
+  if (info.wire_type == WireFormatLite::WIRETYPE_START_GROUP) {
+    ++*depth;
+  } else if (info.wire_type == WireFormatLite::WIRETYPE_END_GROUP) {
+    if (*depth == 0) return false;
+    --*depth;
+  }
+  return true;
+}
+
+}  // namespace
+
+IncrementalParser::Options::Options()
+    : min_nested_size(kDefaultMinNestedSize) {}
+
+IncrementalParser::IncrementalParser(MessageLite* message)
+    : message_(message) {
+  Init(-1);
+}
+
+IncrementalParser::IncrementalParser(MessageLite* message, int64 size)
+    : message_(message) {
+  Init(size);
+}
+
+IncrementalParser::IncrementalParser(MessageLite* message, int64 size,
+                                     const Options& options)
+    : message_(message), options_(options) {
+  Init(size);
+}
+
+IncrementalParser::~IncrementalParser() {}
+
+void IncrementalParser::Init(int64 size) {
+  failed_ = false;
+  Frame frame = { message_, size < 0 ? -1 : size };
+  frames_.push_back(frame);
+  pending_scanned_ = 0;
+  pending_depth_ = 0;
+  pending_needed_ = 0;
+}
+
+bool IncrementalParser::done() const {
+  return !failed_ && frames_.size() == 1 && frames_[0].bytes_left == 0 &&
+         pending_.empty();
+}
+
+int IncrementalParser::Parse(const void* data, int size) {
+  if (failed_) return -1;
+  const uint8* ptr = static_cast<const uint8*>(data);
+  int used = 0;
+  while (used < size && !done()) {
+    int n = ParseSome(ptr + used, size - used);
+    if (n < 0) {
+      failed_ = true;
+      return -1;
+    }
+    used += n;
+  }
+  return used;
+}
+
+int IncrementalParser::ParseSome(const uint8* data, int size) {
+  int index = frames_.size() - 1;
+  bool limited = frames_[index].bytes_left >= 0;
+  if (limited) size = min<int64>(size, frames_[index].bytes_left);
+
+  int used = pending_.empty() ? ParseDirect(data, size)
+                              : ParsePending(data, size);
+  if (used < 0) return -1;
+  if (limited) {
+    frames_[index].bytes_left -= used;
+    // A sub-message we descended into ran past the end of its parent.
+    if (frames_[index].bytes_left < 0) return -1;
+  }
+
+  while (frames_.back().bytes_left == 0) {
+    // A field can't run past the end of its message.
+    if (!pending_.empty()) return -1;
+    if (frames_.size() == 1) break;
+    frames_.pop_back();
+  }
+  return used;
+}
+
+int IncrementalParser::ParseDirect(const uint8* data, int size) {
+  const uint8* ptr = data;
+  const uint8* end = data + size;
+  // End of the last field that isn't inside a group.
+  const uint8* fields_end = data;
+  int depth = 0;
+  FieldInfo info;
+  int field_size = 0;
+  while (ptr < end) {
+    field_size = ScanField(ptr, end, &info);
+    if (field_size <= 0) break;
+    if (!TrackGroups(info, &depth)) return -1;
+    ptr += field_size;
+    if (depth == 0) fields_end = ptr;
+  }
+  if (field_size < 0) return -1;
+  if (fields_end > data && !MergeFields(data, fields_end - data)) return -1;
+  if (fields_end == end) return size;
+
+  // The last field continues in the next chunk.
+  bool header_known = field_size == 0 && info.header_size > 0;
+  if (header_known && depth == 0 &&
+      MaybeDescend(info.number, info.length, 0)) {
+    return (fields_end - data) + info.header_size;
+  }
+  pending_.assign(reinterpret_cast<const char*>(fields_end), end - fields_end);
+  pending_scanned_ = ptr - fields_end;
+  pending_depth_ = depth;
+  pending_needed_ = header_known ?
+      pending_scanned_ + info.header_size + static_cast<int64>(info.length) :
+      0;
+  return size;
+}
+
+int IncrementalParser::ParsePending(const uint8* data, int size) {
+  int used = 0;
+  while (true) {
+    int64 wanted = pending_needed_ > pending_.size() ?
+        pending_needed_ - pending_.size() : kPendingStep;
+    int n = min<int64>(wanted, size - used);
+    pending_.append(reinterpret_cast<const char*>(data + used), n);
+    used += n;
+    if (pending_.size() < pending_needed_) return used;
+
+    const uint8* base = reinterpret_cast<const uint8*>(pending_.data());
+    const uint8* ptr = base + pending_scanned_;
+    const uint8* end = base + pending_.size();
+    int depth = pending_depth_;
+    FieldInfo info;
+    int field_size = 0;
+    while (ptr < end) {
+      field_size = ScanField(ptr, end, &info);
+      if (field_size <= 0) break;
+      if (!TrackGroups(info, &depth)) return -1;
+      ptr += field_size;
+      if (depth == 0) break;
+    }
+    if (field_size < 0) return -1;
+
+    if (depth == 0 && ptr > base) {
+      // The field is complete.  Give back the bytes we took beyond it.
+      int complete_size = ptr - base;
+      used -= pending_.size() - complete_size;
+      if (!MergeFields(base, complete_size)) return -1;
+      pending_.clear();
+      pending_scanned_ = 0;
+      pending_depth_ = 0;
+      pending_needed_ = 0;
+      return used;
+    }
+
+    bool header_known = field_size == 0 && info.header_size > 0;
+    pending_scanned_ = ptr - base;
+    pending_depth_ = depth;
+    pending_needed_ = header_known ?
+        pending_scanned_ + info.header_size + static_cast<int64>(info.length) :
+        0;
+
+    if (header_known && depth == 0) {
+      int payload_received = pending_.size() - info.header_size;
+      if (MaybeDescend(info.number, info.length, payload_received)) {
+        // Hand what we have of the payload to the new frame.
+        string payload = pending_.substr(info.header_size);
+        pending_.clear();
+        pending_scanned_ = 0;
+        pending_depth_ = 0;
+        pending_needed_ = 0;
+        const uint8* payload_data =
+            reinterpret_cast<const uint8*>(payload.data());
+        int fed = 0;
+        while (fed < payload.size()) {
+          int n = ParseSome(payload_data + fed, payload.size() - fed);
+          if (n < 0) return -1;
+          fed += n;
+        }
+        return used;
+      }
+    }
+    if (used == size) return used;
+  }
+}
+
+bool IncrementalParser::MergeFields(const uint8* data, int size) {
+  io::CodedInputStream input(data, size);
+  input.SetTotalBytesLimit(kint32max, kint32max);
+  return frames_.back().message->MergePartialFromCodedStream(&input) &&
+         input.ConsumedEntireMessage();
+}
+
+bool IncrementalParser::MaybeDescend(int number, uint32 length,
+                                     int payload_received) {
+  if (length == 0 || length < options_.min_nested_size ||
+      frames_.size() >= kMaxFrames) {
+    return false;
+  }
+  Message* parent =
+      internal::dynamic_cast_if_available<Message*>(frames_.back().message);
+  if (parent == NULL) return false;
+
+  const Reflection* reflection = parent->GetReflection();
+  const FieldDescriptor* field =
+      parent->GetDescriptor()->FindFieldByNumber(number);
+  if (field == NULL) field = reflection->FindKnownExtensionByNumber(number);
+  if (field == NULL || field->type() != FieldDescriptor::TYPE_MESSAGE ||
+      field->is_map()) {
+    return false;
+  }
+
+  Message* child = field->is_repeated() ?
+      reflection->AddMessage(parent, field) :
+      reflection->MutableMessage(parent, field);
+  if (frames_.back().bytes_left >= 0) {
+    frames_.back().bytes_left -= length - payload_received;
+  }
+  Frame frame = { child, length };
+  frames_.push_back(frame);
+  return true;
+}
+
+bool IncrementalParser::FinishPartial() {
+  return !failed_ && pending_.empty() && frames_.size() == 1 &&
+         frames_[0].bytes_left <= 0;
+}
+
+bool IncrementalParser::Finish() {
+  if (!FinishPartial()) return false;
+  if (!message_->IsInitialized()) {
+    GOOGLE_LOG(ERROR) << "Can't parse message of type \""
+                      << message_->GetTypeName()
+                      << "\" because it is missing required fields: "
+                      << message_->InitializationErrorString();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace protobuf
+}  // namespace google
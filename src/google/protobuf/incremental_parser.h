@@ -0,0 +1,155 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains IncrementalParser, which parses a message from input
+// that is pushed to it in chunks as it arrives, instead of pulling it from
+// a ZeroCopyInputStream.  This lets an event-driven server overlap parsing
+// with network receipt without first buffering the whole message.
+//
+// The parser splits its input into whole top-level fields.  Runs of complete
+// fields are merged into the message straight out of the chunk that holds
+// them, using the message's own (generated) parsing code; since parsing the
+// concatenation of two serializations is the same as merging them, this
+// gives the same result as parsing the whole message at once.  Only a field
+// cut off at the end of a chunk is copied aside, until the rest of it
+// arrives.  If that field is a large sub-message and the message being
+// parsed supports reflection, the parser descends into it instead, so that
+// nested messages are also parsed as they arrive rather than buffered.
+//
+// Example:
+//
+//   IncrementalParser parser(&request, request_size);
+//   while (!parser.done()) {
+//     ... receive a chunk ...
+//     int used = parser.Parse(chunk, chunk_size);
+//     if (used < 0) { ... malformed ... }
+//   }
+//   if (!parser.Finish()) { ... missing required fields ... }
+
+#ifndef GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
+#define GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
+
+#include <string>
+#include <vector>
+#include <google/protobuf/stubs/common.h>
+
+namespace google {
+namespace protobuf {
+
+class MessageLite;
+
+class LIBPROTOBUF_EXPORT IncrementalParser {
+ public:
+  struct Options {
+    // A length-delimited sub-message field at least this long that isn't
+    // complete in the current chunk is parsed as it arrives instead of being
+    // buffered.  Only applies to messages with reflection; set to kint32max
+    // to always buffer.  Defaults to 4096.
+    int min_nested_size;
+
+    Options();  // Initializes with default values.
+  };
+
+  // Parses a message whose end is only known to the caller, who calls
+  // Finish() after the last chunk.  The message is merged into, not
+  // cleared, and must outlive the parser.
+  explicit IncrementalParser(MessageLite* message);
+
+  // Parses a message of exactly size bytes.  Input beyond the end of the
+  // message is left unconsumed.
+  IncrementalParser(MessageLite* message, int64 size);
+  IncrementalParser(MessageLite* message, int64 size, const Options& options);
+  ~IncrementalParser();
+
+  // Parses the next chunk of input.  The chunk doesn't need to outlive the
+  // call.  Returns the number of bytes used, which is less than size only
+  // when the message has a known size that ends inside the chunk, or -1 if
+  // the input is malformed, after which the parser is unusable.
+  int Parse(const void* data, int size);
+
+  // True once a message of known size has been completely parsed.
+  bool done() const;
+
+  // Checks that the input ended at the end of a field (and, for a message
+  // of known size, that the message is complete).  Finish() additionally
+  // checks that all required fields are set, like ParseFromString().
+  bool Finish();
+  bool FinishPartial();
+
+ private:
+  // A message being parsed.  bytes_left is the number of bytes of it not
+  // yet handed to the parser, or -1 if unknown.
+  struct Frame {
+    MessageLite* message;
+    int64 bytes_left;
+  };
+
+  MessageLite* message_;
+  Options options_;
+  bool failed_;
+
+  // Innermost frame last.  Bytes of a sub-message that was descended into
+  // are counted as handed to its parent frame when the descent happens.
+  vector<Frame> frames_;
+
+  // The start of an incomplete field of the innermost frame, if any.
+  // pending_scanned_ bytes of it are known to consist of whole fields, and
+  // leave pending_depth_ groups open; the field can't complete before
+  // pending_needed_ bytes have arrived.
+  string pending_;
+  int pending_scanned_;
+  int pending_depth_;
+  int64 pending_needed_;
+
+  void Init(int64 size);
+
+  // Feeds up to size bytes to the innermost frame.  Returns the number of
+  // bytes used, or -1 on error.
+  int ParseSome(const uint8* data, int size);
+  // Helpers for ParseSome() for when there is or isn't a pending field.
+  int ParseDirect(const uint8* data, int size);
+  int ParsePending(const uint8* data, int size);
+
+  // Merges whole fields into the innermost frame's message.
+  bool MergeFields(const uint8* data, int size);
+
+  // If the length-delimited field with the given number and length is a
+  // sub-message worth descending into, pushes a frame for it and returns
+  // true.  payload_received is how much of the field's payload has already
+  // been counted against the parent.
+  bool MaybeDescend(int number, uint32 length, int payload_received);
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(IncrementalParser);
+};
+
+}  // namespace protobuf
+
+}  // namespace google
+#endif  // GOOGLE_PROTOBUF_INCREMENTAL_PARSER_H__
@@ -0,0 +1,243 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/incremental_parser.h>
+
+#include <string>
+
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/testing/googletest.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace {
+
+// Feeds data to parser in chunks of chunk_size bytes.  Returns the number of
+// bytes used, or -1.
+int ParseInChunks(IncrementalParser* parser, const string& data,
+                  int chunk_size) {
+  int used = 0;
+  while (used < data.size() && !parser->done()) {
+    // Copy the chunk so that the parser can't get away with keeping
+    // pointers into it.
+    string chunk = data.substr(used, chunk_size);
+    int n = parser->Parse(chunk.data(), chunk.size());
+    if (n < 0) return -1;
+    used += n;
+    if (n < chunk.size()) break;
+  }
+  return used;
+}
+
+const int kChunkSizes[] = { 1, 2, 3, 5, 16, 100, 1 << 20 };
+
+// A message with sub-messages big enough to be descended into.
+void MakeNested(unittest::NestedTestAllTypes* message) {
+  unittest::NestedTestAllTypes* child = message;
+  for (int i = 0; i < 3; i++) {
+    TestUtil::SetAllFields(child->mutable_payload());
+    for (int j = 0; j < 20; j++) {
+      child->mutable_payload()->add_repeated_string(string(j * 10, 'a' + i));
+      child->mutable_payload()->add_repeated_nested_message()->set_bb(j);
+    }
+    child = child->mutable_child();
+  }
+}
+
+TEST(IncrementalParserTest, AllTypes) {
+  unittest::TestAllTypes expected;
+  TestUtil::SetAllFields(&expected);
+  string data = expected.SerializeAsString();
+
+  for (int i = 0; i < GOOGLE_ARRAYSIZE(kChunkSizes); i++) {
+    SCOPED_TRACE(kChunkSizes[i]);
+    unittest::TestAllTypes message;
+    IncrementalParser parser(&message);
+    EXPECT_EQ(data.size(), ParseInChunks(&parser, data, kChunkSizes[i]));
+    EXPECT_FALSE(parser.done());
+    EXPECT_TRUE(parser.Finish());
+    TestUtil::ExpectAllFieldsSet(message);
+  }
+}
+
+TEST(IncrementalParserTest, Extensions) {
+  unittest::TestAllExtensions expected;
+  TestUtil::SetAllExtensions(&expected);
+  string data = expected.SerializeAsString();
+
+  for (int i = 0; i < GOOGLE_ARRAYSIZE(kChunkSizes); i++) {
+    SCOPED_TRACE(kChunkSizes[i]);
+    unittest::TestAllExtensions message;
+    IncrementalParser::Options options;
+    options.min_nested_size = 1;
+    IncrementalParser parser(&message, data.size(), options);
+    EXPECT_EQ(data.size(), ParseInChunks(&parser, data, kChunkSizes[i]));
+    EXPECT_TRUE(parser.done());
+    EXPECT_TRUE(parser.Finish());
+    TestUtil::ExpectAllExtensionsSet(message);
+  }
+}
+
+TEST(IncrementalParserTest, UnknownGroups) {
+  unittest::TestAllTypes all;
+  TestUtil::SetAllFields(&all);
+  string data = all.SerializeAsString();
+
+  for (int i = 0; i < GOOGLE_ARRAYSIZE(kChunkSizes); i++) {
+    SCOPED_TRACE(kChunkSizes[i]);
+    unittest::TestEmptyMessage message;
+    IncrementalParser parser(&message);
+    EXPECT_EQ(data.size(), ParseInChunks(&parser, data, kChunkSizes[i]));
+    EXPECT_TRUE(parser.Finish());
+    EXPECT_EQ(data, message.SerializeAsString());
+  }
+}
+
+TEST(IncrementalParserTest, Nested) {
+  unittest::NestedTestAllTypes expected;
+  MakeNested(&expected);
+  string data = expected.SerializeAsString();
+
+  int kMinNestedSizes[] = { 1, 100, 4096, kint32max };
+  for (int i = 0; i < GOOGLE_ARRAYSIZE(kChunkSizes); i++) {
+    for (int j = 0; j < GOOGLE_ARRAYSIZE(kMinNestedSizes); j++) {
+      SCOPED_TRACE(StrCat("chunk_size ", kChunkSizes[i],
+                          " min_nested_size ", kMinNestedSizes[j]));
+      unittest::NestedTestAllTypes message;
+      // Merging into an existing message must work the same way as parsing.
+      message.mutable_child()->mutable_payload()->set_optional_int32(-1);
+      message.mutable_child()->mutable_payload()->add_repeated_int32(-1);
+      unittest::NestedTestAllTypes merged = message;
+      merged.MergeFrom(expected);
+
+      IncrementalParser::Options options;
+      options.min_nested_size = kMinNestedSizes[j];
+      IncrementalParser parser(&message, data.size(), options);
+      EXPECT_EQ(data.size(), ParseInChunks(&parser, data, kChunkSizes[i]));
+      EXPECT_TRUE(parser.done());
+      EXPECT_TRUE(parser.Finish());
+      EXPECT_EQ(merged.SerializeAsString(), message.SerializeAsString());
+    }
+  }
+}
+
+TEST(IncrementalParserTest, KnownSizeLeavesTrailingData) {
+  unittest::TestAllTypes expected;
+  TestUtil::SetAllFields(&expected);
+  string data = expected.SerializeAsString();
+  string input = data + "trailing garbage";
+
+  for (int i = 0; i < GOOGLE_ARRAYSIZE(kChunkSizes); i++) {
+    SCOPED_TRACE(kChunkSizes[i]);
+    unittest::TestAllTypes message;
+    IncrementalParser parser(&message, data.size());
+    EXPECT_EQ(data.size(), ParseInChunks(&parser, input, kChunkSizes[i]));
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(0, parser.Parse("x", 1));
+    EXPECT_TRUE(parser.Finish());
+    TestUtil::ExpectAllFieldsSet(message);
+  }
+}
+
+TEST(IncrementalParserTest, Truncated) {
+  unittest::NestedTestAllTypes expected;
+  MakeNested(&expected);
+  string data = expected.SerializeAsString();
+
+  // Cutting the input anywhere leaves a field or sub-message unfinished.
+  for (int cut = 1; cut < data.size(); cut += 97) {
+    unittest::NestedTestAllTypes message;
+    IncrementalParser::Options options;
+    options.min_nested_size = 100;
+    IncrementalParser parser(&message, -1, options);
+    string input = data.substr(0, cut);
+    ParseInChunks(&parser, input, 7);
+    EXPECT_FALSE(parser.FinishPartial()) << cut;
+  }
+
+  // A known-size message must get all its bytes.
+  unittest::NestedTestAllTypes message;
+  IncrementalParser parser(&message, data.size());
+  EXPECT_EQ(data.size() - 1,
+            ParseInChunks(&parser, data.substr(0, data.size() - 1), 100));
+  EXPECT_FALSE(parser.done());
+  EXPECT_FALSE(parser.FinishPartial());
+}
+
+TEST(IncrementalParserTest, Malformed) {
+  unittest::TestAllTypes message;
+  {
+    // Wire type 7 doesn't exist.
+    IncrementalParser parser(&message);
+    EXPECT_EQ(-1, parser.Parse("\x0f\x00", 2));
+    EXPECT_EQ(-1, parser.Parse("", 0));
+    EXPECT_FALSE(parser.Finish());
+  }
+  {
+    // Unmatched end group.
+    IncrementalParser parser(&message);
+    EXPECT_EQ(-1, parser.Parse("\x0c", 1));
+  }
+  {
+    // A field running past the end of the message.
+    IncrementalParser parser(&message, 3);
+    EXPECT_EQ(-1, parser.Parse("\x08\x01\x72\x05hello", 9));
+  }
+  {
+    // A sub-message running past the end of its parent.
+    unittest::NestedTestAllTypes nested;
+    IncrementalParser::Options options;
+    options.min_nested_size = 1;
+    IncrementalParser parser(&nested, -1, options);
+    EXPECT_EQ(3, parser.Parse("\x0a\x02\x0a", 3));
+    EXPECT_EQ(-1, parser.Parse("\x05\x12\x03", 3));
+  }
+}
+
+TEST(IncrementalParserTest, RequiredFields) {
+  unittest::TestRequired required;
+  required.set_a(1);
+  string data = required.SerializePartialAsString();
+
+  unittest::TestRequired message;
+  IncrementalParser parser(&message);
+  EXPECT_EQ(data.size(), parser.Parse(data.data(), data.size()));
+  EXPECT_TRUE(parser.FinishPartial());
+  EXPECT_FALSE(parser.Finish());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
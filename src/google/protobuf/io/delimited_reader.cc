@@ -0,0 +1,485 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/io/delimited_reader.h>
+
+#include "config.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN  // We only need minimal includes
+#include <windows.h>
+#elif defined(HAVE_PTHREAD)
+#include <pthread.h>
+#else
+#error "No suitable threading library available."
+#endif
+
+#include <algorithm>
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/record_io.h>
+#include <google/protobuf/message_lite.h>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/stl_util.h>
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+namespace {
+
+const int kDefaultNumThreads = 4;
+const int kDefaultRangeSize = 4 << 20;
+// How much of the file the boundary scan reads at a time.
+const int kScanChunkSize = 1 << 20;
+const int kMaxVarint32Bytes = 5;
+
+// Decodes the varint32 at ptr, reading at most available bytes.  Returns
+// the number of bytes consumed, or 0 if the varint doesn't end in time.
+int ReadLengthPrefix(const uint8* ptr, int available, uint32* length) {
+  available = min(available, kMaxVarint32Bytes);
+  uint32 result = 0;
+  for (int i = 0; i < available; i++) {
+    uint32 b = ptr[i];
+    result |= (b & 0x7f) << (7 * i);
+    if (b < 0x80) {
+      *length = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+#ifdef _WIN32
+DWORD WINAPI RunClosure(LPVOID arg) {
+  reinterpret_cast<Closure*>(arg)->Run();
+  return 0;
+}
+#else
+void* RunClosure(void* arg) {
+  reinterpret_cast<Closure*>(arg)->Run();
+  return NULL;
+}
+#endif
+
+// The Mutex in stubs/common.h has no condition variable to go with it, so
+// the workers use the platform's primitives directly.
+#ifdef _WIN32
+
+class Lock {
+ public:
+  Lock() { InitializeCriticalSection(&section_); }
+  ~Lock() { DeleteCriticalSection(&section_); }
+  void Acquire() { EnterCriticalSection(&section_); }
+  void Release() { LeaveCriticalSection(&section_); }
+
+ private:
+  friend class CondVar;
+  CRITICAL_SECTION section_;
+};
+
+class CondVar {
+ public:
+  CondVar() { InitializeConditionVariable(&cond_); }
+  void Wait(Lock* lock) {
+    SleepConditionVariableCS(&cond_, &lock->section_, INFINITE);
+  }
+  void Broadcast() { WakeAllConditionVariable(&cond_); }
+
+ private:
+  CONDITION_VARIABLE cond_;
+};
+
+typedef HANDLE Thread;
+
+bool StartThread(Closure* closure, Thread* thread) {
+  *thread = CreateThread(NULL, 0, &RunClosure, closure, 0, NULL);
+  return *thread != NULL;
+}
+
+void JoinThread(Thread thread) {
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+}
+
+#else
+
+class Lock {
+ public:
+  Lock() { pthread_mutex_init(&mutex_, NULL); }
+  ~Lock() { pthread_mutex_destroy(&mutex_); }
+  void Acquire() { pthread_mutex_lock(&mutex_); }
+  void Release() { pthread_mutex_unlock(&mutex_); }
+
+ private:
+  friend class CondVar;
+  pthread_mutex_t mutex_;
+};
+
+class CondVar {
+ public:
+  CondVar() { pthread_cond_init(&cond_, NULL); }
+  ~CondVar() { pthread_cond_destroy(&cond_); }
+  void Wait(Lock* lock) { pthread_cond_wait(&cond_, &lock->mutex_); }
+  void Broadcast() { pthread_cond_broadcast(&cond_); }
+
+ private:
+  pthread_cond_t cond_;
+};
+
+typedef pthread_t Thread;
+
+bool StartThread(Closure* closure, Thread* thread) {
+  return pthread_create(thread, NULL, &RunClosure, closure) == 0;
+}
+
+void JoinThread(Thread thread) {
+  pthread_join(thread, NULL);
+}
+
+#endif
+
+}  // namespace
+
+// A range's worth of parsed messages.
+struct ParallelDelimitedReader::Slot {
+  enum State { PARSING, READY, FAILED };
+
+  Slot() : range(-1), state(READY) {}
+
+  // The range last claimed for this slot, and how far along it is.  Both
+  // are guarded by the workers' lock.
+  int range;
+  State state;
+
+  Arena arena;
+  vector<MessageLite*> messages;
+  // Holds the range's bytes if the source can't hand them out directly.
+  string scratch;
+};
+
+struct ParallelDelimitedReader::Workers {
+  Workers() : shutdown(false) {}
+
+  Lock lock;
+  // Signalled when more ranges may be claimed, and on shutdown.
+  CondVar work_ready;
+  // Signalled whenever a range is finished.
+  CondVar range_done;
+  bool shutdown;
+
+  scoped_ptr<Closure> loop;
+  vector<Thread> threads;
+};
+
+ParallelDelimitedReader::Options::Options()
+    : num_threads(kDefaultNumThreads),
+      range_size(kDefaultRangeSize) {}
+
+ParallelDelimitedReader::Handler::~Handler() {}
+
+ParallelDelimitedReader::ParallelDelimitedReader(
+    RecordSource* source, const MessageLite* prototype)
+    : source_(source),
+      prototype_(prototype),
+      scanned_(false),
+      scan_ok_(false),
+      num_records_(-1),
+      workers_(new Workers),
+      next_range_(0),
+      claim_end_(0),
+      busy_(0),
+      failed_(false),
+      handler_(NULL),
+      current_range_(-1),
+      current_message_(0) {}
+
+ParallelDelimitedReader::ParallelDelimitedReader(
+    RecordSource* source, const MessageLite* prototype,
+    const Options& options)
+    : source_(source),
+      prototype_(prototype),
+      options_(options),
+      scanned_(false),
+      scan_ok_(false),
+      num_records_(-1),
+      workers_(new Workers),
+      next_range_(0),
+      claim_end_(0),
+      busy_(0),
+      failed_(false),
+      handler_(NULL),
+      current_range_(-1),
+      current_message_(0) {}
+
+ParallelDelimitedReader::~ParallelDelimitedReader() {
+  workers_->lock.Acquire();
+  workers_->shutdown = true;
+  workers_->work_ready.Broadcast();
+  workers_->lock.Release();
+  for (int i = 0; i < workers_->threads.size(); i++) {
+    JoinThread(workers_->threads[i]);
+  }
+  STLDeleteElements(&slots_);
+}
+
+int64 ParallelDelimitedReader::num_records() {
+  return Scan() ? num_records_ : -1;
+}
+
+bool ParallelDelimitedReader::Scan() {
+  if (scanned_) return scan_ok_;
+  scanned_ = true;
+
+  int64 size = source_->Size();
+  string scratch;
+  const char* chunk = NULL;
+  int64 chunk_start = 0;
+  int64 chunk_end = 0;
+
+  int64 position = 0;
+  int64 record = 0;
+  Range range = { 0, 0, 0, 0 };
+  while (position < size) {
+    // Make sure the whole length prefix is in the current chunk.
+    if (position >= chunk_end ||
+        (chunk_end - position < kMaxVarint32Bytes && chunk_end < size)) {
+      int chunk_size = min<int64>(kScanChunkSize, size - position);
+      if (!source_->Read(position, chunk_size, &scratch, &chunk)) {
+        GOOGLE_LOG(ERROR) << "Read failed at offset " << position << ".";
+        return false;
+      }
+      chunk_start = position;
+      chunk_end = position + chunk_size;
+    }
+
+    const uint8* ptr =
+        reinterpret_cast<const uint8*>(chunk + (position - chunk_start));
+    uint32 length = 0;
+    int prefix_size = ReadLengthPrefix(
+        ptr, min<int64>(chunk_end - position, kMaxVarint32Bytes), &length);
+    int64 next = position + prefix_size + length;
+    if (prefix_size == 0 || next > size) {
+      GOOGLE_LOG(ERROR) << "Record " << record << " at offset " << position
+                        << " is truncated.";
+      return false;
+    }
+    if (next - range.start > kint32max) {
+      GOOGLE_LOG(ERROR) << "Record " << record << " at offset " << position
+                        << " is too large.";
+      return false;
+    }
+
+    position = next;
+    ++record;
+    ++range.num_records;
+    if (position - range.start >= options_.range_size) {
+      range.end = position;
+      ranges_.push_back(range);
+      range.start = position;
+      range.first_record = record;
+      range.num_records = 0;
+    }
+  }
+  if (range.num_records > 0) {
+    range.end = position;
+    ranges_.push_back(range);
+  }
+
+  num_records_ = record;
+  scan_ok_ = true;
+  return true;
+}
+
+bool ParallelDelimitedReader::ParseRange(const Range& range, Slot* slot) {
+  slot->arena.Reset();
+  slot->messages.clear();
+
+  const char* data;
+  if (!source_->Read(range.start, range.end - range.start, &slot->scratch,
+                     &data)) {
+    GOOGLE_LOG(ERROR) << "Read failed at offset " << range.start << ".";
+    return false;
+  }
+
+  // The boundary scan already checked the framing, but that was a separate
+  // read of the file.
+  const uint8* ptr = reinterpret_cast<const uint8*>(data);
+  const uint8* end = ptr + (range.end - range.start);
+  for (int i = 0; i < range.num_records; i++) {
+    uint32 length = 0;
+    int prefix_size = ReadLengthPrefix(ptr, end - ptr, &length);
+    if (prefix_size == 0 || length > end - ptr - prefix_size) {
+      GOOGLE_LOG(ERROR) << "Record " << range.first_record + i
+                        << " is truncated; did the file change?";
+      return false;
+    }
+    ptr += prefix_size;
+
+    MessageLite* message = prototype_->New(&slot->arena);
+    if (!message->ParsePartialFromArray(ptr, length)) {
+      GOOGLE_LOG(ERROR) << "Can't parse record " << range.first_record + i
+                        << " as " << prototype_->GetTypeName() << ".";
+      return false;
+    }
+    slot->messages.push_back(message);
+    ptr += length;
+  }
+  return true;
+}
+
+void ParallelDelimitedReader::StartWorkers() {
+  if (workers_->loop != NULL) return;
+  workers_->loop.reset(
+      NewPermanentCallback(this, &ParallelDelimitedReader::WorkerLoop));
+  // The calling thread parses too.
+  int num_workers = min<int>(options_.num_threads, ranges_.size()) - 1;
+  for (int i = 0; i < num_workers; i++) {
+    Thread thread;
+    if (!StartThread(workers_->loop.get(), &thread)) break;
+    workers_->threads.push_back(thread);
+  }
+}
+
+void ParallelDelimitedReader::WorkerLoop() {
+  Slot own_slot;
+  workers_->lock.Acquire();
+  while (!workers_->shutdown) {
+    if (failed_ || next_range_ >= claim_end_) {
+      workers_->work_ready.Wait(&workers_->lock);
+    } else {
+      RunRange(next_range_++, &own_slot);
+    }
+  }
+  workers_->lock.Release();
+}
+
+void ParallelDelimitedReader::RunRange(int i, Slot* own_slot) {
+  Handler* handler = handler_;
+  Slot* slot = handler == NULL ? slots_[i % slots_.size()] : own_slot;
+  slot->range = i;
+  slot->state = Slot::PARSING;
+  ++busy_;
+  workers_->lock.Release();
+
+  const Range& range = ranges_[i];
+  bool ok = ParseRange(range, slot);
+  if (ok && handler != NULL) {
+    for (int j = 0; j < slot->messages.size() && ok; j++) {
+      ok = handler->HandleMessage(range.first_record + j, *slot->messages[j]);
+    }
+  }
+
+  workers_->lock.Acquire();
+  --busy_;
+  slot->state = ok ? Slot::READY : Slot::FAILED;
+  if (!ok) failed_ = true;
+  workers_->range_done.Broadcast();
+}
+
+bool ParallelDelimitedReader::ReadAll(Handler* handler) {
+  if (!Scan()) return false;
+  StartWorkers();
+
+  Slot own_slot;
+  workers_->lock.Acquire();
+  handler_ = handler;
+  next_range_ = 0;
+  claim_end_ = ranges_.size();
+  failed_ = false;
+  workers_->work_ready.Broadcast();
+  while (!failed_ && next_range_ < claim_end_) {
+    RunRange(next_range_++, &own_slot);
+  }
+  while (busy_ > 0) workers_->range_done.Wait(&workers_->lock);
+  claim_end_ = next_range_;
+  handler_ = NULL;
+  bool ok = !failed_;
+  workers_->lock.Release();
+  return ok;
+}
+
+bool ParallelDelimitedReader::NextRange() {
+  if (!Scan()) return false;
+  if (slots_.empty()) {
+    // One slot for the range being returned, and one for each range being
+    // parsed ahead of it.
+    int num_slots = max(options_.num_threads, 1) + 1;
+    for (int i = 0; i < num_slots; i++) slots_.push_back(new Slot);
+    StartWorkers();
+  }
+
+  // Don't go past a range that failed to parse.
+  if (current_range_ >= 0 &&
+      slots_[current_range_ % slots_.size()]->state == Slot::FAILED) {
+    return false;
+  }
+  int range = current_range_ + 1;
+  if (range >= ranges_.size()) return false;
+  Slot* slot = slots_[range % slots_.size()];
+
+  workers_->lock.Acquire();
+  // The current range's slot is free now, so the range that maps to it may
+  // be claimed.
+  claim_end_ = min<int>(range + slots_.size(), ranges_.size());
+  workers_->work_ready.Broadcast();
+  while (slot->range != range || slot->state == Slot::PARSING) {
+    if (next_range_ == range) {
+      // The workers are behind; don't wait for them.
+      RunRange(next_range_++, NULL);
+    } else {
+      workers_->range_done.Wait(&workers_->lock);
+    }
+  }
+  bool ok = slot->state == Slot::READY;
+  workers_->lock.Release();
+
+  // Move on even if the range failed: the current range's slot may have
+  // been claimed again already.
+  current_range_ = range;
+  current_message_ = 0;
+  if (!ok) slot->messages.clear();
+  return ok;
+}
+
+bool ParallelDelimitedReader::Next(const MessageLite** message) {
+  while (current_range_ < 0 ||
+         current_message_ >=
+             slots_[current_range_ % slots_.size()]->messages.size()) {
+    if (!NextRange()) return false;
+  }
+  *message =
+      slots_[current_range_ % slots_.size()]->messages[current_message_++];
+  return true;
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,203 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains ParallelDelimitedReader, which parses a file of
+// length-delimited messages (each a varint32 length followed by that many
+// bytes, as written by MessageLite::SerializeToCodedStream() after
+// CodedOutputStream::WriteVarint32(), or by Java's writeDelimitedTo()) on
+// several threads.
+//
+// Reading proceeds in two passes.  First the file is scanned for record
+// boundaries by hopping from one length prefix to the next without looking
+// at the message bodies, which is cheap enough to run at close to I/O speed.
+// The records are then cut into ranges of about Options::range_size bytes,
+// and the ranges are parsed on worker threads.  Each worker allocates the
+// messages of a range on an Arena of its own, so parsing doesn't contend on
+// the heap and freeing a range's messages is a single Arena::Reset().
+//
+// Note that this means the whole file is read twice, and parsing only starts
+// once the first pass is done: the format has no sync markers, so there is
+// no way to find where a range starts without reading everything before it.
+// For a file that is not in the page cache (and won't fit in it), reading
+// it twice doubles the I/O; use record_io.h's format for such files.
+//
+// The worker threads are started on the first call to ReadAll() or Next()
+// and are kept until the reader is destroyed.
+//
+// Example:
+//
+//   class Counter : public ParallelDelimitedReader::Handler {
+//    public:
+//     bool HandleMessage(int64 record_number, const MessageLite& message) {
+//       const LogEntry& entry = static_cast<const LogEntry&>(message);
+//       ...  // Runs on several threads at once.
+//       return true;
+//     }
+//   };
+//
+//   FileRecordSource source(fd);
+//   ParallelDelimitedReader reader(&source, &LogEntry::default_instance());
+//   Counter counter;
+//   if (!reader.ReadAll(&counter)) { ... }
+
+#ifndef GOOGLE_PROTOBUF_IO_DELIMITED_READER_H__
+#define GOOGLE_PROTOBUF_IO_DELIMITED_READER_H__
+
+#include <string>
+#include <vector>
+#include <google/protobuf/stubs/common.h>
+
+namespace google {
+namespace protobuf {
+
+class MessageLite;
+
+namespace io {
+
+class RecordSource;  // record_io.h
+
+class LIBPROTOBUF_EXPORT ParallelDelimitedReader {
+ public:
+  struct Options {
+    // Number of threads parsing at once, counting the calling thread.
+    // Defaults to 4.
+    int num_threads;
+
+    // Ranges are closed once they hold at least this many bytes.  Each
+    // range is read in one piece, so this also bounds the buffer each
+    // thread needs (unless a single record is larger).  Defaults to 4MB.
+    int range_size;
+
+    Options();  // Initializes with default values.
+  };
+
+  // Receives the messages parsed by ReadAll().
+  class LIBPROTOBUF_EXPORT Handler {
+   public:
+    inline Handler() {}
+    virtual ~Handler();
+
+    // Called once per record, from several threads at once and in no
+    // particular order.  record_number counts from zero over the whole file.
+    // message is only valid during the call.  Return false to stop reading.
+    virtual bool HandleMessage(int64 record_number,
+                               const MessageLite& message) = 0;
+
+   private:
+    GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(Handler);
+  };
+
+  // Messages are created with prototype->New().  Neither the source nor the
+  // prototype is owned; both must outlive the reader.  The source's Read()
+  // is called from several threads at once.
+  ParallelDelimitedReader(RecordSource* source, const MessageLite* prototype);
+  ParallelDelimitedReader(RecordSource* source, const MessageLite* prototype,
+                          const Options& options);
+  ~ParallelDelimitedReader();
+
+  // Parses every message in the file and passes it to handler.  Returns
+  // false if the file is malformed, a message failed to parse, or the
+  // handler returned false.  Messages are not checked for missing required
+  // fields.
+  bool ReadAll(Handler* handler);
+
+  // Returns the messages one at a time, in file order.  While the caller
+  // works through one range, the worker threads parse the next ones, up to
+  // num_threads ranges ahead; if the caller catches up with them it parses
+  // the next range itself.  *message stays valid until the next call.
+  // Returns false at the end of the file or on error.  Don't mix with
+  // ReadAll().
+  bool Next(const MessageLite** message);
+
+  // Number of records in the file.  Scans the file for boundaries if that
+  // hasn't been done yet; returns -1 if the file is malformed.
+  int64 num_records();
+
+ private:
+  struct Range {
+    int64 start;
+    int64 end;
+    int64 first_record;
+    int num_records;
+  };
+  struct Slot;
+  struct Workers;
+
+  RecordSource* source_;
+  const MessageLite* prototype_;
+  Options options_;
+
+  bool scanned_;
+  bool scan_ok_;
+  int64 num_records_;
+  vector<Range> ranges_;
+
+  // The worker threads, and the lock guarding the fields below.
+  scoped_ptr<Workers> workers_;
+
+  // State of the ranges being parsed.  Threads claim ranges in order,
+  // starting at next_range_ and stopping short of claim_end_.  If handler_
+  // is NULL, range i is parsed into slots_[i % slots_.size()] and kept for
+  // Next().
+  int next_range_;
+  int claim_end_;
+  int busy_;  // Ranges claimed and not finished yet.
+  bool failed_;
+  Handler* handler_;
+  vector<Slot*> slots_;
+
+  // Position of Next(): the range whose messages it is returning (-1 before
+  // the first call) and the next message within that range.
+  int current_range_;
+  int current_message_;
+
+  // Finds the record boundaries and fills in ranges_.
+  bool Scan();
+  // Starts the worker threads if they aren't running yet.
+  void StartWorkers();
+  // Body of each worker thread.
+  void WorkerLoop();
+  // Parses range i, which the calling thread has just claimed, and passes
+  // its messages to handler_ or keeps them for Next().  Called with the lock
+  // held; releases it while parsing.
+  void RunRange(int i, Slot* own_slot);
+  // Parses all messages of range into slot's arena.
+  bool ParseRange(const Range& range, Slot* slot);
+  // Moves Next() on to the following range, waiting until it is parsed.
+  bool NextRange();
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ParallelDelimitedReader);
+};
+
+}  // namespace io
+}  // namespace protobuf
+
+}  // namespace google
+#endif  // GOOGLE_PROTOBUF_IO_DELIMITED_READER_H__
@@ -0,0 +1,247 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <vector>
+
+#include <google/protobuf/io/delimited_reader.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/record_io.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/unittest.pb.h>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/testing/googletest.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace io {
+namespace {
+
+using protobuf_unittest::TestAllTypes;
+
+string MakeFile(int num_records) {
+  string file;
+  StringOutputStream output(&file);
+  CodedOutputStream coded_output(&output);
+  TestAllTypes message;
+  for (int i = 0; i < num_records; i++) {
+    message.set_optional_int32(i);
+    message.set_optional_string(string(i % 50, 'x'));
+    message.add_repeated_int64(i);
+    coded_output.WriteVarint32(message.ByteSize());
+    message.SerializeWithCachedSizes(&coded_output);
+  }
+  return file;
+}
+
+// Records which messages it was handed.
+class CheckingHandler : public ParallelDelimitedReader::Handler {
+ public:
+  explicit CheckingHandler(int num_records)
+      : seen_(num_records, 0), stop_after_(-1) {}
+
+  bool HandleMessage(int64 record_number, const MessageLite& message) {
+    const TestAllTypes& typed = static_cast<const TestAllTypes&>(message);
+    EXPECT_EQ(record_number, typed.optional_int32());
+    EXPECT_EQ(record_number % 50, typed.optional_string().size());
+    EXPECT_EQ(record_number + 1, typed.repeated_int64_size());
+    MutexLock lock(&mutex_);
+    ++seen_[record_number];
+    return record_number != stop_after_;
+  }
+
+  vector<int> seen_;
+  int stop_after_;
+
+ private:
+  Mutex mutex_;
+};
+
+class NullHandler : public ParallelDelimitedReader::Handler {
+ public:
+  bool HandleMessage(int64 record_number, const MessageLite& message) {
+    return true;
+  }
+};
+
+TEST(ParallelDelimitedReaderTest, ReadAll) {
+  string file = MakeFile(500);
+  ArrayRecordSource source(file.data(), file.size());
+
+  int kNumThreads[] = { 1, 3, 8 };
+  int kRangeSizes[] = { 1, 1000, 1 << 20 };
+  for (int t = 0; t < GOOGLE_ARRAYSIZE(kNumThreads); t++) {
+    for (int r = 0; r < GOOGLE_ARRAYSIZE(kRangeSizes); r++) {
+      SCOPED_TRACE(StrCat("num_threads ", kNumThreads[t],
+                          " range_size ", kRangeSizes[r]));
+      ParallelDelimitedReader::Options options;
+      options.num_threads = kNumThreads[t];
+      options.range_size = kRangeSizes[r];
+      ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance(),
+                                     options);
+      EXPECT_EQ(500, reader.num_records());
+      CheckingHandler handler(500);
+      EXPECT_TRUE(reader.ReadAll(&handler));
+      // Again, with the worker threads already running.
+      EXPECT_TRUE(reader.ReadAll(&handler));
+      for (int i = 0; i < 500; i++) {
+        EXPECT_EQ(2, handler.seen_[i]) << i;
+      }
+    }
+  }
+}
+
+TEST(ParallelDelimitedReaderTest, Next) {
+  string file = MakeFile(500);
+  ArrayRecordSource source(file.data(), file.size());
+
+  int kRangeSizes[] = { 1, 1000, 1 << 20 };
+  for (int r = 0; r < GOOGLE_ARRAYSIZE(kRangeSizes); r++) {
+    ParallelDelimitedReader::Options options;
+    options.range_size = kRangeSizes[r];
+    ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance(),
+                                   options);
+    const MessageLite* message;
+    for (int i = 0; i < 500; i++) {
+      ASSERT_TRUE(reader.Next(&message));
+      EXPECT_EQ(i, static_cast<const TestAllTypes*>(message)
+                       ->optional_int32());
+    }
+    EXPECT_FALSE(reader.Next(&message));
+    EXPECT_FALSE(reader.Next(&message));
+  }
+}
+
+TEST(ParallelDelimitedReaderTest, DestroyWhileParsingAhead) {
+  string file = MakeFile(500);
+  ArrayRecordSource source(file.data(), file.size());
+  ParallelDelimitedReader::Options options;
+  options.range_size = 100;
+  ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance(),
+                                 options);
+  const MessageLite* message;
+  ASSERT_TRUE(reader.Next(&message));
+  EXPECT_EQ(0, static_cast<const TestAllTypes*>(message)->optional_int32());
+  // The reader is destroyed while the workers are busy with later ranges.
+}
+
+TEST(ParallelDelimitedReaderTest, EmptyFile) {
+  ArrayRecordSource source(NULL, 0);
+  ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance());
+  EXPECT_EQ(0, reader.num_records());
+  CheckingHandler handler(0);
+  EXPECT_TRUE(reader.ReadAll(&handler));
+
+  ParallelDelimitedReader reader2(&source, &TestAllTypes::default_instance());
+  const MessageLite* message;
+  EXPECT_FALSE(reader2.Next(&message));
+}
+
+TEST(ParallelDelimitedReaderTest, HandlerStops) {
+  string file = MakeFile(500);
+  ArrayRecordSource source(file.data(), file.size());
+  ParallelDelimitedReader::Options options;
+  options.range_size = 1000;
+  ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance(),
+                                 options);
+  CheckingHandler handler(500);
+  handler.stop_after_ = 10;
+  EXPECT_FALSE(reader.ReadAll(&handler));
+  EXPECT_EQ(1, handler.seen_[10]);
+}
+
+TEST(ParallelDelimitedReaderTest, Truncated) {
+  string file = MakeFile(500);
+  file.resize(file.size() - 1);
+  ArrayRecordSource source(file.data(), file.size());
+  ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance());
+  EXPECT_EQ(-1, reader.num_records());
+  CheckingHandler handler(500);
+  EXPECT_FALSE(reader.ReadAll(&handler));
+
+  // A length prefix cut off in the middle.
+  string prefix_only = "\x80";
+  ArrayRecordSource source2(prefix_only.data(), prefix_only.size());
+  ParallelDelimitedReader reader2(&source2, &TestAllTypes::default_instance());
+  EXPECT_EQ(-1, reader2.num_records());
+}
+
+TEST(ParallelDelimitedReaderTest, FileChangedAfterScan) {
+  string file = MakeFile(500);
+  ArrayRecordSource source(file.data(), file.size());
+  ParallelDelimitedReader::Options options;
+  options.range_size = 1000;
+  ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance(),
+                                 options);
+  EXPECT_EQ(500, reader.num_records());
+
+  // Make the first record's length run past the end of its range.
+  file[0] = '\xff';
+  file[1] = '\x7f';
+  ScopedMemoryLog log;
+  NullHandler handler;
+  EXPECT_FALSE(reader.ReadAll(&handler));
+  EXPECT_EQ(1, log.GetMessages(ERROR).size());
+}
+
+TEST(ParallelDelimitedReaderTest, ParseError) {
+  string file = MakeFile(100);
+  file += "\x02\xff\xff";  // Not a valid message.
+  file += MakeFile(100);
+  ArrayRecordSource source(file.data(), file.size());
+  ParallelDelimitedReader::Options options;
+  options.range_size = 100;
+  ParallelDelimitedReader reader(&source, &TestAllTypes::default_instance(),
+                                 options);
+  EXPECT_EQ(201, reader.num_records());
+
+  // Messages from batches before the broken range come out; nothing after.
+  const MessageLite* message;
+  int count = 0;
+  while (reader.Next(&message)) {
+    EXPECT_EQ(count, static_cast<const TestAllTypes*>(message)
+                         ->optional_int32());
+    ++count;
+  }
+  EXPECT_LE(count, 100);
+  EXPECT_FALSE(reader.Next(&message));
+
+  ParallelDelimitedReader reader2(&source, &TestAllTypes::default_instance(),
+                                  options);
+  NullHandler handler;
+  EXPECT_FALSE(reader2.ReadAll(&handler));
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
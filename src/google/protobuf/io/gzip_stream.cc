@@ -38,7 +38,11 @@
 #if HAVE_ZLIB
 #include <google/protobuf/io/gzip_stream.h>
 
+#include <algorithm>
+#include <utility>
+
 #include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/hash.h>
 
 namespace google {
 namespace protobuf {
@@ -84,6 +88,26 @@ static inline int internalInflateInit2(
   return inflateInit2(zcontext, /* windowBits */15 | windowBitsFormat);
 }
 
+void GzipInputStream::SetDictionary(const string& dictionary) {
+  dictionary_ = dictionary;
+}
+
+void GzipInputStream::Reset(ZeroCopyInputStream* sub_stream) {
+  sub_stream_ = sub_stream;
+  zerror_ = Z_OK;
+  byte_count_ = 0;
+  // The zlib state is initialized lazily by the first Inflate(), which leaves
+  // next_in non-NULL.  If that happened, reset it in place instead of paying
+  // for inflateEnd() and inflateInit2() again.
+  if (zcontext_.next_in != NULL) {
+    zerror_ = inflateReset(&zcontext_);
+  }
+  zcontext_.avail_in = 0;
+  zcontext_.next_out = static_cast<Bytef*>(output_buffer_);
+  zcontext_.avail_out = output_buffer_length_;
+  output_position_ = output_buffer_;
+}
+
 int GzipInputStream::Inflate(int flush) {
   if ((zerror_ == Z_OK) && (zcontext_.avail_out == 0)) {
     // previous inflate filled output buffer. don't change input params yet.
@@ -110,6 +134,15 @@ int GzipInputStream::Inflate(int flush) {
   zcontext_.avail_out = output_buffer_length_;
   output_position_ = output_buffer_;
   int error = inflate(&zcontext_, flush);
+  if (error == Z_NEED_DICT && !dictionary_.empty()) {
+    // The zlib header asked for a preset dictionary; supply it and continue.
+    error = inflateSetDictionary(
+        &zcontext_, reinterpret_cast<const Bytef*>(dictionary_.data()),
+        dictionary_.size());
+    if (error == Z_OK) {
+      error = inflate(&zcontext_, flush);
+    }
+  }
   return error;
 }
 
@@ -206,22 +239,15 @@ GzipOutputStream::GzipOutputStream(ZeroCopyOutputStream* sub_stream,
 
 void GzipOutputStream::Init(ZeroCopyOutputStream* sub_stream,
                             const Options& options) {
-  sub_stream_ = sub_stream;
-  sub_data_ = NULL;
-  sub_data_size_ = 0;
-
   input_buffer_length_ = options.buffer_size;
   input_buffer_ = operator new(input_buffer_length_);
   GOOGLE_CHECK(input_buffer_ != NULL);
+  dictionary_ = options.dictionary;
 
   zcontext_.zalloc = Z_NULL;
   zcontext_.zfree = Z_NULL;
   zcontext_.opaque = Z_NULL;
-  zcontext_.next_out = NULL;
-  zcontext_.avail_out = 0;
   zcontext_.total_out = 0;
-  zcontext_.next_in = NULL;
-  zcontext_.avail_in = 0;
   zcontext_.total_in = 0;
   zcontext_.msg = NULL;
   // default to GZIP format
@@ -236,10 +262,31 @@ void GzipOutputStream::Init(ZeroCopyOutputStream* sub_stream,
       /* windowBits */15 | windowBitsFormat,
       /* memLevel (default) */8,
       options.compression_strategy);
+  zcontext_initialized_ = zerror_ == Z_OK;
+  StartStream(sub_stream);
+}
+
+void GzipOutputStream::StartStream(ZeroCopyOutputStream* sub_stream) {
+  sub_stream_ = sub_stream;
+  sub_data_ = NULL;
+  sub_data_size_ = 0;
+
+  zcontext_.next_out = NULL;
+  zcontext_.avail_out = 0;
+  zcontext_.next_in = NULL;
+  zcontext_.avail_in = 0;
+  if (zerror_ == Z_OK && !dictionary_.empty()) {
+    zerror_ = deflateSetDictionary(
+        &zcontext_, reinterpret_cast<const Bytef*>(dictionary_.data()),
+        dictionary_.size());
+  }
 }
 
 GzipOutputStream::~GzipOutputStream() {
   Close();
+  if (zcontext_initialized_) {
+    deflateEnd(&zcontext_);
+  }
   if (input_buffer_ != NULL) {
     operator delete(input_buffer_);
   }
@@ -318,12 +365,142 @@ bool GzipOutputStream::Close() {
   do {
     zerror_ = Deflate(Z_FINISH);
   } while (zerror_ == Z_OK);
-  zerror_ = deflateEnd(&zcontext_);
-  bool ok = zerror_ == Z_OK;
+  // The zlib state itself is kept around until destruction so that Reset()
+  // can reuse it.
+  bool ok = zerror_ == Z_STREAM_END;
   zerror_ = Z_STREAM_END;
   return ok;
 }
 
+bool GzipOutputStream::Reset(ZeroCopyOutputStream* sub_stream) {
+  if (!zcontext_initialized_) {
+    // deflateInit2() failed, so there is no zlib state to reset.
+    return false;
+  }
+  if (zerror_ != Z_STREAM_END) {
+    Close();
+  }
+  zerror_ = deflateReset(&zcontext_);
+  StartStream(sub_stream);
+  return zerror_ == Z_OK;
+}
+
+// =========================================================================
+
+namespace {
+
+// Length of the byte sequences counted by BuildGzipDictionary().  deflate
+// cannot encode matches shorter than three bytes and short matches barely pay
+// for their distance code, so longer sequences make better dictionary units.
+const int kDictionaryGramLength = 8;
+
+struct GramInfo {
+  // Number of samples the sequence occurs in.
+  int count;
+  // Index of the last sample the sequence was seen in, to count each sample
+  // only once.
+  int last_sample;
+  // Whether the sequence has already been placed in the dictionary.
+  bool used;
+};
+
+typedef hash_map<string, GramInfo> GramMap;
+
+// Orders sequences by decreasing sample count, breaking ties by content so
+// that the generated dictionary is deterministic.
+bool CompareGrams(const pair<int, string>& a, const pair<int, string>& b) {
+  if (a.first != b.first) return a.first > b.first;
+  return a.second < b.second;
+}
+
+}  // namespace
+
+void BuildGzipDictionary(const vector<string>& samples, int max_size,
+                         string* dictionary) {
+  dictionary->clear();
+  if (max_size <= 0) return;
+
+  GramMap grams;
+  for (int i = 0; i < samples.size(); i++) {
+    const string& sample = samples[i];
+    for (int j = 0; j + kDictionaryGramLength <= sample.size(); j++) {
+      GramInfo& info = grams[sample.substr(j, kDictionaryGramLength)];
+      if (info.count == 0 || info.last_sample != i) {
+        info.count++;
+        info.last_sample = i;
+        info.used = false;
+      }
+    }
+  }
+
+  // A sequence that occurs in a single sample is unlikely to help with the
+  // next one, unless that's all we have to go on.
+  const int min_count = samples.size() > 1 ? 2 : 1;
+  vector<pair<int, string> > candidates;
+  for (GramMap::const_iterator it = grams.begin(); it != grams.end(); ++it) {
+    if (it->second.count >= min_count) {
+      candidates.push_back(make_pair(it->second.count, it->first));
+    }
+  }
+  sort(candidates.begin(), candidates.end(), CompareGrams);
+
+  // Starting from the most common sequence, grow each piece to the right
+  // while some continuation is at least half as common, so that longer
+  // shared runs (a tag followed by a common value, say) end up contiguous.
+  // A piece that grows into the start of an earlier piece absorbs it.
+  vector<string> pieces;
+  hash_map<string, int> piece_starts;
+  int total_size = 0;
+  for (int i = 0; i < candidates.size(); i++) {
+    GramInfo& info = grams[candidates[i].second];
+    if (info.used) continue;
+    info.used = true;
+    string piece = candidates[i].second;
+
+    while (total_size + piece.size() < max_size) {
+      string next = piece.substr(piece.size() - kDictionaryGramLength + 1);
+      next.push_back('\0');
+      GramInfo* best = NULL;
+      string best_gram;
+      for (int c = 0; c < 256; c++) {
+        next[kDictionaryGramLength - 1] = static_cast<char>(c);
+        GramMap::iterator it = grams.find(next);
+        if (it != grams.end() &&
+            (!it->second.used || piece_starts.count(next) > 0) &&
+            (best == NULL || it->second.count > best->count)) {
+          best = &it->second;
+          best_gram = next;
+        }
+      }
+      if (best == NULL || best->count * 2 < candidates[i].first) break;
+      if (best->used) {
+        int index = piece_starts[best_gram];
+        string& absorbed = pieces[index];
+        if (total_size + piece.size() + 1 > max_size) break;
+        piece.append(absorbed, kDictionaryGramLength - 1, string::npos);
+        total_size -= absorbed.size();
+        absorbed.clear();
+        piece_starts.erase(best_gram);
+        break;
+      }
+      best->used = true;
+      piece.push_back(best_gram[kDictionaryGramLength - 1]);
+    }
+
+    if (total_size + piece.size() > max_size) break;
+    total_size += piece.size();
+    piece_starts[piece.substr(0, kDictionaryGramLength)] = pieces.size();
+    pieces.push_back(piece);
+  }
+
+  // zlib encodes matches closer to the end of the dictionary with shorter
+  // distance codes, so put the most common pieces last.
+  dictionary->reserve(total_size);
+  for (int i = pieces.size() - 1; i >= 0; i--) {
+    dictionary->append(pieces[i]);
+  }
+}
+
 }  // namespace io
 }  // namespace protobuf
 }  // namespace google
@@ -45,6 +45,8 @@
 
 #include <zlib.h>
 
+#include <string>
+#include <vector>
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/io/zero_copy_stream.h>
 
@@ -82,6 +84,19 @@ class LIBPROTOBUF_EXPORT GzipInputStream : public ZeroCopyInputStream {
     return zerror_;
   }
 
+  // Sets the preset dictionary used to decompress ZLIB streams that were
+  // written with GzipOutputStream::Options::dictionary.  The dictionary is
+  // only consulted when zlib reports that the stream requires one, so it is
+  // safe to set it for streams that were compressed without a dictionary.
+  // Must be called before the first call to Next().
+  void SetDictionary(const string& dictionary);
+
+  // Starts reading a new compressed stream from sub_stream, reusing the
+  // output buffer and the zlib state allocated for the previous stream.
+  // This makes it cheap to decompress many small messages one after another.
+  // The preset dictionary, if any, is kept.
+  void Reset(ZeroCopyInputStream* sub_stream);
+
   // implements ZeroCopyInputStream ----------------------------------
   bool Next(const void** data, int* size);
   void BackUp(int count);
@@ -92,6 +107,7 @@ class LIBPROTOBUF_EXPORT GzipInputStream : public ZeroCopyInputStream {
   Format format_;
 
   ZeroCopyInputStream* sub_stream_;
+  string dictionary_;
 
   z_stream zcontext_;
   int zerror_;
@@ -135,6 +151,16 @@ class LIBPROTOBUF_EXPORT GzipOutputStream : public ZeroCopyOutputStream {
     // zlib.h for definitions of these constants.
     int compression_strategy;
 
+    // A preset dictionary to prime the compressor with.  Small messages
+    // compress much better when their common byte sequences (field tags,
+    // enum names, repeated string values) are found in the dictionary.
+    // Readers must pass the same dictionary to
+    // GzipInputStream::SetDictionary().  zlib only supports preset
+    // dictionaries in the ZLIB format; with GZIP the stream will fail with
+    // Z_STREAM_ERROR.  Defaults to empty (no dictionary).  See
+    // BuildGzipDictionary() for a way to build one from sample data.
+    string dictionary;
+
     Options();  // Initializes with default values.
   };
 
@@ -173,9 +199,22 @@ class LIBPROTOBUF_EXPORT GzipOutputStream : public ZeroCopyOutputStream {
   // Writes out all data and closes the gzip stream.
   // It is the caller's responsibility to close the underlying stream if
   // necessary.
+  // The zlib state is kept so that Reset() can reuse it, and is only freed
+  // when the GzipOutputStream is destroyed.  With the default options that
+  // is about 256kB plus the input buffer, so destroy streams which will not
+  // be reset rather than keeping them around closed.
   // Returns true if no error.
   bool Close();
 
+  // Starts a new compressed stream that is written to sub_stream, reusing
+  // the input buffer and the zlib state allocated for the previous stream
+  // rather than tearing them down and initializing them again.  The current
+  // stream is closed first if Close() has not been called yet.  All options,
+  // including the preset dictionary, carry over to the new stream.
+  // Returns true if no error, and false without doing anything if the
+  // stream could not be initialized in the first place.
+  bool Reset(ZeroCopyOutputStream* sub_stream);
+
   // implements ZeroCopyOutputStream ---------------------------------
   bool Next(void** data, int* size);
   void BackUp(int count);
@@ -189,12 +228,17 @@ class LIBPROTOBUF_EXPORT GzipOutputStream : public ZeroCopyOutputStream {
 
   z_stream zcontext_;
   int zerror_;
+  bool zcontext_initialized_;  // Whether deflateInit2() succeeded.
   void* input_buffer_;
   size_t input_buffer_length_;
+  string dictionary_;
 
   // Shared constructor code.
   void Init(ZeroCopyOutputStream* sub_stream, const Options& options);
 
+  // Resets the per-stream state and primes zlib with dictionary_.
+  void StartStream(ZeroCopyOutputStream* sub_stream);
+
   // Do some compression.
   // Takes zlib flush mode.
   // Returns zlib error code.
@@ -203,6 +247,15 @@ class LIBPROTOBUF_EXPORT GzipOutputStream : public ZeroCopyOutputStream {
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(GzipOutputStream);
 };
 
+// Builds a preset dictionary suitable for GzipOutputStream::Options::dictionary
+// from a set of representative samples, e.g. serialized messages of the type
+// that is going to be compressed.  The dictionary is made of the byte
+// sequences that occur in the largest number of samples, with the most common
+// ones placed at the end where zlib can reference them most cheaply.  The
+// result is at most max_size bytes (zlib uses at most 32kB of it).
+LIBPROTOBUF_EXPORT void BuildGzipDictionary(const vector<string>& samples,
+                                            int max_size, string* dictionary);
+
 }  // namespace io
 }  // namespace protobuf
 
@@ -0,0 +1,562 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the implementation of classes LzInputStream and
+// LzOutputStream.
+//
+// Compressed block format
+// -----------------------
+// A block is a sequence of commands, each of which copies some literal bytes
+// from the input followed by a back-reference into the data decompressed so
+// far.  A command starts with a token byte: the high four bits hold the
+// number of literals and the low four bits the match length minus
+// kMinMatch.  A nibble value of 15 means more length follows in additional
+// bytes, each of which is added to the length; a byte less than 255 ends the
+// sequence.  The literal-length bytes come right after the token, then the
+// literals, then the match distance as two little-endian bytes, then the
+// match-length bytes.  The last command has literals only, and ends exactly
+// at the end of the input.
+//
+// Stream framing
+// --------------
+// The stream is a sequence of blocks, each preceded by a header of three
+// little-endian 32-bit words:
+//   payload size << 1 | 1 if the payload is compressed, 0 if stored as-is
+//   uncompressed size
+//   masked CRC32C of the uncompressed data
+
+#include <google/protobuf/io/lz_stream.h>
+
+#include <string.h>
+#include <algorithm>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/crc32c.h>
+#include <google/protobuf/stubs/stl_util.h>
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+namespace {
+
+const int kDefaultBlockSize = 65536;
+const int kBlockHeaderSize = 12;
+
+// Shortest match the compressor emits.
+const int kMinMatch = 4;
+// Farthest back a match may point; distances are stored in two bytes.
+const int kMaxDistance = 65535;
+// The compressor leaves the last kLastLiterals bytes as literals and starts no
+// match within the last kMatchFindLimit bytes, which keeps the inner loops
+// free of end-of-buffer checks.
+const int kLastLiterals = 5;
+const int kMatchFindLimit = 12;
+
+const int kHashLog = 13;
+// After this many consecutive failed match attempts the compressor starts
+// skipping ahead, so incompressible data is passed over quickly.
+const int kSkipTrigger = 6;
+
+inline uint32 ReadUnaligned32(const uint8* p) {
+  uint32 result;
+  memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline uint32 HashSequence(uint32 sequence) {
+  return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+inline uint8* WriteLength(uint8* op, int length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = static_cast<uint8>(length);
+  return op;
+}
+
+// Writes one command to op.
+inline uint8* WriteCommand(uint8* op, const uint8* literals,
+                           int literal_length, int distance,
+                           int match_length) {
+  uint8* token = op++;
+  if (literal_length >= 15) {
+    *token = 15 << 4;
+    op = WriteLength(op, literal_length - 15);
+  } else {
+    *token = literal_length << 4;
+  }
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+  if (match_length == 0) return op;  // Last command.
+
+  *op++ = static_cast<uint8>(distance);
+  *op++ = static_cast<uint8>(distance >> 8);
+  int length = match_length - kMinMatch;
+  if (length >= 15) {
+    *token |= 15;
+    op = WriteLength(op, length - 15);
+  } else {
+    *token |= length;
+  }
+  return op;
+}
+
+// Reads an extended length as written by WriteLength().  Returns false if the
+// input ends first or the length exceeds limit.
+inline bool ReadLength(const uint8** ip, const uint8* end, int limit,
+                       int* length) {
+  int b;
+  do {
+    if (*ip >= end) return false;
+    b = *(*ip)++;
+    *length += b;
+    if (*length > limit) return false;
+  } while (b == 255);
+  return true;
+}
+
+inline void WriteLittleEndian32(uint32 value, uint8* p) {
+  p[0] = static_cast<uint8>(value);
+  p[1] = static_cast<uint8>(value >> 8);
+  p[2] = static_cast<uint8>(value >> 16);
+  p[3] = static_cast<uint8>(value >> 24);
+}
+
+inline uint32 ReadLittleEndian32(const uint8* p) {
+  return static_cast<uint32>(p[0]) |
+         (static_cast<uint32>(p[1]) << 8) |
+         (static_cast<uint32>(p[2]) << 16) |
+         (static_cast<uint32>(p[3]) << 24);
+}
+
+}  // namespace
+
+// Block codec ======================================================
+
+int LzMaxCompressedLength(int size) {
+  // Incompressible input costs one length byte per 255 literals, plus the
+  // token and a little slack.
+  return size + size / 255 + 16;
+}
+
+int LzCompress(const void* input, int size, void* output) {
+  const uint8* const base = static_cast<const uint8*>(input);
+  uint8* op = static_cast<uint8*>(output);
+  const uint8* anchor = base;
+
+  if (size >= kMatchFindLimit + 1) {
+    const uint8* const match_limit = base + size - kLastLiterals;
+    const uint8* const find_limit = base + size - kMatchFindLimit;
+
+    // Position of the last occurrence of each hashed four-byte sequence.
+    int32 table[1 << kHashLog];
+    memset(table, 0, sizeof(table));
+
+    const uint8* ip = base + 1;
+    while (true) {
+      // Find a match.
+      const uint8* match;
+      int attempts = 1 << kSkipTrigger;
+      while (true) {
+        if (ip > find_limit) goto last_literals;
+        uint32 sequence = ReadUnaligned32(ip);
+        uint32 h = HashSequence(sequence);
+        match = base + table[h];
+        table[h] = ip - base;
+        if (ip - match <= kMaxDistance && match < ip &&
+            ReadUnaligned32(match) == sequence) {
+          break;
+        }
+        ip += attempts++ >> kSkipTrigger;
+      }
+
+      // Extend the match backwards over pending literals...
+      while (ip > anchor && match > base && ip[-1] == match[-1]) {
+        --ip;
+        --match;
+      }
+      // ...and forwards.
+      const uint8* end = ip + kMinMatch;
+      const uint8* ref = match + kMinMatch;
+      while (end < match_limit && *end == *ref) {
+        ++end;
+        ++ref;
+      }
+
+      op = WriteCommand(op, anchor, ip - anchor, ip - match, end - ip);
+      anchor = ip = end;
+      if (ip > find_limit) break;
+      // Make the position just before the new anchor findable, since the
+      // data around the end of a match often repeats soon.
+      table[HashSequence(ReadUnaligned32(ip - 2))] = ip - 2 - base;
+    }
+  }
+
+ last_literals:
+  op = WriteCommand(op, anchor, base + size - anchor, 0, 0);
+  return op - static_cast<uint8*>(output);
+}
+
+bool LzUncompress(const void* input, int size,
+                  void* output, int uncompressed_size) {
+  const uint8* ip = static_cast<const uint8*>(input);
+  const uint8* const input_end = ip + size;
+  uint8* const base = static_cast<uint8*>(output);
+  uint8* op = base;
+  uint8* const output_end = base + uncompressed_size;
+
+  while (true) {
+    if (ip >= input_end) return false;
+    int token = *ip++;
+
+    // Literals.
+    int length = token >> 4;
+    if (length == 15 &&
+        !ReadLength(&ip, input_end, uncompressed_size, &length)) {
+      return false;
+    }
+    if (length > input_end - ip || length > output_end - op) return false;
+    memcpy(op, ip, length);
+    op += length;
+    ip += length;
+    if (ip == input_end) break;  // Last command.
+
+    // Match.
+    if (input_end - ip < 2) return false;
+    int distance = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (distance == 0 || distance > op - base) return false;
+    length = token & 15;
+    if (length == 15 &&
+        !ReadLength(&ip, input_end, uncompressed_size, &length)) {
+      return false;
+    }
+    length += kMinMatch;
+    if (length > output_end - op) return false;
+
+    const uint8* match = op - distance;
+    if (distance >= 8) {
+      // Copy eight bytes at a time; the source never overlaps the
+      // destination within a single step.
+      uint8* const end = op + length;
+      while (end - op >= 8) {
+        memcpy(op, match, 8);
+        op += 8;
+        match += 8;
+      }
+      while (op < end) *op++ = *match++;
+    } else {
+      // Short distances repeat a pattern, so copy byte by byte.
+      for (int i = 0; i < length; i++) *op++ = *match++;
+    }
+  }
+
+  return op == output_end;
+}
+
+// LzInputStream ====================================================
+
+LzInputStream::LzInputStream(ZeroCopyInputStream* sub_stream)
+    : sub_stream_(sub_stream),
+      had_error_(false),
+      block_data_(NULL),
+      block_size_(0),
+      position_(0),
+      byte_count_(0) {}
+
+LzInputStream::~LzInputStream() {}
+
+bool LzInputStream::ReadRaw(void* data, int size, bool* eof) {
+  char* out = static_cast<char*>(data);
+  *eof = false;
+  int copied = 0;
+  while (copied < size) {
+    const void* buffer;
+    int buffer_size;
+    if (!sub_stream_->Next(&buffer, &buffer_size)) {
+      *eof = copied == 0;
+      return false;
+    }
+    int n = min(buffer_size, size - copied);
+    memcpy(out + copied, buffer, n);
+    copied += n;
+    if (n < buffer_size) sub_stream_->BackUp(buffer_size - n);
+  }
+  return true;
+}
+
+bool LzInputStream::ReadBlock() {
+  uint8 header[kBlockHeaderSize];
+  bool eof;
+  if (!ReadRaw(header, kBlockHeaderSize, &eof)) {
+    had_error_ = !eof;
+    return false;
+  }
+  uint32 type_and_size = ReadLittleEndian32(header);
+  uint32 uncompressed_size = ReadLittleEndian32(header + 4);
+  uint32 expected_crc = internal::UnmaskCrc32c(ReadLittleEndian32(header + 8));
+  bool compressed = (type_and_size & 1) != 0;
+  uint32 payload_size = type_and_size >> 1;
+
+  if (uncompressed_size > LzOutputStream::kMaxBlockSize ||
+      (compressed
+           ? payload_size > LzMaxCompressedLength(uncompressed_size)
+           : payload_size != uncompressed_size)) {
+    had_error_ = true;
+    return false;
+  }
+
+  // Use the payload in place if sub_stream_ returns it in one piece, which
+  // is the common case for array and file streams with reasonable buffers.
+  const char* payload;
+  const void* buffer;
+  int buffer_size;
+  if (payload_size == 0) {
+    payload = NULL;
+  } else if (!sub_stream_->Next(&buffer, &buffer_size)) {
+    had_error_ = true;
+    return false;
+  } else if (buffer_size >= payload_size) {
+    payload = static_cast<const char*>(buffer);
+    if (buffer_size > payload_size) {
+      sub_stream_->BackUp(buffer_size - payload_size);
+    }
+  } else {
+    STLStringResizeUninitialized(&input_buffer_, payload_size);
+    memcpy(string_as_array(&input_buffer_), buffer, buffer_size);
+    if (!ReadRaw(string_as_array(&input_buffer_) + buffer_size,
+                 payload_size - buffer_size, &eof)) {
+      had_error_ = true;
+      return false;
+    }
+    payload = input_buffer_.data();
+  }
+
+  const char* data;
+  if (compressed) {
+    if (output_buffer_.size() < uncompressed_size) {
+      STLStringResizeUninitialized(&output_buffer_, uncompressed_size);
+    }
+    if (!LzUncompress(payload, payload_size,
+                      string_as_array(&output_buffer_), uncompressed_size)) {
+      had_error_ = true;
+      return false;
+    }
+    data = output_buffer_.data();
+  } else {
+    data = payload;
+  }
+
+  if (internal::Crc32c(data, uncompressed_size) != expected_crc) {
+    had_error_ = true;
+    return false;
+  }
+
+  byte_count_ += block_size_;
+  block_data_ = data;
+  block_size_ = uncompressed_size;
+  position_ = 0;
+  return true;
+}
+
+bool LzInputStream::Next(const void** data, int* size) {
+  while (position_ == block_size_) {
+    if (had_error_ || !ReadBlock()) return false;
+  }
+  *data = block_data_ + position_;
+  *size = block_size_ - position_;
+  position_ = block_size_;
+  return true;
+}
+
+void LzInputStream::BackUp(int count) {
+  GOOGLE_CHECK_LE(count, position_)
+      << "Can't back up over more bytes than were returned by the last call"
+         " to Next().";
+  position_ -= count;
+}
+
+bool LzInputStream::Skip(int count) {
+  const void* data;
+  int size;
+  while (count > 0) {
+    if (!Next(&data, &size)) return false;
+    if (size > count) {
+      BackUp(size - count);
+      return true;
+    }
+    count -= size;
+  }
+  return true;
+}
+
+int64 LzInputStream::ByteCount() const {
+  return byte_count_ + position_;
+}
+
+// LzOutputStream ===================================================
+
+const int LzOutputStream::kMaxBlockSize;
+
+LzOutputStream::Options::Options()
+    : block_size(kDefaultBlockSize) {}
+
+LzOutputStream::LzOutputStream(ZeroCopyOutputStream* sub_stream)
+    : sub_stream_(sub_stream),
+      had_error_(false),
+      closed_(false),
+      input_used_(0),
+      byte_count_(0) {
+  STLStringResizeUninitialized(&input_buffer_, kDefaultBlockSize);
+}
+
+LzOutputStream::LzOutputStream(ZeroCopyOutputStream* sub_stream,
+                               const Options& options)
+    : sub_stream_(sub_stream),
+      had_error_(false),
+      closed_(false),
+      input_used_(0),
+      byte_count_(0) {
+  GOOGLE_CHECK_GT(options.block_size, 0);
+  GOOGLE_CHECK_LE(options.block_size, kMaxBlockSize);
+  STLStringResizeUninitialized(&input_buffer_, options.block_size);
+}
+
+LzOutputStream::~LzOutputStream() {
+  Close();
+}
+
+bool LzOutputStream::WriteRaw(const void* data, int size) {
+  const char* in = static_cast<const char*>(data);
+  while (size > 0) {
+    void* buffer;
+    int buffer_size;
+    if (!sub_stream_->Next(&buffer, &buffer_size)) return false;
+    int n = min(buffer_size, size);
+    memcpy(buffer, in, n);
+    in += n;
+    size -= n;
+    if (n < buffer_size) sub_stream_->BackUp(buffer_size - n);
+  }
+  return true;
+}
+
+bool LzOutputStream::WriteBlock() {
+  if (input_used_ == 0) return true;
+  const char* input = input_buffer_.data();
+  const int max_payload_size = LzMaxCompressedLength(input_used_);
+
+  uint8 header[kBlockHeaderSize];
+  WriteLittleEndian32(input_used_, header + 4);
+  WriteLittleEndian32(
+      internal::MaskCrc32c(internal::Crc32c(input, input_used_)), header + 8);
+
+  // If sub_stream_'s next buffer is big enough, compress straight into it
+  // rather than into output_buffer_.
+  void* buffer;
+  int buffer_size;
+  if (!sub_stream_->Next(&buffer, &buffer_size)) return false;
+  bool direct = buffer_size >= kBlockHeaderSize + max_payload_size;
+  uint8* payload;
+  if (direct) {
+    payload = static_cast<uint8*>(buffer) + kBlockHeaderSize;
+  } else {
+    sub_stream_->BackUp(buffer_size);
+    if (output_buffer_.size() < max_payload_size) {
+      STLStringResizeUninitialized(&output_buffer_, max_payload_size);
+    }
+    payload = reinterpret_cast<uint8*>(string_as_array(&output_buffer_));
+  }
+
+  int payload_size = LzCompress(input, input_used_, payload);
+  bool compressed = payload_size < input_used_;
+  if (!compressed) {
+    // Not worth it; store the block as-is so that reading it is a plain copy
+    // (or no copy at all).
+    memcpy(payload, input, input_used_);
+    payload_size = input_used_;
+  }
+  WriteLittleEndian32((static_cast<uint32>(payload_size) << 1) |
+                      (compressed ? 1 : 0), header);
+
+  byte_count_ += input_used_;
+  input_used_ = 0;
+  if (direct) {
+    memcpy(buffer, header, kBlockHeaderSize);
+    sub_stream_->BackUp(buffer_size - kBlockHeaderSize - payload_size);
+    return true;
+  }
+  return WriteRaw(header, kBlockHeaderSize) &&
+         WriteRaw(payload, payload_size);
+}
+
+bool LzOutputStream::Next(void** data, int* size) {
+  if (had_error_ || closed_) return false;
+  if (input_used_ == input_buffer_.size() && !WriteBlock()) {
+    had_error_ = true;
+    return false;
+  }
+  *data = string_as_array(&input_buffer_) + input_used_;
+  *size = input_buffer_.size() - input_used_;
+  input_used_ = input_buffer_.size();
+  return true;
+}
+
+void LzOutputStream::BackUp(int count) {
+  GOOGLE_CHECK_LE(count, input_used_);
+  input_used_ -= count;
+}
+
+int64 LzOutputStream::ByteCount() const {
+  return byte_count_ + input_used_;
+}
+
+bool LzOutputStream::Flush() {
+  if (had_error_ || closed_) return false;
+  if (!WriteBlock()) {
+    had_error_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool LzOutputStream::Close() {
+  if (closed_) return !had_error_;
+  bool ok = Flush();
+  closed_ = true;
+  return ok;
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,190 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains the definition for classes LzInputStream and
+// LzOutputStream, and the block codec they are built on.
+//
+// LzOutputStream is a ZeroCopyOutputStream that splits its input into blocks
+// and compresses each block with a simple LZ77-style codec that needs no
+// external library.  It trades compression ratio for speed: expect ratios
+// well below those of GzipOutputStream, but at a small fraction of the CPU
+// cost.  LzInputStream reads the result back.
+//
+// Each block is framed with its compressed and uncompressed sizes and a
+// CRC32C of the uncompressed data, so corruption is detected at block
+// granularity.  LzInputStream hands out each decompressed block straight from
+// its internal buffer (or, for blocks that were stored uncompressed, from the
+// underlying stream's buffer), so a CodedInputStream reading from it parses
+// the data in place without an extra copy.
+
+#ifndef GOOGLE_PROTOBUF_IO_LZ_STREAM_H__
+#define GOOGLE_PROTOBUF_IO_LZ_STREAM_H__
+
+#include <string>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+// A ZeroCopyInputStream that reads data written by LzOutputStream.
+class LIBPROTOBUF_EXPORT LzInputStream : public ZeroCopyInputStream {
+ public:
+  explicit LzInputStream(ZeroCopyInputStream* sub_stream);
+  virtual ~LzInputStream();
+
+  // Returns true if reading stopped because the compressed data was corrupt
+  // or truncated, rather than because the underlying stream ended cleanly
+  // at a block boundary.
+  inline bool HadError() const { return had_error_; }
+
+  // implements ZeroCopyInputStream ----------------------------------
+  bool Next(const void** data, int* size);
+  void BackUp(int count);
+  bool Skip(int count);
+  int64 ByteCount() const;
+
+ private:
+  ZeroCopyInputStream* sub_stream_;
+  bool had_error_;
+
+  // The current decompressed block, and how much of it was handed out.
+  const char* block_data_;
+  int block_size_;
+  int position_;
+  // Bytes in all blocks before the current one.
+  int64 byte_count_;
+
+  // Compressed payloads that span several buffers of sub_stream_ are
+  // gathered here.
+  string input_buffer_;
+  // Decompressed blocks live here.
+  string output_buffer_;
+
+  // Reads the next block into block_data_ / block_size_.  Returns false at the
+  // end of the stream or on error (in which case had_error_ is set).
+  bool ReadBlock();
+
+  // Copies exactly size bytes from sub_stream_ to data.  Sets *eof if the
+  // stream ended before the first byte.
+  bool ReadRaw(void* data, int size, bool* eof);
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(LzInputStream);
+};
+
+
+// A ZeroCopyOutputStream that compresses data to an underlying
+// ZeroCopyOutputStream in the format read by LzInputStream.
+class LIBPROTOBUF_EXPORT LzOutputStream : public ZeroCopyOutputStream {
+ public:
+  struct Options {
+    // How much data to buffer and compress at a time.  Larger blocks compress
+    // slightly better, at the cost of memory and latency.  Must be at most
+    // kMaxBlockSize.  Defaults to 64kB.
+    int block_size;
+
+    Options();  // Initializes with default values.
+  };
+
+  // The largest block size LzInputStream accepts.
+  static const int kMaxBlockSize = 1 << 24;
+
+  // Create an LzOutputStream with default options.
+  explicit LzOutputStream(ZeroCopyOutputStream* sub_stream);
+
+  // Create an LzOutputStream with the given options.
+  LzOutputStream(ZeroCopyOutputStream* sub_stream, const Options& options);
+
+  virtual ~LzOutputStream();
+
+  // Compresses and writes out the data buffered so far as a (possibly short)
+  // block.  It is the caller's responsibility to flush the underlying stream
+  // if necessary.  Frequent flushes hurt the compression ratio.
+  // Returns true if no error.
+  bool Flush();
+
+  // Writes out all buffered data.  The stream can't be written to afterwards.
+  // It is the caller's responsibility to close the underlying stream if
+  // necessary.  Returns true if no error.
+  bool Close();
+
+  // implements ZeroCopyOutputStream ---------------------------------
+  bool Next(void** data, int* size);
+  void BackUp(int count);
+  int64 ByteCount() const;
+
+ private:
+  ZeroCopyOutputStream* sub_stream_;
+  bool had_error_;
+  bool closed_;
+
+  // Uncompressed data waiting to be written as a block.
+  string input_buffer_;
+  int input_used_;
+  // Scratch space for blocks that don't fit in one sub_stream_ buffer.
+  string output_buffer_;
+  // Bytes in all blocks written so far.
+  int64 byte_count_;
+
+  // Compresses input_buffer_[0, input_used_) and writes it to sub_stream_.
+  bool WriteBlock();
+
+  // Copies data to sub_stream_.
+  bool WriteRaw(const void* data, int size);
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(LzOutputStream);
+};
+
+// Block codec ======================================================
+//
+// The functions below expose the codec used by the streams above for callers
+// that manage their own framing.  The compressed format carries no length or
+// checksum; the caller must record the uncompressed size.
+
+// Returns an upper bound on the compressed size of size bytes of input.
+LIBPROTOBUF_EXPORT int LzMaxCompressedLength(int size);
+
+// Compresses input[0, size) into output, which must have room for at least
+// LzMaxCompressedLength(size) bytes.  Returns the compressed size.
+LIBPROTOBUF_EXPORT int LzCompress(const void* input, int size, void* output);
+
+// Decompresses input[0, size) into output, which must be exactly
+// uncompressed_size bytes long.  Returns false if the input is malformed or
+// doesn't decompress to exactly uncompressed_size bytes; never reads or
+// writes outside the given buffers.
+LIBPROTOBUF_EXPORT bool LzUncompress(const void* input, int size,
+                                     void* output, int uncompressed_size);
+
+}  // namespace io
+}  // namespace protobuf
+
+}  // namespace google
+#endif  // GOOGLE_PROTOBUF_IO_LZ_STREAM_H__
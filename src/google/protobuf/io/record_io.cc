@@ -0,0 +1,635 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+#include <google/protobuf/io/record_io.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/lz_stream.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <google/protobuf/message_lite.h>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/crc32c.h>
+#include <google/protobuf/stubs/stl_util.h>
+
+namespace google {
+namespace protobuf {
+namespace io {
+
+namespace {
+
+const int kDefaultBlockSize = 65536;
+// Blocks claiming to be larger than this are treated as damaged.
+const int kMaxBlockSize = 1 << 30;
+const int kBlockHeaderSize = 36;
+const int kIndexEntrySize = 16;
+const int kFooterSize = 40;
+const int kMagicSize = 8;
+// How much to read at a time while looking for the next block.
+const int kScanChunkSize = 65536;
+
+const char kBlockMagic[kMagicSize] =
+    { '\x89', 'R', 'E', 'C', 'B', 'L', 'K', '\x1a' };
+const char kFooterMagic[kMagicSize] =
+    { '\x89', 'R', 'E', 'C', 'I', 'D', 'X', '\x1a' };
+
+inline uint32 ReadFixed32(const char* p) {
+  uint32 value;
+  CodedInputStream::ReadLittleEndian32FromArray(
+      reinterpret_cast<const uint8*>(p), &value);
+  return value;
+}
+
+inline uint64 ReadFixed64(const char* p) {
+  uint64 value;
+  CodedInputStream::ReadLittleEndian64FromArray(
+      reinterpret_cast<const uint8*>(p), &value);
+  return value;
+}
+
+inline void WriteFixed32(uint32 value, char* p) {
+  CodedOutputStream::WriteLittleEndian32ToArray(value,
+                                                reinterpret_cast<uint8*>(p));
+}
+
+inline void WriteFixed64(uint64 value, char* p) {
+  CodedOutputStream::WriteLittleEndian64ToArray(value,
+                                                reinterpret_cast<uint8*>(p));
+}
+
+inline uint32 MaskedCrc(const char* data, size_t size) {
+  return internal::MaskCrc32c(internal::Crc32c(data, size));
+}
+
+// Orders index entries by first record number.
+bool CompareFirstRecord(const pair<int64, int64>& a,
+                        const pair<int64, int64>& b) {
+  return a.second < b.second;
+}
+
+// EINTR sucks.
+#ifndef _WIN32
+ssize_t pread_no_eintr(int fd, void* buffer, size_t size, off_t offset) {
+  ssize_t result;
+  do {
+    result = pread(fd, buffer, size, offset);
+  } while (result < 0 && errno == EINTR);
+  return result;
+}
+#endif
+
+}  // namespace
+
+// ===================================================================
+
+RecordSource::~RecordSource() {}
+
+ArrayRecordSource::ArrayRecordSource(const void* data, int64 size)
+    : data_(static_cast<const char*>(data)), size_(size) {}
+
+ArrayRecordSource::~ArrayRecordSource() {}
+
+int64 ArrayRecordSource::Size() const {
+  return size_;
+}
+
+bool ArrayRecordSource::Read(int64 offset, int size, string* scratch,
+                             const char** data) {
+  if (offset < 0 || size < 0 || offset > size_ || size > size_ - offset) {
+    return false;
+  }
+  *data = data_ + offset;
+  return true;
+}
+
+FileRecordSource::FileRecordSource(int file_descriptor)
+    : file_(file_descriptor), size_(0), errno_(0) {
+  // Use fstat() rather than seeking to the end, so that the caller's file
+  // position is left alone.
+#ifdef _WIN32
+  struct _stati64 info;
+  int result = _fstati64(file_, &info);
+#else
+  struct stat info;
+  int result = fstat(file_, &info);
+#endif
+  if (result < 0) {
+    errno_ = errno;
+  } else {
+    size_ = info.st_size;
+  }
+}
+
+FileRecordSource::~FileRecordSource() {}
+
+int64 FileRecordSource::Size() const {
+  return size_;
+}
+
+bool FileRecordSource::Read(int64 offset, int size, string* scratch,
+                            const char** data) {
+  if (offset < 0 || size < 0 || offset > size_ || size > size_ - offset) {
+    return false;
+  }
+  STLStringResizeUninitialized(scratch, size);
+  char* buffer = string_as_array(scratch);
+  int done = 0;
+#ifdef _WIN32
+  MutexLock lock(&mutex_);
+  if (_lseeki64(file_, offset, SEEK_SET) < 0) {
+    errno_ = errno;
+    return false;
+  }
+#endif
+  while (done < size) {
+#ifdef _WIN32
+    int result = _read(file_, buffer + done, size - done);
+#else
+    int result = pread_no_eintr(file_, buffer + done, size - done,
+                                offset + done);
+#endif
+    if (result < 0) {
+      errno_ = errno;
+      return false;
+    }
+    if (result == 0) return false;  // The file shrank.
+    done += result;
+  }
+  *data = buffer;
+  return true;
+}
+
+// ===================================================================
+
+RecordWriter::Options::Options()
+    : block_size(kDefaultBlockSize),
+      compression(NO_COMPRESSION) {}
+
+RecordWriter::RecordWriter(ZeroCopyOutputStream* output)
+    : output_(output),
+      had_error_(false),
+      closed_(false),
+      block_records_(0),
+      num_records_(0),
+      offset_(0) {}
+
+RecordWriter::RecordWriter(ZeroCopyOutputStream* output,
+                           const Options& options)
+    : output_(output),
+      options_(options),
+      had_error_(false),
+      closed_(false),
+      block_records_(0),
+      num_records_(0),
+      offset_(0) {}
+
+RecordWriter::~RecordWriter() {
+  Close();
+}
+
+bool RecordWriter::StartRecord(int size) {
+  if (size < 0 ||
+      size > kMaxBlockSize - CodedOutputStream::VarintSize32(size)) {
+    GOOGLE_LOG(ERROR) << "A record of " << size << " bytes does not fit in a "
+                         "block; the limit is " << kMaxBlockSize << " bytes.";
+    return false;
+  }
+  // Readers reject blocks larger than kMaxBlockSize, so end the current
+  // block first if the record would push it past that.
+  if (block_.size() > kMaxBlockSize - CodedOutputStream::VarintSize32(size) -
+                      size) {
+    return WriteBlock();
+  }
+  return true;
+}
+
+bool RecordWriter::WriteRecord(const void* data, int size) {
+  if (had_error_ || closed_ || !StartRecord(size)) return false;
+  uint8 length[5];  // Max varint32 size.
+  uint8* end = CodedOutputStream::WriteVarint32ToArray(size, length);
+  block_.append(reinterpret_cast<const char*>(length), end - length);
+  block_.append(static_cast<const char*>(data), size);
+  ++block_records_;
+  ++num_records_;
+  return block_.size() < options_.block_size || WriteBlock();
+}
+
+bool RecordWriter::WriteRecord(const string& data) {
+  return WriteRecord(data.data(), data.size());
+}
+
+bool RecordWriter::WriteMessage(const MessageLite& message) {
+  if (had_error_ || closed_) return false;
+  int size = message.ByteSize();
+  if (!StartRecord(size)) return false;
+  int old_size = block_.size();
+  STLStringResizeUninitialized(
+      &block_, old_size + CodedOutputStream::VarintSize32(size) + size);
+  uint8* target = reinterpret_cast<uint8*>(string_as_array(&block_)) +
+                  old_size;
+  target = CodedOutputStream::WriteVarint32ToArray(size, target);
+  message.SerializeWithCachedSizesToArray(target);
+  ++block_records_;
+  ++num_records_;
+  return block_.size() < options_.block_size || WriteBlock();
+}
+
+bool RecordWriter::WriteRaw(const void* data, int size) {
+  const char* in = static_cast<const char*>(data);
+  offset_ += size;
+  while (size > 0) {
+    void* buffer;
+    int buffer_size;
+    if (!output_->Next(&buffer, &buffer_size)) return false;
+    int n = min(buffer_size, size);
+    memcpy(buffer, in, n);
+    in += n;
+    size -= n;
+    if (n < buffer_size) output_->BackUp(buffer_size - n);
+  }
+  return true;
+}
+
+bool RecordWriter::WriteBlock() {
+  if (block_records_ == 0) return true;
+
+  const char* payload = block_.data();
+  int payload_size = block_.size();
+  bool compressed = false;
+  if (options_.compression == LZ_COMPRESSION) {
+    int max_size = LzMaxCompressedLength(block_.size());
+    if (compressed_.size() < max_size) {
+      STLStringResizeUninitialized(&compressed_, max_size);
+    }
+    int compressed_size = LzCompress(block_.data(), block_.size(),
+                                     string_as_array(&compressed_));
+    if (compressed_size < block_.size()) {
+      payload = compressed_.data();
+      payload_size = compressed_size;
+      compressed = true;
+    }
+  }
+
+  int64 first_record = num_records_ - block_records_;
+  char header[kBlockHeaderSize];
+  memcpy(header, kBlockMagic, kMagicSize);
+  WriteFixed64(first_record, header + 8);
+  WriteFixed32(block_records_, header + 16);
+  WriteFixed32((static_cast<uint32>(payload_size) << 1) | (compressed ? 1 : 0),
+               header + 20);
+  WriteFixed32(block_.size(), header + 24);
+  WriteFixed32(MaskedCrc(payload, payload_size), header + 28);
+  WriteFixed32(MaskedCrc(header, 32), header + 32);
+
+  index_.push_back(make_pair(offset_, first_record));
+  if (!WriteRaw(header, kBlockHeaderSize) ||
+      !WriteRaw(payload, payload_size)) {
+    had_error_ = true;
+  }
+  block_.clear();
+  block_records_ = 0;
+  return !had_error_;
+}
+
+bool RecordWriter::Flush() {
+  if (had_error_ || closed_) return false;
+  return WriteBlock();
+}
+
+bool RecordWriter::Close() {
+  if (closed_) return !had_error_;
+  if (!Flush()) {
+    closed_ = true;
+    return false;
+  }
+  closed_ = true;
+
+  string index;
+  STLStringResizeUninitialized(&index, index_.size() * kIndexEntrySize);
+  for (int i = 0; i < index_.size(); i++) {
+    WriteFixed64(index_[i].first,
+                 string_as_array(&index) + i * kIndexEntrySize);
+    WriteFixed64(index_[i].second,
+                 string_as_array(&index) + i * kIndexEntrySize + 8);
+  }
+
+  char footer[kFooterSize];
+  WriteFixed64(offset_, footer);
+  WriteFixed64(index_.size(), footer + 8);
+  WriteFixed64(num_records_, footer + 16);
+  WriteFixed32(MaskedCrc(index.data(), index.size()), footer + 24);
+  WriteFixed32(MaskedCrc(footer, 28), footer + 28);
+  memcpy(footer + 32, kFooterMagic, kMagicSize);
+
+  if (!WriteRaw(index.data(), index.size()) ||
+      !WriteRaw(footer, kFooterSize)) {
+    had_error_ = true;
+  }
+  return !had_error_;
+}
+
+// ===================================================================
+
+RecordReader::RecordReader(RecordSource* source)
+    : source_(source) {
+  Init(0, source->Size());
+}
+
+RecordReader::RecordReader(RecordSource* source,
+                           int64 start_offset, int64 end_offset)
+    : source_(source) {
+  Init(start_offset, end_offset);
+}
+
+RecordReader::~RecordReader() {}
+
+void RecordReader::Init(int64 start_offset, int64 end_offset) {
+  data_end_ = source_->Size();
+  has_index_ = false;
+  num_records_ = -1;
+  block_data_ = NULL;
+  block_size_ = 0;
+  block_position_ = 0;
+  block_records_left_ = 0;
+  record_number_ = 0;
+  skipped_bytes_ = 0;
+  synced_ = start_offset <= 0;
+
+  ReadFooter();
+  end_offset_ = min(end_offset, data_end_);
+  position_ = max<int64>(start_offset, 0);
+
+  if (has_index_) {
+    // Go straight to the first block in range.
+    vector<pair<int64, int64> >::const_iterator it = lower_bound(
+        index_.begin(), index_.end(), make_pair(position_, int64(0)));
+    if (it == index_.end()) {
+      position_ = data_end_;
+      record_number_ = num_records_;
+    } else {
+      position_ = it->first;
+      record_number_ = it->second;
+    }
+    synced_ = true;
+  }
+}
+
+void RecordReader::ReadFooter() {
+  int64 size = source_->Size();
+  const char* footer;
+  if (size < kFooterSize ||
+      !source_->Read(size - kFooterSize, kFooterSize, &header_scratch_,
+                     &footer) ||
+      memcmp(footer + 32, kFooterMagic, kMagicSize) != 0 ||
+      ReadFixed32(footer + 28) != MaskedCrc(footer, 28)) {
+    return;
+  }
+  int64 index_offset = ReadFixed64(footer);
+  uint64 num_blocks = ReadFixed64(footer + 8);
+  int64 num_records = ReadFixed64(footer + 16);
+  uint32 index_crc = ReadFixed32(footer + 24);
+  if (index_offset < 0 || num_records < 0 ||
+      num_blocks > (size - kFooterSize) / kIndexEntrySize ||
+      index_offset + num_blocks * kIndexEntrySize + kFooterSize != size ||
+      num_blocks * kIndexEntrySize > kint32max) {
+    return;
+  }
+
+  const char* index;
+  int index_size = num_blocks * kIndexEntrySize;
+  if (!source_->Read(index_offset, index_size, &payload_scratch_, &index) ||
+      MaskedCrc(index, index_size) != index_crc) {
+    return;
+  }
+  index_.resize(num_blocks);
+  for (int i = 0; i < num_blocks; i++) {
+    index_[i].first = ReadFixed64(index + i * kIndexEntrySize);
+    index_[i].second = ReadFixed64(index + i * kIndexEntrySize + 8);
+    // The first block starts the file with record 0; SeekToRecord() relies
+    // on that to find a block for every record.
+    if (index_[i].first < 0 || index_[i].first >= index_offset ||
+        (i == 0 && (index_[i].first != 0 || index_[i].second != 0)) ||
+        (i > 0 && (index_[i].first <= index_[i - 1].first ||
+                   index_[i].second < index_[i - 1].second))) {
+      index_.clear();
+      return;
+    }
+  }
+
+  has_index_ = true;
+  num_records_ = num_records;
+  data_end_ = index_offset;
+}
+
+int64 RecordReader::FindMagic(int64 from) {
+  // Blocks starting at or after end_offset_ belong to the next range, so
+  // don't read past the last magic that could start before it.
+  int64 scan_end = min<int64>(data_end_, end_offset_ + kMagicSize - 1);
+  while (scan_end - from >= kMagicSize) {
+    int size = min<int64>(kScanChunkSize, scan_end - from);
+    const char* data;
+    if (!source_->Read(from, size, &scan_scratch_, &data)) break;
+    const char* end = data + size - kMagicSize + 1;
+    for (const char* p = data; p < end; ++p) {
+      p = static_cast<const char*>(memchr(p, kBlockMagic[0], end - p));
+      if (p == NULL) break;
+      if (memcmp(p, kBlockMagic, kMagicSize) == 0) {
+        return from + (p - data);
+      }
+    }
+    // Overlap the chunks so that a magic straddling two isn't missed.
+    from += size - kMagicSize + 1;
+  }
+  return end_offset_;
+}
+
+bool RecordReader::LoadBlock() {
+  const char* header;
+  if (data_end_ - position_ < kBlockHeaderSize ||
+      !source_->Read(position_, kBlockHeaderSize, &header_scratch_,
+                     &header) ||
+      memcmp(header, kBlockMagic, kMagicSize) != 0 ||
+      ReadFixed32(header + 32) != MaskedCrc(header, 32)) {
+    return false;
+  }
+  int64 first_record = ReadFixed64(header + 8);
+  uint32 num_records = ReadFixed32(header + 16);
+  uint32 type_and_size = ReadFixed32(header + 20);
+  uint32 uncompressed_size = ReadFixed32(header + 24);
+  uint32 payload_crc = ReadFixed32(header + 28);
+  bool compressed = (type_and_size & 1) != 0;
+  uint32 payload_size = type_and_size >> 1;
+  if (first_record < 0 ||
+      uncompressed_size > kMaxBlockSize ||
+      payload_size > data_end_ - position_ - kBlockHeaderSize ||
+      (!compressed && payload_size != uncompressed_size)) {
+    return false;
+  }
+
+  const char* payload;
+  if (!source_->Read(position_ + kBlockHeaderSize, payload_size,
+                     &payload_scratch_, &payload) ||
+      MaskedCrc(payload, payload_size) != payload_crc) {
+    return false;
+  }
+  if (compressed) {
+    if (uncompressed_.size() < uncompressed_size) {
+      STLStringResizeUninitialized(&uncompressed_, uncompressed_size);
+    }
+    if (!LzUncompress(payload, payload_size, string_as_array(&uncompressed_),
+                      uncompressed_size)) {
+      return false;
+    }
+    payload = uncompressed_.data();
+  }
+
+  block_data_ = payload;
+  block_size_ = uncompressed_size;
+  block_position_ = 0;
+  block_records_left_ = num_records;
+  record_number_ = first_record;
+  position_ += kBlockHeaderSize + payload_size;
+  return true;
+}
+
+bool RecordReader::NextBlock() {
+  while (position_ < end_offset_) {
+    if (LoadBlock()) {
+      synced_ = true;
+      return true;
+    }
+    int64 next = FindMagic(position_ + 1);
+    if (synced_) {
+      skipped_bytes_ += min(next, end_offset_) - position_;
+    }
+    position_ = next;
+  }
+  return false;
+}
+
+bool RecordReader::ReadRecord(const char** data, int* size) {
+  while (true) {
+    while (block_records_left_ == 0) {
+      if (!NextBlock()) return false;
+    }
+
+    // Decode the length prefix.
+    const uint8* ptr =
+        reinterpret_cast<const uint8*>(block_data_) + block_position_;
+    const uint8* end = reinterpret_cast<const uint8*>(block_data_) +
+                       block_size_;
+    uint32 length = 0;
+    bool ok = false;
+    for (int shift = 0; ptr < end && shift < 32; shift += 7) {
+      uint32 b = *ptr++;
+      length |= (b & 0x7f) << shift;
+      if (b < 0x80) {
+        ok = true;
+        break;
+      }
+    }
+    if (!ok || length > end - ptr) {
+      // The checksum matched, so the writer must have produced this; give
+      // up on the rest of the block rather than trusting it.
+      skipped_bytes_ += block_size_ - block_position_;
+      record_number_ += block_records_left_;
+      block_records_left_ = 0;
+      continue;
+    }
+
+    *data = reinterpret_cast<const char*>(ptr);
+    *size = length;
+    block_position_ = (reinterpret_cast<const char*>(ptr) - block_data_) +
+                      length;
+    --block_records_left_;
+    ++record_number_;
+    return true;
+  }
+}
+
+bool RecordReader::ReadRecord(string* record) {
+  const char* data;
+  int size;
+  if (!ReadRecord(&data, &size)) return false;
+  record->assign(data, size);
+  return true;
+}
+
+bool RecordReader::ReadMessage(MessageLite* message) {
+  const char* data;
+  int size;
+  return ReadRecord(&data, &size) && message->ParseFromArray(data, size);
+}
+
+bool RecordReader::SeekToRecord(int64 n) {
+  if (n < 0 || (has_index_ && n >= num_records_)) return false;
+
+  block_records_left_ = 0;
+  synced_ = true;
+  if (has_index_) {
+    if (index_.empty()) return false;
+    // Find the last block starting at or before record n.
+    vector<pair<int64, int64> >::const_iterator it = upper_bound(
+        index_.begin(), index_.end(), make_pair(int64(0), n),
+        CompareFirstRecord);
+    if (it == index_.begin()) return false;
+    --it;
+    position_ = it->first;
+    record_number_ = it->second;
+  } else {
+    position_ = 0;
+    record_number_ = 0;
+  }
+
+  // Load blocks until we get to the one containing record n.
+  while (record_number_ + block_records_left_ <= n) {
+    if (!NextBlock()) return false;
+  }
+  if (record_number_ > n) return false;  // Record n was damaged.
+  while (record_number_ < n) {
+    const char* data;
+    int size;
+    if (!ReadRecord(&data, &size)) return false;
+  }
+  return true;
+}
+
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
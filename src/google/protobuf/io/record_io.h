@@ -0,0 +1,327 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This file contains RecordWriter and RecordReader, which store a sequence of
+// records (typically serialized messages) in a file that can be read
+// sequentially, seeked by record number, recovered after corruption, and
+// split into byte ranges that are read in parallel.
+//
+// File format
+// -----------
+// Records are grouped into blocks.  Within a block's payload each record is
+// stored as a varint32 length followed by the record bytes, which is the
+// same encoding that hand-written code produces with
+// CodedOutputStream::WriteVarint32() and SerializeWithCachedSizes().  Each
+// block starts with a fixed 36-byte header:
+//   8 bytes   block magic, used to find the next block after corruption
+//   fixed64   number of the first record in the block
+//   fixed32   number of records in the block
+//   fixed32   stored payload size << 1 | 1 if the payload is compressed
+//   fixed32   uncompressed payload size
+//   fixed32   masked CRC32C of the stored payload
+//   fixed32   masked CRC32C of the preceding 32 header bytes
+// Compressed payloads use the codec from lz_stream.h.  When the writer is
+// closed it appends an index holding a (fixed64 offset, fixed64 first record)
+// pair per block, followed by a fixed 40-byte footer:
+//   fixed64   offset of the index
+//   fixed64   number of blocks
+//   fixed64   number of records
+//   fixed32   masked CRC32C of the index
+//   fixed32   masked CRC32C of the preceding 28 footer bytes
+//   8 bytes   footer magic
+// A file without a valid footer (e.g. because the writer crashed) can still
+// be read sequentially; only seeking by record number gets slower.
+
+#ifndef GOOGLE_PROTOBUF_IO_RECORD_IO_H__
+#define GOOGLE_PROTOBUF_IO_RECORD_IO_H__
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <google/protobuf/stubs/common.h>
+
+namespace google {
+namespace protobuf {
+
+class MessageLite;
+
+namespace io {
+
+class ZeroCopyOutputStream;
+
+// Random access to the bytes of a record file, as needed by RecordReader.
+class LIBPROTOBUF_EXPORT RecordSource {
+ public:
+  inline RecordSource() {}
+  virtual ~RecordSource();
+
+  // Returns the total size of the file in bytes.
+  virtual int64 Size() const = 0;
+
+  // Reads size bytes starting at offset and points *data at them: either
+  // straight into the source's own storage, or into *scratch.  Returns false
+  // if the range is out of bounds or an I/O error occurred.  Must be safe to
+  // call from several threads at once if the source is shared by readers
+  // running in parallel.
+  virtual bool Read(int64 offset, int size, string* scratch,
+                    const char** data) = 0;
+
+ private:
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(RecordSource);
+};
+
+// A RecordSource reading from a contiguous buffer, e.g. a memory-mapped
+// file.  Reads never copy.
+class LIBPROTOBUF_EXPORT ArrayRecordSource : public RecordSource {
+ public:
+  ArrayRecordSource(const void* data, int64 size);
+  ~ArrayRecordSource();
+
+  // implements RecordSource -----------------------------------------
+  int64 Size() const;
+  bool Read(int64 offset, int size, string* scratch, const char** data);
+
+ private:
+  const char* data_;
+  int64 size_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ArrayRecordSource);
+};
+
+// A RecordSource reading from a file descriptor, which must refer to a
+// regular file.  The descriptor is not closed by the source, and its file
+// position is not used, except on Windows: there is no pread() there, so
+// each read seeks the descriptor.
+class LIBPROTOBUF_EXPORT FileRecordSource : public RecordSource {
+ public:
+  explicit FileRecordSource(int file_descriptor);
+  ~FileRecordSource();
+
+  // If an I/O error has occurred on this source, this is the errno from that
+  // error.  Otherwise, this is zero.
+  int GetErrno() const { return errno_; }
+
+  // implements RecordSource -----------------------------------------
+  int64 Size() const;
+  bool Read(int64 offset, int size, string* scratch, const char** data);
+
+ private:
+  const int file_;
+  int64 size_;
+  int errno_;
+#ifdef _WIN32
+  // There is no pread() on Windows, so seeking and reading are serialized.
+  Mutex mutex_;
+#endif
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(FileRecordSource);
+};
+
+// Writes records to a ZeroCopyOutputStream.  The stream must be positioned
+// at the beginning of the file, since block offsets in the index are counted
+// from where the writer started.
+class LIBPROTOBUF_EXPORT RecordWriter {
+ public:
+  enum Compression {
+    NO_COMPRESSION = 0,
+    // Compress each block with LzCompress().  Blocks that don't shrink are
+    // stored uncompressed.
+    LZ_COMPRESSION = 1,
+  };
+
+  struct Options {
+    // Blocks are closed once their payload reaches this size.  Larger blocks
+    // compress better and cost less per record; smaller blocks lose less data
+    // to corruption and make seeking cheaper.  Defaults to 64kB.
+    int block_size;
+
+    // Defaults to NO_COMPRESSION.
+    Compression compression;
+
+    Options();  // Initializes with default values.
+  };
+
+  // Create a RecordWriter with default options.
+  explicit RecordWriter(ZeroCopyOutputStream* output);
+
+  // Create a RecordWriter with the given options.
+  RecordWriter(ZeroCopyOutputStream* output, const Options& options);
+
+  // Calls Close().
+  ~RecordWriter();
+
+  // Appends a record.  Returns false if writing to the underlying stream
+  // failed, in which case all further writes fail too.  Readers reject
+  // blocks over 1GB, so a record which cannot fit in a block of that size
+  // together with its length prefix is not written either; that only makes
+  // this call return false.
+  bool WriteRecord(const void* data, int size);
+  bool WriteRecord(const string& data);
+
+  // Appends message's serialization as a record, serializing it directly
+  // into the block buffer.
+  bool WriteMessage(const MessageLite& message);
+
+  // Ends the current block and writes it out.  It is the caller's
+  // responsibility to flush the underlying stream if necessary.
+  bool Flush();
+
+  // Writes out the last block, the index and the footer.  No records can be
+  // written afterwards.  Returns true if no error occurred since the writer
+  // was created.
+  bool Close();
+
+  // Number of records written so far.
+  int64 num_records() const { return num_records_; }
+
+ private:
+  ZeroCopyOutputStream* output_;
+  Options options_;
+  bool had_error_;
+  bool closed_;
+
+  // Payload of the block being built, and the number of records in it.
+  string block_;
+  int block_records_;
+  // Scratch space for compressed payloads.
+  string compressed_;
+
+  int64 num_records_;
+  // Bytes written to output_ so far.
+  int64 offset_;
+  // (offset, first record number) of each block written so far.
+  vector<pair<int64, int64> > index_;
+
+  // Checks that a record of the given size fits in a block, and writes out
+  // the current block first if adding the record would make it too big.
+  bool StartRecord(int size);
+  bool WriteBlock();
+  bool WriteRaw(const void* data, int size);
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(RecordWriter);
+};
+
+// Reads records written by RecordWriter.
+//
+// Damaged blocks are skipped: the reader moves on to the next intact block
+// and continues from there, and skipped_bytes() tells how much was lost.
+//
+// To read a file in parallel, split [0, source->Size()) into byte ranges and
+// give each range to its own reader.  A reader returns exactly the records of
+// the blocks that start within its range, so every record is read by exactly
+// one reader.
+class LIBPROTOBUF_EXPORT RecordReader {
+ public:
+  // Reads the whole file.  The source must outlive the reader.
+  explicit RecordReader(RecordSource* source);
+
+  // Reads the blocks that start at byte offsets in [start_offset, end_offset).
+  RecordReader(RecordSource* source, int64 start_offset, int64 end_offset);
+
+  ~RecordReader();
+
+  // Reads the next record.  *data stays valid until the next call to any
+  // method of the reader.  Returns false at the end of the file (or range).
+  bool ReadRecord(const char** data, int* size);
+  bool ReadRecord(string* record);
+
+  // Reads the next record and parses it into message.  Returns false at the
+  // end of the file or if the record doesn't parse; use record_number() to
+  // tell these apart.
+  bool ReadMessage(MessageLite* message);
+
+  // Positions the reader so that the next record read is record number n
+  // (counting from zero over the whole file).  Uses the index if there is
+  // one, and otherwise reads forward from the beginning of the file.  The
+  // reader's end offset is kept.  Returns false if there is no such record.
+  bool SeekToRecord(int64 n);
+
+  // Number of the record that the next ReadRecord() returns, counting from
+  // zero over the whole file.
+  int64 record_number() const { return record_number_; }
+
+  // Whether the file has a valid index and footer.
+  bool has_index() const { return has_index_; }
+
+  // Total number of records in the file, or -1 if there is no index.
+  int64 num_records() const { return num_records_; }
+
+  // Number of bytes skipped because they were damaged.
+  int64 skipped_bytes() const { return skipped_bytes_; }
+
+ private:
+  RecordSource* source_;
+  // End of the block area: where the index starts, or the end of the file.
+  int64 data_end_;
+  // Blocks are read while they start before this offset.
+  int64 end_offset_;
+  // Offset of the next block to read.
+  int64 position_;
+
+  bool has_index_;
+  int64 num_records_;
+  vector<pair<int64, int64> > index_;
+
+  // Payload of the current block.
+  const char* block_data_;
+  int block_size_;
+  int block_position_;
+  int block_records_left_;
+  int64 record_number_;
+  int64 skipped_bytes_;
+  // False while a reader that starts mid-file is still looking for its first
+  // block; bytes passed over then aren't damage.
+  bool synced_;
+
+  string header_scratch_;
+  string payload_scratch_;
+  string uncompressed_;
+  string scan_scratch_;
+
+  void Init(int64 start_offset, int64 end_offset);
+  void ReadFooter();
+
+  // Loads the next intact block starting at or after position_ and before
+  // end_offset_.
+  bool NextBlock();
+  // Loads the block at position_, if it is intact.
+  bool LoadBlock();
+  // Finds the first block magic at or after from and before end_offset_.
+  // Returns end_offset_ if there is none.
+  int64 FindMagic(int64 from);
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(RecordReader);
+};
+
+}  // namespace io
+}  // namespace protobuf
+
+}  // namespace google
+#endif  // GOOGLE_PROTOBUF_IO_RECORD_IO_H__
@@ -0,0 +1,426 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include <set>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/io/record_io.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/crc32c.h>
+#include <google/protobuf/stubs/stl_util.h>
+#include <google/protobuf/stubs/strutil.h>
+#include <google/protobuf/testing/file.h>
+#include <google/protobuf/testing/googletest.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace io {
+namespace {
+
+#ifdef _WIN32
+#define O_BINARY_IF_WIN32 O_BINARY
+#else
+#define O_BINARY_IF_WIN32 0
+#endif
+
+// Record i is a few dozen bytes of text that compresses reasonably.
+string MakeRecord(int i) {
+  string record = "record " + SimpleItoa(i) + ":";
+  for (int j = 0; j < i % 37; j++) {
+    record += " " + SimpleItoa(j * i);
+  }
+  return record;
+}
+
+string WriteFile(int num_records, const RecordWriter::Options& options) {
+  string file;
+  {
+    StringOutputStream output(&file);
+    RecordWriter writer(&output, options);
+    for (int i = 0; i < num_records; i++) {
+      EXPECT_TRUE(writer.WriteRecord(MakeRecord(i)));
+    }
+    EXPECT_EQ(num_records, writer.num_records());
+    EXPECT_TRUE(writer.Close());
+  }
+  return file;
+}
+
+// Cuts off the index and footer, as if the writer had crashed.
+void DropIndex(string* file) {
+  uint64 index_offset;
+  CodedInputStream::ReadLittleEndian64FromArray(
+      reinterpret_cast<const uint8*>(file->data() + file->size() - 40),
+      &index_offset);
+  file->resize(index_offset);
+}
+
+RecordWriter::Options SmallBlocks(RecordWriter::Compression compression) {
+  RecordWriter::Options options;
+  options.block_size = 200;
+  options.compression = compression;
+  return options;
+}
+
+TEST(RecordIoTest, RoundTrip) {
+  RecordWriter::Compression kCompressions[] = {
+    RecordWriter::NO_COMPRESSION, RecordWriter::LZ_COMPRESSION
+  };
+  int kBlockSizes[] = { 1, 100, 4096, 65536 };
+
+  for (int c = 0; c < GOOGLE_ARRAYSIZE(kCompressions); c++) {
+    for (int b = 0; b < GOOGLE_ARRAYSIZE(kBlockSizes); b++) {
+      SCOPED_TRACE(StrCat("compression ", kCompressions[c],
+                          " block_size ", kBlockSizes[b]));
+      RecordWriter::Options options;
+      options.compression = kCompressions[c];
+      options.block_size = kBlockSizes[b];
+      string file = WriteFile(1000, options);
+
+      ArrayRecordSource source(file.data(), file.size());
+      RecordReader reader(&source);
+      EXPECT_TRUE(reader.has_index());
+      EXPECT_EQ(1000, reader.num_records());
+      string record;
+      for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(i, reader.record_number());
+        ASSERT_TRUE(reader.ReadRecord(&record));
+        EXPECT_EQ(MakeRecord(i), record);
+      }
+      EXPECT_FALSE(reader.ReadRecord(&record));
+      EXPECT_EQ(0, reader.skipped_bytes());
+    }
+  }
+}
+
+TEST(RecordIoTest, CompressionShrinksFile) {
+  string plain = WriteFile(1000, RecordWriter::Options());
+  RecordWriter::Options options;
+  options.compression = RecordWriter::LZ_COMPRESSION;
+  string compressed = WriteFile(1000, options);
+  EXPECT_LT(compressed.size(), plain.size());
+}
+
+TEST(RecordIoTest, EmptyFile) {
+  string file = WriteFile(0, RecordWriter::Options());
+  ArrayRecordSource source(file.data(), file.size());
+  RecordReader reader(&source);
+  EXPECT_TRUE(reader.has_index());
+  EXPECT_EQ(0, reader.num_records());
+  string record;
+  EXPECT_FALSE(reader.ReadRecord(&record));
+  EXPECT_FALSE(reader.SeekToRecord(0));
+
+  ArrayRecordSource nothing(NULL, 0);
+  RecordReader reader2(&nothing);
+  EXPECT_FALSE(reader2.has_index());
+  EXPECT_FALSE(reader2.ReadRecord(&record));
+}
+
+TEST(RecordIoTest, Messages) {
+  string file;
+  {
+    StringOutputStream output(&file);
+    RecordWriter writer(&output);
+    protobuf_unittest::TestAllTypes message;
+    TestUtil::SetAllFields(&message);
+    EXPECT_TRUE(writer.WriteMessage(message));
+    message.Clear();
+    message.set_optional_int32(123);
+    EXPECT_TRUE(writer.WriteMessage(message));
+  }
+
+  ArrayRecordSource source(file.data(), file.size());
+  RecordReader reader(&source);
+  protobuf_unittest::TestAllTypes message;
+  ASSERT_TRUE(reader.ReadMessage(&message));
+  TestUtil::ExpectAllFieldsSet(message);
+  ASSERT_TRUE(reader.ReadMessage(&message));
+  EXPECT_EQ(123, message.optional_int32());
+  EXPECT_FALSE(message.has_optional_string());
+  EXPECT_FALSE(reader.ReadMessage(&message));
+}
+
+TEST(RecordIoTest, Seek) {
+  for (int with_index = 0; with_index < 2; with_index++) {
+    string file = WriteFile(1000, SmallBlocks(RecordWriter::LZ_COMPRESSION));
+    if (!with_index) DropIndex(&file);
+    ArrayRecordSource source(file.data(), file.size());
+    RecordReader reader(&source);
+    EXPECT_EQ(with_index != 0, reader.has_index());
+
+    int kTargets[] = { 500, 0, 999, 1, 137, 138, 998 };
+    string record;
+    for (int t = 0; t < GOOGLE_ARRAYSIZE(kTargets); t++) {
+      ASSERT_TRUE(reader.SeekToRecord(kTargets[t]));
+      EXPECT_EQ(kTargets[t], reader.record_number());
+      ASSERT_TRUE(reader.ReadRecord(&record));
+      EXPECT_EQ(MakeRecord(kTargets[t]), record);
+    }
+    EXPECT_FALSE(reader.SeekToRecord(1000));
+    EXPECT_FALSE(reader.SeekToRecord(-1));
+  }
+}
+
+TEST(RecordIoTest, NoFooter) {
+  // A writer that was never closed leaves whole blocks but no index; they
+  // are still readable.
+  string file;
+  {
+    StringOutputStream output(&file);
+    RecordWriter writer(&output, SmallBlocks(RecordWriter::NO_COMPRESSION));
+    for (int i = 0; i < 100; i++) {
+      EXPECT_TRUE(writer.WriteRecord(MakeRecord(i)));
+    }
+    EXPECT_TRUE(writer.Flush());
+    string partial = file;
+
+    ArrayRecordSource source(partial.data(), partial.size());
+    RecordReader reader(&source);
+    EXPECT_FALSE(reader.has_index());
+    EXPECT_EQ(-1, reader.num_records());
+    string record;
+    for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(reader.ReadRecord(&record));
+      EXPECT_EQ(MakeRecord(i), record);
+    }
+    EXPECT_FALSE(reader.ReadRecord(&record));
+    EXPECT_EQ(0, reader.skipped_bytes());
+  }
+}
+
+TEST(RecordIoTest, BadIndexIgnored) {
+  // An index whose first entry isn't (offset 0, record 0) can't be used for
+  // seeking, even if its checksums are right.  The reader must fall back to
+  // scanning the blocks.
+  for (int field = 0; field < 2; field++) {
+    string file = WriteFile(100, SmallBlocks(RecordWriter::NO_COMPRESSION));
+    uint8* footer = reinterpret_cast<uint8*>(
+        string_as_array(&file) + file.size() - 40);
+    uint64 index_offset;
+    uint64 num_blocks;
+    CodedInputStream::ReadLittleEndian64FromArray(footer, &index_offset);
+    CodedInputStream::ReadLittleEndian64FromArray(footer + 8, &num_blocks);
+    ASSERT_GT(num_blocks, 1);
+
+    uint8* index = reinterpret_cast<uint8*>(
+        string_as_array(&file) + index_offset);
+    CodedOutputStream::WriteLittleEndian64ToArray(1, index + field * 8);
+    CodedOutputStream::WriteLittleEndian32ToArray(
+        internal::MaskCrc32c(internal::Crc32c(index, num_blocks * 16)),
+        footer + 24);
+    CodedOutputStream::WriteLittleEndian32ToArray(
+        internal::MaskCrc32c(internal::Crc32c(footer, 28)), footer + 28);
+
+    ArrayRecordSource source(file.data(), file.size());
+    RecordReader reader(&source);
+    EXPECT_FALSE(reader.has_index());
+    string record;
+    ASSERT_TRUE(reader.SeekToRecord(0));
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    EXPECT_EQ(MakeRecord(0), record);
+    ASSERT_TRUE(reader.SeekToRecord(99));
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    EXPECT_EQ(MakeRecord(99), record);
+  }
+}
+
+TEST(RecordIoTest, ResyncAfterCorruption) {
+  RecordWriter::Compression kCompressions[] = {
+    RecordWriter::NO_COMPRESSION, RecordWriter::LZ_COMPRESSION
+  };
+  for (int c = 0; c < GOOGLE_ARRAYSIZE(kCompressions); c++) {
+    string file = WriteFile(1000, SmallBlocks(kCompressions[c]));
+    // Damage a byte in the middle of the file, then drop the footer too so
+    // the reader can't just use the index.
+    DropIndex(&file);
+    file[file.size() / 2] ^= 0x55;
+
+    ArrayRecordSource source(file.data(), file.size());
+    RecordReader reader(&source);
+    string record;
+    int last = -1;
+    int lost = 0;
+    while (reader.ReadRecord(&record)) {
+      int i = reader.record_number() - 1;
+      EXPECT_EQ(MakeRecord(i), record);
+      EXPECT_GT(i, last);
+      lost += i - last - 1;
+      last = i;
+    }
+    EXPECT_EQ(999, last);
+    // Exactly one block's worth of records is gone.
+    EXPECT_GT(lost, 0);
+    EXPECT_LT(lost, 20);
+    EXPECT_GT(reader.skipped_bytes(), 0);
+    EXPECT_LT(reader.skipped_bytes(), 500);
+  }
+}
+
+TEST(RecordIoTest, SplitRanges) {
+  for (int with_index = 0; with_index < 2; with_index++) {
+    string file = WriteFile(1000, SmallBlocks(RecordWriter::LZ_COMPRESSION));
+    if (!with_index) DropIndex(&file);
+    ArrayRecordSource source(file.data(), file.size());
+
+    // Cut the file at arbitrary points; every record must come out of
+    // exactly one range.
+    int kSplits[] = { 1, 2, 3, 7, 16 };
+    for (int s = 0; s < GOOGLE_ARRAYSIZE(kSplits); s++) {
+      set<int> seen;
+      int64 range_size = file.size() / kSplits[s] + 1;
+      for (int64 start = 0; start < file.size(); start += range_size) {
+        RecordReader reader(&source, start, start + range_size);
+        EXPECT_EQ(0, reader.skipped_bytes());
+        string record;
+        while (reader.ReadRecord(&record)) {
+          int i = reader.record_number() - 1;
+          EXPECT_EQ(MakeRecord(i), record);
+          EXPECT_TRUE(seen.insert(i).second) << i;
+        }
+        EXPECT_EQ(0, reader.skipped_bytes());
+      }
+      EXPECT_EQ(1000, seen.size());
+    }
+  }
+}
+
+TEST(RecordIoTest, OversizedRecordRejected) {
+  string file;
+  {
+    StringOutputStream output(&file);
+    RecordWriter writer(&output);
+    EXPECT_TRUE(writer.WriteRecord(MakeRecord(0)));
+    // Rejected before the data is looked at, so no such buffer is needed.
+    char small_buffer[1];
+    ScopedMemoryLog log;
+    EXPECT_FALSE(writer.WriteRecord(small_buffer, 1 << 30));
+    EXPECT_FALSE(writer.WriteRecord(small_buffer, -1));
+    EXPECT_EQ(2, log.GetMessages(ERROR).size());
+    // The writer is still usable.
+    EXPECT_TRUE(writer.WriteRecord(MakeRecord(1)));
+    EXPECT_EQ(2, writer.num_records());
+    EXPECT_TRUE(writer.Close());
+  }
+
+  ArrayRecordSource source(file.data(), file.size());
+  RecordReader reader(&source);
+  string record;
+  ASSERT_TRUE(reader.ReadRecord(&record));
+  EXPECT_EQ(MakeRecord(0), record);
+  ASSERT_TRUE(reader.ReadRecord(&record));
+  EXPECT_EQ(MakeRecord(1), record);
+  EXPECT_FALSE(reader.ReadRecord(&record));
+}
+
+// Remembers how far into the file it was asked to read.
+class TrackingRecordSource : public ArrayRecordSource {
+ public:
+  TrackingRecordSource(const string& file)
+      : ArrayRecordSource(file.data(), file.size()), max_end_(0) {}
+
+  int64 max_end() const { return max_end_; }
+  void clear_max_end() { max_end_ = 0; }
+
+  bool Read(int64 offset, int size, string* scratch, const char** data) {
+    max_end_ = max(max_end_, offset + size);
+    return ArrayRecordSource::Read(offset, size, scratch, data);
+  }
+
+ private:
+  int64 max_end_;
+};
+
+TEST(RecordIoTest, CorruptionDoesNotLeaveRange) {
+  string file = WriteFile(1000, SmallBlocks(RecordWriter::NO_COMPRESSION));
+  DropIndex(&file);
+  // Damage the first block's magic.  The reader of the first quarter of the
+  // file must look for the next block within its own range only.
+  file[0] ^= 0x55;
+
+  TrackingRecordSource source(file);
+  int64 range_end = file.size() / 4;
+  RecordReader reader(&source, 0, range_end);
+  // Forget about the reader looking for a footer at the end of the file.
+  source.clear_max_end();
+  string record;
+  int count = 0;
+  while (reader.ReadRecord(&record)) {
+    EXPECT_EQ(MakeRecord(reader.record_number() - 1), record);
+    ++count;
+  }
+  EXPECT_GT(count, 0);
+  EXPECT_GT(reader.skipped_bytes(), 0);
+  // The last block starting in the range may end a little past it.
+  EXPECT_LT(source.max_end(), range_end + 1000);
+}
+
+TEST(RecordIoTest, FileSource) {
+  string filename = TestTempDir() + "/record_io_test";
+  string file = WriteFile(1000, SmallBlocks(RecordWriter::LZ_COMPRESSION));
+  File::WriteStringToFileOrDie(file, filename);
+
+  int fd = open(filename.c_str(), O_RDONLY | O_BINARY_IF_WIN32);
+  ASSERT_GE(fd, 0);
+  {
+    FileRecordSource source(fd);
+    EXPECT_EQ(file.size(), source.Size());
+    // Getting the size must not move the caller's file position.
+    EXPECT_EQ(0, lseek(fd, 0, SEEK_CUR));
+    RecordReader reader(&source);
+    EXPECT_TRUE(reader.has_index());
+    ASSERT_TRUE(reader.SeekToRecord(777));
+    string record;
+    ASSERT_TRUE(reader.ReadRecord(&record));
+    EXPECT_EQ(MakeRecord(777), record);
+    EXPECT_EQ(0, source.GetErrno());
+  }
+  close(fd);
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace protobuf
+}  // namespace google
@@ -62,12 +62,14 @@
 
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/lz_stream.h>
 
 #if HAVE_ZLIB
 #include <google/protobuf/io/gzip_stream.h>
 #endif
 
 #include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/stl_util.h>
 #include <google/protobuf/testing/googletest.h>
 #include <google/protobuf/testing/file.h>
 #include <gtest/gtest.h>
@@ -693,8 +695,374 @@ TEST_F(IoTest, GzipInputByteCountAfterClosedConcatenatedStreams) {
     EXPECT_EQ(total_size, gz_input.ByteCount());
   }
 }
+
+TEST_F(IoTest, ZlibIoWithDictionary) {
+  string golden = "the quick brown fox jumps over the lazy dog";
+
+  GzipOutputStream::Options options;
+  options.format = GzipOutputStream::ZLIB;
+  string plain_compressed = Compress(golden, options);
+  options.dictionary = "jumps over the lazy dog, the quick brown fox";
+  string dict_compressed = Compress(golden, options);
+
+  // The dictionary covers the whole message, so it should compress better.
+  EXPECT_LT(dict_compressed.size(), plain_compressed.size());
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      ArrayInputStream input(dict_compressed.data(), dict_compressed.size(),
+                             kBlockSizes[i]);
+      GzipInputStream gzin(&input, GzipInputStream::AUTO, kBlockSizes[j]);
+      gzin.SetDictionary(options.dictionary);
+      string result;
+      const void* buffer;
+      int size;
+      while (gzin.Next(&buffer, &size)) {
+        result.append(reinterpret_cast<const char*>(buffer), size);
+      }
+      EXPECT_EQ(golden, result);
+    }
+  }
+
+  // Without the dictionary, the stream can't be decompressed.
+  ArrayInputStream input(dict_compressed.data(), dict_compressed.size());
+  GzipInputStream gzin(&input);
+  const void* buffer;
+  int size;
+  EXPECT_FALSE(gzin.Next(&buffer, &size));
+  EXPECT_EQ(Z_NEED_DICT, gzin.ZlibErrorCode());
+
+  // A dictionary set on the reader is ignored for streams that don't use one.
+  EXPECT_EQ(golden, Uncompress(plain_compressed));
+}
+
+TEST_F(IoTest, GzipIoWithDictionaryFails) {
+  // zlib doesn't support preset dictionaries with the GZIP format.
+  GzipOutputStream::Options options;
+  options.format = GzipOutputStream::GZIP;
+  options.dictionary = "some dictionary";
+  string result;
+  StringOutputStream output(&result);
+  GzipOutputStream gzout(&output, options);
+  void* buffer;
+  int size;
+  EXPECT_FALSE(gzout.Next(&buffer, &size));
+  EXPECT_EQ(Z_STREAM_ERROR, gzout.ZlibErrorCode());
+}
+
+TEST_F(IoTest, GzipStreamReset) {
+  const char* goldens[] = {
+    "abcdefghijklmnopqrstuvwxyz",
+    "",
+    "the quick brown fox jumps over the lazy dog",
+  };
+
+  GzipOutputStream::Options options;
+  options.format = GzipOutputStream::ZLIB;
+  options.dictionary = "the quick brown fox";
+
+  vector<string> compressed(GOOGLE_ARRAYSIZE(goldens));
+  {
+    StringOutputStream output(&compressed[0]);
+    GzipOutputStream gzout(&output, options);
+    WriteString(&gzout, goldens[0]);
+    EXPECT_TRUE(gzout.Close());
+    for (int i = 1; i < GOOGLE_ARRAYSIZE(goldens); i++) {
+      StringOutputStream next_output(&compressed[i]);
+      // The second stream relies on Reset() to close the first one.
+      EXPECT_TRUE(gzout.Reset(&next_output));
+      WriteString(&gzout, goldens[i]);
+      EXPECT_TRUE(gzout.Close());
+    }
+  }
+
+  // Each stream should be exactly what a freshly constructed stream writes.
+  for (int i = 0; i < GOOGLE_ARRAYSIZE(goldens); i++) {
+    EXPECT_EQ(Compress(goldens[i], options), compressed[i]);
+  }
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    ArrayInputStream first_input(compressed[0].data(), compressed[0].size(),
+                                 kBlockSizes[i]);
+    GzipInputStream gzin(&first_input);
+    gzin.SetDictionary(options.dictionary);
+    for (int j = 0; j < GOOGLE_ARRAYSIZE(goldens); j++) {
+      ArrayInputStream input(compressed[j].data(), compressed[j].size(),
+                             kBlockSizes[i]);
+      gzin.Reset(&input);
+      string result;
+      const void* buffer;
+      int size;
+      while (gzin.Next(&buffer, &size)) {
+        result.append(reinterpret_cast<const char*>(buffer), size);
+      }
+      EXPECT_EQ(goldens[j], result);
+      EXPECT_EQ(result.size(), gzin.ByteCount());
+    }
+  }
+}
+
+TEST_F(IoTest, GzipStreamResetAfterFailedInit) {
+  GzipOutputStream::Options options;
+  options.compression_level = 42;  // Makes deflateInit2() fail.
+  string result;
+  StringOutputStream output(&result);
+  GzipOutputStream gzout(&output, options);
+  EXPECT_EQ(Z_STREAM_ERROR, gzout.ZlibErrorCode());
+  EXPECT_FALSE(gzout.Close());
+  // Neither Reset() nor the destructor may touch the zlib state, which
+  // deflateInit2() never set up.
+  StringOutputStream next_output(&result);
+  EXPECT_FALSE(gzout.Reset(&next_output));
+  EXPECT_EQ(Z_STREAM_ERROR, gzout.ZlibErrorCode());
+}
+
+TEST_F(IoTest, BuildGzipDictionary) {
+  vector<string> samples;
+  samples.push_back("header:common-prefix:alpha:trailer-common");
+  samples.push_back("header:common-prefix:beta:trailer-common");
+  samples.push_back("header:common-prefix:gamma:trailer-common");
+
+  string dictionary;
+  BuildGzipDictionary(samples, 1024, &dictionary);
+  EXPECT_NE(string::npos, dictionary.find("header:common-prefix:"));
+  EXPECT_NE(string::npos, dictionary.find(":trailer-common"));
+  // Sequences that only occur in one sample are left out.
+  EXPECT_EQ(string::npos, dictionary.find("gamma"));
+
+  BuildGzipDictionary(samples, 10, &dictionary);
+  EXPECT_LE(dictionary.size(), 10);
+
+  // The dictionary should help with a message similar to the samples.
+  string golden = "header:common-prefix:delta:trailer-common";
+  GzipOutputStream::Options options;
+  options.format = GzipOutputStream::ZLIB;
+  string plain_compressed = Compress(golden, options);
+  BuildGzipDictionary(samples, 1024, &options.dictionary);
+  string dict_compressed = Compress(golden, options);
+  EXPECT_LT(dict_compressed.size(), plain_compressed.size());
+}
 #endif
 
+TEST_F(IoTest, LzIo) {
+  const int kBufferSize = 2*1024;
+  uint8* buffer = new uint8[kBufferSize];
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      for (int z = 0; z < kBlockSizeCount; z++) {
+        int lz_block_size = kBlockSizes[z];
+        int size;
+        {
+          ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+          LzOutputStream::Options options;
+          if (lz_block_size > 0) {
+            options.block_size = lz_block_size;
+          }
+          LzOutputStream lzout(&output, options);
+          WriteStuff(&lzout);
+          EXPECT_TRUE(lzout.Close());
+          size = output.ByteCount();
+        }
+        {
+          ArrayInputStream input(buffer, size, kBlockSizes[j]);
+          LzInputStream lzin(&input);
+          ReadStuff(&lzin);
+          EXPECT_FALSE(lzin.HadError());
+        }
+      }
+    }
+  }
+  delete [] buffer;
+}
+
+TEST_F(IoTest, LzIoWithFlush) {
+  const int kBufferSize = 2*1024;
+  uint8* buffer = new uint8[kBufferSize];
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    for (int j = 0; j < kBlockSizeCount; j++) {
+      int size;
+      {
+        ArrayOutputStream output(buffer, kBufferSize, kBlockSizes[i]);
+        LzOutputStream lzout(&output);
+        WriteString(&lzout, "Hello world!\n");
+        EXPECT_TRUE(lzout.Flush());
+        // Flushing with nothing buffered writes nothing.
+        int64 flushed_size = output.ByteCount();
+        EXPECT_TRUE(lzout.Flush());
+        EXPECT_EQ(flushed_size, output.ByteCount());
+        WriteString(&lzout, "Some te");
+        WriteString(&lzout, "xt.  Blah blah.");
+        EXPECT_TRUE(lzout.Flush());
+        WriteString(&lzout, "abcdefg");
+        WriteString(&lzout, "01234567890123456789");
+        WriteString(&lzout, "foobar");
+        EXPECT_TRUE(lzout.Close());
+        EXPECT_FALSE(lzout.Flush());
+        size = output.ByteCount();
+      }
+      {
+        ArrayInputStream input(buffer, size, kBlockSizes[j]);
+        LzInputStream lzin(&input);
+        ReadStuff(&lzin);
+      }
+    }
+  }
+  delete [] buffer;
+}
+
+TEST_F(IoTest, LzIoLarge) {
+  string compressed;
+  {
+    StringOutputStream output(&compressed);
+    LzOutputStream lzout(&output);
+    WriteStuffLarge(&lzout);
+  }
+  // The long runs should compress very well.
+  EXPECT_LT(compressed.size(), 2000);
+
+  for (int i = 0; i < kBlockSizeCount; i++) {
+    ArrayInputStream input(compressed.data(), compressed.size(),
+                           kBlockSizes[i]);
+    LzInputStream lzin(&input);
+    ReadStuffLarge(&lzin);
+  }
+}
+
+TEST_F(IoTest, LzIoCodedStream) {
+  // Messages parsed from an LzInputStream should read straight out of the
+  // decompressed blocks.
+  string compressed;
+  int uncompressed_size;
+  {
+    StringOutputStream output(&compressed);
+    LzOutputStream lzout(&output);
+    CodedOutputStream coded_output(&lzout);
+    for (int i = 0; i < 1000; i++) {
+      coded_output.WriteVarint32(i);
+      coded_output.WriteString("a fairly repetitive string");
+    }
+    uncompressed_size = coded_output.ByteCount();
+  }
+  EXPECT_LT(compressed.size(), uncompressed_size / 2);
+
+  ArrayInputStream input(compressed.data(), compressed.size());
+  LzInputStream lzin(&input);
+  CodedInputStream coded_input(&lzin);
+  const void* data;
+  int size;
+  EXPECT_TRUE(coded_input.GetDirectBufferPointer(&data, &size));
+  // Everything fits in one block, which is handed out whole.
+  EXPECT_EQ(uncompressed_size, size);
+  for (int i = 0; i < 1000; i++) {
+    uint32 value;
+    string str;
+    EXPECT_TRUE(coded_input.ReadVarint32(&value));
+    EXPECT_EQ(i, value);
+    EXPECT_TRUE(coded_input.ReadString(&str, 26));
+    EXPECT_EQ("a fairly repetitive string", str);
+  }
+}
+
+TEST_F(IoTest, LzCodec) {
+  // Build inputs that exercise literal runs, short and long matches,
+  // overlapping matches and incompressible data.
+  vector<string> inputs;
+  inputs.push_back("");
+  inputs.push_back("a");
+  inputs.push_back("abcdefghijklm");
+  inputs.push_back(string(1000, 'z'));
+  inputs.push_back(string(100, 'q') + "abcabcabcabcabcabcabc" + string(3, 'r'));
+  string text;
+  for (int i = 0; i < 500; i++) {
+    text += "field_";
+    text += static_cast<char>('a' + i % 26);
+    text += string(i % 20, 'x');
+  }
+  inputs.push_back(text);
+  string noise;
+  uint32 state = 12345;
+  for (int i = 0; i < 100000; i++) {
+    state = state * 1103515245 + 12345;
+    noise.push_back(static_cast<char>(state >> 24));
+  }
+  inputs.push_back(noise);
+
+  for (int i = 0; i < inputs.size(); i++) {
+    const string& input = inputs[i];
+    string compressed(LzMaxCompressedLength(input.size()), '\0');
+    int compressed_size =
+        LzCompress(input.data(), input.size(), string_as_array(&compressed));
+    ASSERT_LE(compressed_size, compressed.size());
+    compressed.resize(compressed_size);
+
+    string output(input.size(), '\0');
+    EXPECT_TRUE(LzUncompress(compressed.data(), compressed.size(),
+                             string_as_array(&output), output.size()));
+    EXPECT_TRUE(input == output);
+
+    // The uncompressed size must match exactly.
+    if (!input.empty()) {
+      string short_output(input.size() - 1, '\0');
+      EXPECT_FALSE(LzUncompress(compressed.data(), compressed.size(),
+                                string_as_array(&short_output),
+                                short_output.size()));
+    }
+    string long_output(input.size() + 1, '\0');
+    EXPECT_FALSE(LzUncompress(compressed.data(), compressed.size(),
+                              string_as_array(&long_output),
+                              long_output.size()));
+
+    // Truncated input must be rejected without overrunning anything.
+    for (int j = 0; j < compressed.size(); j += 1 + j / 16) {
+      EXPECT_FALSE(LzUncompress(compressed.data(), j,
+                                string_as_array(&output), output.size()));
+    }
+  }
+
+  // Repetitive text should actually shrink.
+  string compressed(LzMaxCompressedLength(text.size()), '\0');
+  EXPECT_LT(LzCompress(text.data(), text.size(), string_as_array(&compressed)),
+            text.size() / 2);
+}
+
+TEST_F(IoTest, LzInputDetectsCorruption) {
+  string golden;
+  for (int i = 0; i < 1000; i++) {
+    golden += "the quick brown fox jumps over the lazy dog ";
+  }
+  string compressed;
+  {
+    StringOutputStream output(&compressed);
+    LzOutputStream::Options options;
+    options.block_size = 4096;
+    LzOutputStream lzout(&output, options);
+    WriteString(&lzout, golden);
+  }
+
+  // Flip one bit at a time in various places; every damaged stream must either
+  // fail or, if the damage hit a header in a way that still parses, fail the
+  // checksum.  Either way the reader must report an error.
+  for (int i = 0; i < compressed.size(); i += 7) {
+    string damaged = compressed;
+    damaged[i] ^= 1 << (i % 8);
+    ArrayInputStream input(damaged.data(), damaged.size());
+    LzInputStream lzin(&input);
+    const void* data;
+    int size;
+    while (lzin.Next(&data, &size)) {}
+    EXPECT_TRUE(lzin.HadError()) << "offset " << i;
+  }
+
+  // A truncated stream is an error too, unless it ends at a block boundary.
+  string truncated = compressed.substr(0, compressed.size() - 1);
+  ArrayInputStream input(truncated.data(), truncated.size());
+  LzInputStream lzin(&input);
+  const void* data;
+  int size;
+  while (lzin.Next(&data, &size)) {}
+  EXPECT_TRUE(lzin.HadError());
+}
+
 // There is no string input, only string output.  Also, it doesn't support
 // explicit block sizes.  So, we'll only run one test and we'll use
 // ArrayInput to read back the results.
@@ -107,6 +107,13 @@ class Map {
     insert(other.begin(), other.end());
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  // Moving takes other's elements without copying them.
+  Map(Map&& other) : default_enum_value_(other.default_enum_value_) {
+    elements_.swap(other.elements_);
+  }
+#endif
+
   ~Map() { clear(); }
 
   // Iterators
@@ -291,6 +298,16 @@ class Map {
     return *this;
   }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  Map& operator=(Map&& other) {
+    if (this != &other) {
+      clear();
+      elements_.swap(other.elements_);
+    }
+    return *this;
+  }
+#endif
+
  private:
   // Set default enum value only for proto2 map field whose value is enum type.
   void SetDefaultEnumValue(int default_enum_value) {
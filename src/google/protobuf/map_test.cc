@@ -34,6 +34,7 @@
 #include <google/protobuf/stubs/shared_ptr.h>
 #endif
 #include <sstream>
+#include <utility>
 
 #include <google/protobuf/stubs/casts.h>
 #include <google/protobuf/stubs/common.h>
@@ -503,6 +504,37 @@ TEST_F(MapImplTest, Assigner) {
   EXPECT_EQ(value2, other.at(key2));
 }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+TEST_F(MapImplTest, MoveConstructor) {
+  map_[0] = 100;
+  map_[1] = 101;
+  const int32* value = &map_.at(0);
+
+  Map<int32, int32> other(std::move(map_));
+
+  // The elements were taken, not copied.
+  EXPECT_EQ(value, &other.at(0));
+  EXPECT_EQ(2, other.size());
+  EXPECT_EQ(101, other.at(1));
+  EXPECT_TRUE(map_.empty());
+}
+
+TEST_F(MapImplTest, MoveAssigner) {
+  map_[0] = 100;
+  map_[1] = 101;
+  const int32* value = &map_.at(0);
+
+  Map<int32, int32> other;
+  other[123] = 321;
+  other = std::move(map_);
+
+  EXPECT_EQ(value, &other.at(0));
+  EXPECT_EQ(2, other.size());
+  EXPECT_EQ(101, other.at(1));
+  EXPECT_TRUE(other.find(123) == other.end());
+}
+#endif  // GOOGLE_PROTOBUF_CXX11
+
 TEST_F(MapImplTest, Rehash) {
   const int test_size = 50;
   std::map<int32, int32> reference_map;
@@ -2045,6 +2077,19 @@ TEST_F(MapFieldInDynamicMessageTest, Map) {
   reflection_tester.ExpectMapFieldsSetViaReflection(*message);
 }
 
+TEST_F(MapFieldInDynamicMessageTest, Arena) {
+  // Map fields are not arena-aware, so the message is allocated on the heap
+  // and owned by the arena.
+  Arena arena;
+  Message* message = map_prototype_->New(&arena);
+  EXPECT_TRUE(message->GetArena() == NULL);
+
+  MapTestUtil::MapReflectionTester reflection_tester(map_descriptor_);
+  reflection_tester.SetMapFieldsViaReflection(message);
+  reflection_tester.ExpectMapFieldsSetViaReflection(*message);
+  // Return without freeing: should not leak.
+}
+
 TEST_F(MapFieldInDynamicMessageTest, MapSpaceUsed) {
   // Test that SpaceUsed() works properly
 
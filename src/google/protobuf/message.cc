@@ -188,7 +188,20 @@ bool Message::SerializePartialToOstream(ostream* output) const {
 // =============================================================================
 // Reflection and associated Template Specializations
 
-Reflection::~Reflection() {}
+Reflection::~Reflection() {
+  internal::ReflectionOps::ForgetReflection(this);
+}
+
+Reflection::FieldVisitor::~FieldVisitor() {}
+
+void Reflection::VisitFields(const Message& message,
+                             FieldVisitor* visitor) const {
+  vector<const FieldDescriptor*> fields;
+  ListFields(message, &fields);
+  for (int i = 0; i < fields.size(); i++) {
+    visitor->Visit(fields[i]);
+  }
+}
 
 #define HANDLE_TYPE(TYPE, CPPTYPE, CTYPE)                             \
 template<>                                                            \
@@ -401,6 +414,11 @@ void* Reflection::RepeatedFieldData(
   return NULL;
 }
 
+bool Reflection::GetFieldLayout(const FieldDescriptor* field,
+                                internal::FieldLayout* layout) const {
+  return false;
+}
+
 namespace internal {
 RepeatedFieldAccessor::~RepeatedFieldAccessor() {
 }
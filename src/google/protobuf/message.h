@@ -118,6 +118,7 @@
 #include <google/protobuf/arena.h>
 #include <google/protobuf/message_lite.h>
 
+#include <google/protobuf/stubs/atomicops.h>
 #include <google/protobuf/stubs/common.h>
 #include <google/protobuf/descriptor.h>
 
@@ -331,6 +332,10 @@ namespace internal {
 // Forward-declare interfaces used to implement RepeatedFieldRef.
 // These are protobuf internals that users shouldn't care about.
 class RepeatedFieldAccessor;
+// Forward-declare the types used to implement FieldAccessor.
+struct FieldLayout;
+class FieldAccessorBase;
+class ReflectionOps;     // reflection_ops.h
 }  // namespace internal
 
 // Forward-declare RepeatedFieldRef templates. The second type parameter is
@@ -341,6 +346,10 @@ class RepeatedFieldRef;
 template<typename T, typename Enable = void>
 class MutableRepeatedFieldRef;
 
+// Forward-declare the FieldAccessor template, defined in reflection.h.
+template<typename T>
+class FieldAccessor;
+
 // This interface contains methods that can be used to dynamically access
 // and modify the fields of a protocol message.  Their semantics are
 // similar to the accessors the protocol compiler generates.
@@ -384,7 +393,7 @@ class MutableRepeatedFieldRef;
 //   write fields from a Reflection without paying attention to the type.
 class LIBPROTOBUF_EXPORT Reflection {
  public:
-  inline Reflection() {}
+  inline Reflection() : merge_plans_(0) {}
   virtual ~Reflection();
 
   // Get the UnknownFieldSet for the message.  This contains fields which
@@ -473,6 +482,28 @@ class LIBPROTOBUF_EXPORT Reflection {
   virtual void ListFields(const Message& message,
                           vector<const FieldDescriptor*>* output) const = 0;
 
+  // Abstract interface for VisitFields().
+  class LIBPROTOBUF_EXPORT FieldVisitor {
+   public:
+    inline FieldVisitor() {}
+    virtual ~FieldVisitor();
+
+    // Called once for each field which is currently set.
+    virtual void Visit(const FieldDescriptor* field) = 0;
+
+   private:
+    GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(FieldVisitor);
+  };
+
+  // Pass each field which ListFields() would list to visitor->Visit(), in
+  // the same order.  Unlike ListFields(), this does not need to build and
+  // sort a vector, so generic code which walks every nesting level of a
+  // message (serializers, printers) can use it without allocating.  The
+  // default implementation calls ListFields(); GeneratedMessageReflection
+  // (and thus DynamicMessage) reads the has-bits in field number order.
+  virtual void VisitFields(const Message& message,
+                           FieldVisitor* visitor) const;
+
   // Singular field getters ------------------------------------------
   // These get the value of a non-repeated field.  They return the default
   // value for fields that aren't set.
@@ -753,6 +784,26 @@ class LIBPROTOBUF_EXPORT Reflection {
   MutableRepeatedFieldRef<T> GetMutableRepeatedFieldRef(
       Message* message, const FieldDescriptor* field) const;
 
+  // Get a FieldAccessor object that can be used to read and write the given
+  // singular field in any message of this type.  The type parameter T is
+  // chosen from the field's cpp type as for GetRepeatedFieldRef(), except
+  // that enum fields always use int32 (the value's number) and message fields
+  // always use google::protobuf::Message.
+  //
+  // The field is checked, and where it is stored is looked up, only once
+  // when the FieldAccessor is created; after that, reading the field in a
+  // message usually takes a load of the has-bit or oneof case and a load of
+  // the value.  Use it when the same field is accessed in many messages, for
+  // example by obtaining one FieldAccessor per field before looping over a
+  // batch of messages.  The object can be copied, and can be used as long as
+  // this Reflection object exists.
+  //
+  // Note that to use this method users need to include the header file
+  // "google/protobuf/reflection.h" (which defines the FieldAccessor class
+  // templates).
+  template<typename T>
+  FieldAccessor<T> GetAccessor(const FieldDescriptor* field) const;
+
   // DEPRECATED. Please use Get(Mutable)RepeatedFieldRef() for repeated field
   // access. The following repeated field accesors will be removed in the
   // future.
@@ -880,11 +931,21 @@ class LIBPROTOBUF_EXPORT Reflection {
   virtual const internal::RepeatedFieldAccessor* RepeatedFieldAccessor(
       const FieldDescriptor* field) const;
 
+  // Used to implement FieldAccessor and ReflectionOps::Merge().  If the
+  // field is stored at a fixed offset in every message of this type, fills
+  // in "layout" and returns true.  Otherwise returns false, and the caller
+  // uses the accessors above instead.  The default implementation returns
+  // false.
+  virtual bool GetFieldLayout(const FieldDescriptor* field,
+                              internal::FieldLayout* layout) const;
+
  private:
   template<typename T, typename Enable>
   friend class RepeatedFieldRef;
   template<typename T, typename Enable>
   friend class MutableRepeatedFieldRef;
+  friend class internal::FieldAccessorBase;
+  friend class internal::ReflectionOps;
 
   // Special version for specialized implementations of string.  We can't call
   // MutableRawRepeatedField directly here because we don't have access to
@@ -893,6 +954,10 @@ class LIBPROTOBUF_EXPORT Reflection {
   void* MutableRawRepeatedString(
       Message* message, const FieldDescriptor* field, bool is_string) const;
 
+  // The plans ReflectionOps::Merge() has built for merging into messages of
+  // this Reflection.  Really a MergePlanCache* (see reflection_ops.cc), or 0.
+  mutable internal::AtomicWord merge_plans_;
+
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(Reflection);
 };
 
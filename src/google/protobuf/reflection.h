@@ -29,11 +29,13 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 // This header defines the RepeatedFieldRef class template used to access
-// repeated fields with protobuf reflection API.
+// repeated fields with protobuf reflection API, and the FieldAccessor class
+// template used to access singular fields through a precomputed handle.
 #ifndef GOOGLE_PROTOBUF_REFLECTION_H__
 #define GOOGLE_PROTOBUF_REFLECTION_H__
 
 #include <google/protobuf/message.h>
+#include <google/protobuf/arenastring.h>
 
 namespace google {
 namespace protobuf {
@@ -297,6 +299,296 @@ class MutableRepeatedFieldRef<
   const AccessorType* accessor_;
   const Message* default_instance_;
 };
+
+namespace internal {
+// Where a field is stored in the messages of one type.  See
+// Reflection::GetFieldLayout().
+struct FieldLayout {
+  // Offset of the field from the start of the message.  Strings are stored
+  // as an ArenaStringPtr and messages as a pointer, which is NULL while the
+  // sub-message has not been allocated.  Repeated fields are stored as a
+  // RepeatedField or RepeatedPtrField of the same types as in generated
+  // code, and have no has-bit, oneof or default value.  Map fields have no
+  // layout.
+  int offset;
+  // Offset of the uint32 that holds the field's has-bit, and the bit within
+  // it, or -1 if the field has no has-bit.
+  int has_bit_offset;
+  uint32 has_bit_mask;
+  // Offset of the uint32 that holds the case of the field's oneof, or -1 if
+  // the field is not in a oneof.
+  int oneof_case_offset;
+  // Offset of the bool that is true only in the default instance, or -1.
+  // Consulted for message fields that have neither a has-bit nor a oneof.
+  int is_default_instance_offset;
+  // The value of the field when it is not set: points to a T for numeric
+  // fields, to a string for string fields and to a Message for message
+  // fields.
+  const void* default_value;
+};
+
+// Fallbacks used by FieldAccessor<T> when the Reflection does not provide a
+// FieldLayout for the field.
+template<typename T>
+struct FieldAccessorTraits;
+
+#define DEFINE_FIELD_ACCESSOR_TRAITS(TYPE, CPPTYPE, METHOD)                  \
+template<>                                                                   \
+struct FieldAccessorTraits<TYPE> {                                           \
+  static bool Matches(FieldDescriptor::CppType cpp_type) {                   \
+    return cpp_type == FieldDescriptor::CPPTYPE_##CPPTYPE;                   \
+  }                                                                          \
+  static TYPE Get(const Reflection* reflection, const Message& message,      \
+                  const FieldDescriptor* field) {                            \
+    return reflection->Get##METHOD(message, field);                          \
+  }                                                                          \
+  static void Set(const Reflection* reflection, Message* message,            \
+                  const FieldDescriptor* field, TYPE value) {                \
+    reflection->Set##METHOD(message, field, value);                          \
+  }                                                                          \
+};
+
+DEFINE_FIELD_ACCESSOR_TRAITS(int64 , INT64 , Int64 )
+DEFINE_FIELD_ACCESSOR_TRAITS(uint32, UINT32, UInt32)
+DEFINE_FIELD_ACCESSOR_TRAITS(uint64, UINT64, UInt64)
+DEFINE_FIELD_ACCESSOR_TRAITS(float , FLOAT , Float )
+DEFINE_FIELD_ACCESSOR_TRAITS(double, DOUBLE, Double)
+DEFINE_FIELD_ACCESSOR_TRAITS(bool  , BOOL  , Bool  )
+
+#undef DEFINE_FIELD_ACCESSOR_TRAITS
+
+// int32 is also used for enum fields.
+template<>
+struct FieldAccessorTraits<int32> {
+  static bool Matches(FieldDescriptor::CppType cpp_type) {
+    return cpp_type == FieldDescriptor::CPPTYPE_INT32 ||
+           cpp_type == FieldDescriptor::CPPTYPE_ENUM;
+  }
+  static int32 Get(const Reflection* reflection, const Message& message,
+                   const FieldDescriptor* field) {
+    return field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM ?
+        reflection->GetEnumValue(message, field) :
+        reflection->GetInt32(message, field);
+  }
+  static void Set(const Reflection* reflection, Message* message,
+                  const FieldDescriptor* field, int32 value) {
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM) {
+      reflection->SetEnumValue(message, field, value);
+    } else {
+      reflection->SetInt32(message, field, value);
+    }
+  }
+};
+
+// The parts of FieldAccessor<T> that do not depend on T.
+class FieldAccessorBase {
+ public:
+  const FieldDescriptor* field() const { return field_; }
+
+ protected:
+  FieldAccessorBase(const Reflection* reflection,
+                    const FieldDescriptor* field)
+      : reflection_(reflection), field_(field) {
+    GOOGLE_CHECK(!field->is_repeated())
+        << "FieldAccessor used on repeated field " << field->full_name();
+    direct_ = reflection->GetFieldLayout(field, &layout_);
+  }
+
+  // True if the field is present in "message" according to its has-bit or
+  // oneof case.  Only valid when has_presence().
+  bool IsSet(const Message& message) const {
+    if (layout_.oneof_case_offset >= 0) {
+      return OneofCase(message) == static_cast<uint32>(field_->number());
+    }
+    return (*reinterpret_cast<const uint32*>(
+        Base(message) + layout_.has_bit_offset) & layout_.has_bit_mask) != 0;
+  }
+  bool has_presence() const {
+    return layout_.oneof_case_offset >= 0 || layout_.has_bit_offset >= 0;
+  }
+
+  // Returns the field's storage in "message", or NULL if the field is in a
+  // oneof that is set to a different field.
+  const void* Raw(const Message& message) const {
+    if (layout_.oneof_case_offset >= 0 &&
+        OneofCase(message) != static_cast<uint32>(field_->number())) {
+      return NULL;
+    }
+    return Base(message) + layout_.offset;
+  }
+
+  // Returns the field's storage in "message" and marks it present, or NULL
+  // if the field is in a oneof that is set to a different field (which must
+  // be cleared first, so the caller needs to go through the Reflection).
+  void* MutableRaw(Message* message) const {
+    uint8* base = reinterpret_cast<uint8*>(message);
+    if (layout_.oneof_case_offset >= 0) {
+      if (OneofCase(*message) != static_cast<uint32>(field_->number())) {
+        return NULL;
+      }
+    } else if (layout_.has_bit_offset >= 0) {
+      *reinterpret_cast<uint32*>(base + layout_.has_bit_offset) |=
+          layout_.has_bit_mask;
+    }
+    return base + layout_.offset;
+  }
+
+  bool IsDefaultInstance(const Message& message) const {
+    return layout_.is_default_instance_offset >= 0 &&
+        *reinterpret_cast<const bool*>(
+            Base(message) + layout_.is_default_instance_offset);
+  }
+
+  const Reflection* reflection_;
+  const FieldDescriptor* field_;
+  bool direct_;
+  FieldLayout layout_;
+
+ private:
+  const uint8* Base(const Message& message) const {
+    GOOGLE_DCHECK(message.GetReflection() == reflection_);
+    return reinterpret_cast<const uint8*>(&message);
+  }
+  uint32 OneofCase(const Message& message) const {
+    return *reinterpret_cast<const uint32*>(
+        Base(message) + layout_.oneof_case_offset);
+  }
+};
+}  // namespace internal
+
+template<typename T>
+FieldAccessor<T> Reflection::GetAccessor(const FieldDescriptor* field) const {
+  return FieldAccessor<T>(this, field);
+}
+
+// FieldAccessor definition for numeric, bool and enum fields.
+template<typename T>
+class FieldAccessor : public internal::FieldAccessorBase {
+  typedef internal::FieldAccessorTraits<T> Traits;
+
+ public:
+  // Same as Reflection::HasField().
+  bool Has(const Message& message) const {
+    if (!direct_) return reflection_->HasField(message, field_);
+    if (has_presence()) return IsSet(message);
+    // proto3: present if non-zero.
+    return Get(message) != T();
+  }
+  T Get(const Message& message) const {
+    if (!direct_) return Traits::Get(reflection_, message, field_);
+    const void* raw = Raw(message);
+    return *static_cast<const T*>(raw != NULL ? raw : layout_.default_value);
+  }
+  void Set(Message* message, T value) const {
+    if (direct_ && !checked_set_) {
+      void* raw = MutableRaw(message);
+      if (raw != NULL) {
+        *static_cast<T*>(raw) = value;
+        return;
+      }
+    }
+    Traits::Set(reflection_, message, field_, value);
+  }
+
+ private:
+  friend class Reflection;
+  FieldAccessor(const Reflection* reflection, const FieldDescriptor* field)
+      : FieldAccessorBase(reflection, field),
+        // Closed enums must reject unknown values, which needs the
+        // descriptor, so their Set() goes through the Reflection.
+        checked_set_(field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM &&
+                     !reflection->SupportsUnknownEnumValues()) {
+    GOOGLE_CHECK(Traits::Matches(field->cpp_type()))
+        << "FieldAccessor type does not match field " << field->full_name();
+  }
+
+  bool checked_set_;
+};
+
+// FieldAccessor definition for string fields.
+template<>
+class FieldAccessor<string> : public internal::FieldAccessorBase {
+ public:
+  // Same as Reflection::HasField().
+  bool Has(const Message& message) const {
+    if (!direct_) return reflection_->HasField(message, field_);
+    if (has_presence()) return IsSet(message);
+    // proto3: present if non-empty.
+    return !GetReference(message, NULL).empty();
+  }
+  string Get(const Message& message) const {
+    if (!direct_) return reflection_->GetString(message, field_);
+    return GetReference(message, NULL);
+  }
+  // Same as Reflection::GetStringReference(): avoids the copy when the
+  // string is stored directly, in which case "scratch" is not used.
+  const string& GetReference(const Message& message, string* scratch) const {
+    if (!direct_) {
+      return reflection_->GetStringReference(message, field_, scratch);
+    }
+    const string* default_value =
+        static_cast<const string*>(layout_.default_value);
+    const void* raw = Raw(message);
+    if (raw == NULL) return *default_value;
+    return static_cast<const internal::ArenaStringPtr*>(raw)->Get(
+        default_value);
+  }
+  // Setting a string may allocate, so this always goes through the
+  // Reflection.
+  void Set(Message* message, const string& value) const {
+    reflection_->SetString(message, field_, value);
+  }
+
+ private:
+  friend class Reflection;
+  FieldAccessor(const Reflection* reflection, const FieldDescriptor* field)
+      : FieldAccessorBase(reflection, field) {
+    GOOGLE_CHECK(field->cpp_type() == FieldDescriptor::CPPTYPE_STRING)
+        << "FieldAccessor type does not match field " << field->full_name();
+  }
+};
+
+// FieldAccessor definition for message fields.
+template<>
+class FieldAccessor<Message> : public internal::FieldAccessorBase {
+ public:
+  // Same as Reflection::HasField().
+  bool Has(const Message& message) const {
+    if (!direct_) return reflection_->HasField(message, field_);
+    if (has_presence()) return IsSet(message);
+    // proto3: present if allocated, except in the default instance.
+    return !IsDefaultInstance(message) &&
+        *static_cast<const Message* const*>(Raw(message)) != NULL;
+  }
+  // Same as Reflection::GetMessage().
+  const Message& Get(const Message& message) const {
+    if (!direct_) return reflection_->GetMessage(message, field_);
+    const void* raw = Raw(message);
+    const Message* result =
+        raw != NULL ? *static_cast<const Message* const*>(raw) : NULL;
+    return result != NULL ?
+        *result : *static_cast<const Message*>(layout_.default_value);
+  }
+  // Same as Reflection::MutableMessage().  Only goes through the Reflection
+  // if the sub-message still has to be allocated.
+  Message* Mutable(Message* message) const {
+    if (direct_) {
+      void* raw = MutableRaw(message);
+      if (raw != NULL && *static_cast<Message**>(raw) != NULL) {
+        return *static_cast<Message**>(raw);
+      }
+    }
+    return reflection_->MutableMessage(message, field_);
+  }
+
+ private:
+  friend class Reflection;
+  FieldAccessor(const Reflection* reflection, const FieldDescriptor* field)
+      : FieldAccessorBase(reflection, field) {
+    GOOGLE_CHECK(field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE)
+        << "FieldAccessor type does not match field " << field->full_name();
+  }
+};
 }  // namespace protobuf
 }  // namespace google
 
@@ -32,13 +32,19 @@
 //  Based on original Protocol Buffers design by
 //  Sanjay Ghemawat, Jeff Dean, and others.
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include <google/protobuf/reflection_ops.h>
+#include <google/protobuf/arenastring.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/reflection.h>
+#include <google/protobuf/repeated_field.h>
 #include <google/protobuf/unknown_field_set.h>
+#include <google/protobuf/stubs/atomicops.h>
+#include <google/protobuf/stubs/once.h>
 #include <google/protobuf/stubs/strutil.h>
 
 namespace google {
@@ -51,88 +57,794 @@ void ReflectionOps::Copy(const Message& from, Message* to) {
   Merge(from, to);
 }
 
-void ReflectionOps::Merge(const Message& from, Message* to) {
-  GOOGLE_CHECK_NE(&from, to);
+// A MergePlan merges the fields which two Reflections of the same type both
+// keep at fixed offsets (see Reflection::GetFieldLayout()) straight from one
+// message to the other: singular fields tracked with has-bits, and repeated
+// fields other than maps.  Merge() builds one per pair of Reflections and
+// falls back to the Reflection accessors for every other field.  Clear()
+// uses the plan from a Reflection to itself to reset the same fields in
+// place.
+struct MergePlan {
+  // A numeric, bool or enum field, copied bytewise.
+  struct PodField {
+    int from_offset;
+    int to_offset;
+    int size;
+    uint32 has_bit_mask;
+    const void* to_default;
+  };
+
+  // PodFields which are laid out back to back in both messages and whose
+  // has-bits share a word in both.  When all of them are set, the whole
+  // run is copied with a single memcpy().
+  struct PodRun {
+    int from_has_bit_offset;
+    int to_has_bit_offset;
+    uint32 has_bit_mask;
+    int from_offset;
+    int to_offset;
+    int size;
+    int begin;  // [begin, end) is the run's range of pod_fields.
+    int end;
+  };
+
+  struct StringField {
+    int from_offset;
+    int to_offset;
+    int from_has_bit_offset;
+    int to_has_bit_offset;
+    uint32 has_bit_mask;
+    const string* from_default;
+    const string* to_default;
+  };
+
+  // A repeated numeric, bool, enum or string field.  merge and clear are
+  // instantiated for its RepeatedField or RepeatedPtrField type.
+  struct RepeatedValueField {
+    int from_offset;
+    int to_offset;
+    void (*merge)(const void* from, void* to);
+    void (*clear)(void* field);
+  };
+
+  // A sub-message field, either repeated and stored as a RepeatedPtrField,
+  // or singular with a has-bit and stored as a pointer.  Sub-messages are
+  // still allocated through the Reflection of the message merged into.
+  struct MessageField {
+    const FieldDescriptor* descriptor;
+    int from_offset;
+    int to_offset;
+    int from_has_bit_offset;  // -1 if repeated.
+    int to_has_bit_offset;
+    uint32 has_bit_mask;
+  };
+
+  vector<PodField> pod_fields;
+  vector<PodRun> pod_runs;
+  vector<StringField> string_fields;
+  vector<RepeatedValueField> repeated_fields;
+  vector<MessageField> message_fields;
+  // Indexed by field index.  True for the fields copied by the above.
+  vector<bool> planned;
+  // The other fields, which go through the Reflection accessors.
+  vector<const FieldDescriptor*> unplanned_fields;
+  // Whether the type has extension ranges, in which case the unplanned
+  // fields are found with Reflection::VisitFields() instead.
+  bool has_extensions;
+};
+
+namespace {
+
+// A PodField along with the has-bit words which PodRuns are grouped by.
+struct PodCandidate {
+  int from_has_bit_offset;
+  int to_has_bit_offset;
+  MergePlan::PodField field;
+};
+
+// Orders PodCandidates so that members of a run end up adjacent.
+struct PodCandidateOrder {
+  bool operator()(const PodCandidate& a, const PodCandidate& b) const {
+    if (a.from_has_bit_offset != b.from_has_bit_offset) {
+      return a.from_has_bit_offset < b.from_has_bit_offset;
+    }
+    if (a.to_has_bit_offset != b.to_has_bit_offset) {
+      return a.to_has_bit_offset < b.to_has_bit_offset;
+    }
+    return a.field.from_offset < b.field.from_offset;
+  }
+};
+
+int PodSize(FieldDescriptor::CppType cpp_type) {
+  switch (cpp_type) {
+    case FieldDescriptor::CPPTYPE_INT32:  return sizeof(int32);
+    case FieldDescriptor::CPPTYPE_INT64:  return sizeof(int64);
+    case FieldDescriptor::CPPTYPE_UINT32: return sizeof(uint32);
+    case FieldDescriptor::CPPTYPE_UINT64: return sizeof(uint64);
+    case FieldDescriptor::CPPTYPE_DOUBLE: return sizeof(double);
+    case FieldDescriptor::CPPTYPE_FLOAT:  return sizeof(float);
+    case FieldDescriptor::CPPTYPE_BOOL:   return sizeof(bool);
+    case FieldDescriptor::CPPTYPE_ENUM:   return sizeof(int);
+    default:                              return 0;
+  }
+}
 
-  const Descriptor* descriptor = from.GetDescriptor();
-  GOOGLE_CHECK_EQ(to->GetDescriptor(), descriptor)
-    << "Tried to merge messages of different types "
-    << "(merge " << descriptor->full_name()
-    << " to " << to->GetDescriptor()->full_name() << ")";
+template <typename RepeatedType>
+void MergeRepeatedValues(const void* from, void* to) {
+  static_cast<RepeatedType*>(to)->MergeFrom(
+      *static_cast<const RepeatedType*>(from));
+}
 
-  const Reflection* from_reflection = from.GetReflection();
-  const Reflection* to_reflection = to->GetReflection();
+template <typename RepeatedType>
+void ClearRepeatedValues(void* field) {
+  static_cast<RepeatedType*>(field)->Clear();
+}
 
-  vector<const FieldDescriptor*> fields;
-  from_reflection->ListFields(from, &fields);
-  for (int i = 0; i < fields.size(); i++) {
-    const FieldDescriptor* field = fields[i];
+// Fills in the functions for merging and clearing a repeated field other
+// than a message field.  Returns false for strings which are not stored as
+// plain strings.
+bool GetRepeatedValueOps(const FieldDescriptor* field,
+                         MergePlan::RepeatedValueField* repeated_field) {
+  switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, TYPE)                                       \
+    case FieldDescriptor::CPPTYPE_##CPPTYPE:                             \
+      repeated_field->merge = &MergeRepeatedValues<RepeatedField<TYPE> >; \
+      repeated_field->clear = &ClearRepeatedValues<RepeatedField<TYPE> >; \
+      return true;
+
+    HANDLE_TYPE(INT32 , int32 );
+    HANDLE_TYPE(INT64 , int64 );
+    HANDLE_TYPE(UINT32, uint32);
+    HANDLE_TYPE(UINT64, uint64);
+    HANDLE_TYPE(FLOAT , float );
+    HANDLE_TYPE(DOUBLE, double);
+    HANDLE_TYPE(BOOL  , bool  );
+    HANDLE_TYPE(ENUM  , int   );
+#undef HANDLE_TYPE
+
+    case FieldDescriptor::CPPTYPE_STRING:
+      if (field->options().ctype() != FieldOptions::STRING) return false;
+      repeated_field->merge = &MergeRepeatedValues<RepeatedPtrField<string> >;
+      repeated_field->clear = &ClearRepeatedValues<RepeatedPtrField<string> >;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void SplitIntoRuns(vector<PodCandidate>* candidates, MergePlan* plan) {
+  sort(candidates->begin(), candidates->end(), PodCandidateOrder());
+  for (int i = 0; i < candidates->size(); i++) {
+    const PodCandidate& candidate = (*candidates)[i];
+    const MergePlan::PodField& field = candidate.field;
+    MergePlan::PodRun* run =
+        plan->pod_runs.empty() ? NULL : &plan->pod_runs.back();
+    if (run == NULL ||
+        run->from_has_bit_offset != candidate.from_has_bit_offset ||
+        run->to_has_bit_offset != candidate.to_has_bit_offset ||
+        run->from_offset + run->size != field.from_offset ||
+        run->to_offset + run->size != field.to_offset) {
+      MergePlan::PodRun new_run;
+      new_run.from_has_bit_offset = candidate.from_has_bit_offset;
+      new_run.to_has_bit_offset = candidate.to_has_bit_offset;
+      new_run.has_bit_mask = 0;
+      new_run.from_offset = field.from_offset;
+      new_run.to_offset = field.to_offset;
+      new_run.size = 0;
+      new_run.begin = plan->pod_fields.size();
+      plan->pod_runs.push_back(new_run);
+      run = &plan->pod_runs.back();
+    }
+    run->has_bit_mask |= field.has_bit_mask;
+    run->size += field.size;
+    plan->pod_fields.push_back(field);
+    run->end = plan->pod_fields.size();
+  }
+}
+
+inline const uint32& HasBitWord(const Message& message, int offset) {
+  return *reinterpret_cast<const uint32*>(
+      reinterpret_cast<const uint8*>(&message) + offset);
+}
+
+inline uint32* MutableHasBitWord(Message* message, int offset) {
+  return reinterpret_cast<uint32*>(
+      reinterpret_cast<uint8*>(message) + offset);
+}
+
+inline const void* FieldAt(const Message& message, int offset) {
+  return reinterpret_cast<const uint8*>(&message) + offset;
+}
+
+inline void* MutableFieldAt(Message* message, int offset) {
+  return reinterpret_cast<uint8*>(message) + offset;
+}
 
+// Sub-messages of the same implementation use their own MergeFrom(),
+// which for generated messages is the generated code.  Otherwise
+// MergeFrom() would only end up back in ReflectionOps::Merge() after a
+// failed dynamic_cast, so go there directly.
+void MergeMessage(const Message& from, Message* to) {
+  if (from.GetReflection() == to->GetReflection()) {
+    to->MergeFrom(from);
+  } else {
+    ReflectionOps::Merge(from, to);
+  }
+}
+
+void MergePlannedMessages(const MergePlan& plan, const Message& from,
+                          Message* to, const Reflection* to_reflection) {
+  for (int i = 0; i < plan.message_fields.size(); i++) {
+    const MergePlan::MessageField& field = plan.message_fields[i];
+    if (field.from_has_bit_offset == -1) {
+      const RepeatedPtrField<Message>& from_field =
+          *static_cast<const RepeatedPtrField<Message>*>(
+              FieldAt(from, field.from_offset));
+      for (int j = 0; j < from_field.size(); j++) {
+        MergeMessage(from_field.Get(j),
+                     to_reflection->AddMessage(to, field.descriptor));
+      }
+      continue;
+    }
+
+    if ((HasBitWord(from, field.from_has_bit_offset) &
+         field.has_bit_mask) == 0) {
+      continue;
+    }
+    const Message* from_message =
+        *static_cast<const Message* const*>(FieldAt(from, field.from_offset));
+    Message* to_message =
+        *static_cast<Message**>(MutableFieldAt(to, field.to_offset));
+    if (to_message != NULL) {
+      *MutableHasBitWord(to, field.to_has_bit_offset) |= field.has_bit_mask;
+    } else {
+      to_message = to_reflection->MutableMessage(to, field.descriptor);
+    }
+    if (from_message != NULL) MergeMessage(*from_message, to_message);
+  }
+}
+
+void ExecuteMergePlan(const MergePlan& plan, const Message& from,
+                      Message* to, const Reflection* to_reflection) {
+  for (int i = 0; i < plan.pod_runs.size(); i++) {
+    const MergePlan::PodRun& run = plan.pod_runs[i];
+    uint32 bits =
+        HasBitWord(from, run.from_has_bit_offset) & run.has_bit_mask;
+    if (bits == 0) continue;
+    if (bits == run.has_bit_mask) {
+      memcpy(MutableFieldAt(to, run.to_offset),
+             FieldAt(from, run.from_offset), run.size);
+    } else {
+      for (int j = run.begin; j < run.end; j++) {
+        const MergePlan::PodField& field = plan.pod_fields[j];
+        if (bits & field.has_bit_mask) {
+          memcpy(MutableFieldAt(to, field.to_offset),
+                 FieldAt(from, field.from_offset), field.size);
+        }
+      }
+    }
+    *MutableHasBitWord(to, run.to_has_bit_offset) |= bits;
+  }
+
+  if (!plan.string_fields.empty()) {
+    Arena* arena = to->GetArena();
+    for (int i = 0; i < plan.string_fields.size(); i++) {
+      const MergePlan::StringField& field = plan.string_fields[i];
+      if ((HasBitWord(from, field.from_has_bit_offset) &
+           field.has_bit_mask) == 0) {
+        continue;
+      }
+      const ArenaStringPtr* from_string =
+          reinterpret_cast<const ArenaStringPtr*>(
+              FieldAt(from, field.from_offset));
+      reinterpret_cast<ArenaStringPtr*>(MutableFieldAt(to, field.to_offset))
+          ->Set(field.to_default, from_string->Get(field.from_default), arena);
+      *MutableHasBitWord(to, field.to_has_bit_offset) |= field.has_bit_mask;
+    }
+  }
+
+  for (int i = 0; i < plan.repeated_fields.size(); i++) {
+    const MergePlan::RepeatedValueField& field = plan.repeated_fields[i];
+    field.merge(FieldAt(from, field.from_offset),
+                MutableFieldAt(to, field.to_offset));
+  }
+
+  if (!plan.message_fields.empty()) {
+    MergePlannedMessages(plan, from, to, to_reflection);
+  }
+}
+
+// Resets the fields of the MergePlan from a message's Reflection to itself
+// to their defaults.  Unlike Reflection::ClearField(), strings keep their
+// allocation for reuse, as in generated Clear() methods.  Sub-messages are
+// kept and cleared, as ClearField() does.
+void ClearPlannedFields(const MergePlan& plan, Message* message) {
+  for (int i = 0; i < plan.pod_runs.size(); i++) {
+    const MergePlan::PodRun& run = plan.pod_runs[i];
+    uint32* has_bits = MutableHasBitWord(message, run.to_has_bit_offset);
+    uint32 bits = *has_bits & run.has_bit_mask;
+    if (bits == 0) continue;
+    for (int j = run.begin; j < run.end; j++) {
+      const MergePlan::PodField& field = plan.pod_fields[j];
+      if (bits & field.has_bit_mask) {
+        memcpy(MutableFieldAt(message, field.to_offset), field.to_default,
+               field.size);
+      }
+    }
+    *has_bits &= ~bits;
+  }
+
+  if (!plan.string_fields.empty()) {
+    Arena* arena = message->GetArena();
+    for (int i = 0; i < plan.string_fields.size(); i++) {
+      const MergePlan::StringField& field = plan.string_fields[i];
+      uint32* has_bits = MutableHasBitWord(message, field.to_has_bit_offset);
+      if ((*has_bits & field.has_bit_mask) == 0) continue;
+      reinterpret_cast<ArenaStringPtr*>(
+          MutableFieldAt(message, field.to_offset))
+          ->ClearToDefault(field.to_default, arena);
+      *has_bits &= ~field.has_bit_mask;
+    }
+  }
+
+  for (int i = 0; i < plan.repeated_fields.size(); i++) {
+    const MergePlan::RepeatedValueField& field = plan.repeated_fields[i];
+    field.clear(MutableFieldAt(message, field.to_offset));
+  }
+
+  for (int i = 0; i < plan.message_fields.size(); i++) {
+    const MergePlan::MessageField& field = plan.message_fields[i];
+    void* raw = MutableFieldAt(message, field.to_offset);
+    if (field.to_has_bit_offset == -1) {
+      static_cast<RepeatedPtrField<Message>*>(raw)->Clear();
+      continue;
+    }
+    uint32* has_bits = MutableHasBitWord(message, field.to_has_bit_offset);
+    if ((*has_bits & field.has_bit_mask) == 0) continue;
+    Message* sub_message = *static_cast<Message**>(raw);
+    if (sub_message != NULL) sub_message->Clear();
+    *has_bits &= ~field.has_bit_mask;
+  }
+}
+
+// Clears the fields which the MergePlan leaves to the Reflection accessors.
+// Clearing the field being visited does not affect which of the remaining
+// fields are visited.
+class FieldClearer : public Reflection::FieldVisitor {
+ public:
+  FieldClearer(const MergePlan& plan, Message* message)
+      : plan_(plan), message_(message),
+        reflection_(message->GetReflection()) {}
+
+  void Visit(const FieldDescriptor* field) {
+    if (!field->is_extension() && plan_.planned[field->index()]) return;
+    reflection_->ClearField(message_, field);
+  }
+
+ private:
+  const MergePlan& plan_;
+  Message* message_;
+  const Reflection* reflection_;
+};
+
+inline bool HasUnplannedFields(const MergePlan& plan) {
+  return plan.has_extensions || !plan.unplanned_fields.empty();
+}
+
+// Passes each field of message which is set but not covered by the MergePlan
+// to visitor.  The visitor must ignore the planned fields itself, since they
+// are also visited when the type has extensions.
+void VisitUnplannedFields(const MergePlan& plan, const Message& message,
+                          Reflection::FieldVisitor* visitor) {
+  const Reflection* reflection = message.GetReflection();
+  if (plan.has_extensions) {
+    reflection->VisitFields(message, visitor);
+    return;
+  }
+  for (int i = 0; i < plan.unplanned_fields.size(); i++) {
+    const FieldDescriptor* field = plan.unplanned_fields[i];
+    if (field->is_repeated() ? reflection->FieldSize(message, field) > 0
+                             : reflection->HasField(message, field)) {
+      visitor->Visit(field);
+    }
+  }
+}
+
+// Merges the fields which the MergePlan leaves to the Reflection accessors.
+class FieldMerger : public Reflection::FieldVisitor {
+ public:
+  FieldMerger(const MergePlan& plan, const Message& from, Message* to)
+      : plan_(plan), from_(from), from_reflection_(from.GetReflection()),
+        to_(to), to_reflection_(to->GetReflection()) {}
+
+  void Visit(const FieldDescriptor* field) {
+    if (!field->is_extension() && plan_.planned[field->index()]) return;
     if (field->is_repeated()) {
-      int count = from_reflection->FieldSize(from, field);
-      for (int j = 0; j < count; j++) {
-        switch (field->cpp_type()) {
-#define HANDLE_TYPE(CPPTYPE, METHOD)                                     \
-          case FieldDescriptor::CPPTYPE_##CPPTYPE:                       \
-            to_reflection->Add##METHOD(to, field,                        \
-              from_reflection->GetRepeated##METHOD(from, field, j));     \
-            break;
-
-          HANDLE_TYPE(INT32 , Int32 );
-          HANDLE_TYPE(INT64 , Int64 );
-          HANDLE_TYPE(UINT32, UInt32);
-          HANDLE_TYPE(UINT64, UInt64);
-          HANDLE_TYPE(FLOAT , Float );
-          HANDLE_TYPE(DOUBLE, Double);
-          HANDLE_TYPE(BOOL  , Bool  );
-          HANDLE_TYPE(STRING, String);
-          HANDLE_TYPE(ENUM  , Enum  );
+      MergeRepeated(field);
+    } else {
+      MergeSingular(field);
+    }
+  }
+
+ private:
+  void MergeRepeated(const FieldDescriptor* field) {
+    switch (field->cpp_type()) {
+      // Numeric fields are appended as a block.
+#define HANDLE_TYPE(CPPTYPE, TYPE)                                       \
+      case FieldDescriptor::CPPTYPE_##CPPTYPE:                           \
+        to_reflection_->MutableRepeatedField<TYPE>(to_, field)->MergeFrom( \
+            from_reflection_->GetRepeatedField<TYPE>(from_, field));     \
+        return;
+
+      HANDLE_TYPE(INT32 , int32 );
+      HANDLE_TYPE(INT64 , int64 );
+      HANDLE_TYPE(UINT32, uint32);
+      HANDLE_TYPE(UINT64, uint64);
+      HANDLE_TYPE(FLOAT , float );
+      HANDLE_TYPE(DOUBLE, double);
+      HANDLE_TYPE(BOOL  , bool  );
 #undef HANDLE_TYPE
 
-          case FieldDescriptor::CPPTYPE_MESSAGE:
-            to_reflection->AddMessage(to, field)->MergeFrom(
-              from_reflection->GetRepeatedMessage(from, field, j));
-            break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        if (field->options().ctype() == FieldOptions::STRING) {
+          to_reflection_->MutableRepeatedPtrField<string>(to_, field)
+              ->MergeFrom(
+                  from_reflection_->GetRepeatedPtrField<string>(from_, field));
+          return;
         }
+        break;
+
+      case FieldDescriptor::CPPTYPE_MESSAGE: {
+        // Fetch the source field once rather than once per element.  Not
+        // for maps, whose raw repeated field would have to be synced first.
+        if (field->is_map()) break;
+        const RepeatedPtrField<Message>& from_field =
+            from_reflection_->GetRepeatedPtrField<Message>(from_, field);
+        for (int j = 0; j < from_field.size(); j++) {
+          MergeMessage(from_field.Get(j),
+                       to_reflection_->AddMessage(to_, field));
+        }
+        return;
       }
-    } else {
+
+      default:
+        break;
+    }
+
+    int count = from_reflection_->FieldSize(from_, field);
+    for (int j = 0; j < count; j++) {
       switch (field->cpp_type()) {
-#define HANDLE_TYPE(CPPTYPE, METHOD)                                        \
-        case FieldDescriptor::CPPTYPE_##CPPTYPE:                            \
-          to_reflection->Set##METHOD(to, field,                             \
-            from_reflection->Get##METHOD(from, field));                     \
+        case FieldDescriptor::CPPTYPE_STRING:
+          to_reflection_->AddString(to_, field,
+            from_reflection_->GetRepeatedString(from_, field, j));
+          break;
+        case FieldDescriptor::CPPTYPE_ENUM:
+          to_reflection_->AddEnum(to_, field,
+            from_reflection_->GetRepeatedEnum(from_, field, j));
+          break;
+        case FieldDescriptor::CPPTYPE_MESSAGE:
+          MergeMessage(from_reflection_->GetRepeatedMessage(from_, field, j),
+                       to_reflection_->AddMessage(to_, field));
+          break;
+        default:
+          GOOGLE_LOG(FATAL) << "Can't get here.";
           break;
+      }
+    }
+  }
 
-        HANDLE_TYPE(INT32 , Int32 );
-        HANDLE_TYPE(INT64 , Int64 );
-        HANDLE_TYPE(UINT32, UInt32);
-        HANDLE_TYPE(UINT64, UInt64);
-        HANDLE_TYPE(FLOAT , Float );
-        HANDLE_TYPE(DOUBLE, Double);
-        HANDLE_TYPE(BOOL  , Bool  );
-        HANDLE_TYPE(STRING, String);
-        HANDLE_TYPE(ENUM  , Enum  );
+  void MergeSingular(const FieldDescriptor* field) {
+    switch (field->cpp_type()) {
+#define HANDLE_TYPE(CPPTYPE, METHOD)                                        \
+      case FieldDescriptor::CPPTYPE_##CPPTYPE:                              \
+        to_reflection_->Set##METHOD(to_, field,                             \
+          from_reflection_->Get##METHOD(from_, field));                     \
+        break;
+
+      HANDLE_TYPE(INT32 , Int32 );
+      HANDLE_TYPE(INT64 , Int64 );
+      HANDLE_TYPE(UINT32, UInt32);
+      HANDLE_TYPE(UINT64, UInt64);
+      HANDLE_TYPE(FLOAT , Float );
+      HANDLE_TYPE(DOUBLE, Double);
+      HANDLE_TYPE(BOOL  , Bool  );
+      HANDLE_TYPE(STRING, String);
+      HANDLE_TYPE(ENUM  , Enum  );
 #undef HANDLE_TYPE
 
-        case FieldDescriptor::CPPTYPE_MESSAGE:
-          to_reflection->MutableMessage(to, field)->MergeFrom(
-            from_reflection->GetMessage(from, field));
-          break;
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        MergeMessage(from_reflection_->GetMessage(from_, field),
+                     to_reflection_->MutableMessage(to_, field));
+        break;
+    }
+  }
+
+  const MergePlan& plan_;
+  const Message& from_;
+  const Reflection* from_reflection_;
+  Message* to_;
+  const Reflection* to_reflection_;
+};
+
+// The plans for merging into one Reflection, hung off its merge_plans_.
+// GetMergePlan() reads them without locking.  They are only changed with
+// merge_plans_mutex_ held: an entry's plan is written before its key is
+// published with a release store, and new entries are published the same
+// way at the head of the list.  Entries are never unlinked while the
+// Reflection is alive.  When the Reflection an entry is keyed by goes away,
+// the entry's key is cleared and its plan deleted, which is safe since
+// nobody can be looking up that key anymore, and the entry is reused for
+// the next plan.
+struct MergePlanCache {
+  struct Entry {
+    AtomicWord from;  // Really the const Reflection* merged from, or 0.
+    const MergePlan* plan;
+    Entry* next;
+  };
+
+  MergePlanCache() : head(0) {}
+  ~MergePlanCache() {
+    Entry* entry = reinterpret_cast<Entry*>(head);
+    while (entry != NULL) {
+      Entry* next = entry->next;
+      delete entry->plan;
+      delete entry;
+      entry = next;
+    }
+  }
+
+  AtomicWord head;  // Really an Entry*.
+
+  // The other Reflections whose caches have plans merging from this one.
+  // Guarded by merge_plans_mutex_.
+  vector<const Reflection*> merged_into;
+};
+
+// Only guards building plans and forgetting Reflections; lookups don't take
+// it.  NULL after shutdown.
+Mutex* merge_plans_mutex_ = NULL;
+GOOGLE_PROTOBUF_DECLARE_ONCE(merge_plans_once_);
+
+void DeleteMergePlansMutex() {
+  // The caches belong to the Reflections, which may outlive this.
+  delete merge_plans_mutex_;
+  merge_plans_mutex_ = NULL;
+}
+
+void InitMergePlansMutex() {
+  merge_plans_mutex_ = new Mutex;
+  OnShutdown(&DeleteMergePlansMutex);
+}
+
+inline MergePlanCache* LoadCache(const AtomicWord* merge_plans) {
+  return reinterpret_cast<MergePlanCache*>(Acquire_Load(merge_plans));
+}
+
+// Returns the cached plan for merging from from_reflection, or NULL.
+inline const MergePlan* FindMergePlan(const MergePlanCache* cache,
+                                      const Reflection* from_reflection) {
+  if (cache == NULL) return NULL;
+  AtomicWord key = reinterpret_cast<AtomicWord>(from_reflection);
+  for (const MergePlanCache::Entry* entry =
+           reinterpret_cast<const MergePlanCache::Entry*>(
+               Acquire_Load(&cache->head));
+       entry != NULL; entry = entry->next) {
+    if (Acquire_Load(&entry->from) == key) return entry->plan;
+  }
+  return NULL;
+}
+
+// Returns the cache at *merge_plans, creating it if needed.  Must be called
+// with merge_plans_mutex_ held.
+MergePlanCache* MutableCache(AtomicWord* merge_plans) {
+  MergePlanCache* cache = LoadCache(merge_plans);
+  if (cache == NULL) {
+    cache = new MergePlanCache;
+    Release_Store(merge_plans, reinterpret_cast<AtomicWord>(cache));
+  }
+  return cache;
+}
+
+// Adds a plan to the cache, reusing a cleared entry if there is one.  Must
+// be called with merge_plans_mutex_ held.
+void AddMergePlan(MergePlanCache* cache, const Reflection* from_reflection,
+                  const MergePlan* plan) {
+  AtomicWord key = reinterpret_cast<AtomicWord>(from_reflection);
+  MergePlanCache::Entry* head =
+      reinterpret_cast<MergePlanCache::Entry*>(cache->head);
+  for (MergePlanCache::Entry* entry = head; entry != NULL;
+       entry = entry->next) {
+    if (entry->from == 0) {
+      entry->plan = plan;
+      Release_Store(&entry->from, key);
+      return;
+    }
+  }
+  MergePlanCache::Entry* entry = new MergePlanCache::Entry;
+  entry->from = key;
+  entry->plan = plan;
+  entry->next = head;
+  Release_Store(&cache->head, reinterpret_cast<AtomicWord>(entry));
+}
+
+// Clears the entry keyed by from_reflection and deletes its plan.  Must be
+// called with merge_plans_mutex_ held.
+void RemoveMergePlan(MergePlanCache* cache,
+                     const Reflection* from_reflection) {
+  AtomicWord key = reinterpret_cast<AtomicWord>(from_reflection);
+  for (MergePlanCache::Entry* entry =
+           reinterpret_cast<MergePlanCache::Entry*>(cache->head);
+       entry != NULL; entry = entry->next) {
+    if (entry->from == key) {
+      Release_Store(&entry->from, 0);
+      delete entry->plan;
+      entry->plan = NULL;
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+bool ReflectionOps::GetFieldLayout(const Reflection* reflection,
+                                   const FieldDescriptor* field,
+                                   FieldLayout* layout) {
+  return reflection->GetFieldLayout(field, layout);
+}
+
+const MergePlan* ReflectionOps::GetMergePlan(
+    const Descriptor* descriptor, const Reflection* from_reflection,
+    const Reflection* to_reflection) {
+  const MergePlan* plan =
+      FindMergePlan(LoadCache(MergePlans(to_reflection)), from_reflection);
+  if (plan != NULL) return plan;
+
+  ::google::protobuf::GoogleOnceInit(&merge_plans_once_, &InitMergePlansMutex);
+  MutexLock lock(merge_plans_mutex_);
+  MergePlanCache* cache = MutableCache(MergePlans(to_reflection));
+  plan = FindMergePlan(cache, from_reflection);
+  if (plan != NULL) return plan;
+
+  MergePlan* new_plan = new MergePlan;
+  new_plan->planned.resize(descriptor->field_count(), false);
+  new_plan->has_extensions = descriptor->extension_range_count() > 0;
+  vector<PodCandidate> pod_candidates;
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const FieldDescriptor* field = descriptor->field(i);
+    FieldLayout from_layout;
+    FieldLayout to_layout;
+    if (!GetFieldLayout(from_reflection, field, &from_layout) ||
+        !GetFieldLayout(to_reflection, field, &to_layout)) {
+      new_plan->unplanned_fields.push_back(field);
+      continue;
+    }
+    if (field->is_repeated() &&
+        field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      MergePlan::RepeatedValueField repeated_field;
+      if (!GetRepeatedValueOps(field, &repeated_field)) {
+        new_plan->unplanned_fields.push_back(field);
+        continue;
       }
+      repeated_field.from_offset = from_layout.offset;
+      repeated_field.to_offset = to_layout.offset;
+      new_plan->repeated_fields.push_back(repeated_field);
+      new_plan->planned[i] = true;
+      continue;
+    }
+    if (from_layout.has_bit_mask != to_layout.has_bit_mask ||
+        (!field->is_repeated() && (from_layout.has_bit_offset == -1 ||
+                                   to_layout.has_bit_offset == -1))) {
+      new_plan->unplanned_fields.push_back(field);
+      continue;
+    }
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      MergePlan::MessageField message_field;
+      message_field.descriptor = field;
+      message_field.from_offset = from_layout.offset;
+      message_field.to_offset = to_layout.offset;
+      message_field.from_has_bit_offset = from_layout.has_bit_offset;
+      message_field.to_has_bit_offset = to_layout.has_bit_offset;
+      message_field.has_bit_mask = from_layout.has_bit_mask;
+      new_plan->message_fields.push_back(message_field);
+    } else if (field->cpp_type() == FieldDescriptor::CPPTYPE_STRING) {
+      MergePlan::StringField string_field;
+      string_field.from_offset = from_layout.offset;
+      string_field.to_offset = to_layout.offset;
+      string_field.from_has_bit_offset = from_layout.has_bit_offset;
+      string_field.to_has_bit_offset = to_layout.has_bit_offset;
+      string_field.has_bit_mask = from_layout.has_bit_mask;
+      string_field.from_default =
+          static_cast<const string*>(from_layout.default_value);
+      string_field.to_default =
+          static_cast<const string*>(to_layout.default_value);
+      new_plan->string_fields.push_back(string_field);
+    } else {
+      PodCandidate candidate;
+      candidate.from_has_bit_offset = from_layout.has_bit_offset;
+      candidate.to_has_bit_offset = to_layout.has_bit_offset;
+      candidate.field.from_offset = from_layout.offset;
+      candidate.field.to_offset = to_layout.offset;
+      candidate.field.size = PodSize(field->cpp_type());
+      candidate.field.has_bit_mask = from_layout.has_bit_mask;
+      candidate.field.to_default = to_layout.default_value;
+      pod_candidates.push_back(candidate);
     }
+    new_plan->planned[i] = true;
   }
+  SplitIntoRuns(&pod_candidates, new_plan);
 
-  to_reflection->MutableUnknownFields(to)->MergeFrom(
-    from_reflection->GetUnknownFields(from));
+  AddMergePlan(cache, from_reflection, new_plan);
+  if (from_reflection != to_reflection) {
+    // So that from_reflection can clear the entry when it goes away.
+    MutableCache(MergePlans(from_reflection))
+        ->merged_into.push_back(to_reflection);
+  }
+  return new_plan;
+}
+
+void ReflectionOps::ForgetReflection(const Reflection* reflection) {
+  MergePlanCache* cache = LoadCache(MergePlans(reflection));
+  if (cache == NULL) return;  // Never merged from or into.
+
+  // The mutex is gone after shutdown, but then nobody is merging anymore.
+  MutexLockMaybe lock(merge_plans_mutex_);
+  // Clear the plans from this Reflection in the caches of the others.
+  for (int i = 0; i < cache->merged_into.size(); i++) {
+    RemoveMergePlan(LoadCache(MergePlans(cache->merged_into[i])), reflection);
+  }
+  // The others don't need to clear their plans into this one anymore.
+  for (const MergePlanCache::Entry* entry =
+           reinterpret_cast<const MergePlanCache::Entry*>(cache->head);
+       entry != NULL; entry = entry->next) {
+    const Reflection* from_reflection =
+        reinterpret_cast<const Reflection*>(entry->from);
+    if (from_reflection == NULL || from_reflection == reflection) continue;
+    vector<const Reflection*>* merged_into =
+        &LoadCache(MergePlans(from_reflection))->merged_into;
+    merged_into->erase(
+        find(merged_into->begin(), merged_into->end(), reflection));
+  }
+  delete cache;
+  *MergePlans(reflection) = 0;
+}
+
+void ReflectionOps::Merge(const Message& from, Message* to) {
+  GOOGLE_CHECK_NE(&from, to);
+
+  const Descriptor* descriptor = from.GetDescriptor();
+  GOOGLE_CHECK_EQ(to->GetDescriptor(), descriptor)
+    << "Tried to merge messages of different types "
+    << "(merge " << descriptor->full_name()
+    << " to " << to->GetDescriptor()->full_name() << ")";
+
+  const Reflection* from_reflection = from.GetReflection();
+  const Reflection* to_reflection = to->GetReflection();
+
+  const MergePlan* plan =
+      GetMergePlan(descriptor, from_reflection, to_reflection);
+  ExecuteMergePlan(*plan, from, to, to_reflection);
+  if (HasUnplannedFields(*plan)) {
+    FieldMerger merger(*plan, from, to);
+    VisitUnplannedFields(*plan, from, &merger);
+  }
+
+  const UnknownFieldSet& unknown_fields =
+      from_reflection->GetUnknownFields(from);
+  if (!unknown_fields.empty()) {
+    to_reflection->MutableUnknownFields(to)->MergeFrom(unknown_fields);
+  }
 }
 
 void ReflectionOps::Clear(Message* message) {
   const Reflection* reflection = message->GetReflection();
 
-  vector<const FieldDescriptor*> fields;
-  reflection->ListFields(*message, &fields);
-  for (int i = 0; i < fields.size(); i++) {
-    reflection->ClearField(message, fields[i]);
+  const MergePlan* plan =
+      GetMergePlan(message->GetDescriptor(), reflection, reflection);
+  ClearPlannedFields(*plan, message);
+  if (HasUnplannedFields(*plan)) {
+    FieldClearer clearer(*plan, message);
+    VisitUnplannedFields(*plan, *message, &clearer);
   }
 
   reflection->MutableUnknownFields(message)->Clear();
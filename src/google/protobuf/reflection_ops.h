@@ -45,6 +45,9 @@ namespace google {
 namespace protobuf {
 namespace internal {
 
+struct FieldLayout;  // reflection.h
+struct MergePlan;   // reflection_ops.cc
+
 // Basic operations that can be performed using reflection.
 // These can be used as a cheap way to implement the corresponding
 // methods of the Message interface, though they are likely to be
@@ -69,7 +72,23 @@ class LIBPROTOBUF_EXPORT ReflectionOps {
                                        const string& prefix,
                                        vector<string>* errors);
 
+  // Merge() caches a plan for each pair of Reflections it has merged
+  // between, on the Reflection merged into.  Called by ~Reflection() to
+  // discard the plans involving it.
+  static void ForgetReflection(const Reflection* reflection);
+
  private:
+  // Reflection::merge_plans_, for the helpers in reflection_ops.cc.
+  static AtomicWord* MergePlans(const Reflection* reflection) {
+    return &reflection->merge_plans_;
+  }
+  static bool GetFieldLayout(const Reflection* reflection,
+                             const FieldDescriptor* field,
+                             FieldLayout* layout);
+  static const MergePlan* GetMergePlan(const Descriptor* descriptor,
+                                       const Reflection* from_reflection,
+                                       const Reflection* to_reflection);
+
   // All methods are static.  No need to construct.
   GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ReflectionOps);
 };
@@ -33,7 +33,9 @@
 //  Sanjay Ghemawat, Jeff Dean, and others.
 
 #include <google/protobuf/reflection_ops.h>
+#include <google/protobuf/arena.h>
 #include <google/protobuf/descriptor.h>
+#include <google/protobuf/dynamic_message.h>
 #include <google/protobuf/unittest.pb.h>
 #include <google/protobuf/test_util.h>
 
@@ -182,6 +184,122 @@ TEST(ReflectionOpsTest, MergeOneof) {
   TestUtil::ExpectOneofSet2(message2);
 }
 
+TEST(ReflectionOpsTest, CopyBetweenGeneratedAndDynamic) {
+  // Merge() copies between different implementations of the same type
+  // through a cached plan of field offsets.
+  const Descriptor* descriptor = unittest::TestAllTypes::descriptor();
+  TestUtil::ReflectionTester reflection_tester(descriptor);
+  DynamicMessageFactory factory;
+  scoped_ptr<Message> dynamic(factory.GetPrototype(descriptor)->New());
+
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  ReflectionOps::Copy(message, dynamic.get());
+  reflection_tester.ExpectAllFieldsSetViaReflection(*dynamic);
+
+  unittest::TestAllTypes message2;
+  ReflectionOps::Copy(*dynamic, &message2);
+  TestUtil::ExpectAllFieldsSet(message2);
+
+  // Again, now that the plans are cached.
+  ReflectionOps::Copy(message, dynamic.get());
+  reflection_tester.ExpectAllFieldsSetViaReflection(*dynamic);
+  message2.Clear();
+  ReflectionOps::Copy(*dynamic, &message2);
+  TestUtil::ExpectAllFieldsSet(message2);
+
+  // Between two DynamicMessages.
+  scoped_ptr<Message> dynamic2(factory.GetPrototype(descriptor)->New());
+  ReflectionOps::Copy(*dynamic, dynamic2.get());
+  reflection_tester.ExpectAllFieldsSetViaReflection(*dynamic2);
+}
+
+TEST(ReflectionOpsTest, MergeBetweenGeneratedAndDynamic) {
+  const Descriptor* descriptor = unittest::TestAllTypes::descriptor();
+  DynamicMessageFactory factory;
+  scoped_ptr<Message> dynamic(factory.GetPrototype(descriptor)->New());
+
+  unittest::TestAllTypes message, message2;
+  TestUtil::SetAllFields(&message);
+
+  // Only some of the fields sharing a has-bit word are set in the source.
+  message2.set_optional_int32(message.optional_int32());
+  message.clear_optional_int32();
+  message2.set_optional_double(message.optional_double());
+  message.clear_optional_double();
+  message2.set_optional_string(message.optional_string());
+  message.set_optional_string("something else");
+  message2.add_repeated_int32(message.repeated_int32(1));
+  int32 i = message.repeated_int32(0);
+  message.clear_repeated_int32();
+  message.add_repeated_int32(i);
+
+  ReflectionOps::Copy(message, dynamic.get());
+  ReflectionOps::Merge(message2, dynamic.get());
+  unittest::TestAllTypes result;
+  ReflectionOps::Copy(*dynamic, &result);
+  TestUtil::ExpectAllFieldsSet(result);
+}
+
+TEST(ReflectionOpsTest, CopyToDynamicMessageOnArena) {
+  const Descriptor* descriptor = unittest::TestAllTypes::descriptor();
+  DynamicMessageFactory factory;
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+
+  Arena arena;
+  Message* dynamic = factory.GetPrototype(descriptor)->New(&arena);
+  ReflectionOps::Copy(message, dynamic);
+  TestUtil::ReflectionTester(descriptor)
+      .ExpectAllFieldsSetViaReflection(*dynamic);
+}
+
+TEST(ReflectionOpsTest, ReuseClearedSubMessagesOfDynamic) {
+  // Clear() keeps sub-messages allocated.  Merging into them again must
+  // merge rather than keep what they held before.
+  const Descriptor* descriptor = unittest::TestAllTypes::descriptor();
+  DynamicMessageFactory factory;
+  scoped_ptr<Message> dynamic(factory.GetPrototype(descriptor)->New());
+
+  unittest::TestAllTypes message;
+  message.mutable_optional_nested_message()->set_bb(1);
+  message.add_repeated_nested_message()->set_bb(2);
+  ReflectionOps::Copy(message, dynamic.get());
+
+  message.Clear();
+  message.mutable_optional_nested_message();
+  message.add_repeated_nested_message();
+  ReflectionOps::Copy(message, dynamic.get());
+
+  unittest::TestAllTypes result;
+  ReflectionOps::Copy(*dynamic, &result);
+  EXPECT_TRUE(result.has_optional_nested_message());
+  EXPECT_FALSE(result.optional_nested_message().has_bb());
+  ASSERT_EQ(1, result.repeated_nested_message_size());
+  EXPECT_FALSE(result.repeated_nested_message(0).has_bb());
+
+  ReflectionOps::Clear(dynamic.get());
+  ReflectionOps::Copy(*dynamic, &result);
+  EXPECT_FALSE(result.has_optional_nested_message());
+  EXPECT_EQ(0, result.repeated_nested_message_size());
+}
+
+TEST(ReflectionOpsTest, MergeAfterFactoryDeleted) {
+  // Plans involving a Reflection are dropped when it is destroyed, so a
+  // new factory's Reflection is never matched with a stale plan.
+  const Descriptor* descriptor = unittest::TestAllTypes::descriptor();
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  for (int i = 0; i < 3; i++) {
+    DynamicMessageFactory factory;
+    scoped_ptr<Message> dynamic(factory.GetPrototype(descriptor)->New());
+    ReflectionOps::Copy(message, dynamic.get());
+    unittest::TestAllTypes message2;
+    ReflectionOps::Copy(*dynamic, &message2);
+    TestUtil::ExpectAllFieldsSet(message2);
+  }
+}
+
 #ifdef PROTOBUF_HAS_DEATH_TEST
 
 TEST(ReflectionOpsTest, MergeFromSelf) {
@@ -114,6 +114,13 @@ class RepeatedField {
 
   RepeatedField& operator=(const RepeatedField& other);
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  // Moving takes other's elements without copying them, unless the two
+  // fields are on different arenas.
+  RepeatedField(RepeatedField&& other);
+  RepeatedField& operator=(RepeatedField&& other);
+#endif
+
   bool empty() const;
   int size() const;
 
@@ -354,6 +361,10 @@ class LIBPROTOBUF_EXPORT RepeatedPtrFieldBase {
   // subclass.
   friend class MapFieldBase;
 
+  // The table-driven parser adds elements to repeated message fields without
+  // knowing their types, and needs AddFromCleared() to do so efficiently.
+  friend class TableDrivenMessage;
+
   // To parse directly into a proto2 generated class, the upb class GMR_Handlers
   // needs to be able to modify a RepeatedPtrFieldBase directly.
   friend class LIBPROTOBUF_EXPORT upb::google_opensource::GMR_Handlers;
@@ -704,6 +715,13 @@ class RepeatedPtrField : public internal::RepeatedPtrFieldBase {
 
   RepeatedPtrField& operator=(const RepeatedPtrField& other);
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+  // Moving takes other's elements without copying them, unless the two
+  // fields are on different arenas.
+  RepeatedPtrField(RepeatedPtrField&& other);
+  RepeatedPtrField& operator=(RepeatedPtrField&& other);
+#endif
+
   bool empty() const;
   int size() const;
 
@@ -996,6 +1014,35 @@ RepeatedField<Element>::operator=(const RepeatedField& other) {
   return *this;
 }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+template <typename Element>
+inline RepeatedField<Element>::RepeatedField(RepeatedField&& other)
+  : current_size_(0),
+    total_size_(0),
+    rep_(NULL) {
+  // This field is not on an arena (that would have used the Arena*
+  // constructor), so other's elements can only be taken if other isn't either.
+  if (other.GetArenaNoVirtual() != NULL) {
+    CopyFrom(other);
+  } else {
+    InternalSwap(&other);
+  }
+}
+
+template <typename Element>
+inline RepeatedField<Element>&
+RepeatedField<Element>::operator=(RepeatedField&& other) {
+  if (this != &other) {
+    if (GetArenaNoVirtual() != other.GetArenaNoVirtual()) {
+      CopyFrom(other);
+    } else {
+      InternalSwap(&other);
+    }
+  }
+  return *this;
+}
+#endif  // GOOGLE_PROTOBUF_CXX11
+
 template <typename Element>
 inline bool RepeatedField<Element>::empty() const {
   return current_size_ == 0;
@@ -1773,6 +1820,32 @@ inline RepeatedPtrField<Element>& RepeatedPtrField<Element>::operator=(
   return *this;
 }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+template <typename Element>
+inline RepeatedPtrField<Element>::RepeatedPtrField(RepeatedPtrField&& other)
+  : RepeatedPtrFieldBase() {
+  // As for RepeatedField, this field is not on an arena.
+  if (other.GetArenaNoVirtual() != NULL) {
+    CopyFrom(other);
+  } else {
+    RepeatedPtrFieldBase::InternalSwap(&other);
+  }
+}
+
+template <typename Element>
+inline RepeatedPtrField<Element>& RepeatedPtrField<Element>::operator=(
+    RepeatedPtrField&& other) {
+  if (this != &other) {
+    if (GetArenaNoVirtual() != other.GetArenaNoVirtual()) {
+      CopyFrom(other);
+    } else {
+      RepeatedPtrFieldBase::InternalSwap(&other);
+    }
+  }
+  return *this;
+}
+#endif  // GOOGLE_PROTOBUF_CXX11
+
 template <typename Element>
 inline bool RepeatedPtrField<Element>::empty() const {
   return RepeatedPtrFieldBase::empty();
@@ -39,6 +39,7 @@
 #include <limits>
 #include <list>
 #include <vector>
+#include <utility>
 
 #include <google/protobuf/repeated_field.h>
 
@@ -372,6 +373,44 @@ TEST(RepeatedField, CopyAssign) {
   EXPECT_EQ(5, destination.Get(1));
 }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+TEST(RepeatedField, MoveConstruct) {
+  RepeatedField<int> source;
+  source.Add(1);
+  source.Add(2);
+  const int* data = source.data();
+
+  RepeatedField<int> destination(std::move(source));
+
+  // The elements were taken, not copied.
+  EXPECT_EQ(data, destination.data());
+  ASSERT_EQ(2, destination.size());
+  EXPECT_EQ(1, destination.Get(0));
+  EXPECT_EQ(2, destination.Get(1));
+  EXPECT_TRUE(source.empty());
+}
+
+TEST(RepeatedField, MoveAssign) {
+  RepeatedField<int> source, destination;
+  source.Add(4);
+  source.Add(5);
+  destination.Add(1);
+  const int* data = source.data();
+
+  destination = std::move(source);
+
+  EXPECT_EQ(data, destination.data());
+  ASSERT_EQ(2, destination.size());
+  EXPECT_EQ(4, destination.Get(0));
+  EXPECT_EQ(5, destination.Get(1));
+
+  // Moving to self keeps the elements.
+  RepeatedField<int>& alias = destination;
+  destination = std::move(alias);
+  EXPECT_EQ(2, destination.size());
+}
+#endif  // GOOGLE_PROTOBUF_CXX11
+
 TEST(RepeatedField, SelfAssign) {
   // Verify that assignment to self does not destroy data.
   RepeatedField<int> source, *p;
@@ -870,6 +909,39 @@ TEST(RepeatedPtrField, CopyAssign) {
   EXPECT_EQ("5", destination.Get(1));
 }
 
+#ifdef GOOGLE_PROTOBUF_CXX11
+TEST(RepeatedPtrField, MoveConstruct) {
+  RepeatedPtrField<string> source;
+  source.Add()->assign("1");
+  source.Add()->assign("2");
+  const string* element = &source.Get(0);
+
+  RepeatedPtrField<string> destination(std::move(source));
+
+  // The elements were taken, not copied.
+  EXPECT_EQ(element, &destination.Get(0));
+  ASSERT_EQ(2, destination.size());
+  EXPECT_EQ("1", destination.Get(0));
+  EXPECT_EQ("2", destination.Get(1));
+  EXPECT_TRUE(source.empty());
+}
+
+TEST(RepeatedPtrField, MoveAssign) {
+  RepeatedPtrField<string> source, destination;
+  source.Add()->assign("4");
+  source.Add()->assign("5");
+  destination.Add()->assign("1");
+  const string* element = &source.Get(0);
+
+  destination = std::move(source);
+
+  EXPECT_EQ(element, &destination.Get(0));
+  ASSERT_EQ(2, destination.size());
+  EXPECT_EQ("4", destination.Get(0));
+  EXPECT_EQ("5", destination.Get(1));
+}
+#endif  // GOOGLE_PROTOBUF_CXX11
+
 TEST(RepeatedPtrField, SelfAssign) {
   // Verify that assignment to self does not destroy data.
   RepeatedPtrField<string> source, *p;
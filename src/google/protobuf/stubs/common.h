@@ -256,6 +256,15 @@ static const uint64 kuint64max = GOOGLE_ULONGLONG(0xFFFFFFFFFFFFFFFF);
 #endif
 #endif
 
+// GOOGLE_PROTOBUF_CXX11 is defined when compiling as C++11 or later.  Messages,
+// repeated fields and maps then also have move constructors and move
+// assignment operators.
+#ifndef GOOGLE_PROTOBUF_CXX11
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1800)
+#define GOOGLE_PROTOBUF_CXX11 1
+#endif
+#endif
+
 // Delimits a block of code which may write to memory which is simultaneously
 // written by other threads, but which has been determined to be thread-safe
 // (e.g. because it is an idempotent write).
@@ -0,0 +1,102 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Table-driven CRC32C, processing eight bytes per step ("slicing-by-8").
+
+#include <google/protobuf/stubs/crc32c.h>
+
+#include <google/protobuf/stubs/once.h>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+namespace {
+
+// The CRC32C polynomial, bit-reversed.
+const uint32 kCrc32cPolynomial = 0x82f63b78u;
+
+// crc32c_tables[0] is the usual byte-at-a-time table.  crc32c_tables[k][b] is
+// the CRC of byte b followed by k zero bytes, which lets us fold eight input
+// bytes with eight independent lookups.
+uint32 crc32c_tables[8][256];
+
+GOOGLE_PROTOBUF_DECLARE_ONCE(crc32c_tables_once_);
+
+void InitCrc32cTables() {
+  for (int i = 0; i < 256; i++) {
+    uint32 crc = i;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? kCrc32cPolynomial : 0);
+    }
+    crc32c_tables[0][i] = crc;
+  }
+  for (int i = 0; i < 256; i++) {
+    for (int k = 1; k < 8; k++) {
+      uint32 prev = crc32c_tables[k - 1][i];
+      crc32c_tables[k][i] = (prev >> 8) ^ crc32c_tables[0][prev & 0xff];
+    }
+  }
+}
+
+inline uint32 ReadLittleEndian32(const uint8* p) {
+  return static_cast<uint32>(p[0]) |
+         (static_cast<uint32>(p[1]) << 8) |
+         (static_cast<uint32>(p[2]) << 16) |
+         (static_cast<uint32>(p[3]) << 24);
+}
+
+}  // namespace
+
+uint32 Crc32cExtend(uint32 crc, const void* data, size_t size) {
+  ::google::protobuf::GoogleOnceInit(&crc32c_tables_once_, &InitCrc32cTables);
+  const uint32 (*t)[256] = crc32c_tables;
+  const uint8* p = static_cast<const uint8*>(data);
+  const uint8* end = p + size;
+  uint32 l = ~crc;
+
+  while (end - p >= 8) {
+    uint32 a = ReadLittleEndian32(p) ^ l;
+    uint32 b = ReadLittleEndian32(p + 4);
+    l = t[7][a & 0xff] ^ t[6][(a >> 8) & 0xff] ^
+        t[5][(a >> 16) & 0xff] ^ t[4][a >> 24] ^
+        t[3][b & 0xff] ^ t[2][(b >> 8) & 0xff] ^
+        t[1][(b >> 16) & 0xff] ^ t[0][b >> 24];
+    p += 8;
+  }
+  while (p < end) {
+    l = t[0][(l ^ *p++) & 0xff] ^ (l >> 8);
+  }
+  return ~l;
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
@@ -0,0 +1,73 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// CRC32C (Castagnoli) checksums, as used by the framing formats in io/.
+//
+// This header is intended to be included only by internal .cc files.
+
+#ifndef GOOGLE_PROTOBUF_STUBS_CRC32C_H__
+#define GOOGLE_PROTOBUF_STUBS_CRC32C_H__
+
+#include <stddef.h>
+
+#include <google/protobuf/stubs/common.h>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+
+// Returns the CRC32C of the concatenation of A and data[0, size), where crc
+// is the CRC32C of A.  Pass crc = 0 to start a new checksum.
+LIBPROTOBUF_EXPORT uint32 Crc32cExtend(uint32 crc, const void* data,
+                                       size_t size);
+
+// Returns the CRC32C of data[0, size).
+inline uint32 Crc32c(const void* data, size_t size) {
+  return Crc32cExtend(0, data, size);
+}
+
+// Checksums that are stored alongside the data they cover are "masked", so
+// that computing the CRC of a string that itself contains embedded CRCs does
+// not degenerate.  Use MaskCrc32c() before storing and UnmaskCrc32c() after
+// loading.
+inline uint32 MaskCrc32c(uint32 crc) {
+  return ((crc >> 15) | (crc << 17)) + 0xa282ead8u;
+}
+
+inline uint32 UnmaskCrc32c(uint32 masked_crc) {
+  uint32 rot = masked_crc - 0xa282ead8u;
+  return (rot >> 17) | (rot << 15);
+}
+
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
+
+#endif  // GOOGLE_PROTOBUF_STUBS_CRC32C_H__
@@ -0,0 +1,89 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <google/protobuf/stubs/crc32c.h>
+
+#include <string.h>
+#include <string>
+
+#include <google/protobuf/testing/googletest.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace internal {
+namespace {
+
+// Test vectors from RFC 3720, section B.4.
+TEST(Crc32cTest, StandardResults) {
+  char buf[32];
+
+  memset(buf, 0, sizeof(buf));
+  EXPECT_EQ(0x8a9136aau, Crc32c(buf, sizeof(buf)));
+
+  memset(buf, 0xff, sizeof(buf));
+  EXPECT_EQ(0x62a8ab43u, Crc32c(buf, sizeof(buf)));
+
+  for (int i = 0; i < 32; i++) {
+    buf[i] = i;
+  }
+  EXPECT_EQ(0x46dd794eu, Crc32c(buf, sizeof(buf)));
+
+  for (int i = 0; i < 32; i++) {
+    buf[i] = 31 - i;
+  }
+  EXPECT_EQ(0x113fdb5cu, Crc32c(buf, sizeof(buf)));
+
+  EXPECT_EQ(0xe3069283u, Crc32c("123456789", 9));
+}
+
+TEST(Crc32cTest, Extend) {
+  string data = "the quick brown fox jumps over the lazy dog";
+  uint32 whole = Crc32c(data.data(), data.size());
+  // Split at every possible point, including ones that leave the second part
+  // unaligned with respect to the eight-byte main loop.
+  for (int i = 0; i <= data.size(); i++) {
+    uint32 crc = Crc32c(data.data(), i);
+    EXPECT_EQ(whole, Crc32cExtend(crc, data.data() + i, data.size() - i));
+  }
+}
+
+TEST(Crc32cTest, Mask) {
+  uint32 crc = Crc32c("foo", 3);
+  EXPECT_NE(crc, MaskCrc32c(crc));
+  EXPECT_NE(crc, MaskCrc32c(MaskCrc32c(crc)));
+  EXPECT_EQ(crc, UnmaskCrc32c(MaskCrc32c(crc)));
+  EXPECT_EQ(crc, UnmaskCrc32c(UnmaskCrc32c(MaskCrc32c(MaskCrc32c(crc)))));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace protobuf
+}  // namespace google
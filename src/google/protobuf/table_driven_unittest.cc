@@ -0,0 +1,452 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for messages generated with the table_driven_parsing and
+// table_driven_serialization options.  The messages in
+// unittest_table_driven.proto are wire-compatible with those in unittest.proto,
+// which use generated code, so most tests check that both parse the same input
+// the same way, and serialize the same contents to the same bytes.
+
+#include <string>
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/text_format.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/unittest_proto3_arena.pb.h>
+#include <google/protobuf/unittest_table_driven.pb.h>
+#include <google/protobuf/unittest_table_driven_lite.pb.h>
+#include <google/protobuf/unittest_table_driven_proto3.pb.h>
+#include <google/protobuf/unknown_field_set.h>
+#include <google/protobuf/stubs/common.h>
+#include <google/protobuf/stubs/stl_util.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using protobuf_unittest_table_driven::TestAllTypes;
+using protobuf_unittest_table_driven::TestExtensions;
+using protobuf_unittest_table_driven::TestFieldOrder;
+using protobuf_unittest_table_driven::TestPackedTypes;
+using protobuf_unittest_table_driven::TestUnpackedTypes;
+
+bool MergeFromString(const string& data, MessageLite* message) {
+  io::CodedInputStream input(reinterpret_cast<const uint8*>(data.data()),
+                             data.size());
+  return message->MergeFromCodedStream(&input);
+}
+
+string AllFieldsData() {
+  unittest::TestAllTypes message;
+  TestUtil::SetAllFields(&message);
+  return message.SerializeAsString();
+}
+
+// Copies |from| into |to|, which has a different type with the same field
+// names, without using either type's parser.
+void CopyThroughTextFormat(const Message& from, Message* to) {
+  string text;
+  ASSERT_TRUE(TextFormat::PrintToString(from, &text));
+  ASSERT_TRUE(TextFormat::ParseFromString(text, to));
+}
+
+// Serializes |message| through a CodedOutputStream whose buffers are too small
+// for submessages to be serialized directly to arrays.
+string SerializeToSmallBuffers(const MessageLite& message) {
+  string data(message.ByteSize(), '\0');
+  io::ArrayOutputStream output(string_as_array(&data), data.size(), 3);
+  io::CodedOutputStream coded_output(&output);
+  message.SerializeWithCachedSizes(&coded_output);
+  EXPECT_FALSE(coded_output.HadError());
+  EXPECT_EQ(data.size(), coded_output.ByteCount());
+  return data;
+}
+
+TEST(TableDrivenParsingTest, AllFields) {
+  string data = AllFieldsData();
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(data, message.SerializeAsString());
+
+  unittest::TestAllTypes reference;
+  ASSERT_TRUE(reference.ParseFromString(message.SerializeAsString()));
+  TestUtil::ExpectAllFieldsSet(reference);
+}
+
+TEST(TableDrivenParsingTest, Merge) {
+  string data = AllFieldsData();
+  unittest::TestAllTypes reference;
+  ASSERT_TRUE(reference.ParseFromString(data));
+  ASSERT_TRUE(MergeFromString(data, &reference));
+
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  ASSERT_TRUE(MergeFromString(data, &message));
+  EXPECT_EQ(reference.SerializeAsString(), message.SerializeAsString());
+
+  // Parse again into the cleared message, which reuses the cleared elements
+  // of its repeated message fields.
+  message.Clear();
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(data, message.SerializeAsString());
+}
+
+TEST(TableDrivenParsingTest, DefaultValues) {
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(""));
+  EXPECT_FALSE(message.has_default_string());
+  EXPECT_EQ("hello", message.default_string());
+
+  // Parsing an empty string into a field with a default value must not
+  // modify the default.
+  unittest::TestAllTypes reference;
+  reference.set_default_string("");
+  ASSERT_TRUE(message.ParseFromString(reference.SerializeAsString()));
+  EXPECT_TRUE(message.has_default_string());
+  EXPECT_EQ("", message.default_string());
+  EXPECT_EQ("hello", TestAllTypes::default_instance().default_string());
+}
+
+TEST(TableDrivenParsingTest, Lite) {
+  string data = AllFieldsData();
+  protobuf_unittest_table_driven_lite::TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(data, message.SerializeAsString());
+}
+
+TEST(TableDrivenParsingTest, PackedAndUnpacked) {
+  unittest::TestPackedTypes packed_reference;
+  TestUtil::SetPackedFields(&packed_reference);
+  string packed_data = packed_reference.SerializeAsString();
+  unittest::TestUnpackedTypes unpacked_reference;
+  TestUtil::SetUnpackedFields(&unpacked_reference);
+  string unpacked_data = unpacked_reference.SerializeAsString();
+
+  TestPackedTypes packed;
+  ASSERT_TRUE(packed.ParseFromString(packed_data));
+  EXPECT_EQ(packed_data, packed.SerializeAsString());
+  TestUnpackedTypes unpacked;
+  ASSERT_TRUE(unpacked.ParseFromString(unpacked_data));
+  EXPECT_EQ(unpacked_data, unpacked.SerializeAsString());
+
+  // Each must accept the other's encoding.
+  ASSERT_TRUE(packed.ParseFromString(unpacked_data));
+  EXPECT_EQ(packed_data, packed.SerializeAsString());
+  ASSERT_TRUE(unpacked.ParseFromString(packed_data));
+  EXPECT_EQ(unpacked_data, unpacked.SerializeAsString());
+}
+
+TEST(TableDrivenParsingTest, UnknownEnumValues) {
+  unittest::TestEmptyMessage input;
+  UnknownFieldSet* fields = input.mutable_unknown_fields();
+  fields->AddVarint(unittest::TestAllTypes::kOptionalNestedEnumFieldNumber,
+                    unittest::TestAllTypes::BAZ);
+  fields->AddVarint(unittest::TestAllTypes::kOptionalNestedEnumFieldNumber,
+                    100);
+  fields->AddVarint(unittest::TestAllTypes::kRepeatedNestedEnumFieldNumber,
+                    unittest::TestAllTypes::BAR);
+  fields->AddVarint(unittest::TestAllTypes::kRepeatedNestedEnumFieldNumber,
+                    200);
+  fields->AddVarint(unittest::TestAllTypes::kRepeatedNestedEnumFieldNumber,
+                    unittest::TestAllTypes::FOO);
+  string data = input.SerializeAsString();
+
+  unittest::TestAllTypes reference;
+  ASSERT_TRUE(reference.ParseFromString(data));
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+
+  EXPECT_EQ(TestAllTypes::BAZ, message.optional_nested_enum());
+  ASSERT_EQ(2, message.repeated_nested_enum_size());
+  EXPECT_EQ(TestAllTypes::BAR, message.repeated_nested_enum(0));
+  EXPECT_EQ(TestAllTypes::FOO, message.repeated_nested_enum(1));
+  ASSERT_EQ(2, message.unknown_fields().field_count());
+  EXPECT_EQ(100, message.unknown_fields().field(0).varint());
+  EXPECT_EQ(200, message.unknown_fields().field(1).varint());
+  EXPECT_EQ(reference.SerializeAsString(), message.SerializeAsString());
+
+  protobuf_unittest_table_driven_lite::TestAllTypes lite_message;
+  ASSERT_TRUE(lite_message.ParseFromString(data));
+  EXPECT_EQ(reference.SerializeAsString(), lite_message.SerializeAsString());
+}
+
+TEST(TableDrivenParsingTest, WrongWireType) {
+  // A field with an unexpected wire type is treated as an unknown field.
+  unittest::TestEmptyMessage input;
+  input.mutable_unknown_fields()->AddFixed32(
+      unittest::TestAllTypes::kOptionalInt32FieldNumber, 1);
+  input.mutable_unknown_fields()->AddLengthDelimited(
+      unittest::TestAllTypes::kOptionalgroupFieldNumber, "abc");
+  string data = input.SerializeAsString();
+
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_FALSE(message.has_optional_int32());
+  EXPECT_FALSE(message.has_optionalgroup());
+  EXPECT_EQ(2, message.unknown_fields().field_count());
+  EXPECT_EQ(data, message.SerializeAsString());
+}
+
+TEST(TableDrivenParsingTest, Oneof) {
+  unittest::TestAllTypes reference;
+  reference.mutable_oneof_nested_message()->set_bb(1);
+  string data = reference.SerializeAsString();
+  reference.set_oneof_string("foo");
+  data += reference.SerializeAsString();
+
+  TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(TestAllTypes::kOneofString, message.oneof_field_case());
+  EXPECT_EQ("foo", message.oneof_string());
+  EXPECT_EQ(reference.SerializeAsString(), message.SerializeAsString());
+}
+
+TEST(TableDrivenParsingTest, ExtensionsAndUnknownFields) {
+  TestExtensions source;
+  source.set_a(1);
+  source.SetExtension(protobuf_unittest_table_driven::int32_extension, 2);
+  source.AddExtension(protobuf_unittest_table_driven::repeated_string_extension,
+                      "foo");
+  source.AddExtension(protobuf_unittest_table_driven::repeated_string_extension,
+                      "bar");
+  source.MutableExtension(protobuf_unittest_table_driven::message_extension)
+      ->set_bb(3);
+  source.mutable_unknown_fields()->AddVarint(2, 4);
+  string data = source.SerializeAsString();
+
+  TestExtensions message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(1, message.a());
+  EXPECT_EQ(2, message.GetExtension(
+      protobuf_unittest_table_driven::int32_extension));
+  ASSERT_EQ(2, message.ExtensionSize(
+      protobuf_unittest_table_driven::repeated_string_extension));
+  EXPECT_EQ("bar", message.GetExtension(
+      protobuf_unittest_table_driven::repeated_string_extension, 1));
+  EXPECT_EQ(3, message.GetExtension(
+      protobuf_unittest_table_driven::message_extension).bb());
+  ASSERT_EQ(1, message.unknown_fields().field_count());
+  EXPECT_EQ(data, message.SerializeAsString());
+
+  protobuf_unittest_table_driven_lite::TestExtensions lite_message;
+  ASSERT_TRUE(lite_message.ParseFromString(data));
+  EXPECT_EQ(2, lite_message.GetExtension(
+      protobuf_unittest_table_driven_lite::int32_extension));
+  EXPECT_EQ(3, lite_message.GetExtension(
+      protobuf_unittest_table_driven_lite::message_extension).bb());
+  EXPECT_EQ(data.size(), lite_message.SerializeAsString().size());
+}
+
+TEST(TableDrivenParsingTest, Maps) {
+  protobuf_unittest_table_driven_lite::TestMap source;
+  (*source.mutable_map_int32_int32())[1] = 2;
+  (*source.mutable_map_int32_int32())[3] = 4;
+  (*source.mutable_map_string_string())["foo"] = "bar";
+  source.set_after_maps(6);
+
+  protobuf_unittest_table_driven_lite::TestMap message;
+  ASSERT_TRUE(message.ParseFromString(source.SerializeAsString()));
+  ASSERT_EQ(2, message.map_int32_int32().size());
+  EXPECT_EQ(4, message.map_int32_int32().at(3));
+  ASSERT_EQ(1, message.map_string_string().size());
+  EXPECT_EQ("bar", message.map_string_string().at("foo"));
+  EXPECT_EQ(6, message.after_maps());
+}
+
+TEST(TableDrivenParsingTest, Arena) {
+  string data = AllFieldsData();
+  ::google::protobuf::Arena arena;
+  TestAllTypes* message = ::google::protobuf::Arena::CreateMessage<TestAllTypes>(&arena);
+  ASSERT_TRUE(message->ParseFromString(data));
+  ASSERT_TRUE(MergeFromString(data, message));
+  EXPECT_EQ(&arena, message->optional_nested_message().GetArena());
+  EXPECT_EQ(&arena, message->repeated_nested_message(0).GetArena());
+
+  unittest::TestAllTypes reference;
+  ASSERT_TRUE(reference.ParseFromString(data));
+  ASSERT_TRUE(MergeFromString(data, &reference));
+  EXPECT_EQ(reference.SerializeAsString(), message->SerializeAsString());
+}
+
+TEST(TableDrivenParsingTest, Truncated) {
+  // Every prefix of the data must be accepted or rejected exactly like the
+  // generated parser does.
+  string data = AllFieldsData();
+  for (int i = 0; i < data.size(); i++) {
+    string prefix = data.substr(0, i);
+    unittest::TestAllTypes reference;
+    TestAllTypes message;
+    bool reference_ok = reference.ParsePartialFromString(prefix);
+    EXPECT_EQ(reference_ok, message.ParsePartialFromString(prefix)) << i;
+    if (reference_ok) {
+      EXPECT_EQ(reference.SerializePartialAsString(),
+                message.SerializePartialAsString());
+    }
+  }
+}
+
+TEST(TableDrivenSerializationTest, AllFields) {
+  unittest::TestAllTypes reference;
+  TestUtil::SetAllFields(&reference);
+  TestAllTypes message;
+  CopyThroughTextFormat(reference, &message);
+
+  string data = reference.SerializeAsString();
+  EXPECT_EQ(reference.ByteSize(), message.ByteSize());
+  EXPECT_EQ(data, message.SerializeAsString());
+  EXPECT_EQ(data, SerializeToSmallBuffers(message));
+
+  protobuf_unittest_table_driven_lite::TestAllTypes lite_message;
+  ASSERT_TRUE(lite_message.ParseFromString(data));
+  EXPECT_EQ(data, lite_message.SerializeAsString());
+  EXPECT_EQ(data, SerializeToSmallBuffers(lite_message));
+}
+
+TEST(TableDrivenSerializationTest, Empty) {
+  TestAllTypes message;
+  EXPECT_EQ(0, message.ByteSize());
+  EXPECT_EQ("", message.SerializeAsString());
+  EXPECT_EQ("", TestAllTypes::default_instance().SerializeAsString());
+}
+
+TEST(TableDrivenSerializationTest, PackedAndUnpacked) {
+  unittest::TestPackedTypes packed_reference;
+  TestUtil::SetPackedFields(&packed_reference);
+  TestPackedTypes packed;
+  CopyThroughTextFormat(packed_reference, &packed);
+  EXPECT_EQ(packed_reference.SerializeAsString(), packed.SerializeAsString());
+  EXPECT_EQ(packed_reference.SerializeAsString(),
+            SerializeToSmallBuffers(packed));
+
+  unittest::TestUnpackedTypes unpacked_reference;
+  TestUtil::SetUnpackedFields(&unpacked_reference);
+  TestUnpackedTypes unpacked;
+  CopyThroughTextFormat(unpacked_reference, &unpacked);
+  EXPECT_EQ(unpacked_reference.SerializeAsString(),
+            unpacked.SerializeAsString());
+  EXPECT_EQ(unpacked_reference.SerializeAsString(),
+            SerializeToSmallBuffers(unpacked));
+
+  // Removing elements must update the cached size of the packed data.
+  packed.mutable_packed_int32()->RemoveLast();
+  packed_reference.mutable_packed_int32()->RemoveLast();
+  EXPECT_EQ(packed_reference.SerializeAsString(), packed.SerializeAsString());
+}
+
+TEST(TableDrivenSerializationTest, Proto3) {
+  proto3_arena_unittest::TestAllTypes reference;
+  protobuf_unittest_table_driven_proto3::TestAllTypes message;
+  EXPECT_EQ("", message.SerializeAsString());
+
+  // Fields set to their default values are not serialized.
+  message.set_optional_int32(0);
+  message.set_optional_string("");
+  message.set_optional_double(0.0);
+  message.set_optional_nested_enum(
+      protobuf_unittest_table_driven_proto3::TestAllTypes::FOO);
+  EXPECT_EQ("", message.SerializeAsString());
+
+  reference.set_optional_int32(-1);
+  reference.set_optional_int64(2);
+  reference.set_optional_sint32(-3);
+  reference.set_optional_fixed32(4);
+  reference.set_optional_fixed64(5);
+  reference.set_optional_float(6.5);
+  reference.set_optional_double(-7.5);
+  reference.set_optional_bool(true);
+  reference.set_optional_string("foo");
+  reference.set_optional_bytes("bar");
+  reference.mutable_optional_nested_message();
+  reference.set_optional_nested_enum(proto3_arena_unittest::TestAllTypes::NEG);
+  reference.add_repeated_int32(8);
+  reference.add_repeated_int32(9);
+  reference.add_repeated_string("baz");
+  reference.add_repeated_nested_message()->set_bb(10);
+  CopyThroughTextFormat(reference, &message);
+  EXPECT_TRUE(message.has_optional_nested_message());
+
+  string data = reference.SerializeAsString();
+  EXPECT_EQ(data, message.SerializeAsString());
+  EXPECT_EQ(data, SerializeToSmallBuffers(message));
+
+  protobuf_unittest_table_driven_proto3::TestAllTypes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(data));
+  EXPECT_EQ(data, parsed.SerializeAsString());
+}
+
+TEST(TableDrivenSerializationTest, FieldOrder) {
+  TestFieldOrder message;
+  message.set_a(1);
+  message.set_c("foo");
+  message.set_d("bar");
+  message.SetExtension(protobuf_unittest_table_driven::field_order_extension,
+                       2);
+  message.add_e(3);
+  message.set_f(4);
+  message.mutable_unknown_fields()->AddVarint(12, 5);
+
+  // The expected output, in field number order.
+  unittest::TestEmptyMessage expected;
+  UnknownFieldSet* fields = expected.mutable_unknown_fields();
+  fields->AddVarint(1, 1);
+  fields->AddLengthDelimited(3, "foo");
+  fields->AddLengthDelimited(4, "bar");
+  fields->AddVarint(5, 2);
+  fields->AddLengthDelimited(10, "\x03");
+  fields->AddVarint(11, 4);
+  fields->AddVarint(12, 5);
+
+  EXPECT_EQ(expected.ByteSize(), message.ByteSize());
+  EXPECT_EQ(expected.SerializeAsString(), message.SerializeAsString());
+  EXPECT_EQ(expected.SerializeAsString(), SerializeToSmallBuffers(message));
+}
+
+TEST(TableDrivenSerializationTest, Maps) {
+  protobuf_unittest_table_driven_lite::TestMap message;
+  (*message.mutable_map_int32_int32())[1] = 2;
+  (*message.mutable_map_string_string())["foo"] = "bar";
+  message.set_after_maps(3);
+
+  // The maps precede after_maps, which is in the message table.
+  string data = message.SerializeAsString();
+  EXPECT_EQ(message.ByteSize(), data.size());
+  EXPECT_EQ("\x0a\x04\x08\x01\x10\x02"
+            "\x12\x0a\x0a\x03" "foo" "\x12\x03" "bar"
+            "\x18\x03",
+            data);
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
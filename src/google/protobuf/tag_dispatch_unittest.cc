@@ -0,0 +1,152 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Tests for messages generated with the tag_dispatch_table option, whose
+// parsers look up each tag in a table to find the case which handles it.  The
+// messages in unittest_tag_dispatch.proto are wire-compatible with those in
+// unittest.proto, so the tests parse data written by the ordinary generated
+// ones and check that writing it back out gives the same bytes.
+
+#include <string>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/test_util.h>
+#include <google/protobuf/unittest.pb.h>
+#include <google/protobuf/unittest_tag_dispatch.pb.h>
+#include <google/protobuf/wire_format.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/stubs/common.h>
+#include <gtest/gtest.h>
+
+namespace google {
+namespace protobuf {
+namespace {
+
+using internal::WireFormat;
+using internal::WireFormatLite;
+
+TEST(TagDispatchTest, AllFields) {
+  unittest::TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+  string data = original.SerializeAsString();
+
+  protobuf_unittest_tag_dispatch::TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(data, message.SerializeAsString());
+}
+
+TEST(TagDispatchTest, FieldsInReverseOrder) {
+  // Every field is missed by the ExpectTag() predictions and has to go
+  // through the table.
+  unittest::TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+  original.ByteSize();
+  vector<const FieldDescriptor*> fields;
+  original.GetReflection()->ListFields(original, &fields);
+  string data;
+  {
+    io::StringOutputStream string_stream(&data);
+    io::CodedOutputStream output_stream(&string_stream);
+    for (int i = fields.size() - 1; i >= 0; i--) {
+      WireFormat::SerializeFieldWithCachedSizes(fields[i], original,
+                                                &output_stream);
+    }
+  }
+
+  protobuf_unittest_tag_dispatch::TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(original.SerializeAsString(), message.SerializeAsString());
+}
+
+TEST(TagDispatchTest, PackedAndUnpackedEncodings) {
+  // Packable fields have a table entry for each encoding.
+  unittest::TestPackedTypes packed;
+  unittest::TestUnpackedTypes unpacked;
+  TestUtil::SetPackedFields(&packed);
+  TestUtil::SetUnpackedFields(&unpacked);
+
+  protobuf_unittest_tag_dispatch::TestPackedTypes packed_from_unpacked;
+  ASSERT_TRUE(packed_from_unpacked.ParseFromString(
+      unpacked.SerializeAsString()));
+  EXPECT_EQ(packed.SerializeAsString(),
+            packed_from_unpacked.SerializeAsString());
+
+  protobuf_unittest_tag_dispatch::TestUnpackedTypes unpacked_from_packed;
+  ASSERT_TRUE(unpacked_from_packed.ParseFromString(
+      packed.SerializeAsString()));
+  EXPECT_EQ(unpacked.SerializeAsString(),
+            unpacked_from_packed.SerializeAsString());
+}
+
+TEST(TagDispatchTest, UnknownFields) {
+  // None of the fields of TestAllTypes are known to TestPackedTypes, so all
+  // of them are kept as unknown fields, in order.
+  unittest::TestAllTypes original;
+  TestUtil::SetAllFields(&original);
+  string data = original.SerializeAsString();
+
+  protobuf_unittest_tag_dispatch::TestPackedTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_EQ(0, message.packed_int32_size());
+  EXPECT_EQ(data, message.SerializeAsString());
+}
+
+TEST(TagDispatchTest, WrongWireType) {
+  // A known field number with the wrong wire type has no table entry, so the
+  // field is kept as an unknown field.
+  string data;
+  {
+    io::StringOutputStream string_stream(&data);
+    io::CodedOutputStream output_stream(&string_stream);
+    WireFormatLite::WriteFixed32(1, 123, &output_stream);
+  }
+
+  protobuf_unittest_tag_dispatch::TestAllTypes message;
+  ASSERT_TRUE(message.ParseFromString(data));
+  EXPECT_FALSE(message.has_optional_int32());
+  EXPECT_EQ(data, message.SerializeAsString());
+}
+
+TEST(TagDispatchTest, ReallyLargeTagNumber) {
+  unittest::TestReallyLargeTagNumber original;
+  original.set_a(1);
+  original.set_bb(2);
+
+  protobuf_unittest_tag_dispatch::TestReallyLargeTagNumber message;
+  ASSERT_TRUE(message.ParseFromString(original.SerializeAsString()));
+  EXPECT_EQ(1, message.a());
+  EXPECT_EQ(2, message.bb());
+}
+
+}  // namespace
+}  // namespace protobuf
+}  // namespace google
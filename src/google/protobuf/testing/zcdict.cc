@@ -0,0 +1,134 @@
+// Protocol Buffers - Google's data interchange format
+// Copyright 2008 Google Inc.  All rights reserved.
+// https://developers.google.com/protocol-buffers/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Builds a preset dictionary for GzipOutputStream::Options::dictionary from
+// sample messages of a given type.
+//
+// Usage:
+//   zcdict PROTO_PATH FILE.proto MESSAGE_TYPE [MAX_SIZE] < samples > dict
+//
+// Reads varint-length-delimited serialized messages of MESSAGE_TYPE on
+// standard input.  Each sample is parsed and serialized again, so that the
+// dictionary reflects the canonical field order that the C++ implementation
+// writes, and the resulting dictionary is written to standard output.
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include <google/protobuf/compiler/importer.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/message.h>
+#include <google/protobuf/stubs/common.h>
+
+using google::protobuf::Descriptor;
+using google::protobuf::DynamicMessageFactory;
+using google::protobuf::Message;
+using google::protobuf::compiler::DiskSourceTree;
+using google::protobuf::compiler::Importer;
+using google::protobuf::compiler::MultiFileErrorCollector;
+using google::protobuf::io::BuildGzipDictionary;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::FileInputStream;
+
+namespace {
+
+class StderrErrorCollector : public MultiFileErrorCollector {
+ public:
+  void AddError(const std::string& filename, int line, int column,
+                const std::string& message) {
+    fprintf(stderr, "%s:%d:%d: %s\n", filename.c_str(), line + 1, column + 1,
+            message.c_str());
+  }
+};
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  if (argc < 4 || argc > 5) {
+    fprintf(stderr,
+            "Usage: %s PROTO_PATH FILE.proto MESSAGE_TYPE [MAX_SIZE]"
+            " < samples > dictionary\n", argv[0]);
+    return 1;
+  }
+  int max_size = argc == 5 ? atoi(argv[4]) : 32768;
+
+  DiskSourceTree source_tree;
+  source_tree.MapPath("", argv[1]);
+  StderrErrorCollector error_collector;
+  Importer importer(&source_tree, &error_collector);
+  if (importer.Import(argv[2]) == NULL) {
+    return 1;
+  }
+  const Descriptor* type = importer.pool()->FindMessageTypeByName(argv[3]);
+  if (type == NULL) {
+    fprintf(stderr, "%s: no such message type\n", argv[3]);
+    return 1;
+  }
+  DynamicMessageFactory factory;
+  google::protobuf::scoped_ptr<Message> message(
+      factory.GetPrototype(type)->New());
+
+  std::vector<std::string> samples;
+  FileInputStream fin(STDIN_FILENO);
+  CodedInputStream input(&fin);
+  input.SetTotalBytesLimit(INT_MAX, INT_MAX);
+  google::protobuf::uint32 size;
+  while (input.ReadVarint32(&size)) {
+    CodedInputStream::Limit limit = input.PushLimit(size);
+    if (!message->ParseFromCodedStream(&input) ||
+        !input.ConsumedEntireMessage()) {
+      fprintf(stderr, "Sample %d is not a valid %s.\n",
+              static_cast<int>(samples.size()), argv[3]);
+      return 1;
+    }
+    input.PopLimit(limit);
+    samples.push_back(message->SerializeAsString());
+  }
+
+  std::string dictionary;
+  BuildGzipDictionary(samples, max_size, &dictionary);
+
+  if (fwrite(dictionary.data(), 1, dictionary.size(), stdout) !=
+      dictionary.size()) {
+    perror("fwrite");
+    return 1;
+  }
+  return 0;
+}
@@ -1416,16 +1416,36 @@ struct FieldIndexSorter {
 };
 }  // namespace
 
+class TextFormat::Printer::FieldPrinter : public Reflection::FieldVisitor {
+ public:
+  FieldPrinter(const Printer* printer, const Message& message,
+               const Reflection* reflection, TextGenerator& generator)
+      : printer_(printer), message_(message), reflection_(reflection),
+        generator_(generator) {}
+  void Visit(const FieldDescriptor* field) {
+    printer_->PrintField(message_, reflection_, field, generator_);
+  }
+
+ private:
+  const Printer* printer_;
+  const Message& message_;
+  const Reflection* reflection_;
+  TextGenerator& generator_;
+};
+
 void TextFormat::Printer::Print(const Message& message,
                                 TextGenerator& generator) const {
   const Reflection* reflection = message.GetReflection();
-  vector<const FieldDescriptor*> fields;
-  reflection->ListFields(message, &fields);
   if (print_message_fields_in_index_order_) {
+    vector<const FieldDescriptor*> fields;
+    reflection->ListFields(message, &fields);
     sort(fields.begin(), fields.end(), FieldIndexSorter());
-  }
-  for (int i = 0; i < fields.size(); i++) {
-    PrintField(message, reflection, fields[i], generator);
+    for (int i = 0; i < fields.size(); i++) {
+      PrintField(message, reflection, fields[i], generator);
+    }
+  } else {
+    FieldPrinter printer(this, message, reflection, generator);
+    reflection->VisitFields(message, &printer);
   }
   if (!hide_unknown_fields_) {
     PrintUnknownFields(reflection->GetUnknownFields(message), generator);
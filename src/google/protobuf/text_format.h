@@ -221,6 +221,10 @@ class LIBPROTOBUF_EXPORT TextFormat {
     // output to the OutputStream (see text_format.cc for implementation).
     class TextGenerator;
 
+    // Reflection::FieldVisitor which calls PrintField() on each field it
+    // visits (see text_format.cc).
+    class FieldPrinter;
+
     // Internal Print method, used for writing to the OutputStream via
     // the TextGenerator class.
     void Print(const Message& message,
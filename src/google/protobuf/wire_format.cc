@@ -747,6 +747,36 @@ bool WireFormat::ParseAndMergeMessageSetItem(
 
 // ===================================================================
 
+namespace {
+// Serializes each field it visits.
+class FieldSerializer : public Reflection::FieldVisitor {
+ public:
+  FieldSerializer(const Message& message, io::CodedOutputStream* output)
+      : message_(message), output_(output) {}
+  void Visit(const FieldDescriptor* field) {
+    WireFormat::SerializeFieldWithCachedSizes(field, message_, output_);
+  }
+
+ private:
+  const Message& message_;
+  io::CodedOutputStream* output_;
+};
+
+// Sums the serialized sizes of the fields it visits.
+class FieldSizer : public Reflection::FieldVisitor {
+ public:
+  explicit FieldSizer(const Message& message) : message_(message), size_(0) {}
+  void Visit(const FieldDescriptor* field) {
+    size_ += WireFormat::FieldByteSize(field, message_);
+  }
+  int size() const { return size_; }
+
+ private:
+  const Message& message_;
+  int size_;
+};
+}  // namespace
+
 void WireFormat::SerializeWithCachedSizes(
     const Message& message,
     int size, io::CodedOutputStream* output) {
@@ -754,11 +784,8 @@ void WireFormat::SerializeWithCachedSizes(
   const Reflection* message_reflection = message.GetReflection();
   int expected_endpoint = output->ByteCount() + size;
 
-  vector<const FieldDescriptor*> fields;
-  message_reflection->ListFields(message, &fields);
-  for (int i = 0; i < fields.size(); i++) {
-    SerializeFieldWithCachedSizes(fields[i], message, output);
-  }
+  FieldSerializer serializer(message, output);
+  message_reflection->VisitFields(message, &serializer);
 
   if (descriptor->options().message_set_wire_format()) {
     SerializeUnknownMessageSetItems(
@@ -923,13 +950,9 @@ int WireFormat::ByteSize(const Message& message) {
   const Descriptor* descriptor = message.GetDescriptor();
   const Reflection* message_reflection = message.GetReflection();
 
-  int our_size = 0;
-
-  vector<const FieldDescriptor*> fields;
-  message_reflection->ListFields(message, &fields);
-  for (int i = 0; i < fields.size(); i++) {
-    our_size += FieldByteSize(fields[i], message);
-  }
+  FieldSizer sizer(message);
+  message_reflection->VisitFields(message, &sizer);
+  int our_size = sizer.size();
 
   if (descriptor->options().message_set_wire_format()) {
     our_size += ComputeUnknownMessageSetItemsSize(
@@ -1110,6 +1133,14 @@ void WireFormat::VerifyUTF8StringFallback(const char* data,
   }
 }
 
+void WireFormat::VerifyUTF8StringFromTable(const char* data,
+                                           int size,
+                                           bool parsing,
+                                           const char* field_name) {
+  VerifyUTF8StringFallback(data, size, parsing ? PARSE : SERIALIZE,
+                           field_name);
+}
+
 
 }  // namespace internal
 }  // namespace protobuf
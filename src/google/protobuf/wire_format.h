@@ -237,6 +237,13 @@ class LIBPROTOBUF_EXPORT WireFormat {
                                          int size,
                                          Operation op,
                                          const char* field_name);
+  // Variant used as MessageTable::verify_utf8 by generated code which uses
+  // the table-driven parser (see generated_message_util.h).  It is called
+  // only when GOOGLE_PROTOBUF_UTF8_VALIDATION_ENABLED.
+  static void VerifyUTF8StringFromTable(const char* data,
+                                        int size,
+                                        bool parsing,
+                                        const char* field_name);
 
  private:
   // Verifies that a string field is valid UTF8, logging an error if not.
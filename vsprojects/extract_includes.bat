@@ -22,6 +22,7 @@ copy ..\src\google\protobuf\extension_set.h include\google\protobuf\extension_se
 copy ..\src\google\protobuf\generated_enum_reflection.h include\google\protobuf\generated_enum_reflection.h
 copy ..\src\google\protobuf\generated_message_util.h include\google\protobuf\generated_message_util.h
 copy ..\src\google\protobuf\generated_message_reflection.h include\google\protobuf\generated_message_reflection.h
+copy ..\src\google\protobuf\incremental_parser.h include\google\protobuf\incremental_parser.h
 copy ..\src\google\protobuf\message.h include\google\protobuf\message.h
 copy ..\src\google\protobuf\message_lite.h include\google\protobuf\message_lite.h
 copy ..\src\google\protobuf\reflection_ops.h include\google\protobuf\reflection_ops.h
@@ -33,8 +34,11 @@ copy ..\src\google\protobuf\wire_format.h include\google\protobuf\wire_format.h
 copy ..\src\google\protobuf\wire_format_lite.h include\google\protobuf\wire_format_lite.h
 copy ..\src\google\protobuf\wire_format_lite_inl.h include\google\protobuf\wire_format_lite_inl.h
 copy ..\src\google\protobuf\io\coded_stream.h include\google\protobuf\io\coded_stream.h
+copy ..\src\google\protobuf\io\delimited_reader.h include\google\protobuf\io\delimited_reader.h
 copy ..\src\google\protobuf\io\gzip_stream.h include\google\protobuf\io\gzip_stream.h
+copy ..\src\google\protobuf\io\lz_stream.h include\google\protobuf\io\lz_stream.h
 copy ..\src\google\protobuf\io\printer.h include\google\protobuf\io\printer.h
+copy ..\src\google\protobuf\io\record_io.h include\google\protobuf\io\record_io.h
 copy ..\src\google\protobuf\io\strtod.h include\google\protobuf\io\strtod.h
 copy ..\src\google\protobuf\io\tokenizer.h include\google\protobuf\io\tokenizer.h
 copy ..\src\google\protobuf\io\zero_copy_stream.h include\google\protobuf\io\zero_copy_stream.h